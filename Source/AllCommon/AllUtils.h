@@ -4,31 +4,42 @@
 
 namespace Utils {
     inline const char* PLUGIN_SCAN_SERVER_UID = "pluginScanServer";
+    inline const char* PLUGIN_HOST_SERVER_UID = "pluginHostServer";
 
     inline const char* SCANNED_PLUGINS_FILE_NAME = "ScannedPlugins.txt";
     inline const char* SCANNED_PLUGINS_BACKUP_FILE_NAME = "ScannedPlugins.txt.bak";
     inline const char* CRASHED_PLUGINS_FILE_NAME = "CrashedPlugins.txt";
     inline const char* SCAN_IS_ALIVE_FILE_NAME = "ScanAlive.txt";
 
+    // Messages sent to the scan server, the stop message is followed by the path to export to
+    inline const char* SCAN_SERVER_START_TRACE_MESSAGE = "StartTrace";
+    inline const char* SCAN_SERVER_STOP_TRACE_MESSAGE = "StopTrace ";
+
     constexpr int PLUGIN_SCANNER_IS_ALIVE_INTERVAL{ 1000 };
 
 #ifdef __APPLE__
     const juce::File DataDirectory(juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("WhiteElephantAudio/Syndicate"));
     const juce::File PluginLogDirectory(juce::File::getSpecialLocation(juce::File::userHomeDirectory).getChildFile("Library/Logs/WhiteElephantAudio/Syndicate/Syndicate"));
     const juce::File PluginScanServerLogDirectory(juce::File::getSpecialLocation(juce::File::userHomeDirectory).getChildFile("Library/Logs/WhiteElephantAudio/Syndicate/PluginScanServer"));
+    const juce::File PluginHostServerLogDirectory(juce::File::getSpecialLocation(juce::File::userHomeDirectory).getChildFile("Library/Logs/WhiteElephantAudio/Syndicate/PluginHostServer"));
     const juce::File PluginScanServerBinary(juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory().getSiblingFile("Resources").getChildFile("PluginScanServer"));
+    const juce::File PluginHostServerBinary(juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory().getSiblingFile("Resources").getChildFile("PluginHostServer"));
 #elif _WIN32
     const juce::File ApplicationDirectory(juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("WhiteElephantAudio/Syndicate"));
     const juce::File DataDirectory(ApplicationDirectory.getChildFile("Data"));
     const juce::File PluginLogDirectory(ApplicationDirectory.getChildFile("Logs/Syndicate"));
     const juce::File PluginScanServerLogDirectory(ApplicationDirectory.getChildFile("Logs/PluginScanServer"));
+    const juce::File PluginHostServerLogDirectory(ApplicationDirectory.getChildFile("Logs/PluginHostServer"));
     const juce::File PluginScanServerBinary(juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory().getSiblingFile("Resources").getChildFile("PluginScanServer.exe"));
+    const juce::File PluginHostServerBinary(juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory().getSiblingFile("Resources").getChildFile("PluginHostServer.exe"));
 #elif __linux__
     const juce::File ApplicationDirectory(juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("WhiteElephantAudio/Syndicate"));
     const juce::File DataDirectory(ApplicationDirectory.getChildFile("Data"));
     const juce::File PluginLogDirectory(ApplicationDirectory.getChildFile("Logs/Syndicate"));
     const juce::File PluginScanServerLogDirectory(ApplicationDirectory.getChildFile("Logs/PluginScanServer"));
+    const juce::File PluginHostServerLogDirectory(ApplicationDirectory.getChildFile("Logs/PluginHostServer"));
     const juce::File PluginScanServerBinary(juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory().getSiblingFile("Resources").getChildFile("PluginScanServer"));
+    const juce::File PluginHostServerBinary(juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory().getSiblingFile("Resources").getChildFile("PluginHostServer"));
 #else
     #error Unsupported OS
 #endif
@@ -0,0 +1,173 @@
+#include "SandboxTransport.h"
+
+namespace {
+    // Regions are padded to keep the audio aligned for vector operations
+    constexpr size_t REGION_ALIGNMENT {64};
+
+    size_t alignSize(size_t size) {
+        return (size + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+    }
+
+    // Each MIDI event is stored as its sample position and size followed by its data
+    constexpr int MIDI_EVENT_HEADER_BYTES {2 * sizeof(juce::int32)};
+}
+
+namespace Sandbox {
+    juce::MemoryBlock createMessage(MESSAGE_TYPE type, juce::int32 requestId, const juce::MemoryBlock& payload) {
+        juce::MemoryOutputStream stream;
+        stream.writeInt(static_cast<int>(type));
+        stream.writeInt(requestId);
+        stream.write(payload.getData(), payload.getSize());
+
+        return stream.getMemoryBlock();
+    }
+
+    void parseMessage(const juce::MemoryBlock& message, MESSAGE_TYPE& type, juce::int32& requestId, juce::MemoryBlock& payload) {
+        juce::MemoryInputStream stream(message, false);
+        type = static_cast<MESSAGE_TYPE>(stream.readInt());
+        requestId = stream.readInt();
+
+        payload.reset();
+        stream.readIntoMemoryBlock(payload);
+    }
+
+    void writeLayout(juce::MemoryOutputStream& stream, const juce::AudioProcessor::BusesLayout& layout) {
+        stream.writeInt(layout.inputBuses.size());
+        for (const juce::AudioChannelSet& bus : layout.inputBuses) {
+            stream.writeString(bus.getSpeakerArrangementAsString());
+        }
+
+        stream.writeInt(layout.outputBuses.size());
+        for (const juce::AudioChannelSet& bus : layout.outputBuses) {
+            stream.writeString(bus.getSpeakerArrangementAsString());
+        }
+    }
+
+    juce::AudioProcessor::BusesLayout readLayout(juce::MemoryInputStream& stream) {
+        juce::AudioProcessor::BusesLayout retVal;
+
+        const int numInputBuses {stream.readInt()};
+        for (int busIndex {0}; busIndex < numInputBuses; busIndex++) {
+            retVal.inputBuses.add(juce::AudioChannelSet::fromAbbreviatedString(stream.readString()));
+        }
+
+        const int numOutputBuses {stream.readInt()};
+        for (int busIndex {0}; busIndex < numOutputBuses; busIndex++) {
+            retVal.outputBuses.add(juce::AudioChannelSet::fromAbbreviatedString(stream.readString()));
+        }
+
+        return retVal;
+    }
+
+    void writeMemoryBlock(juce::MemoryOutputStream& stream, const juce::MemoryBlock& block) {
+        stream.writeInt64(static_cast<juce::int64>(block.getSize()));
+        stream.write(block.getData(), block.getSize());
+    }
+
+    juce::MemoryBlock readMemoryBlock(juce::MemoryInputStream& stream) {
+        juce::MemoryBlock retVal;
+        const juce::int64 size {stream.readInt64()};
+
+        if (size > 0 && size <= stream.getNumBytesRemaining()) {
+            stream.readIntoMemoryBlock(retVal, static_cast<ssize_t>(size));
+        }
+
+        return retVal;
+    }
+
+    SharedAudioBlock::SharedAudioBlock(const juce::File& file, int numChannels, int maxBlockSize, int numParameters) :
+            _numChannels(numChannels),
+            _maxBlockSize(maxBlockSize),
+            _numParameters(numParameters),
+            _header(nullptr),
+            _inputAudio(nullptr),
+            _outputAudio(nullptr),
+            _inputParameters(nullptr),
+            _outputParameters(nullptr),
+            _inputMidi(nullptr),
+            _outputMidi(nullptr) {
+
+        _file = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readWrite, false);
+
+        if (_file->getData() != nullptr &&
+            _file->getSize() >= _getRequiredSize(numChannels, maxBlockSize, numParameters)) {
+
+            const size_t audioSize {alignSize(sizeof(float) * numChannels * maxBlockSize)};
+            const size_t parametersSize {alignSize(sizeof(float) * numParameters)};
+
+            juce::uint8* position {static_cast<juce::uint8*>(_file->getData())};
+
+            _header = reinterpret_cast<SharedHeader*>(position);
+            position += alignSize(sizeof(SharedHeader));
+
+            _inputAudio = reinterpret_cast<float*>(position);
+            position += audioSize;
+
+            _outputAudio = reinterpret_cast<float*>(position);
+            position += audioSize;
+
+            _inputParameters = reinterpret_cast<float*>(position);
+            position += parametersSize;
+
+            _outputParameters = reinterpret_cast<float*>(position);
+            position += parametersSize;
+
+            _inputMidi = position;
+            position += alignSize(MAX_MIDI_BYTES);
+
+            _outputMidi = position;
+        } else {
+            juce::Logger::writeToLog("SharedAudioBlock: Failed to map " + file.getFullPathName());
+        }
+    }
+
+    bool SharedAudioBlock::createFile(const juce::File& file, int numChannels, int maxBlockSize, int numParameters) {
+        const size_t size {_getRequiredSize(numChannels, maxBlockSize, numParameters)};
+        const juce::MemoryBlock zeros(size, true);
+
+        return file.replaceWithData(zeros.getData(), zeros.getSize());
+    }
+
+    int SharedAudioBlock::writeMidi(const juce::MidiBuffer& midiMessages, juce::uint8* destination) {
+        int numBytesWritten {0};
+
+        for (const juce::MidiMessageMetadata metadata : midiMessages) {
+            if (numBytesWritten + MIDI_EVENT_HEADER_BYTES + metadata.numBytes > MAX_MIDI_BYTES) {
+                break;
+            }
+
+            const juce::int32 eventHeader[2] {metadata.samplePosition, metadata.numBytes};
+            std::memcpy(destination + numBytesWritten, eventHeader, MIDI_EVENT_HEADER_BYTES);
+            numBytesWritten += MIDI_EVENT_HEADER_BYTES;
+
+            std::memcpy(destination + numBytesWritten, metadata.data, metadata.numBytes);
+            numBytesWritten += metadata.numBytes;
+        }
+
+        return numBytesWritten;
+    }
+
+    void SharedAudioBlock::readMidi(const juce::uint8* source, int numBytes, juce::MidiBuffer& midiMessages) {
+        int numBytesRead {0};
+
+        while (numBytesRead + MIDI_EVENT_HEADER_BYTES <= numBytes) {
+            juce::int32 eventHeader[2];
+            std::memcpy(eventHeader, source + numBytesRead, MIDI_EVENT_HEADER_BYTES);
+            numBytesRead += MIDI_EVENT_HEADER_BYTES;
+
+            if (eventHeader[1] <= 0 || numBytesRead + eventHeader[1] > numBytes) {
+                break;
+            }
+
+            midiMessages.addEvent(source + numBytesRead, eventHeader[1], eventHeader[0]);
+            numBytesRead += eventHeader[1];
+        }
+    }
+
+    size_t SharedAudioBlock::_getRequiredSize(int numChannels, int maxBlockSize, int numParameters) {
+        return alignSize(sizeof(SharedHeader)) +
+               2 * alignSize(sizeof(float) * numChannels * maxBlockSize) +
+               2 * alignSize(sizeof(float) * numParameters) +
+               2 * alignSize(MAX_MIDI_BYTES);
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Shared between Syndicate and the plugin host server, which runs sandboxed guest plugins in a
+ * separate process.
+ *
+ * Setup requests (loading, layouts, state) are sent as messages over the ChildProcessMaster/Slave
+ * connection. Audio, MIDI and parameter values are exchanged every block through a memory mapped
+ * file, with sequence counters in the file to signal when a block is ready.
+ */
+namespace Sandbox {
+    enum class MESSAGE_TYPE : juce::int32 {
+        LOAD_PLUGIN,
+        SET_LAYOUT,
+        PREPARE,
+        RELEASE,
+        RESET,
+        GET_STATE,
+        SET_STATE
+    };
+
+    // Space reserved for each block's MIDI in each direction, events which don't fit are dropped
+    constexpr int MAX_MIDI_BYTES {16384};
+
+    // The guest's text for each parameter is sent for at most this many evenly spaced values
+    constexpr int MAX_PARAMETER_TEXTS {101};
+
+    /**
+     * Creates a message with the given type and request ID, followed by the payload.
+     */
+    juce::MemoryBlock createMessage(MESSAGE_TYPE type, juce::int32 requestId, const juce::MemoryBlock& payload);
+
+    /**
+     * Reads the type, request ID and payload from a message created by createMessage().
+     */
+    void parseMessage(const juce::MemoryBlock& message, MESSAGE_TYPE& type, juce::int32& requestId, juce::MemoryBlock& payload);
+
+    void writeLayout(juce::MemoryOutputStream& stream, const juce::AudioProcessor::BusesLayout& layout);
+    juce::AudioProcessor::BusesLayout readLayout(juce::MemoryInputStream& stream);
+
+    void writeMemoryBlock(juce::MemoryOutputStream& stream, const juce::MemoryBlock& block);
+    juce::MemoryBlock readMemoryBlock(juce::MemoryInputStream& stream);
+
+    /**
+     * Sits at the start of the shared file.
+     */
+    struct SharedHeader {
+        // Incremented by Syndicate once a new input block has been written
+        std::atomic<juce::uint32> inputSequence;
+
+        // Set to the input sequence by the server once that block's output has been written
+        std::atomic<juce::uint32> outputSequence;
+
+        // Written by Syndicate with each input block
+        juce::int32 numSamples;
+        juce::int32 numInputMidiBytes;
+
+        // Written by the server with each output block
+        juce::int32 numOutputMidiBytes;
+        juce::int32 latencySamples;
+    };
+
+    /**
+     * Maps the file used to exchange blocks and provides access to each region of it.
+     */
+    class SharedAudioBlock {
+    public:
+        SharedAudioBlock(const juce::File& file, int numChannels, int maxBlockSize, int numParameters);
+        ~SharedAudioBlock() = default;
+
+        /**
+         * Creates a zeroed file big enough for the given sizes, should be called by Syndicate
+         * before either process maps it.
+         */
+        static bool createFile(const juce::File& file, int numChannels, int maxBlockSize, int numParameters);
+
+        bool isValid() const { return _header != nullptr; }
+
+        int getNumChannels() const { return _numChannels; }
+        int getMaxBlockSize() const { return _maxBlockSize; }
+        int getNumParameters() const { return _numParameters; }
+
+        SharedHeader* getHeader() { return _header; }
+        float* getInputChannel(int channel) { return _inputAudio + channel * _maxBlockSize; }
+        float* getOutputChannel(int channel) { return _outputAudio + channel * _maxBlockSize; }
+        float* getInputParameters() { return _inputParameters; }
+        float* getOutputParameters() { return _outputParameters; }
+        juce::uint8* getInputMidi() { return _inputMidi; }
+        juce::uint8* getOutputMidi() { return _outputMidi; }
+
+        /**
+         * Writes the events to the given MIDI region, returns the number of bytes used.
+         */
+        static int writeMidi(const juce::MidiBuffer& midiMessages, juce::uint8* destination);
+
+        /**
+         * Adds the events in the given MIDI region to the buffer.
+         */
+        static void readMidi(const juce::uint8* source, int numBytes, juce::MidiBuffer& midiMessages);
+
+    private:
+        std::unique_ptr<juce::MemoryMappedFile> _file;
+        const int _numChannels;
+        const int _maxBlockSize;
+        const int _numParameters;
+
+        SharedHeader* _header;
+        float* _inputAudio;
+        float* _outputAudio;
+        float* _inputParameters;
+        float* _outputParameters;
+        juce::uint8* _inputMidi;
+        juce::uint8* _outputMidi;
+
+        static size_t _getRequiredSize(int numChannels, int maxBlockSize, int numParameters);
+    };
+}
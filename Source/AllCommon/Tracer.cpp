@@ -0,0 +1,297 @@
+#include "Tracer.h"
+
+#include <cstring>
+
+#if JUCE_WINDOWS
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace {
+    /**
+     * Holds the calling thread's buffer, and returns it to the tracer when the thread exits.
+     */
+    struct ThreadBufferClaim {
+        void* buffer {nullptr};
+        std::atomic<bool>* isClaimed {nullptr};
+
+        ~ThreadBufferClaim() {
+            if (isClaimed != nullptr) {
+                isClaimed->store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local ThreadBufferClaim currentThreadClaim;
+
+    int getProcessId() {
+#if JUCE_WINDOWS
+        return _getpid();
+#else
+        return static_cast<int>(getpid());
+#endif
+    }
+
+    juce::String ticksToMicroseconds(juce::int64 ticks) {
+        return juce::String(juce::Time::highResolutionTicksToSeconds(ticks) * 1000000.0, 3);
+    }
+}
+
+Tracer::Scope::Scope(const char* name, const char* category, const char* argName, int argValue) :
+        _name(name),
+        _category(category),
+        _hasBegun(Tracer::getInstance().isEnabled()) {
+    if (_hasBegun) {
+        Tracer::getInstance()._record(_name, _category, argName, argValue, 'B');
+    }
+}
+
+Tracer::Scope::~Scope() {
+    // Always end what was begun, even if tracing has stopped since, so the events stay balanced
+    if (_hasBegun) {
+        Tracer::getInstance()._record(_name, _category, nullptr, 0, 'E');
+    }
+}
+
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::Tracer() : _isEnabled(false),
+                   _generation(0),
+                   _isExporting(false),
+                   _numAllocatedBuffers(0),
+                   _numUnbufferedEvents(0) {
+}
+
+bool Tracer::start(const juce::String& processName) {
+    const juce::ScopedLock lock(_controlMutex);
+
+    // Restarting would have the threads overwrite the events being exported
+    if (_isExporting) {
+        juce::Logger::writeToLog("Tracer::start: Can't start while a trace is being exported");
+        return false;
+    }
+
+    juce::Logger::writeToLog("Starting trace");
+
+    _processName = processName;
+
+    // Allocate the buffers now, so threads recording their first event don't need to
+    const juce::uint32 generation {_generation.load()};
+
+    int numClaimedBuffers {0};
+    for (int index {0}; index < _numAllocatedBuffers.load(); index++) {
+        if (_buffers[index]->isClaimed.load()) {
+            numClaimedBuffers++;
+        }
+    }
+
+    const int numBuffersNeeded {
+        std::min(numClaimedBuffers + juce::SystemStats::getNumCpus() + NUM_SPARE_BUFFERS, MAX_THREADS)
+    };
+
+    for (int index {_numAllocatedBuffers.load()}; index < numBuffersNeeded; index++) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->threadNumber = index + 1;
+        buffer->isClaimed = false;
+        std::memset(buffer->threadName, 0, sizeof(buffer->threadName));
+        buffer->generation = generation;
+        buffer->numEvents = 0;
+        buffer->numDropped = 0;
+        buffer->events.reset(new Event[MAX_EVENTS_PER_THREAD]);
+
+        _buffers[index] = std::move(buffer);
+        _numAllocatedBuffers.store(index + 1, std::memory_order_release);
+    }
+
+    _numUnbufferedEvents = 0;
+
+    // Each thread clears its own buffer the next time it records
+    _generation++;
+    _isEnabled = true;
+
+    return true;
+}
+
+bool Tracer::stopAndExport(const juce::File& file) {
+    std::vector<std::pair<const ThreadBuffer*, int>> buffers;
+    juce::String processName;
+    int numUnbufferedEvents {0};
+
+    {
+        // Only take what's needed to write the file, it's written without the lock
+        const juce::ScopedLock lock(_controlMutex);
+        _isEnabled = false;
+        _isExporting = true;
+
+        const juce::uint32 generation {_generation.load()};
+        processName = _processName;
+        numUnbufferedEvents = _numUnbufferedEvents.load();
+
+        const int numAllocatedBuffers {_numAllocatedBuffers.load()};
+        for (int index {0}; index < numAllocatedBuffers; index++) {
+            const ThreadBuffer* buffer {_buffers[index].get()};
+
+            // Skip threads that haven't recorded anything since tracing started, this includes
+            // buffers that haven't been claimed. Events recorded by threads that are still running
+            // will be after the count taken here, so they're left out.
+            if (buffer->generation.load(std::memory_order_acquire) == generation) {
+                buffers.emplace_back(buffer, buffer->numEvents.load(std::memory_order_acquire));
+            }
+        }
+    }
+
+    const bool retVal {_writeTrace(file, processName, buffers, numUnbufferedEvents)};
+
+    {
+        const juce::ScopedLock lock(_controlMutex);
+        _isExporting = false;
+    }
+
+    return retVal;
+}
+
+bool Tracer::_writeTrace(const juce::File& file,
+                         const juce::String& processName,
+                         const std::vector<std::pair<const ThreadBuffer*, int>>& buffers,
+                         int numUnbufferedEvents) const {
+    const int processId {getProcessId()};
+
+    juce::Logger::writeToLog("Exporting trace to " + file.getFullPathName());
+
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+
+    juce::FileOutputStream stream(file);
+    if (!stream.openedOk()) {
+        juce::Logger::writeToLog("Failed to open trace file");
+        return false;
+    }
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << processId
+           << ",\"args\":{\"name\":" << juce::JSON::toString(processName) << "}}";
+
+    int numEvents {0};
+    int numDropped {numUnbufferedEvents};
+
+    for (const auto& [buffer, bufferNumEvents] : buffers) {
+        const juce::String threadName {
+            buffer->threadName[0] != '\0' ?
+                juce::String::fromUTF8(buffer->threadName) :
+                "Thread " + juce::String(buffer->threadNumber)  // Usually the host's audio thread
+        };
+
+        stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << processId
+               << ",\"tid\":" << buffer->threadNumber
+               << ",\"args\":{\"name\":" << juce::JSON::toString(threadName) << "}}";
+
+        for (int index {0}; index < bufferNumEvents; index++) {
+            const Event& event = buffer->events[index];
+
+            stream << ",\n{\"name\":\"" << event.name
+                   << "\",\"cat\":\"" << event.category
+                   << "\",\"ph\":\"" << juce::String::charToString(event.phase)
+                   << "\",\"ts\":" << ticksToMicroseconds(event.ticks)
+                   << ",\"pid\":" << processId
+                   << ",\"tid\":" << buffer->threadNumber;
+
+            if (event.argName != nullptr) {
+                stream << ",\"args\":{\"" << event.argName << "\":" << event.argValue << "}";
+            }
+
+            stream << "}";
+        }
+
+        numEvents += bufferNumEvents;
+        numDropped += buffer->numDropped.load(std::memory_order_relaxed);
+    }
+
+    stream << "\n]}\n";
+    stream.flush();
+
+    juce::Logger::writeToLog("Exported " + juce::String(numEvents) + " trace events, " + juce::String(numDropped) + " dropped");
+
+    return stream.getStatus().wasOk();
+}
+
+void Tracer::_record(const char* name, const char* category, const char* argName, int argValue, char phase) {
+    ThreadBuffer* buffer {_getThreadBuffer()};
+    if (buffer == nullptr) {
+        _numUnbufferedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const juce::uint32 generation {_generation.load(std::memory_order_relaxed)};
+    if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+        // Tracing has restarted since this thread last recorded
+        buffer->numEvents.store(0, std::memory_order_relaxed);
+        buffer->numDropped.store(0, std::memory_order_relaxed);
+        buffer->generation.store(generation, std::memory_order_release);
+    }
+
+    const int eventIndex {buffer->numEvents.load(std::memory_order_relaxed)};
+    if (eventIndex >= MAX_EVENTS_PER_THREAD) {
+        buffer->numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[eventIndex] = {name, category, argName, argValue, phase, juce::Time::getHighResolutionTicks()};
+
+    // Publish the event to the exporter
+    buffer->numEvents.store(eventIndex + 1, std::memory_order_release);
+}
+
+Tracer::ThreadBuffer* Tracer::_getThreadBuffer() {
+    if (currentThreadClaim.buffer == nullptr) {
+        // Claiming a buffer renames it, which mustn't happen while it's being exported
+        if (!isEnabled()) {
+            return nullptr;
+        }
+
+        // First event on this thread, claim a free buffer start() allocated without allocating or
+        // locking. A buffer returned by a thread which recorded into it during this trace is left
+        // alone, so its events can still be exported.
+        const juce::uint32 generation {_generation.load(std::memory_order_relaxed)};
+        const int numAllocatedBuffers {_numAllocatedBuffers.load(std::memory_order_acquire)};
+        ThreadBuffer* buffer {nullptr};
+
+        for (int index {0}; index < numAllocatedBuffers && buffer == nullptr; index++) {
+            ThreadBuffer* candidate {_buffers[index].get()};
+
+            if (candidate->generation.load(std::memory_order_acquire) == generation &&
+                    candidate->numEvents.load(std::memory_order_relaxed) > 0) {
+                continue;
+            }
+
+            bool expected {false};
+            if (candidate->isClaimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                buffer = candidate;
+            }
+        }
+
+        if (buffer == nullptr) {
+            // Try again next time, tracing may have been restarted with more buffers
+            return nullptr;
+        }
+
+        // Copied into the buffer's own storage so naming the thread doesn't allocate either. The
+        // exporter only reads it once the thread has recorded an event.
+        std::memset(buffer->threadName, 0, sizeof(buffer->threadName));
+
+        if (juce::MessageManager::getInstanceWithoutCreating() != nullptr &&
+                juce::MessageManager::getInstanceWithoutCreating()->isThisTheMessageThread()) {
+            std::strncpy(buffer->threadName, "Message thread", sizeof(buffer->threadName) - 1);
+        } else if (juce::Thread* thread = juce::Thread::getCurrentThread()) {
+            thread->getThreadName().copyToUTF8(buffer->threadName, sizeof(buffer->threadName));
+        }
+
+        currentThreadClaim.buffer = buffer;
+        currentThreadClaim.isClaimed = &buffer->isClaimed;
+    }
+
+    return static_cast<ThreadBuffer*>(currentThreadClaim.buffer);
+}
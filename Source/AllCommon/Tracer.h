@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <JuceHeader.h>
+
+/**
+ * Records begin and end events from any thread while tracing is enabled, and exports them in the
+ * Chrome trace event format which can be loaded by Perfetto or chrome://tracing.
+ *
+ * There's one tracer per process. Each thread records into its own buffer, which it claims the
+ * first time it records an event and is only ever written by that thread, so recording doesn't
+ * need any locks. A thread's buffer is returned when the thread exits, so threads that come and go
+ * don't use up the buffers, but isn't claimed by another thread until the events recorded into it
+ * have been exported.
+ *
+ * Buffers are allocated by start() rather than by the recording thread, so the audio thread never
+ * allocates. A buffer that fills up drops any further events until tracing is restarted, and a
+ * thread that starts recording when no buffer is free drops all of its events.
+ *
+ * Timestamps come from the system's monotonic clock, so traces exported by different processes
+ * on the same machine can be combined into a single timeline.
+ */
+class Tracer {
+public:
+    // About 1.3MB per buffer, a few seconds of a busy audio thread
+    static constexpr int MAX_EVENTS_PER_THREAD {1 << 15};
+
+    // Most buffers that can be allocated, each uses MAX_EVENTS_PER_THREAD events
+    static constexpr int MAX_THREADS {128};
+
+    // start() makes sure this many buffers more than the number of CPUs are free to be claimed,
+    // enough for the worker threads plus the host's and Syndicate's own threads
+    static constexpr int NUM_SPARE_BUFFERS {8};
+
+    /**
+     * Records a begin event when created and the matching end event when destroyed, if tracing
+     * is enabled.
+     *
+     * The name and category must be string literals (or otherwise outlive the trace), and
+     * mustn't contain anything that needs escaping in JSON.
+     */
+    class Scope {
+    public:
+        Scope(const char* name, const char* category, const char* argName = nullptr, int argValue = 0);
+        ~Scope();
+
+    private:
+        const char* _name;
+        const char* _category;
+        bool _hasBegun;
+    };
+
+    static Tracer& getInstance();
+
+    /**
+     * Discards any events recorded so far and starts recording. Returns false without starting if
+     * a trace is still being exported.
+     */
+    bool start(const juce::String& processName);
+
+    /**
+     * Stops recording and writes the events to the given file. Returns false if the file couldn't
+     * be written.
+     */
+    bool stopAndExport(const juce::File& file);
+
+    bool isEnabled() const { return _isEnabled.load(std::memory_order_relaxed); }
+
+private:
+    struct Event {
+        const char* name;
+        const char* category;
+        const char* argName;
+        int argValue;
+        char phase;
+        juce::int64 ticks;
+    };
+
+    struct ThreadBuffer {
+        int threadNumber;
+
+        // Set while a thread owns the buffer, cleared when the thread exits
+        std::atomic<bool> isClaimed;
+
+        // Written once when the buffer is claimed, empty if the thread has no name
+        char threadName[64];
+
+        // Events with an older generation are discarded the next time the thread records
+        std::atomic<juce::uint32> generation;
+
+        std::atomic<int> numEvents;
+        std::atomic<int> numDropped;
+        std::unique_ptr<Event[]> events;
+    };
+
+    std::atomic<bool> _isEnabled;
+    std::atomic<juce::uint32> _generation;
+    juce::String _processName;
+
+    // Serialises starting and exporting, recording never takes it
+    juce::CriticalSection _controlMutex;
+    bool _isExporting;
+
+    // Buffers are never deleted once allocated, a thread's buffer is reused each time tracing
+    // restarts and by other threads once it has exited. Buffers below _numAllocatedBuffers exist.
+    std::array<std::unique_ptr<ThreadBuffer>, MAX_THREADS> _buffers;
+    std::atomic<int> _numAllocatedBuffers;
+    std::atomic<int> _numUnbufferedEvents;
+
+    Tracer();
+
+    void _record(const char* name, const char* category, const char* argName, int argValue, char phase);
+
+    /**
+     * Returns the calling thread's buffer, claiming one if it hasn't already. Returns nullptr if
+     * no buffer is free.
+     */
+    ThreadBuffer* _getThreadBuffer();
+
+    /**
+     * Writes the given number of events from each buffer, called without holding any locks.
+     */
+    bool _writeTrace(const juce::File& file,
+                     const juce::String& processName,
+                     const std::vector<std::pair<const ThreadBuffer*, int>>& buffers,
+                     int numUnbufferedEvents) const;
+};
@@ -0,0 +1,375 @@
+#include "AnticipativeProcessor.h"
+
+AnticipativeProcessor::AnticipativeProcessor(ProcessCallback processCallback,
+                                             SaveStateCallback saveStateCallback,
+                                             int numStateValues) :
+        juce::Thread("Anticipative processing"),
+        _processCallback(processCallback),
+        _saveStateCallback(saveStateCallback),
+        _requestedLatencySamples(0),
+        _latencySamples(0),
+        _sampleRate(44100),
+        _maxBlockSize(0),
+        _numInputChannels(0),
+        _numOutputChannels(0),
+        _mode(MODE::REALTIME),
+        _nextBlockPosition(0),
+        _outputDeficit(0),
+        _isWorkerActive(false),
+        _isWorkerRunning(false),
+        _inputFifo(1),
+        _outputFifo(1),
+        _blockFifo(MAX_QUEUED_BLOCKS + 1),
+        _blockRecords(MAX_QUEUED_BLOCKS + 1) {
+
+    // The records are allocated up front so queueing a block never allocates
+    for (BlockRecord& record : _blockRecords) {
+        record.numSamples = 0;
+        record.position.resetToDefault();
+        record.midi.ensureSize(MIDI_BYTES_PER_BLOCK);
+        record.state.resize(numStateValues, 0);
+    }
+}
+
+AnticipativeProcessor::~AnticipativeProcessor() {
+    _isWorkerActive = false;
+    stopThread(1000);
+}
+
+void AnticipativeProcessor::setLatencySamples(int numSamples) {
+    _requestedLatencySamples = std::max(numSamples, 0);
+    _reconfigure();
+}
+
+void AnticipativeProcessor::prepare(double sampleRate, int maxBlockSize, int numInputChannels, int numOutputChannels) {
+    {
+        WECore::AudioSpinLock lock(_configMutex);
+        _sampleRate = sampleRate;
+        _maxBlockSize = maxBlockSize;
+        _numInputChannels = numInputChannels;
+        _numOutputChannels = numOutputChannels;
+    }
+
+    _reconfigure();
+}
+
+void AnticipativeProcessor::process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, juce::AudioPlayHead* playHead) {
+    WECore::AudioSpinTryLock lock(_configMutex);
+
+    if (!lock.isLocked()) {
+        // Being reconfigured, the worker may still be finishing a block so the graph can't be
+        // processed here
+        buffer.clear();
+        return;
+    }
+
+    if (_latencySamples == 0) {
+        // Disabled, process as normal
+        _processCallback(buffer, midiMessages, playHead, nullptr);
+        return;
+    }
+
+    juce::AudioPlayHead::CurrentPositionInfo position;
+    if (playHead == nullptr || !playHead->getCurrentPosition(position)) {
+        position.resetToDefault();
+    }
+
+    const int numSamples {buffer.getNumSamples()};
+    const bool shouldAnticipate {_shouldAnticipate(position, numSamples) && _canQueueBlock(numSamples)};
+
+    if (_mode == MODE::ANTICIPATIVE && !shouldAnticipate) {
+        // Stop the worker, the input FIFO can't be touched until it's finished its current block
+        _isWorkerActive = false;
+        _mode = MODE::STOPPING_WORKER;
+    }
+
+    if (_mode == MODE::STOPPING_WORKER) {
+        if (_isWorkerRunning) {
+            // The graph can't be processed here until the worker has finished with it, so play
+            // what it's already processed
+            _readOutput(buffer);
+            return;
+        }
+
+        _resyncOutput();
+        _mode = MODE::REALTIME;
+    }
+
+    if (_mode == MODE::REALTIME && shouldAnticipate) {
+        _startWorker();
+    }
+
+    if (_mode == MODE::ANTICIPATIVE) {
+        _processAnticipative(buffer, midiMessages, position);
+    } else {
+        _processRealtime(buffer, midiMessages, playHead);
+    }
+}
+
+void AnticipativeProcessor::run() {
+    while (!threadShouldExit()) {
+        // The audio thread checks _isWorkerRunning after clearing _isWorkerActive, so set it
+        // before checking
+        _isWorkerRunning = true;
+
+        if (_isWorkerActive) {
+            _processWorkerBlocks();
+        }
+
+        _isWorkerRunning = false;
+
+        // The audio thread notifies after every block it queues, so only poll while active
+        wait(_isWorkerActive ? WORKER_WAIT_MS : -1);
+    }
+}
+
+void AnticipativeProcessor::_reconfigure() {
+    {
+        WECore::AudioSpinLock lock(_configMutex);
+        _allocate();
+    }
+
+    if (_latencySamples > 0) {
+        startThread(8);
+    } else {
+        stopThread(1000);
+    }
+}
+
+void AnticipativeProcessor::_allocate() {
+    // Make sure the worker isn't touching anything before reallocating
+    _isWorkerActive = false;
+    while (_isWorkerRunning) {
+        juce::Thread::sleep(1);
+    }
+
+    // The worker can't process a block until the callback it arrives in, so it needs at least the
+    // maximum block size to have its output ready in time
+    _latencySamples = _requestedLatencySamples > 0 ? std::max(_requestedLatencySamples.load(), _maxBlockSize) : 0;
+
+    // Leave room for the blocks either side of the latency
+    const int fifoSize {_latencySamples + 2 * _maxBlockSize + 1};
+
+    _inputFifo.setTotalSize(fifoSize);
+    _inputFifoBuffer.setSize(_numInputChannels, fifoSize);
+    _outputFifo.setTotalSize(fifoSize);
+    _outputFifoBuffer.setSize(_numOutputChannels, fifoSize);
+    _workerBuffer.setSize(_numInputChannels, _maxBlockSize);
+
+    _resetFifos();
+    _mode = MODE::REALTIME;
+}
+
+void AnticipativeProcessor::_resetFifos() {
+    _inputFifo.reset();
+    _blockFifo.reset();
+    _outputFifo.reset();
+    _outputDeficit = 0;
+
+    // Prime the output with the latency, so each block is read back that much later than it's
+    // written
+    _writeSilenceToFifo(_outputFifo, _outputFifoBuffer, _latencySamples);
+}
+
+bool AnticipativeProcessor::_shouldAnticipate(const juce::AudioPlayHead::CurrentPositionInfo& position, int numSamples) {
+    // While stopped or recording the input may be live
+    bool retVal {position.isPlaying && !position.isRecording};
+
+    // Anything buffered after a jump is from the wrong place in the timeline
+    if (position.timeInSamples != _nextBlockPosition) {
+        retVal = false;
+    }
+
+    _nextBlockPosition = position.timeInSamples + numSamples;
+
+    return retVal;
+}
+
+bool AnticipativeProcessor::_canQueueBlock(int numSamples) const {
+    // If either FIFO is full the worker has fallen too far behind to catch up
+    return numSamples <= _maxBlockSize
+        && _inputFifo.getFreeSpace() >= numSamples
+        && _blockFifo.getFreeSpace() > 0;
+}
+
+void AnticipativeProcessor::_startWorker() {
+    // The output FIFO already holds the latency's worth of delayed realtime output, which is
+    // played while the worker processes its first blocks
+    _inputFifo.reset();
+    _blockFifo.reset();
+    _outputDeficit = 0;
+
+    _mode = MODE::ANTICIPATIVE;
+    _isWorkerActive = true;
+}
+
+void AnticipativeProcessor::_resyncOutput() {
+    // Drop anything the worker delivered too late
+    _skipFifo(_outputFifo, std::min(_outputDeficit, _outputFifo.getNumReady()));
+    _outputDeficit = 0;
+
+    // The blocks the worker hadn't processed yet are lost, so fill their place with silence to
+    // bring the output back to the latency
+    const int numReady {_outputFifo.getNumReady()};
+    if (numReady < _latencySamples) {
+        _writeSilenceToFifo(_outputFifo, _outputFifoBuffer, _latencySamples - numReady);
+    } else if (numReady > _latencySamples) {
+        _skipFifo(_outputFifo, numReady - _latencySamples);
+    }
+}
+
+void AnticipativeProcessor::_processRealtime(juce::AudioBuffer<float>& buffer,
+                                             juce::MidiBuffer& midiMessages,
+                                             juce::AudioPlayHead* playHead) {
+    _processCallback(buffer, midiMessages, playHead, nullptr);
+
+    // Still delay the output so it's aligned with the reported latency
+    const int numChannels {std::min(buffer.getNumChannels(), _numOutputChannels)};
+    _writeToFifo(_outputFifo, _outputFifoBuffer, buffer, numChannels, buffer.getNumSamples());
+    _readFromFifo(_outputFifo, _outputFifoBuffer, buffer, numChannels, buffer.getNumSamples());
+}
+
+void AnticipativeProcessor::_processAnticipative(juce::AudioBuffer<float>& buffer,
+                                                 const juce::MidiBuffer& midiMessages,
+                                                 const juce::AudioPlayHead::CurrentPositionInfo& position) {
+    _queueBlock(buffer, midiMessages, position);
+    notify();
+
+    _readOutput(buffer);
+}
+
+void AnticipativeProcessor::_queueBlock(const juce::AudioBuffer<float>& buffer,
+                                        const juce::MidiBuffer& midiMessages,
+                                        const juce::AudioPlayHead::CurrentPositionInfo& position) {
+    int start1, size1, start2, size2;
+    _blockFifo.prepareToWrite(1, start1, size1, start2, size2);
+    BlockRecord& record = _blockRecords[start1];
+
+    record.numSamples = buffer.getNumSamples();
+    record.position = position;
+
+    // Don't grow the preallocated buffer, anything beyond it is dropped
+    record.midi.clear();
+    for (const juce::MidiMessageMetadata metadata : midiMessages) {
+        const int numBytesNeeded {static_cast<int>(sizeof(juce::int32) + sizeof(juce::uint16)) + metadata.numBytes};
+        if (record.midi.data.size() + numBytesNeeded > MIDI_BYTES_PER_BLOCK) {
+            break;
+        }
+
+        record.midi.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition);
+    }
+
+    _saveStateCallback(record.state);
+
+    // The audio is written first so it's there by the time the worker sees the record
+    const int numInputChannels {std::min(buffer.getNumChannels(), _numInputChannels)};
+    _writeToFifo(_inputFifo, _inputFifoBuffer, buffer, numInputChannels, record.numSamples);
+
+    _blockFifo.finishedWrite(size1 + size2);
+}
+
+void AnticipativeProcessor::_readOutput(juce::AudioBuffer<float>& buffer) {
+    const int numSamples {buffer.getNumSamples()};
+
+    // Drop whatever the worker delivered after it was needed, so the output stays aligned
+    const int numLateSamples {std::min(_outputDeficit, _outputFifo.getNumReady())};
+    _skipFifo(_outputFifo, numLateSamples);
+    _outputDeficit -= numLateSamples;
+
+    // If the worker hasn't kept up the rest of the buffer will be silent
+    const int numOutputChannels {std::min(buffer.getNumChannels(), _numOutputChannels)};
+    buffer.clear();
+    const int numSamplesRead {_readFromFifo(_outputFifo, _outputFifoBuffer, buffer, numOutputChannels, numSamples)};
+    _outputDeficit += numSamples - numSamplesRead;
+}
+
+void AnticipativeProcessor::_processWorkerBlocks() {
+    while (_isWorkerActive && !threadShouldExit()) {
+        if (_blockFifo.getNumReady() == 0) {
+            break;
+        }
+
+        int start1, size1, start2, size2;
+        _blockFifo.prepareToRead(1, start1, size1, start2, size2);
+        BlockRecord& record = _blockRecords[start1];
+
+        if (_outputFifo.getFreeSpace() < record.numSamples) {
+            break;
+        }
+
+        juce::AudioBuffer<float> block(_workerBuffer.getArrayOfWritePointers(), _numInputChannels, record.numSamples);
+        _readFromFifo(_inputFifo, _inputFifoBuffer, block, _numInputChannels, record.numSamples);
+
+        _workerPlayHead.position = record.position;
+        _processCallback(block, record.midi, &_workerPlayHead, &record.state);
+
+        _writeToFifo(_outputFifo, _outputFifoBuffer, block, std::min(_numInputChannels, _numOutputChannels), record.numSamples);
+
+        _blockFifo.finishedRead(size1 + size2);
+    }
+}
+
+void AnticipativeProcessor::_writeToFifo(juce::AbstractFifo& fifo,
+                                         juce::AudioBuffer<float>& fifoBuffer,
+                                         const juce::AudioBuffer<float>& source,
+                                         int numChannels,
+                                         int numSamples) {
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    for (int channel {0}; channel < numChannels; channel++) {
+        if (size1 > 0) {
+            fifoBuffer.copyFrom(channel, start1, source, channel, 0, size1);
+        }
+
+        if (size2 > 0) {
+            fifoBuffer.copyFrom(channel, start2, source, channel, size1, size2);
+        }
+    }
+
+    fifo.finishedWrite(size1 + size2);
+}
+
+void AnticipativeProcessor::_writeSilenceToFifo(juce::AbstractFifo& fifo, juce::AudioBuffer<float>& fifoBuffer, int numSamples) {
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    if (size1 > 0) {
+        fifoBuffer.clear(start1, size1);
+    }
+
+    if (size2 > 0) {
+        fifoBuffer.clear(start2, size2);
+    }
+
+    fifo.finishedWrite(size1 + size2);
+}
+
+int AnticipativeProcessor::_readFromFifo(juce::AbstractFifo& fifo,
+                                         const juce::AudioBuffer<float>& fifoBuffer,
+                                         juce::AudioBuffer<float>& dest,
+                                         int numChannels,
+                                         int numSamples) {
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(numSamples, start1, size1, start2, size2);
+
+    for (int channel {0}; channel < numChannels; channel++) {
+        if (size1 > 0) {
+            dest.copyFrom(channel, 0, fifoBuffer, channel, start1, size1);
+        }
+
+        if (size2 > 0) {
+            dest.copyFrom(channel, size1, fifoBuffer, channel, start2, size2);
+        }
+    }
+
+    fifo.finishedRead(size1 + size2);
+
+    return size1 + size2;
+}
+
+void AnticipativeProcessor::_skipFifo(juce::AbstractFifo& fifo, int numSamples) {
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(numSamples, start1, size1, start2, size2);
+    fifo.finishedRead(size1 + size2);
+}
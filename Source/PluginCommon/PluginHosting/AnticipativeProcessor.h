@@ -0,0 +1,177 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "General/AudioSpinMutex.h"
+#include "PositionPlayHead.h"
+
+/**
+ * Runs the processing graph on a worker thread ahead of the host's audio callback.
+ *
+ * Input is pushed into a FIFO and processed by the worker, and the audio callback reads the output
+ * back from a second FIFO which is primed with the anticipative latency. This gives the worker
+ * that much slack before the callback needs its output, so heavy chains aren't limited by the
+ * host's buffer deadline. The latency must be reported to the host.
+ *
+ * Each block is queued with its MIDI, playhead position and the values of the modulation sources
+ * when it arrived, so the worker processes it exactly as the audio callback would have. The latency
+ * is never less than the host's maximum block size, as the worker can't start on a block before the
+ * callback has given it to it.
+ *
+ * The graph is processed in the audio callback as normal (but still delayed by the same latency,
+ * so it stays aligned) while the transport is stopped or recording, since the input may be live,
+ * and for one block after the transport jumps or if the worker falls too far behind. Output the
+ * worker delivers late is dropped, so the output never drifts from the reported latency.
+ *
+ * The worker thread is only running while anticipative processing is enabled.
+ */
+class AnticipativeProcessor : public juce::Thread {
+public:
+    /**
+     * Processes a block. The state is what the save state callback stored when a queued block
+     * arrived, or nullptr when the block is processed in the audio callback and the live state
+     * should be used.
+     */
+    typedef std::function<void(juce::AudioBuffer<float>&, juce::MidiBuffer&, juce::AudioPlayHead*, const std::vector<float>*)> ProcessCallback;
+
+    /**
+     * Called on the audio thread to store any state the worker will need to process a queued block
+     * the same way it would have been processed in the audio callback. The vector is preallocated
+     * with numStateValues values.
+     */
+    typedef std::function<void(std::vector<float>&)> SaveStateCallback;
+
+    AnticipativeProcessor(ProcessCallback processCallback, SaveStateCallback saveStateCallback, int numStateValues);
+    ~AnticipativeProcessor();
+
+    /**
+     * Sets the latency that is added to give the worker its slack, 0 disables anticipative
+     * processing.
+     */
+    void setLatencySamples(int numSamples);
+
+    /**
+     * @see setLatencySamples
+     */
+    int getRequestedLatencySamples() const { return _requestedLatencySamples; }
+
+    /**
+     * Returns the latency added by this processor, which should be added to the latency reported
+     * to the host. This may be more than was requested if the host's blocks are bigger.
+     */
+    int getLatencySamples() const { return _latencySamples; }
+
+    /**
+     * Allocates the FIFOs. Must be called before processing and whenever the configuration
+     * changes.
+     */
+    void prepare(double sampleRate, int maxBlockSize, int numInputChannels, int numOutputChannels);
+
+    /**
+     * Processes the buffer, either by passing it to the worker and returning its output from an
+     * earlier block, or by processing it on this thread.
+     */
+    void process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, juce::AudioPlayHead* playHead);
+
+    // Thread methods
+    void run() override;
+
+private:
+    enum class MODE {
+        REALTIME,
+        ANTICIPATIVE,
+        STOPPING_WORKER
+    };
+
+    static constexpr int WORKER_WAIT_MS {2};
+    static constexpr int MAX_QUEUED_BLOCKS {1024};
+    static constexpr int MIDI_BYTES_PER_BLOCK {2048};
+
+    // Everything about a queued block other than its audio, which is in the input FIFO
+    struct BlockRecord {
+        int numSamples;
+        juce::AudioPlayHead::CurrentPositionInfo position;
+        juce::MidiBuffer midi;
+        std::vector<float> state;
+    };
+
+    ProcessCallback _processCallback;
+    SaveStateCallback _saveStateCallback;
+
+    // Held while the FIFOs are reallocated
+    WECore::AudioSpinMutex _configMutex;
+
+    std::atomic<int> _requestedLatencySamples;
+    std::atomic<int> _latencySamples;
+    double _sampleRate;
+    int _maxBlockSize;
+    int _numInputChannels;
+    int _numOutputChannels;
+
+    // Audio thread state
+    MODE _mode;
+    juce::int64 _nextBlockPosition;
+
+    // Number of samples the worker's output is behind where it should be, this many samples are
+    // dropped when it catches up
+    int _outputDeficit;
+
+    // Set by the audio thread to let the worker process
+    std::atomic<bool> _isWorkerActive;
+
+    // Set by the worker while it may be touching the FIFOs
+    std::atomic<bool> _isWorkerRunning;
+
+    juce::AbstractFifo _inputFifo;
+    juce::AudioBuffer<float> _inputFifoBuffer;
+    juce::AbstractFifo _outputFifo;
+    juce::AudioBuffer<float> _outputFifoBuffer;
+
+    // Preallocated records of the blocks in the input FIFO
+    juce::AbstractFifo _blockFifo;
+    std::vector<BlockRecord> _blockRecords;
+
+    // Used by the worker to process a block from the input FIFO
+    juce::AudioBuffer<float> _workerBuffer;
+    // The host's playhead can only be used during its audio callback, so the worker uses this to
+    // report the position of the block it's processing instead
+    PositionPlayHead _workerPlayHead;
+
+    /**
+     * Reallocates for the current configuration and starts or stops the worker thread.
+     */
+    void _reconfigure();
+
+    void _allocate();
+    void _resetFifos();
+    bool _shouldAnticipate(const juce::AudioPlayHead::CurrentPositionInfo& position, int numSamples);
+    bool _canQueueBlock(int numSamples) const;
+    void _startWorker();
+    void _resyncOutput();
+    void _processRealtime(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, juce::AudioPlayHead* playHead);
+    void _processAnticipative(juce::AudioBuffer<float>& buffer,
+                              const juce::MidiBuffer& midiMessages,
+                              const juce::AudioPlayHead::CurrentPositionInfo& position);
+    void _queueBlock(const juce::AudioBuffer<float>& buffer,
+                     const juce::MidiBuffer& midiMessages,
+                     const juce::AudioPlayHead::CurrentPositionInfo& position);
+    void _readOutput(juce::AudioBuffer<float>& buffer);
+    void _processWorkerBlocks();
+
+    static void _writeToFifo(juce::AbstractFifo& fifo,
+                             juce::AudioBuffer<float>& fifoBuffer,
+                             const juce::AudioBuffer<float>& source,
+                             int numChannels,
+                             int numSamples);
+    static void _writeSilenceToFifo(juce::AbstractFifo& fifo, juce::AudioBuffer<float>& fifoBuffer, int numSamples);
+
+    /**
+     * Returns the number of samples read, which is less than requested if not enough are ready.
+     */
+    static int _readFromFifo(juce::AbstractFifo& fifo,
+                             const juce::AudioBuffer<float>& fifoBuffer,
+                             juce::AudioBuffer<float>& dest,
+                             int numChannels,
+                             int numSamples);
+    static void _skipFifo(juce::AbstractFifo& fifo, int numSamples);
+};
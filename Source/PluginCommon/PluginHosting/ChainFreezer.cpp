@@ -0,0 +1,287 @@
+#include "ChainFreezer.h"
+#include "AllUtils.h"
+
+namespace {
+    const char* XML_FREEZER_START_SAMPLE_STR {"StartSample"};
+    const char* XML_FREEZER_FILE_STR {"File"};
+    const char* XML_FREEZER_HASH_STR {"Hash"};
+
+    const char* FREEZER_DIRECTORY_NAME {"FrozenChains"};
+
+    // Touching one sample in every this many makes sure every page of a stereo float recording is
+    // loaded
+    constexpr int TOUCH_INTERVAL_SAMPLES {256};
+
+    /**
+     * FNV-1a hash of the file's contents, so a restored state can tell if the recording it refers
+     * to has been replaced.
+     */
+    juce::String hashFile(const juce::File& file) {
+        juce::FileInputStream stream(file);
+        if (!stream.openedOk()) {
+            return {};
+        }
+
+        juce::uint64 hash {14695981039346656037ull};
+        juce::HeapBlock<juce::uint8> chunk(1 << 16);
+
+        while (!stream.isExhausted()) {
+            const int numBytesRead {stream.read(chunk.get(), 1 << 16)};
+            if (numBytesRead <= 0) {
+                break;
+            }
+
+            for (int index {0}; index < numBytesRead; index++) {
+                hash = (hash ^ chunk[index]) * 1099511628211ull;
+            }
+        }
+
+        return juce::String::toHexString(static_cast<juce::int64>(hash));
+    }
+}
+
+ChainFreezer::ChainFreezer(juce::File file, double sampleRate) :
+        _file(file),
+        _writerThread("Chain freeze writer"),
+        _sampleRate(sampleRate),
+        _isCapturing(true),
+        _hasCaptureStarted(false),
+        _didCaptureFail(false),
+        _nextCaptureSample(0),
+        _recordingStartSample(0) {
+}
+
+ChainFreezer::~ChainFreezer() {
+    _isCapturing = false;
+
+    // Make sure the file is released before deleting it
+    _writer.reset();
+    _writerThread.stopThread(1000);
+
+    // An unfinished recording can't be referred to by any state
+    if (_recording == nullptr && _file != juce::File()) {
+        _file.deleteFile();
+    }
+}
+
+std::unique_ptr<ChainFreezer> ChainFreezer::startCapture(double sampleRate, int maxBlockSize) {
+    const juce::File directory = Utils::DataDirectory.getChildFile(FREEZER_DIRECTORY_NAME);
+    if (!directory.createDirectory()) {
+        juce::Logger::writeToLog("ChainFreezer::startCapture: Failed to create " + directory.getFullPathName());
+        return nullptr;
+    }
+
+    const juce::File file = directory.getNonexistentChildFile("Freeze", ".wav");
+
+    std::unique_ptr<ChainFreezer> freezer(new ChainFreezer(file, sampleRate));
+    freezer->_silence.resize(std::max(maxBlockSize, 1), 0);
+
+    std::unique_ptr<juce::FileOutputStream> stream = file.createOutputStream();
+    if (stream == nullptr) {
+        juce::Logger::writeToLog("ChainFreezer::startCapture: Failed to create " + file.getFullPathName());
+        return nullptr;
+    }
+
+    // 32 bit wav files are written as floats, so there's no conversion when reading them back
+    juce::WavAudioFormat format;
+    juce::AudioFormatWriter* writer = format.createWriterFor(stream.get(), sampleRate, NUM_CHANNELS, 32, {}, 0);
+    if (writer == nullptr) {
+        juce::Logger::writeToLog("ChainFreezer::startCapture: Failed to create writer");
+        return nullptr;
+    }
+
+    // The writer owns the stream now
+    stream.release();
+
+    freezer->_writerThread.startThread();
+    freezer->_writer.reset(new juce::AudioFormatWriter::ThreadedWriter(writer, freezer->_writerThread, WRITER_BUFFER_SIZE));
+
+    juce::Logger::writeToLog("ChainFreezer::startCapture: Capturing to " + file.getFullPathName());
+    return freezer;
+}
+
+std::unique_ptr<ChainFreezer> ChainFreezer::restoreFromXml(juce::XmlElement* element) {
+    for (const char* attribute : {XML_FREEZER_FILE_STR, XML_FREEZER_HASH_STR}) {
+        if (!element->hasAttribute(attribute)) {
+            juce::Logger::writeToLog("Missing attribute " + juce::String(attribute));
+            return nullptr;
+        }
+    }
+
+    const juce::File file(element->getStringAttribute(XML_FREEZER_FILE_STR));
+    if (!file.existsAsFile()) {
+        juce::Logger::writeToLog("ChainFreezer::restoreFromXml: Missing recording " + file.getFullPathName());
+        return nullptr;
+    }
+
+    std::unique_ptr<ChainFreezer> freezer(new ChainFreezer(file, 0));
+    freezer->_isCapturing = false;
+    freezer->_hasCaptureStarted = true;
+    freezer->_recordingStartSample = element->getStringAttribute(XML_FREEZER_START_SAMPLE_STR).getLargeIntValue();
+
+    if (!freezer->_mapRecording()) {
+        // The file isn't deleted as it's not a recording this freezer made
+        freezer->_file = juce::File();
+        return nullptr;
+    }
+
+    if (freezer->_recordingHash != element->getStringAttribute(XML_FREEZER_HASH_STR)) {
+        juce::Logger::writeToLog("ChainFreezer::restoreFromXml: Recording has changed " + file.getFullPathName());
+        return nullptr;
+    }
+
+    return freezer;
+}
+
+void ChainFreezer::writeToXml(juce::XmlElement* element) {
+    if (_recording == nullptr) {
+        juce::Logger::writeToLog("ChainFreezer::writeToXml: Nothing has been recorded");
+        return;
+    }
+
+    element->setAttribute(XML_FREEZER_START_SAMPLE_STR, juce::String(_recordingStartSample));
+    element->setAttribute(XML_FREEZER_FILE_STR, _file.getFullPathName());
+    element->setAttribute(XML_FREEZER_HASH_STR, _recordingHash);
+}
+
+void ChainFreezer::captureBlock(const juce::AudioBuffer<float>& buffer,
+                                const juce::AudioPlayHead::CurrentPositionInfo& position,
+                                int compensationSamples) {
+    if (!_isCapturing) {
+        return;
+    }
+
+    if (!position.isPlaying) {
+        // Wait for the transport to start, and finish when it stops
+        if (_hasCaptureStarted) {
+            _isCapturing = false;
+        }
+
+        return;
+    }
+
+    if (!_hasCaptureStarted) {
+        // The block has already been delayed by the latency compensation, so it belongs earlier on
+        // the timeline
+        _recordingStartSample = position.timeInSamples - compensationSamples;
+        _nextCaptureSample = position.timeInSamples;
+        _hasCaptureStarted = true;
+    } else if (position.timeInSamples != _nextCaptureSample) {
+        // The transport has jumped, so the region we've captured so far is all we can use
+        _isCapturing = false;
+        return;
+    }
+
+    // The writer always takes NUM_CHANNELS channels, any the chain doesn't have are recorded as
+    // silence. This is written in pieces no longer than the silence if the host's block is bigger
+    // than it said it would be.
+    const int numChannels {std::min(buffer.getNumChannels(), NUM_CHANNELS)};
+    const int maxSamplesPerWrite {static_cast<int>(_silence.size())};
+    int numSamplesWritten {0};
+
+    while (numSamplesWritten < buffer.getNumSamples()) {
+        const int numSamplesToWrite {std::min(buffer.getNumSamples() - numSamplesWritten, maxSamplesPerWrite)};
+
+        std::array<const float*, NUM_CHANNELS> channels;
+        for (int channel {0}; channel < NUM_CHANNELS; channel++) {
+            channels[channel] = channel < numChannels ? buffer.getReadPointer(channel, numSamplesWritten) : _silence.data();
+        }
+
+        if (!_writer->write(channels.data(), numSamplesToWrite)) {
+            // The background thread isn't keeping up, the recording would have a gap in it
+            _didCaptureFail = true;
+            _isCapturing = false;
+            return;
+        }
+
+        numSamplesWritten += numSamplesToWrite;
+    }
+
+    _nextCaptureSample += buffer.getNumSamples();
+}
+
+bool ChainFreezer::finishCapture() {
+    _isCapturing = false;
+
+    // Deleting the writer flushes everything that's left to the file
+    _writer.reset();
+    _writerThread.stopThread(1000);
+
+    if (_didCaptureFail) {
+        juce::Logger::writeToLog("ChainFreezer::finishCapture: Capture failed");
+        return false;
+    }
+
+    if (!_hasCaptureStarted) {
+        juce::Logger::writeToLog("ChainFreezer::finishCapture: Nothing was captured");
+        return false;
+    }
+
+    if (!_mapRecording()) {
+        return false;
+    }
+
+    juce::Logger::writeToLog("ChainFreezer::finishCapture: Captured " + juce::String(_recording->lengthInSamples) + " samples");
+    return true;
+}
+
+void ChainFreezer::playBlock(juce::AudioBuffer<float>& buffer,
+                             const juce::AudioPlayHead::CurrentPositionInfo& position,
+                             int compensationSamples) {
+    buffer.clear();
+
+    if (_recording == nullptr || !position.isPlaying) {
+        return;
+    }
+
+    // Work out which part of this block overlaps the frozen region, once it's been delayed by the
+    // compensation the chain is currently applying
+    const juce::int64 blockStartInRecording {position.timeInSamples - compensationSamples - _recordingStartSample};
+    const juce::int64 startInRecording {std::max<juce::int64>(blockStartInRecording, 0)};
+    const juce::int64 endInRecording {
+        std::min<juce::int64>(blockStartInRecording + buffer.getNumSamples(), _recording->lengthInSamples)
+    };
+
+    if (endInRecording > startInRecording) {
+        // The recording is float data, so it's copied straight into the buffer's channels
+        const int numChannels {std::min(buffer.getNumChannels(), NUM_CHANNELS)};
+        std::array<int*, NUM_CHANNELS> channels {};
+        for (int channel {0}; channel < numChannels; channel++) {
+            channels[channel] = reinterpret_cast<int*>(buffer.getWritePointer(channel));
+        }
+
+        _recording->readSamples(channels.data(),
+                                numChannels,
+                                static_cast<int>(startInRecording - blockStartInRecording),
+                                startInRecording,
+                                static_cast<int>(endInRecording - startInRecording));
+    }
+}
+
+bool ChainFreezer::_mapRecording() {
+    juce::WavAudioFormat format;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(format.createMemoryMappedReader(_file));
+
+    if (reader == nullptr || !reader->mapEntireFile()) {
+        juce::Logger::writeToLog("ChainFreezer: Failed to map " + _file.getFullPathName());
+        return false;
+    }
+
+    if (reader->lengthInSamples <= 0 ||
+            static_cast<int>(reader->numChannels) != NUM_CHANNELS ||
+            !reader->usesFloatingPointData) {
+        juce::Logger::writeToLog("ChainFreezer: Invalid recording " + _file.getFullPathName());
+        return false;
+    }
+
+    // Load every page now, so the audio thread doesn't have to wait for them
+    for (juce::int64 sample {0}; sample < reader->lengthInSamples; sample += TOUCH_INTERVAL_SAMPLES) {
+        reader->touchSample(sample);
+    }
+
+    _recordingHash = hashFile(_file);
+    _sampleRate = reader->sampleRate;
+    _recording = std::move(reader);
+
+    return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Records the output of a chain while the host plays through the section being frozen, then plays
+ * the recording back in place of the chain.
+ *
+ * A plugin can't render the host's timeline offline, so the recording is captured during a normal
+ * pass of the transport. Capturing stops when the transport stops or jumps, and the frozen region
+ * is the section that was played.
+ *
+ * The recording is written to a file in the data directory by a background thread while capturing.
+ * Once capturing finishes the file is memory mapped for playback, and every page is touched before
+ * the recording is handed to the audio thread so it doesn't usually have to wait for the disk. The
+ * plugin state only stores the file's path and a hash of its contents.
+ *
+ * Finished recordings are never deleted, as saved projects (and the host's undo history) may still
+ * refer to them after the chain has been unfrozen.
+ *
+ * The recording is stored without the chain's latency compensation, which is applied again on
+ * playback, so it stays aligned if the latency of the other chains changes.
+ */
+class ChainFreezer {
+public:
+    ~ChainFreezer();
+
+    /**
+     * Creates a freezer which is ready to capture, or nullptr if the recording file couldn't be
+     * created.
+     */
+    static std::unique_ptr<ChainFreezer> startCapture(double sampleRate, int maxBlockSize);
+
+    /**
+     * Creates a freezer with the finished recording stored by writeToXml(), or nullptr if it
+     * couldn't be restored (eg. the file has been deleted or changed).
+     */
+    static std::unique_ptr<ChainFreezer> restoreFromXml(juce::XmlElement* element);
+
+    /**
+     * Stores where to find the finished recording.
+     */
+    void writeToXml(juce::XmlElement* element);
+
+    /**
+     * Returns true until the capture pass has finished.
+     */
+    bool isCapturing() const { return _isCapturing; }
+
+    double getSampleRate() const { return _sampleRate; }
+
+    /**
+     * Records the block if the transport is playing through the region being captured.
+     * compensationSamples is the latency compensation the chain applied to this block.
+     */
+    void captureBlock(const juce::AudioBuffer<float>& buffer,
+                      const juce::AudioPlayHead::CurrentPositionInfo& position,
+                      int compensationSamples);
+
+    /**
+     * Stops capturing and maps the recording for playback. Returns false if nothing usable was
+     * captured.
+     *
+     * Must not be called while captureBlock() may be running.
+     */
+    bool finishCapture();
+
+    /**
+     * Replaces the contents of the buffer with the recording at the given timeline position,
+     * delayed by the chain's current latency compensation, or silence outside the frozen region.
+     */
+    void playBlock(juce::AudioBuffer<float>& buffer,
+                   const juce::AudioPlayHead::CurrentPositionInfo& position,
+                   int compensationSamples);
+
+private:
+    static constexpr int NUM_CHANNELS {2};
+    static constexpr int WRITER_BUFFER_SIZE {1 << 16};
+
+    juce::File _file;
+    juce::TimeSliceThread _writerThread;
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> _writer;
+
+    // Written in place of channels the chain doesn't have, one block long
+    std::vector<float> _silence;
+
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> _recording;
+    juce::String _recordingHash;
+    double _sampleRate;
+
+    std::atomic<bool> _isCapturing;
+    bool _hasCaptureStarted;
+    bool _didCaptureFail;
+    juce::int64 _nextCaptureSample;
+
+    // Timeline position of the first sample of the recording, before latency compensation
+    juce::int64 _recordingStartSample;
+
+    ChainFreezer(juce::File file, double sampleRate);
+
+    /**
+     * Maps the recording file, returns false if it isn't a usable recording.
+     */
+    bool _mapRecording();
+};
@@ -8,29 +8,29 @@
  *
  * Ideally each ChainParameters object would be registered as a parameter (since it needs to trigger
  * updates) but since they vary with the number of bands they can't be
- * registered. Instead a callback is provided for triggering updates, and save/restore state is
- * managed by the splitter itself.
+ * registered. Instead a callback is provided for triggering updates, which is passed the object
+ * that changed, and save/restore state is managed by the splitter itself.
  */
 class ChainParameters {
 public:
-    ChainParameters(std::function<void()> onUpdateCallback) : _isBypassed(false),
+    ChainParameters(std::function<void(const ChainParameters&)> onUpdateCallback) : _isBypassed(false),
                                                               _isMuted(false),
                                                               _isSoloed(false),
                                                               _onUpdateCallback(onUpdateCallback) {}
 
     void setBypass(bool val) {
         _isBypassed = val;
-        _onUpdateCallback();
+        _onUpdateCallback(*this);
     }
 
     void setMute(bool val) {
         _isMuted = val;
-        _onUpdateCallback();
+        _onUpdateCallback(*this);
     }
 
     void setSolo(bool val) {
         _isSoloed = val;
-        _onUpdateCallback();
+        _onUpdateCallback(*this);
     }
 
     bool getBypass() const { return _isBypassed; }
@@ -42,5 +42,5 @@ private:
     bool _isMuted;
     bool _isSoloed;
 
-    std::function<void()> _onUpdateCallback;
+    std::function<void(const ChainParameters&)> _onUpdateCallback;
 };
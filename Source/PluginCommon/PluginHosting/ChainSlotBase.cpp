@@ -23,3 +23,15 @@ bool ChainSlotBase::XmlElementIsGainStage(juce::XmlElement* element) {
 
     return retVal;
 }
+
+bool ChainSlotBase::XmlElementIsSplitter(juce::XmlElement* element) {
+    bool retVal {false};
+
+    if (element->hasAttribute(XML_SLOT_TYPE_STR)) {
+        if (element->getStringAttribute(XML_SLOT_TYPE_STR) == XML_SLOT_TYPE_SPLITTER_STR) {
+            retVal = true;
+        }
+    }
+
+    return retVal;
+}
@@ -1,25 +1,50 @@
 #pragma once
 
+#include <atomic>
 #include <JuceHeader.h>
 
 inline const char* XML_SLOT_TYPE_STR {"SlotType"};
 inline const char* XML_SLOT_TYPE_PLUGIN_STR {"Plugin"};
 inline const char* XML_SLOT_TYPE_GAIN_STAGE_STR {"GainStage"};
+inline const char* XML_SLOT_TYPE_SPLITTER_STR {"Splitter"};
+
+class DeferredPluginStates;
 
 class ChainSlotBase {
 public:
     bool isBypassed;
 
-    explicit ChainSlotBase(bool newIsBypassed) : isBypassed(newIsBypassed) {}
+    // Unique for the lifetime of the process, unlike the slot's address which may be reused once
+    // it's deleted
+    const juce::uint64 id;
+
+    explicit ChainSlotBase(bool newIsBypassed) : isBypassed(newIsBypassed), id(_getNextId()) {}
     virtual ~ChainSlotBase() = default;
 
     virtual void prepareToPlay(double sampleRate, int samplesPerBlock) = 0;
+
+    /**
+     * Returns true if this slot has already been prepared with the given sample rate and block
+     * size and hasn't been released since, so doesn't need to be prepared again.
+     */
+    virtual bool isPreparedFor(double sampleRate, int samplesPerBlock) const = 0;
     virtual void releaseResources() = 0;
     virtual void reset() = 0;
     virtual void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) = 0;
 
-    virtual void writeToXml(juce::XmlElement* element) = 0;
+    /**
+     * Writes the slot to the given element. If deferredStates is provided any plugin state is
+     * added to it to be written later, rather than being collected now.
+     */
+    virtual void writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates) = 0;
 
     static bool XmlElementIsPlugin(juce::XmlElement* element);
     static bool XmlElementIsGainStage(juce::XmlElement* element);
+    static bool XmlElementIsSplitter(juce::XmlElement* element);
+
+private:
+    static juce::uint64 _getNextId() {
+        static std::atomic<juce::uint64> nextId {1};
+        return nextId++;
+    }
 };
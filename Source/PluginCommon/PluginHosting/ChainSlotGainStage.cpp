@@ -1,6 +1,6 @@
 #include "ChainSlotGainStage.h"
 
-#include "PluginUtils.h"
+#include "General/CoreMath.h"
 #include <assert.h>
 
 namespace {
@@ -10,54 +10,43 @@ namespace {
 }
 
 ChainSlotGainStage::ChainSlotGainStage(float newGain, float newPan, bool newIsBypassed, const juce::AudioProcessor::BusesLayout& busesLayout)
-        : ChainSlotBase(newIsBypassed), gain(newGain), pan(newPan), _numMainChannels(busesLayout.getMainInputChannels()) {
-
-    for (auto& env : _meterEnvelopes) {
-        env.setAttackTimeMs(1);
-        env.setReleaseTimeMs(50);
-        env.setFilterEnabled(false);
-    }
+        : ChainSlotBase(newIsBypassed),
+          gain(newGain),
+          pan(newPan),
+          _numMainChannels(busesLayout.getMainInputChannels()),
+          _isPrepared(false),
+          _preparedSampleRate(0) {
 }
 
 void ChainSlotGainStage::prepareToPlay(double sampleRate, int samplesPerBlock) {
     assert(_numMainChannels <= 2);
 
-    for (auto& env : _meterEnvelopes) {
-        env.setSampleRate(sampleRate);
-    }
+    _gainPanMeter.prepareToPlay(sampleRate);
+
+    _isPrepared = true;
+    _preparedSampleRate = sampleRate;
+}
+
+bool ChainSlotGainStage::isPreparedFor(double sampleRate, int /*samplesPerBlock*/) const {
+    // The block size doesn't affect anything we prepare
+    return _isPrepared && WECore::CoreMath::compareFloatsEqual(_preparedSampleRate, sampleRate);
 }
 
 void ChainSlotGainStage::releaseResources() {
-    // Do nothing
+    _isPrepared = false;
 }
 
 void ChainSlotGainStage::reset() {
-    for (auto& env : _meterEnvelopes) {
-        env.reset();
-    }
+    _gainPanMeter.reset();
 }
 
 void ChainSlotGainStage::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
-    if (!isBypassed) {
-        // Apply gain
-        for (int channel {0}; channel < _numMainChannels; channel++) {
-            juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel),
-                                                  gain,
-                                                  buffer.getNumSamples());
-        }
-
-        if (_numMainChannels == 2) {
-            // Stereo input - apply balance
-            Utils::processBalance(pan, buffer);
-        }
-    }
-
-    // Update the envelope follower
-    for (int sampleIndex {0}; sampleIndex < buffer.getNumSamples(); sampleIndex++) {
-        for (int channel {0}; channel < _numMainChannels; channel++) {
-            _meterEnvelopes[channel].getNextOutput(buffer.getReadPointer(channel)[sampleIndex]);
-        }
-    }
+    // Apply gain and balance and update the meter in one pass, when bypassed this still meters
+    // (and ramps back to unity gain)
+    _gainPanMeter.process(buffer,
+                          _numMainChannels,
+                          isBypassed ? 1.0f : gain,
+                          isBypassed ? 0.0f : pan);
 }
 
 std::unique_ptr<ChainSlotGainStage> ChainSlotGainStage::restoreFromXml(juce::XmlElement* element, const juce::AudioProcessor::BusesLayout& busesLayout) {
@@ -85,7 +74,7 @@ std::unique_ptr<ChainSlotGainStage> ChainSlotGainStage::restoreFromXml(juce::Xml
     return std::make_unique<ChainSlotGainStage>(gain, pan, isSlotBypassed, busesLayout);
 }
 
-void ChainSlotGainStage::writeToXml(juce::XmlElement* element) {
+void ChainSlotGainStage::writeToXml(juce::XmlElement* element, DeferredPluginStates* /*deferredStates*/) {
     element->setAttribute(XML_SLOT_TYPE_STR, XML_SLOT_TYPE_GAIN_STAGE_STR);
 
     element->setAttribute(XML_SLOT_IS_BYPASSED_STR, isBypassed);
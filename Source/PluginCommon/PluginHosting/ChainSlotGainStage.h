@@ -3,7 +3,7 @@
 #include <JuceHeader.h>
 
 #include "ChainSlotBase.h"
-#include "WEFilters/AREnvelopeFollowerSquareLaw.h"
+#include "GainPanMeter.h"
 
 /**
  * Represents a gain stage in a slot in a processing chain.
@@ -19,21 +19,30 @@ public:
     ChainSlotGainStage(float newGain, float newPan, bool newIsBypassed, const juce::AudioProcessor::BusesLayout& busesLayout);
     virtual ~ChainSlotGainStage() = default;
 
-    float getOutputAmplitude(int channel) const { return static_cast<float>(_meterEnvelopes[channel].getLastOutput()); }
+    float getOutputAmplitude(int channel) const { return _gainPanMeter.getOutputAmplitude(channel); }
+    float getOutputPeak(int channel) const { return _gainPanMeter.getOutputPeak(channel); }
 
     int getNumChannels() const { return _numMainChannels; }
 
+    /**
+     * Used when the chain this gain stage is in switches between mono and stereo processing.
+     */
+    void setNumChannels(int val) { _numMainChannels = val; }
+
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    bool isPreparedFor(double sampleRate, int samplesPerBlock) const override;
     void releaseResources() override;
     void reset() override;
     void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
 
     static std::unique_ptr<ChainSlotGainStage> restoreFromXml(juce::XmlElement* element, const juce::AudioProcessor::BusesLayout& busesLayout);
-    void writeToXml(juce::XmlElement* element) override;
+    void writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates) override;
 
 private:
     int _numMainChannels;
-    std::array<WECore::AREnv::AREnvelopeFollowerSquareLaw, 2> _meterEnvelopes;
+    bool _isPrepared;
+    double _preparedSampleRate;
+    GainPanMeter _gainPanMeter;
 };
 
 /**
@@ -46,6 +55,7 @@ public:
 
     int getNumChannels() const { return _gainStage.getNumChannels(); }
     float getOutputAmplitude(int channel) const { return _gainStage.getOutputAmplitude(channel); }
+    float getOutputPeak(int channel) const { return _gainStage.getOutputPeak(channel); }
 
 private:
     const ChainSlotGainStage& _gainStage;
@@ -1,11 +1,17 @@
 #include "ChainSlotPlugin.h"
+#include "SandboxedPluginInstance.h"
+#include "General/CoreMath.h"
 
 namespace {
     const char* XML_SLOT_IS_BYPASSED_STR {"isSlotBypassed"};
     const char* XML_PLUGIN_DATA_STR {"PluginData"};
+    const char* XML_PLUGIN_IS_SANDBOXED_STR {"isSandboxed"};
     const char* XML_MODULATION_CONFIG_STR {"ModulationConfig"};
     const char* XML_MODULATION_IS_ACTIVE_STR {"ModulationIsActive"};
     const char* XML_MODULATION_TARGET_PARAMETER_NAME_STR {"TargetParameterName"};
+    const char* XML_MODULATION_TARGET_PARAMETER_ID_STR {"TargetParameterID"};
+    const char* XML_MODULATION_TARGET_PARAMETER_INDEX_STR {"TargetParameterIndex"};
+    const char* XML_MODULATION_TARGET_BINDING_VERSION_STR {"TargetBindingVersion"};
     const char* XML_MODULATION_REST_VALUE_STR {"RestValue"};
     const char* XML_MODULATION_SOURCE {"Source"};
     const char* XML_MODULATION_SOURCE_AMOUNT {"SourceAmount"};
@@ -21,6 +27,20 @@ namespace {
         retVal += std::to_string(sourceNumber);
         return retVal;
     }
+
+    void writePluginState(juce::AudioPluginInstance& plugin, juce::XmlElement* element) {
+        juce::MemoryBlock pluginMemoryBlock;
+        plugin.getStateInformation(pluginMemoryBlock);
+        element->setAttribute(XML_PLUGIN_DATA_STR, pluginMemoryBlock.toBase64Encoding());
+    }
+}
+
+void DeferredPluginStates::write() {
+    for (auto& [plugin, element] : _states) {
+        writePluginState(*plugin, element);
+    }
+
+    _states.clear();
 }
 
 void PluginParameterModulationSource::restoreFromXml(juce::XmlElement* element) {
@@ -45,6 +65,13 @@ void PluginParameterModulationConfig::restoreFromXml(juce::XmlElement* element)
         juce::Logger::writeToLog("Missing attribute " + juce::String(XML_MODULATION_TARGET_PARAMETER_NAME_STR));
     }
 
+    // Older versions only stored the name, leave the ID and index empty so the target is bound by
+    // name and they're filled in when it is
+    if (element->getIntAttribute(XML_MODULATION_TARGET_BINDING_VERSION_STR, 0) >= TARGET_BINDING_VERSION) {
+        targetParameterID = element->getStringAttribute(XML_MODULATION_TARGET_PARAMETER_ID_STR);
+        targetParameterIndex = element->getIntAttribute(XML_MODULATION_TARGET_PARAMETER_INDEX_STR, -1);
+    }
+
     if (element->hasAttribute(XML_MODULATION_REST_VALUE_STR)) {
         restValue = element->getDoubleAttribute(XML_MODULATION_REST_VALUE_STR);
     } else {
@@ -66,6 +93,9 @@ void PluginParameterModulationConfig::restoreFromXml(juce::XmlElement* element)
 
 void PluginParameterModulationConfig::writeToXml(juce::XmlElement* element) {
     element->setAttribute(XML_MODULATION_TARGET_PARAMETER_NAME_STR, targetParameterName);
+    element->setAttribute(XML_MODULATION_TARGET_PARAMETER_ID_STR, targetParameterID);
+    element->setAttribute(XML_MODULATION_TARGET_PARAMETER_INDEX_STR, targetParameterIndex);
+    element->setAttribute(XML_MODULATION_TARGET_BINDING_VERSION_STR, TARGET_BINDING_VERSION);
     element->setAttribute(XML_MODULATION_REST_VALUE_STR, restValue);
 
     for (int index {0}; index < sources.size(); index++ ) {
@@ -95,6 +125,33 @@ void PluginModulationConfig::restoreFromXml(juce::XmlElement* element) {
     }
 }
 
+void PluginModulationConfig::removeSource(ModulationSourceDefinition definition) {
+    // Iterate through each configured parameter
+    for (PluginParameterModulationConfig& parameterConfig : parameterConfigs) {
+        bool needsToDelete {false};
+        int indexToDelete {0};
+
+        // Iterate through each configured source
+        for (int sourceIndex {0}; sourceIndex < parameterConfig.sources.size(); sourceIndex++) {
+            PluginParameterModulationSource& thisSource = parameterConfig.sources[sourceIndex];
+
+            if (thisSource.definition == definition) {
+                // We need to come back and delete this one
+                needsToDelete = true;
+                indexToDelete = sourceIndex;
+            } else if (thisSource.definition.type == definition.type &&
+                        thisSource.definition.id > definition.id) {
+                // We need to renumber this one
+                thisSource.definition.id--;
+            }
+        }
+
+        if (needsToDelete) {
+            parameterConfig.sources.erase(parameterConfig.sources.begin() + indexToDelete);
+        }
+    }
+}
+
 void PluginModulationConfig::writeToXml(juce::XmlElement* element) {
     element->setAttribute(XML_MODULATION_IS_ACTIVE_STR, isActive);
 
@@ -105,13 +162,61 @@ void PluginModulationConfig::writeToXml(juce::XmlElement* element) {
     }
 }
 
+ChainSlotPlugin::ChainSlotPlugin(std::shared_ptr<juce::AudioPluginInstance> newPlugin,
+                                 bool newIsBypassed,
+                                 std::function<float(int, MODULATION_TYPE)> getModulationValueCallback)
+        : ChainSlotBase(newIsBypassed), plugin(newPlugin),
+          parameterCache(std::make_unique<PluginParameterCache>(newPlugin)),
+          _getModulationValueCallback(getModulationValueCallback),
+          _isPrepared(true) {
+    parameterCache->setOnRebuiltCallback([&]() { _onParameterCacheRebuilt(); });
+}
+
+void ChainSlotPlugin::setModulationConfig(const PluginModulationConfig& config) {
+    // Bind the targets before locking so the audio thread isn't blocked while doing it
+    PluginModulationConfig newConfig = config;
+    std::vector<juce::AudioProcessorParameter*> newTargets;
+
+    for (PluginParameterModulationConfig& parameterConfig : newConfig.parameterConfigs) {
+        const CachedParameterInfo* info {parameterCache->findTarget(
+            parameterConfig.targetParameterID, parameterConfig.targetParameterIndex, parameterConfig.targetParameterName)};
+
+        if (info != nullptr) {
+            parameterConfig.targetParameterID = info->id;
+            parameterConfig.targetParameterIndex = info->index;
+            newTargets.push_back(info->parameter);
+        } else {
+            juce::Logger::writeToLog("ChainSlotPlugin::setModulationConfig: Couldn't find modulation target " + parameterConfig.targetParameterName);
+            newTargets.push_back(nullptr);
+        }
+    }
+
+    WECore::AudioSpinLock lock(_modulationMutex);
+    std::swap(_modulationConfig, newConfig);
+    std::swap(_modulationTargets, newTargets);
+}
+
+PluginModulationConfig ChainSlotPlugin::getModulationConfig() const {
+    WECore::AudioSpinLock lock(_modulationMutex);
+    return _modulationConfig;
+}
+
 void ChainSlotPlugin::prepareToPlay(double sampleRate, int samplesPerBlock) {
     plugin->setRateAndBufferSizeDetails(sampleRate, samplesPerBlock);
     plugin->prepareToPlay(sampleRate, samplesPerBlock);
+    _isPrepared = true;
+}
+
+bool ChainSlotPlugin::isPreparedFor(double sampleRate, int samplesPerBlock) const {
+    // The plugin keeps track of the rate and block size it was last prepared with
+    return _isPrepared &&
+           WECore::CoreMath::compareFloatsEqual(plugin->getSampleRate(), sampleRate) &&
+           plugin->getBlockSize() == samplesPerBlock;
 }
 
 void ChainSlotPlugin::releaseResources() {
     plugin->releaseResources();
+    _isPrepared = false;
 }
 
 void ChainSlotPlugin::reset() {
@@ -120,16 +225,14 @@ void ChainSlotPlugin::reset() {
 
 void ChainSlotPlugin::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
     if (!isBypassed) {
-        // Apply parameter modulation
-        if (modulationConfig.isActive) {
-            // TODO we need a faster way of retrieving parameters
-            // Try again to get PluginParameterModulationConfig to hold a pointer to the parameter directly
-            const juce::Array<juce::AudioProcessorParameter*>& parameters = plugin->getParameters();
-            for (const PluginParameterModulationConfig& parameterConfig : modulationConfig.parameterConfigs) {
-                for (juce::AudioProcessorParameter* targetParameter : parameters) {
-                    if (targetParameter->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT) == parameterConfig.targetParameterName) {
-                        _applyModulationForParamter(targetParameter, parameterConfig);
-                    }
+        // Apply parameter modulation, the targets have already been bound so there's no need to
+        // look them up here (skip it if they're being changed, or the plugin's parameters have
+        // changed and the targets haven't been bound again yet)
+        WECore::AudioSpinTryLock lock(_modulationMutex);
+        if (lock.isLocked() && _modulationConfig.isActive && !parameterCache->isStale()) {
+            for (size_t index {0}; index < _modulationConfig.parameterConfigs.size(); index++) {
+                if (_modulationTargets[index] != nullptr) {
+                    _applyModulationForParamter(_modulationTargets[index], _modulationConfig.parameterConfigs[index]);
                 }
             }
         }
@@ -161,13 +264,20 @@ std::unique_ptr<ChainSlotPlugin> ChainSlotPlugin::restoreFromXml(
         juce::PluginDescription pluginDescription;
 
         if (pluginDescription.loadFromXml(*pluginDescriptionXml)) {
-            juce::AudioPluginFormatManager formatManager;
-            formatManager.addDefaultFormats();
-
             juce::String errorMessage;
-            std::unique_ptr<juce::AudioPluginInstance> thisPlugin =
-                formatManager.createPluginInstance(
+            std::unique_ptr<juce::AudioPluginInstance> thisPlugin;
+
+            // Older versions don't have sandboxing, so run in process if missing
+            if (element->getBoolAttribute(XML_PLUGIN_IS_SANDBOXED_STR, false)) {
+                thisPlugin = SandboxedPluginInstance::create(
                     pluginDescription, configuration.sampleRate, configuration.blockSize, errorMessage);
+            } else {
+                juce::AudioPluginFormatManager formatManager;
+                formatManager.addDefaultFormats();
+
+                thisPlugin = formatManager.createPluginInstance(
+                    pluginDescription, configuration.sampleRate, configuration.blockSize, errorMessage);
+            }
 
             if (thisPlugin != nullptr) {
                 std::shared_ptr<juce::AudioPluginInstance> sharedPlugin = std::move(thisPlugin);
@@ -185,7 +295,9 @@ std::unique_ptr<ChainSlotPlugin> ChainSlotPlugin::restoreFromXml(
 
                         // Now that the plugin is restored, we can restore the modulation config
                         juce::XmlElement* modulationConfigElement = element->getChildByName(XML_MODULATION_CONFIG_STR);
-                        retVal->modulationConfig.restoreFromXml(modulationConfigElement);
+                        PluginModulationConfig modulationConfig;
+                        modulationConfig.restoreFromXml(modulationConfigElement);
+                        retVal->setModulationConfig(modulationConfig);
                     } else {
                         juce::Logger::writeToLog("Missing attribute " + juce::String(XML_PLUGIN_DATA_STR));
                     }
@@ -207,24 +319,53 @@ std::unique_ptr<ChainSlotPlugin> ChainSlotPlugin::restoreFromXml(
     return std::move(retVal);
 }
 
-void ChainSlotPlugin::writeToXml(juce::XmlElement* element) {
+void ChainSlotPlugin::writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates) {
     element->setAttribute(XML_SLOT_TYPE_STR, XML_SLOT_TYPE_PLUGIN_STR);
 
     // Store the plugin level bypass
     element->setAttribute(XML_SLOT_IS_BYPASSED_STR, isBypassed);
 
+    // Store whether the plugin is running in the plugin host server
+    element->setAttribute(XML_PLUGIN_IS_SANDBOXED_STR, dynamic_cast<SandboxedPluginInstance*>(plugin.get()) != nullptr);
+
     // Store the plugin description
     std::unique_ptr<juce::XmlElement> pluginDescriptionXml = plugin->getPluginDescription().createXml();
     element->addChildElement(pluginDescriptionXml.release());
 
-    // Store the plugin's internal state
-    juce::MemoryBlock pluginMemoryBlock;
-    plugin->getStateInformation(pluginMemoryBlock);
-    element->setAttribute(XML_PLUGIN_DATA_STR, pluginMemoryBlock.toBase64Encoding());
+    // Store the plugin's internal state, or leave it for later if deferring
+    if (deferredStates != nullptr) {
+        deferredStates->add(plugin, element);
+    } else {
+        writePluginState(*plugin, element);
+    }
 
     // Store the modulation config
     juce::XmlElement* modulationConfigElement = element->createNewChildElement(XML_MODULATION_CONFIG_STR);
-    modulationConfig.writeToXml(modulationConfigElement);
+    getModulationConfig().writeToXml(modulationConfigElement);
+}
+
+void ChainSlotPlugin::removeModulationSourceFromXml(juce::XmlElement* element, ModulationSourceDefinition definition) {
+    for (juce::XmlElement* childElement {element->getFirstChildElement()};
+            childElement != nullptr;
+            childElement = childElement->getNextElement()) {
+        if (childElement->hasTagName(XML_MODULATION_CONFIG_STR)) {
+            PluginModulationConfig modulationConfig;
+            modulationConfig.restoreFromXml(childElement);
+            modulationConfig.removeSource(definition);
+
+            // Write the config back from scratch, as sources may have been removed
+            childElement->deleteAllChildElements();
+            modulationConfig.writeToXml(childElement);
+        } else {
+            // Nested splitters store their plugins further down
+            removeModulationSourceFromXml(childElement, definition);
+        }
+    }
+}
+
+void ChainSlotPlugin::_onParameterCacheRebuilt() {
+    // Parameters may have been added, removed, or reordered
+    setModulationConfig(getModulationConfig());
 }
 
 void ChainSlotPlugin::_applyModulationForParamter(juce::AudioProcessorParameter* targetParameter,
@@ -2,9 +2,11 @@
 
 #include <JuceHeader.h>
 
+#include "General/AudioSpinMutex.h"
 #include "ChainSlotBase.h"
 #include "ModulationSourceDefinition.h"
 #include "PluginConfigurator.h"
+#include "PluginParameterCache.h"
 
 struct PluginParameterModulationSource {
     PluginParameterModulationSource() : definition(0, MODULATION_TYPE::MACRO), modulationAmount(0) { }
@@ -25,9 +27,14 @@ struct PluginParameterModulationSource {
 };
 
 struct PluginParameterModulationConfig {
-    // Name of the parameter being modulated
+    // Name of the parameter being modulated, kept for display and for binding configs saved before
+    // IDs were stored
     juce::String targetParameterName;
 
+    // The plugin's ID and index for the parameter being modulated, used to bind the target
+    juce::String targetParameterID;
+    int targetParameterIndex {-1};
+
     // Parameter value without modulation applied (0 : 1)
     float restValue;
 
@@ -37,6 +44,9 @@ struct PluginParameterModulationConfig {
     // Used when retrieving the parameter name from a juce::AudioProcessorParameter
     static constexpr int PLUGIN_PARAMETER_NAME_LENGTH_LIMIT {30};
 
+    // Configs saved with an older version than this are bound by name only
+    static constexpr int TARGET_BINDING_VERSION {1};
+
     void restoreFromXml(juce::XmlElement* element);
     void writeToXml(juce::XmlElement* element);
 };
@@ -47,6 +57,12 @@ struct PluginModulationConfig {
 
     PluginModulationConfig() : isActive(false) {}
 
+    /**
+     * Removes any uses of the given source, and renumbers sources of the same type with a higher
+     * ID as they move down to fill the gap.
+     */
+    void removeSource(ModulationSourceDefinition definition);
+
     PluginModulationConfig& operator=(const PluginModulationConfig& other) {
         isActive = other.isActive;
         parameterConfigs = other.parameterConfigs;
@@ -58,23 +74,55 @@ struct PluginModulationConfig {
     void writeToXml(juce::XmlElement* element);
 };
 
+/**
+ * Plugin states which still need to be written to XML. This lets the structure of the graph be
+ * written quickly while it's locked, then each plugin's state (which can take much longer) be
+ * collected after it's unlocked.
+ *
+ * The plugins are kept alive until their state is written, even if they're removed from the
+ * graph in the meantime.
+ */
+class DeferredPluginStates {
+public:
+    void add(std::shared_ptr<juce::AudioPluginInstance> plugin, juce::XmlElement* element) { _states.emplace_back(plugin, element); }
+
+    /**
+     * Collects the state of each plugin and writes it to its element.
+     */
+    void write();
+
+private:
+    std::vector<std::pair<std::shared_ptr<juce::AudioPluginInstance>, juce::XmlElement*>> _states;
+};
+
 /**
  * Represents a plugin in a slot in a processing chain.
  */
 class ChainSlotPlugin : public ChainSlotBase {
 public:
     std::shared_ptr<juce::AudioPluginInstance> plugin;
-    PluginModulationConfig modulationConfig;
+    std::unique_ptr<PluginParameterCache> parameterCache;
 
+    /**
+     * The plugin is expected to have already been configured and prepared (see
+     * PluginConfigurator::configure()) before it is handed to a slot.
+     */
     ChainSlotPlugin(std::shared_ptr<juce::AudioPluginInstance> newPlugin,
                     bool newIsBypassed,
-                    std::function<float(int, MODULATION_TYPE)> getModulationValueCallback)
-        : ChainSlotBase(newIsBypassed), plugin(newPlugin),
-          _getModulationValueCallback(getModulationValueCallback) {}
+                    std::function<float(int, MODULATION_TYPE)> getModulationValueCallback);
 
     virtual ~ChainSlotPlugin() = default;
 
+    /**
+     * Sets the modulation config and binds each target to a plugin parameter, so the audio thread
+     * doesn't need to look them up. Targets are bound by ID, then index, then name, and the config
+     * is updated with the ID and index of the parameter that was bound.
+     */
+    void setModulationConfig(const PluginModulationConfig& config);
+    PluginModulationConfig getModulationConfig() const;
+
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    bool isPreparedFor(double sampleRate, int samplesPerBlock) const override;
     void releaseResources() override;
     void reset() override;
     void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
@@ -85,10 +133,28 @@ public:
         HostConfiguration configuration,
         const PluginConfigurator& pluginConfigurator,
         std::function<void(juce::String)> onErrorCallback);
-    void writeToXml(juce::XmlElement* element) override;
+    void writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates) override;
+
+    /**
+     * Removes the given source from every modulation config stored within the element, including
+     * those of plugins in nested splitters. Used for chains which only exist as XML while
+     * hibernated.
+     */
+    static void removeModulationSourceFromXml(juce::XmlElement* element, ModulationSourceDefinition definition);
 
 private:
     std::function<float(int, MODULATION_TYPE)> _getModulationValueCallback;
+    bool _isPrepared;
+
+    // The bound target of each parameter config, or nullptr if it couldn't be found
+    PluginModulationConfig _modulationConfig;
+    std::vector<juce::AudioProcessorParameter*> _modulationTargets;
+    mutable WECore::AudioSpinMutex _modulationMutex;
+
+    /**
+     * Binds the targets again if the plugin's parameters have changed.
+     */
+    void _onParameterCacheRebuilt();
 
     void _applyModulationForParamter(juce::AudioProcessorParameter* targetParameter,
                                      const PluginParameterModulationConfig& parameterConfig);
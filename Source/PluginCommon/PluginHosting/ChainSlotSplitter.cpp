@@ -0,0 +1,158 @@
+#include "ChainSlotSplitter.h"
+
+#include "PluginSplitterSeries.h"
+#include "PluginSplitterParallel.h"
+#include "PluginSplitterMultiband.h"
+#include "PluginSplitterLeftRight.h"
+#include "PluginSplitterMidSide.h"
+#include "General/CoreMath.h"
+
+namespace {
+    const char* XML_SLOT_IS_BYPASSED_STR {"isSlotBypassed"};
+    const char* XML_NESTED_SPLIT_TYPE_STR {"SplitType"};
+
+    juce::String getCrossoverXMLName(int crossoverNumber) {
+        juce::String retVal("Crossover_");
+        retVal += juce::String(crossoverNumber);
+        return retVal;
+    }
+}
+
+ChainSlotSplitter::ChainSlotSplitter(std::unique_ptr<PluginSplitter> newSplitter, bool newIsBypassed)
+        : ChainSlotBase(newIsBypassed),
+          splitter(std::move(newSplitter)),
+          _isPrepared(false) {
+}
+
+std::unique_ptr<PluginSplitter> ChainSlotSplitter::createSplitter(SPLIT_TYPE splitType,
+                                                                  std::function<float(int, MODULATION_TYPE)> getModulationValueCallback,
+                                                                  HostConfiguration configuration) {
+    std::unique_ptr<PluginSplitter> retVal;
+
+    const bool isStereo {configuration.layout.getMainInputChannels() == 2 &&
+                         configuration.layout.getMainOutputChannels() == 2};
+
+    switch (splitType) {
+        case SPLIT_TYPE::SERIES:
+            retVal.reset(new PluginSplitterSeries(getModulationValueCallback));
+            break;
+        case SPLIT_TYPE::PARALLEL:
+            retVal.reset(new PluginSplitterParallel(getModulationValueCallback));
+            break;
+        case SPLIT_TYPE::MULTIBAND:
+            retVal.reset(new PluginSplitterMultiband(getModulationValueCallback, isStereo));
+            break;
+        case SPLIT_TYPE::LEFTRIGHT:
+            if (isStereo) {
+                retVal.reset(new PluginSplitterLeftRight(getModulationValueCallback));
+            } else {
+                juce::Logger::writeToLog("ChainSlotSplitter::createSplitter: Can't use a left/right split while not in 2in2out configuration");
+            }
+            break;
+        case SPLIT_TYPE::MIDSIDE:
+            if (isStereo) {
+                retVal.reset(new PluginSplitterMidSide(getModulationValueCallback));
+            } else {
+                juce::Logger::writeToLog("ChainSlotSplitter::createSplitter: Can't use a mid/side split while not in 2in2out configuration");
+            }
+            break;
+    }
+
+    return retVal;
+}
+
+void ChainSlotSplitter::prepareToPlay(double sampleRate, int samplesPerBlock) {
+    splitter->prepareToPlay(sampleRate, samplesPerBlock);
+    _isPrepared = true;
+}
+
+bool ChainSlotSplitter::isPreparedFor(double sampleRate, int samplesPerBlock) const {
+    return _isPrepared &&
+           WECore::CoreMath::compareFloatsEqual(splitter->getSampleRate(), sampleRate) &&
+           splitter->getBlockSize() == samplesPerBlock;
+}
+
+void ChainSlotSplitter::releaseResources() {
+    splitter->releaseResources();
+    _isPrepared = false;
+}
+
+void ChainSlotSplitter::reset() {
+    splitter->reset();
+}
+
+void ChainSlotSplitter::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+    if (!isBypassed) {
+        splitter->processBlock(buffer, midiMessages);
+    }
+}
+
+std::unique_ptr<ChainSlotSplitter> ChainSlotSplitter::restoreFromXml(
+        juce::XmlElement* element,
+        std::function<float(int, MODULATION_TYPE)> getModulationValueCallback,
+        HostConfiguration configuration,
+        const PluginConfigurator& pluginConfigurator,
+        std::function<void(juce::String)> onErrorCallback) {
+
+    bool isSlotBypassed {false};
+    if (element->hasAttribute(XML_SLOT_IS_BYPASSED_STR)) {
+        isSlotBypassed = element->getBoolAttribute(XML_SLOT_IS_BYPASSED_STR);
+    } else {
+        juce::Logger::writeToLog("Missing attribute " + juce::String(XML_SLOT_IS_BYPASSED_STR));
+    }
+
+    SPLIT_TYPE splitType {SPLIT_TYPE::SERIES};
+    if (element->hasAttribute(XML_NESTED_SPLIT_TYPE_STR)) {
+        splitType = stringToSplitType(element->getStringAttribute(XML_NESTED_SPLIT_TYPE_STR));
+    } else {
+        juce::Logger::writeToLog("Missing attribute " + juce::String(XML_NESTED_SPLIT_TYPE_STR));
+    }
+
+    std::unique_ptr<PluginSplitter> newSplitter = createSplitter(splitType, getModulationValueCallback, configuration);
+
+    if (newSplitter == nullptr) {
+        // Same as the top level splitter, fall back to parallel if a stereo split type is being
+        // restored into a mono configuration
+        newSplitter = createSplitter(SPLIT_TYPE::PARALLEL, getModulationValueCallback, configuration);
+    }
+
+    newSplitter->restoreFromXml(element, configuration, pluginConfigurator, onErrorCallback);
+
+    PluginSplitterMultiband* multibandSplitter = dynamic_cast<PluginSplitterMultiband*>(newSplitter.get());
+    if (multibandSplitter != nullptr) {
+        for (int crossoverNumber {0}; crossoverNumber < multibandSplitter->getNumBands() - 1; crossoverNumber++) {
+            const juce::String crossoverName = getCrossoverXMLName(crossoverNumber);
+
+            if (element->hasAttribute(crossoverName)) {
+                multibandSplitter->setCrossoverFrequency(crossoverNumber, element->getDoubleAttribute(crossoverName));
+            } else {
+                juce::Logger::writeToLog("Missing attribute " + crossoverName);
+            }
+        }
+    }
+
+    newSplitter->configureChainLayouts(configuration, pluginConfigurator);
+
+    std::unique_ptr<ChainSlotSplitter> retVal = std::make_unique<ChainSlotSplitter>(std::move(newSplitter), isSlotBypassed);
+
+    // Call prepareToPlay since some hosts won't call it after restoring
+    retVal->prepareToPlay(configuration.sampleRate, configuration.blockSize);
+
+    return retVal;
+}
+
+void ChainSlotSplitter::writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates) {
+    element->setAttribute(XML_SLOT_TYPE_STR, XML_SLOT_TYPE_SPLITTER_STR);
+
+    element->setAttribute(XML_SLOT_IS_BYPASSED_STR, isBypassed);
+    element->setAttribute(XML_NESTED_SPLIT_TYPE_STR, splitTypeToString(splitter->getSplitType()));
+
+    PluginSplitterMultiband* multibandSplitter = dynamic_cast<PluginSplitterMultiband*>(splitter.get());
+    if (multibandSplitter != nullptr) {
+        for (int crossoverNumber {0}; crossoverNumber < multibandSplitter->getNumBands() - 1; crossoverNumber++) {
+            element->setAttribute(getCrossoverXMLName(crossoverNumber), multibandSplitter->getCrossoverFrequency(crossoverNumber));
+        }
+    }
+
+    splitter->writeToXml(element, deferredStates);
+}
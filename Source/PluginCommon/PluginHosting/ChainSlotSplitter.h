@@ -0,0 +1,46 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "ChainSlotBase.h"
+#include "PluginSplitter.h"
+
+/**
+ * Represents a nested splitter in a slot in a processing chain, so a chain can split its signal
+ * again (eg. a multiband split inside one branch of a parallel split).
+ *
+ * The nested splitter reports its own latency (including the compensation between its chains), so
+ * the chain containing it can compensate for it in the same way as a plugin.
+ */
+class ChainSlotSplitter : public ChainSlotBase {
+public:
+    std::unique_ptr<PluginSplitter> splitter;
+
+    ChainSlotSplitter(std::unique_ptr<PluginSplitter> newSplitter, bool newIsBypassed);
+    virtual ~ChainSlotSplitter() = default;
+
+    /**
+     * Creates an empty splitter of the given type, or nullptr if the split type can't be used with
+     * the given configuration.
+     */
+    static std::unique_ptr<PluginSplitter> createSplitter(SPLIT_TYPE splitType,
+                                                          std::function<float(int, MODULATION_TYPE)> getModulationValueCallback,
+                                                          HostConfiguration configuration);
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    bool isPreparedFor(double sampleRate, int samplesPerBlock) const override;
+    void releaseResources() override;
+    void reset() override;
+    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+
+    static std::unique_ptr<ChainSlotSplitter> restoreFromXml(
+        juce::XmlElement* element,
+        std::function<float(int, MODULATION_TYPE)> getModulationValueCallback,
+        HostConfiguration configuration,
+        const PluginConfigurator& pluginConfigurator,
+        std::function<void(juce::String)> onErrorCallback);
+    void writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates) override;
+
+private:
+    bool _isPrepared;
+};
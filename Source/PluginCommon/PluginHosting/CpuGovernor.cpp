@@ -0,0 +1,144 @@
+#include "CpuGovernor.h"
+
+namespace {
+    int fallbackToFlag(CPU_FALLBACK fallback) {
+        return 1 << static_cast<int>(fallback);
+    }
+}
+
+CpuGovernor::CpuGovernor() : _sampleRate(44100),
+                             _budget(DEFAULT_BUDGET),
+                             _enabledFallbacks(DEFAULT_ENABLED_FALLBACKS),
+                             _level(0),
+                             _load(0),
+                             _secondsSinceLastStep(0),
+                             _secondsWithHeadroom(0),
+                             _hasLoad(false) {
+}
+
+void CpuGovernor::prepareToPlay(double sampleRate) {
+    _sampleRate = sampleRate;
+    reset();
+}
+
+void CpuGovernor::reset() {
+    _level.store(0, std::memory_order_relaxed);
+    _load.store(0, std::memory_order_relaxed);
+    _secondsSinceLastStep = 0;
+    _secondsWithHeadroom = 0;
+    _hasLoad = false;
+}
+
+bool CpuGovernor::onBlockProcessed(double processingSeconds, int numSamples) {
+    if (numSamples <= 0 || _sampleRate <= 0) {
+        return false;
+    }
+
+    const double blockSeconds {numSamples / _sampleRate};
+    const float budget {_budget.load(std::memory_order_relaxed)};
+    const int level {_level.load(std::memory_order_relaxed)};
+
+    if (budget <= 0) {
+        // Disabled, return to full quality if needed
+        if (level > 0) {
+            reset();
+            return true;
+        }
+
+        return false;
+    }
+
+    // Smooth over roughly the same time whatever the block size
+    const float blockLoad {static_cast<float>(processingSeconds / blockSeconds)};
+    float load {blockLoad};
+    if (_hasLoad) {
+        const float coefficient {static_cast<float>(std::exp(-blockSeconds / SMOOTHING_TIME_S))};
+        load = blockLoad + coefficient * (_load.load(std::memory_order_relaxed) - blockLoad);
+    }
+    _load.store(load, std::memory_order_relaxed);
+    _hasLoad = true;
+
+    _secondsSinceLastStep += blockSeconds;
+    _secondsWithHeadroom = load < budget * RECOVERY_RATIO ? _secondsWithHeadroom + blockSeconds : 0;
+
+    int newLevel {level};
+    if (load > budget && _secondsSinceLastStep >= STEP_DOWN_HOLD_TIME_S) {
+        newLevel = std::min(level + 1, _getNumEnabledFallbacks());
+    } else if (_secondsWithHeadroom >= RECOVERY_TIME_S) {
+        newLevel = std::max(level - 1, 0);
+    }
+
+    // A fallback may have been disabled while it was active
+    newLevel = std::min(newLevel, _getNumEnabledFallbacks());
+
+    if (newLevel != level) {
+        _level.store(newLevel, std::memory_order_relaxed);
+        _secondsSinceLastStep = 0;
+        _secondsWithHeadroom = 0;
+        return true;
+    }
+
+    return false;
+}
+
+bool CpuGovernor::isFallbackActive(CPU_FALLBACK fallback) const {
+    const int enabledFallbacks {_enabledFallbacks.load(std::memory_order_relaxed)};
+
+    if ((enabledFallbacks & fallbackToFlag(fallback)) == 0) {
+        return false;
+    }
+
+    // Count the enabled fallbacks up to and including this one, they're applied in order
+    int position {0};
+    for (int index {0}; index <= static_cast<int>(fallback); index++) {
+        if ((enabledFallbacks & (1 << index)) != 0) {
+            position++;
+        }
+    }
+
+    return position <= getLevel();
+}
+
+void CpuGovernor::setBudget(float budget) {
+    _budget.store(std::max(budget, 0.0f), std::memory_order_relaxed);
+}
+
+void CpuGovernor::setFallbackEnabled(CPU_FALLBACK fallback, bool isEnabled) {
+    if (isEnabled) {
+        _enabledFallbacks.fetch_or(fallbackToFlag(fallback), std::memory_order_relaxed);
+    } else {
+        _enabledFallbacks.fetch_and(~fallbackToFlag(fallback), std::memory_order_relaxed);
+    }
+}
+
+bool CpuGovernor::isFallbackEnabled(CPU_FALLBACK fallback) const {
+    return (_enabledFallbacks.load(std::memory_order_relaxed) & fallbackToFlag(fallback)) != 0;
+}
+
+juce::String CpuGovernor::fallbackToString(CPU_FALLBACK fallback) {
+    switch (fallback) {
+        case CPU_FALLBACK::ECONOMY_CROSSOVER:
+            return "Economy crossover";
+        case CPU_FALLBACK::REDUCED_MODULATION_RATE:
+            return "Reduced modulation rate";
+        case CPU_FALLBACK::NO_VISUALISER:
+            return "Visualiser disabled";
+        case CPU_FALLBACK::HIBERNATE_MUTED_CHAINS:
+            return "Muted chains unloaded";
+    }
+
+    return "Unknown";
+}
+
+int CpuGovernor::_getNumEnabledFallbacks() const {
+    const int enabledFallbacks {_enabledFallbacks.load(std::memory_order_relaxed)};
+
+    int retVal {0};
+    for (int index {0}; index < NUM_FALLBACKS; index++) {
+        if ((enabledFallbacks & (1 << index)) != 0) {
+            retVal++;
+        }
+    }
+
+    return retVal;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * The ways processing can be made cheaper when the CPU is overloaded, in the order they're applied.
+ *
+ * Only NO_VISUALISER is enabled by default, the others change the sound or unload plugins so the
+ * user has to opt in to them.
+ */
+enum class CPU_FALLBACK {
+    // Crossover filters use a single stage rather than two (12dB/oct rather than 24dB/oct)
+    ECONOMY_CROSSOVER,
+
+    // LFOs and envelopes are advanced at a fraction of the sample rate
+    REDUCED_MODULATION_RATE,
+
+    // The multiband visualiser's FFT isn't calculated
+    NO_VISUALISER,
+
+    // Muted chains have their plugins unloaded until they're needed again
+    HIBERNATE_MUTED_CHAINS
+};
+
+/**
+ * Monitors how long each block takes to process compared with the time available for it, and steps
+ * through the enabled fallbacks one at a time while the budget is exceeded. Once there's enough
+ * headroom for long enough it steps back up the same way.
+ *
+ * onBlockProcessed() is called on the audio thread, everything else can be called from any thread.
+ */
+class CpuGovernor {
+public:
+    static constexpr int NUM_FALLBACKS {4};
+
+    // Fraction of the block's duration which can be spent processing it
+    static constexpr float DEFAULT_BUDGET {0.5f};
+
+    // Bit flags of the fallbacks enabled by default, one bit per CPU_FALLBACK value
+    static constexpr int DEFAULT_ENABLED_FALLBACKS {1 << static_cast<int>(CPU_FALLBACK::NO_VISUALISER)};
+
+    // Divides the sample rate the modulation sources run at while REDUCED_MODULATION_RATE is active
+    static constexpr int REDUCED_MODULATION_RATE_DIVIDER {8};
+
+    CpuGovernor();
+    ~CpuGovernor() = default;
+
+    void prepareToPlay(double sampleRate);
+
+    /**
+     * Returns to full quality and forgets the measurements so far.
+     */
+    void reset();
+
+    /**
+     * Records the time taken to process a block of numSamples. Returns true if the level changed
+     * and the fallbacks need to be applied.
+     *
+     * Shouldn't be called while rendering offline, as the block's duration doesn't apply.
+     */
+    bool onBlockProcessed(double processingSeconds, int numSamples);
+
+    /**
+     * Returns the number of enabled fallbacks which are currently active.
+     */
+    int getLevel() const { return _level.load(std::memory_order_relaxed); }
+
+    bool isFallbackActive(CPU_FALLBACK fallback) const;
+
+    /**
+     * Returns the smoothed processing time as a fraction of the block duration.
+     */
+    float getLoad() const { return _load.load(std::memory_order_relaxed); }
+
+    /**
+     * Sets the fraction of each block's duration that processing may use before falling back.
+     * Zero disables the governor.
+     */
+    void setBudget(float budget);
+    float getBudget() const { return _budget.load(std::memory_order_relaxed); }
+
+    void setFallbackEnabled(CPU_FALLBACK fallback, bool isEnabled);
+    bool isFallbackEnabled(CPU_FALLBACK fallback) const;
+
+    /**
+     * Returns the enabled fallbacks as bit flags, one bit per CPU_FALLBACK value.
+     */
+    int getEnabledFallbacks() const { return _enabledFallbacks.load(std::memory_order_relaxed); }
+
+    static juce::String fallbackToString(CPU_FALLBACK fallback);
+
+private:
+    // Time constant of the load smoothing
+    static constexpr double SMOOTHING_TIME_S {0.1};
+
+    // Minimum time between steps down, so each step has a chance to take effect first
+    static constexpr double STEP_DOWN_HOLD_TIME_S {0.5};
+
+    // The load needs to stay below this fraction of the budget for RECOVERY_TIME_S to step back up
+    static constexpr float RECOVERY_RATIO {0.6f};
+    static constexpr double RECOVERY_TIME_S {5};
+
+    double _sampleRate;
+
+    std::atomic<float> _budget;
+    std::atomic<int> _enabledFallbacks;
+    std::atomic<int> _level;
+    std::atomic<float> _load;
+
+    // Audio thread only
+    double _secondsSinceLastStep;
+    double _secondsWithHeadroom;
+    bool _hasLoad;
+
+    int _getNumEnabledFallbacks() const;
+};
@@ -0,0 +1,514 @@
+#include "DspKernels.h"
+
+#if JUCE_INTEL
+    #include <immintrin.h>
+
+    // MSVC allows intrinsics for any instruction set without enabling it for the whole file
+    #if JUCE_MSVC
+        #define KERNEL_TARGET(isa)
+    #else
+        #define KERNEL_TARGET(isa) __attribute__((target(isa)))
+    #endif
+#endif
+
+namespace {
+    // Scalar reference, these are also used for the samples left over by the vector versions
+
+    ChannelLevels applyGainAndMeasureScalar(float* samples, int numSamples, float startGain, float endGain) {
+        const float gainIncrement {numSamples > 0 ? (endGain - startGain) / numSamples : 0};
+
+        ChannelLevels retVal {0, 0};
+        for (int sampleIndex {0}; sampleIndex < numSamples; sampleIndex++) {
+            const float sample {samples[sampleIndex] * (startGain + gainIncrement * static_cast<float>(sampleIndex))};
+            samples[sampleIndex] = sample;
+            retVal.peak = std::max(retVal.peak, std::abs(sample));
+            retVal.meanSquare += sample * sample;
+        }
+
+        if (numSamples > 0) {
+            retVal.meanSquare /= numSamples;
+        }
+
+        return retVal;
+    }
+
+    void addScalar(float* destination, const float* source, int numSamples) {
+        for (int sampleIndex {0}; sampleIndex < numSamples; sampleIndex++) {
+            destination[sampleIndex] += source[sampleIndex];
+        }
+    }
+
+    void encodeMidSideScalar(float* mid, float* side, const float* left, const float* right, int numSamples) {
+        for (int sampleIndex {0}; sampleIndex < numSamples; sampleIndex++) {
+            const float leftSample {left[sampleIndex]};
+            const float rightSample {right[sampleIndex]};
+            mid[sampleIndex] = (leftSample + rightSample) * 0.5f;
+            side[sampleIndex] = (leftSample - rightSample) * 0.5f;
+        }
+    }
+
+    void decodeMidSideScalar(float* first, float* second, const float* mid, const float* side, int numSamples) {
+        for (int sampleIndex {0}; sampleIndex < numSamples; sampleIndex++) {
+            const float midSample {mid[sampleIndex]};
+            const float sideSample {side[sampleIndex]};
+            first[sampleIndex] = midSample - sideSample;
+            second[sampleIndex] = midSample + sideSample;
+        }
+    }
+
+    const DspKernels::KernelTable scalarKernels {
+        DspKernels::ISA::SCALAR,
+        applyGainAndMeasureScalar,
+        addScalar,
+        encodeMidSideScalar,
+        decodeMidSideScalar
+    };
+
+    /**
+     * Finishes off a vector gain kernel by processing the remaining samples with the scalar
+     * reference and combining the levels.
+     */
+    ChannelLevels finishGainAndMeasure(float* samples,
+                                       int numSamples,
+                                       int numVectorSamples,
+                                       float startGain,
+                                       float gainIncrement,
+                                       float peak,
+                                       float sumSquares) {
+        for (int sampleIndex {numVectorSamples}; sampleIndex < numSamples; sampleIndex++) {
+            const float sample {samples[sampleIndex] * (startGain + gainIncrement * static_cast<float>(sampleIndex))};
+            samples[sampleIndex] = sample;
+            peak = std::max(peak, std::abs(sample));
+            sumSquares += sample * sample;
+        }
+
+        return {peak, numSamples > 0 ? sumSquares / numSamples : 0};
+    }
+
+#if JUCE_INTEL
+    // SSE2 is part of x64, but may not be available on older 32 bit CPUs
+
+    KERNEL_TARGET("sse2")
+    ChannelLevels applyGainAndMeasureSSE2(float* samples, int numSamples, float startGain, float endGain) {
+        constexpr int WIDTH {4};
+        const float gainIncrement {numSamples > 0 ? (endGain - startGain) / numSamples : 0};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+
+        const __m128 signMask {_mm_set1_ps(-0.0f)};
+        const __m128 laneOffsets {_mm_setr_ps(0, 1, 2, 3)};
+        const __m128 startGains {_mm_set1_ps(startGain)};
+        const __m128 gainIncrements {_mm_set1_ps(gainIncrement)};
+
+        __m128 peaks {_mm_setzero_ps()};
+        __m128 sumSquares {_mm_setzero_ps()};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            // Same operations as the scalar version so the output matches exactly
+            const __m128 indexes {_mm_add_ps(_mm_set1_ps(static_cast<float>(sampleIndex)), laneOffsets)};
+            const __m128 gains {_mm_add_ps(startGains, _mm_mul_ps(gainIncrements, indexes))};
+            const __m128 output {_mm_mul_ps(_mm_loadu_ps(samples + sampleIndex), gains)};
+            _mm_storeu_ps(samples + sampleIndex, output);
+
+            peaks = _mm_max_ps(peaks, _mm_andnot_ps(signMask, output));
+            sumSquares = _mm_add_ps(sumSquares, _mm_mul_ps(output, output));
+        }
+
+        alignas(16) float peakLanes[WIDTH];
+        alignas(16) float sumLanes[WIDTH];
+        _mm_store_ps(peakLanes, peaks);
+        _mm_store_ps(sumLanes, sumSquares);
+
+        return finishGainAndMeasure(samples, numSamples, numVectorSamples, startGain, gainIncrement,
+                                    std::max({peakLanes[0], peakLanes[1], peakLanes[2], peakLanes[3]}),
+                                    sumLanes[0] + sumLanes[1] + sumLanes[2] + sumLanes[3]);
+    }
+
+    KERNEL_TARGET("sse2")
+    void addSSE2(float* destination, const float* source, int numSamples) {
+        constexpr int WIDTH {4};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            _mm_storeu_ps(destination + sampleIndex,
+                          _mm_add_ps(_mm_loadu_ps(destination + sampleIndex), _mm_loadu_ps(source + sampleIndex)));
+        }
+
+        addScalar(destination + numVectorSamples, source + numVectorSamples, numSamples - numVectorSamples);
+    }
+
+    KERNEL_TARGET("sse2")
+    void encodeMidSideSSE2(float* mid, float* side, const float* left, const float* right, int numSamples) {
+        constexpr int WIDTH {4};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+        const __m128 half {_mm_set1_ps(0.5f)};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            const __m128 leftSamples {_mm_loadu_ps(left + sampleIndex)};
+            const __m128 rightSamples {_mm_loadu_ps(right + sampleIndex)};
+            _mm_storeu_ps(mid + sampleIndex, _mm_mul_ps(_mm_add_ps(leftSamples, rightSamples), half));
+            _mm_storeu_ps(side + sampleIndex, _mm_mul_ps(_mm_sub_ps(leftSamples, rightSamples), half));
+        }
+
+        encodeMidSideScalar(mid + numVectorSamples, side + numVectorSamples,
+                            left + numVectorSamples, right + numVectorSamples,
+                            numSamples - numVectorSamples);
+    }
+
+    KERNEL_TARGET("sse2")
+    void decodeMidSideSSE2(float* first, float* second, const float* mid, const float* side, int numSamples) {
+        constexpr int WIDTH {4};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            const __m128 midSamples {_mm_loadu_ps(mid + sampleIndex)};
+            const __m128 sideSamples {_mm_loadu_ps(side + sampleIndex)};
+            _mm_storeu_ps(first + sampleIndex, _mm_sub_ps(midSamples, sideSamples));
+            _mm_storeu_ps(second + sampleIndex, _mm_add_ps(midSamples, sideSamples));
+        }
+
+        decodeMidSideScalar(first + numVectorSamples, second + numVectorSamples,
+                            mid + numVectorSamples, side + numVectorSamples,
+                            numSamples - numVectorSamples);
+    }
+
+    const DspKernels::KernelTable sse2Kernels {
+        DspKernels::ISA::SSE2,
+        applyGainAndMeasureSSE2,
+        addSSE2,
+        encodeMidSideSSE2,
+        decodeMidSideSSE2
+    };
+
+    // FMA isn't used so the results match the scalar reference
+
+    KERNEL_TARGET("avx2")
+    ChannelLevels applyGainAndMeasureAVX2(float* samples, int numSamples, float startGain, float endGain) {
+        constexpr int WIDTH {8};
+        const float gainIncrement {numSamples > 0 ? (endGain - startGain) / numSamples : 0};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+
+        const __m256 signMask {_mm256_set1_ps(-0.0f)};
+        const __m256 laneOffsets {_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)};
+        const __m256 startGains {_mm256_set1_ps(startGain)};
+        const __m256 gainIncrements {_mm256_set1_ps(gainIncrement)};
+
+        __m256 peaks {_mm256_setzero_ps()};
+        __m256 sumSquares {_mm256_setzero_ps()};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            const __m256 indexes {_mm256_add_ps(_mm256_set1_ps(static_cast<float>(sampleIndex)), laneOffsets)};
+            const __m256 gains {_mm256_add_ps(startGains, _mm256_mul_ps(gainIncrements, indexes))};
+            const __m256 output {_mm256_mul_ps(_mm256_loadu_ps(samples + sampleIndex), gains)};
+            _mm256_storeu_ps(samples + sampleIndex, output);
+
+            peaks = _mm256_max_ps(peaks, _mm256_andnot_ps(signMask, output));
+            sumSquares = _mm256_add_ps(sumSquares, _mm256_mul_ps(output, output));
+        }
+
+        alignas(32) float peakLanes[WIDTH];
+        alignas(32) float sumLanes[WIDTH];
+        _mm256_store_ps(peakLanes, peaks);
+        _mm256_store_ps(sumLanes, sumSquares);
+
+        float peak {0};
+        float sum {0};
+        for (int lane {0}; lane < WIDTH; lane++) {
+            peak = std::max(peak, peakLanes[lane]);
+            sum += sumLanes[lane];
+        }
+
+        return finishGainAndMeasure(samples, numSamples, numVectorSamples, startGain, gainIncrement, peak, sum);
+    }
+
+    KERNEL_TARGET("avx2")
+    void addAVX2(float* destination, const float* source, int numSamples) {
+        constexpr int WIDTH {8};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            _mm256_storeu_ps(destination + sampleIndex,
+                             _mm256_add_ps(_mm256_loadu_ps(destination + sampleIndex), _mm256_loadu_ps(source + sampleIndex)));
+        }
+
+        addScalar(destination + numVectorSamples, source + numVectorSamples, numSamples - numVectorSamples);
+    }
+
+    KERNEL_TARGET("avx2")
+    void encodeMidSideAVX2(float* mid, float* side, const float* left, const float* right, int numSamples) {
+        constexpr int WIDTH {8};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+        const __m256 half {_mm256_set1_ps(0.5f)};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            const __m256 leftSamples {_mm256_loadu_ps(left + sampleIndex)};
+            const __m256 rightSamples {_mm256_loadu_ps(right + sampleIndex)};
+            _mm256_storeu_ps(mid + sampleIndex, _mm256_mul_ps(_mm256_add_ps(leftSamples, rightSamples), half));
+            _mm256_storeu_ps(side + sampleIndex, _mm256_mul_ps(_mm256_sub_ps(leftSamples, rightSamples), half));
+        }
+
+        encodeMidSideScalar(mid + numVectorSamples, side + numVectorSamples,
+                            left + numVectorSamples, right + numVectorSamples,
+                            numSamples - numVectorSamples);
+    }
+
+    KERNEL_TARGET("avx2")
+    void decodeMidSideAVX2(float* first, float* second, const float* mid, const float* side, int numSamples) {
+        constexpr int WIDTH {8};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            const __m256 midSamples {_mm256_loadu_ps(mid + sampleIndex)};
+            const __m256 sideSamples {_mm256_loadu_ps(side + sampleIndex)};
+            _mm256_storeu_ps(first + sampleIndex, _mm256_sub_ps(midSamples, sideSamples));
+            _mm256_storeu_ps(second + sampleIndex, _mm256_add_ps(midSamples, sideSamples));
+        }
+
+        decodeMidSideScalar(first + numVectorSamples, second + numVectorSamples,
+                            mid + numVectorSamples, side + numVectorSamples,
+                            numSamples - numVectorSamples);
+    }
+
+    const DspKernels::KernelTable avx2Kernels {
+        DspKernels::ISA::AVX2,
+        applyGainAndMeasureAVX2,
+        addAVX2,
+        encodeMidSideAVX2,
+        decodeMidSideAVX2
+    };
+
+    KERNEL_TARGET("avx512f")
+    ChannelLevels applyGainAndMeasureAVX512(float* samples, int numSamples, float startGain, float endGain) {
+        constexpr int WIDTH {16};
+        const float gainIncrement {numSamples > 0 ? (endGain - startGain) / numSamples : 0};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+
+        const __m512 laneOffsets {_mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)};
+        const __m512 startGains {_mm512_set1_ps(startGain)};
+        const __m512 gainIncrements {_mm512_set1_ps(gainIncrement)};
+
+        __m512 peaks {_mm512_setzero_ps()};
+        __m512 sumSquares {_mm512_setzero_ps()};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            const __m512 indexes {_mm512_add_ps(_mm512_set1_ps(static_cast<float>(sampleIndex)), laneOffsets)};
+            const __m512 gains {_mm512_add_ps(startGains, _mm512_mul_ps(gainIncrements, indexes))};
+            const __m512 output {_mm512_mul_ps(_mm512_loadu_ps(samples + sampleIndex), gains)};
+            _mm512_storeu_ps(samples + sampleIndex, output);
+
+            peaks = _mm512_max_ps(peaks, _mm512_abs_ps(output));
+            sumSquares = _mm512_add_ps(sumSquares, _mm512_mul_ps(output, output));
+        }
+
+        alignas(64) float peakLanes[WIDTH];
+        alignas(64) float sumLanes[WIDTH];
+        _mm512_store_ps(peakLanes, peaks);
+        _mm512_store_ps(sumLanes, sumSquares);
+
+        float peak {0};
+        float sum {0};
+        for (int lane {0}; lane < WIDTH; lane++) {
+            peak = std::max(peak, peakLanes[lane]);
+            sum += sumLanes[lane];
+        }
+
+        return finishGainAndMeasure(samples, numSamples, numVectorSamples, startGain, gainIncrement, peak, sum);
+    }
+
+    KERNEL_TARGET("avx512f")
+    void addAVX512(float* destination, const float* source, int numSamples) {
+        constexpr int WIDTH {16};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            _mm512_storeu_ps(destination + sampleIndex,
+                             _mm512_add_ps(_mm512_loadu_ps(destination + sampleIndex), _mm512_loadu_ps(source + sampleIndex)));
+        }
+
+        addScalar(destination + numVectorSamples, source + numVectorSamples, numSamples - numVectorSamples);
+    }
+
+    KERNEL_TARGET("avx512f")
+    void encodeMidSideAVX512(float* mid, float* side, const float* left, const float* right, int numSamples) {
+        constexpr int WIDTH {16};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+        const __m512 half {_mm512_set1_ps(0.5f)};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            const __m512 leftSamples {_mm512_loadu_ps(left + sampleIndex)};
+            const __m512 rightSamples {_mm512_loadu_ps(right + sampleIndex)};
+            _mm512_storeu_ps(mid + sampleIndex, _mm512_mul_ps(_mm512_add_ps(leftSamples, rightSamples), half));
+            _mm512_storeu_ps(side + sampleIndex, _mm512_mul_ps(_mm512_sub_ps(leftSamples, rightSamples), half));
+        }
+
+        encodeMidSideScalar(mid + numVectorSamples, side + numVectorSamples,
+                            left + numVectorSamples, right + numVectorSamples,
+                            numSamples - numVectorSamples);
+    }
+
+    KERNEL_TARGET("avx512f")
+    void decodeMidSideAVX512(float* first, float* second, const float* mid, const float* side, int numSamples) {
+        constexpr int WIDTH {16};
+        const int numVectorSamples {numSamples - (numSamples % WIDTH)};
+
+        for (int sampleIndex {0}; sampleIndex < numVectorSamples; sampleIndex += WIDTH) {
+            const __m512 midSamples {_mm512_loadu_ps(mid + sampleIndex)};
+            const __m512 sideSamples {_mm512_loadu_ps(side + sampleIndex)};
+            _mm512_storeu_ps(first + sampleIndex, _mm512_sub_ps(midSamples, sideSamples));
+            _mm512_storeu_ps(second + sampleIndex, _mm512_add_ps(midSamples, sideSamples));
+        }
+
+        decodeMidSideScalar(first + numVectorSamples, second + numVectorSamples,
+                            mid + numVectorSamples, side + numVectorSamples,
+                            numSamples - numVectorSamples);
+    }
+
+    const DspKernels::KernelTable avx512Kernels {
+        DspKernels::ISA::AVX512,
+        applyGainAndMeasureAVX512,
+        addAVX512,
+        encodeMidSideAVX512,
+        decodeMidSideAVX512
+    };
+#endif
+
+    bool isNear(float a, float b) {
+        // The vector versions sum in a different order, so allow for some rounding error
+        return std::abs(a - b) <= 1e-5f * std::max({1.0f, std::abs(a), std::abs(b)});
+    }
+
+    bool isNear(const std::vector<float>& a, const std::vector<float>& b) {
+        for (size_t index {0}; index < a.size(); index++) {
+            if (!isNear(a[index], b[index])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    const DspKernels::KernelTable& selectKernels() {
+        // Try the widest first
+        for (DspKernels::ISA isa : {DspKernels::ISA::AVX512, DspKernels::ISA::AVX2, DspKernels::ISA::SSE2}) {
+            const DspKernels::KernelTable* kernels {DspKernels::getForISA(isa)};
+
+            if (kernels != nullptr) {
+                if (DspKernels::runSelfTest(*kernels)) {
+                    juce::Logger::writeToLog("Using " + DspKernels::isaToString(isa) + " DSP kernels");
+                    return *kernels;
+                }
+
+                juce::Logger::writeToLog("DSP kernels for " + DspKernels::isaToString(isa) + " failed self test");
+            }
+        }
+
+        juce::Logger::writeToLog("Using scalar DSP kernels");
+        return scalarKernels;
+    }
+}
+
+namespace DspKernels {
+    const KernelTable& get() {
+        static const KernelTable& kernels {selectKernels()};
+        return kernels;
+    }
+
+    const KernelTable* getForISA(ISA isa) {
+        switch (isa) {
+            case ISA::SCALAR:
+                return &scalarKernels;
+#if JUCE_INTEL
+            case ISA::SSE2:
+                return juce::SystemStats::hasSSE2() ? &sse2Kernels : nullptr;
+            case ISA::AVX2:
+                return juce::SystemStats::hasAVX2() ? &avx2Kernels : nullptr;
+            case ISA::AVX512:
+                return juce::SystemStats::hasAVX512F() ? &avx512Kernels : nullptr;
+#else
+            case ISA::SSE2:
+            case ISA::AVX2:
+            case ISA::AVX512:
+                return nullptr;
+#endif
+        }
+
+        return nullptr;
+    }
+
+    bool runSelfTest(const KernelTable& kernels) {
+        juce::Random random(1234);
+
+        // Include lengths that leave samples for the scalar remainder
+        for (int numSamples : {0, 1, 7, 16, 33, 512, 509}) {
+            std::vector<float> first(numSamples);
+            std::vector<float> second(numSamples);
+            for (int index {0}; index < numSamples; index++) {
+                first[index] = random.nextFloat() * 2 - 1;
+                second[index] = random.nextFloat() * 2 - 1;
+            }
+
+            // Gain
+            {
+                std::vector<float> expected(first);
+                std::vector<float> actual(first);
+                const ChannelLevels expectedLevels {scalarKernels.applyGainAndMeasure(expected.data(), numSamples, 0.5f, 1.5f)};
+                const ChannelLevels actualLevels {kernels.applyGainAndMeasure(actual.data(), numSamples, 0.5f, 1.5f)};
+
+                if (!isNear(expected, actual) ||
+                    !isNear(expectedLevels.peak, actualLevels.peak) ||
+                    !isNear(expectedLevels.meanSquare, actualLevels.meanSquare)) {
+                    return false;
+                }
+            }
+
+            // Add
+            {
+                std::vector<float> expected(first);
+                std::vector<float> actual(first);
+                scalarKernels.add(expected.data(), second.data(), numSamples);
+                kernels.add(actual.data(), second.data(), numSamples);
+
+                if (!isNear(expected, actual)) {
+                    return false;
+                }
+            }
+
+            // Mid/side
+            {
+                std::vector<float> expectedMid(numSamples), expectedSide(numSamples);
+                std::vector<float> actualMid(numSamples), actualSide(numSamples);
+                scalarKernels.encodeMidSide(expectedMid.data(), expectedSide.data(), first.data(), second.data(), numSamples);
+                kernels.encodeMidSide(actualMid.data(), actualSide.data(), first.data(), second.data(), numSamples);
+
+                if (!isNear(expectedMid, actualMid) || !isNear(expectedSide, actualSide)) {
+                    return false;
+                }
+
+                std::vector<float> expectedFirst(numSamples), expectedSecond(numSamples);
+                std::vector<float> actualFirst(numSamples), actualSecond(numSamples);
+                scalarKernels.decodeMidSide(expectedFirst.data(), expectedSecond.data(), first.data(), second.data(), numSamples);
+                kernels.decodeMidSide(actualFirst.data(), actualSecond.data(), first.data(), second.data(), numSamples);
+
+                if (!isNear(expectedFirst, actualFirst) || !isNear(expectedSecond, actualSecond)) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    juce::String isaToString(ISA isa) {
+        switch (isa) {
+            case ISA::SCALAR:
+                return "scalar";
+            case ISA::SSE2:
+                return "SSE2";
+            case ISA::AVX2:
+                return "AVX2";
+            case ISA::AVX512:
+                return "AVX-512";
+        }
+
+        return "unknown";
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Levels of one channel of a block, measured after gain has been applied.
+ */
+struct ChannelLevels {
+    float peak;
+    float meanSquare;
+};
+
+/**
+ * The hot loops of Syndicate's own DSP, compiled for several instruction sets so a single binary
+ * can use the widest one the CPU supports.
+ *
+ * The best variant is chosen the first time the kernels are requested. Each variant is checked
+ * against the scalar reference before it's used, and a variant that doesn't match is skipped.
+ */
+namespace DspKernels {
+    enum class ISA {
+        SCALAR,
+        SSE2,
+        AVX2,
+        AVX512
+    };
+
+    struct KernelTable {
+        ISA isa;
+
+        /**
+         * Multiplies the samples by a gain that ramps linearly from startGain to endGain and returns
+         * the levels of the result.
+         */
+        ChannelLevels (*applyGainAndMeasure)(float* samples, int numSamples, float startGain, float endGain);
+
+        /**
+         * destination += source
+         */
+        void (*add)(float* destination, const float* source, int numSamples);
+
+        /**
+         * mid = (left + right) / 2, side = (left - right) / 2
+         */
+        void (*encodeMidSide)(float* mid, float* side, const float* left, const float* right, int numSamples);
+
+        /**
+         * first = mid - side, second = mid + side
+         */
+        void (*decodeMidSide)(float* first, float* second, const float* mid, const float* side, int numSamples);
+    };
+
+    /**
+     * Returns the kernels selected for this CPU. Safe to call from any thread, the selection is only
+     * made once.
+     */
+    const KernelTable& get();
+
+    /**
+     * Returns the kernels for the given instruction set, or nullptr if they weren't compiled in or
+     * the CPU doesn't support them.
+     */
+    const KernelTable* getForISA(ISA isa);
+
+    /**
+     * Compares the given kernels with the scalar reference, returns true if they match.
+     */
+    bool runSelfTest(const KernelTable& kernels);
+
+    juce::String isaToString(ISA isa);
+}
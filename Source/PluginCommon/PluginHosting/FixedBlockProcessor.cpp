@@ -0,0 +1,148 @@
+#include "FixedBlockProcessor.h"
+
+FixedBlockProcessor::FixedBlockProcessor(ProcessCallback processCallback) :
+        _processCallback(processCallback),
+        _blockSize(0),
+        _sampleRate(44100),
+        _numChannels(0),
+        _inputBlockIndex(0),
+        _blockPosition(0),
+        _bypassPosition(0) {
+}
+
+void FixedBlockProcessor::setBlockSize(int numSamples) {
+    _reconfigure(_sampleRate, _numChannels, std::max(numSamples, 0));
+}
+
+void FixedBlockProcessor::prepare(double sampleRate, int numChannels) {
+    _reconfigure(sampleRate, numChannels, _blockSize);
+}
+
+void FixedBlockProcessor::process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, juce::AudioPlayHead* playHead) {
+    WECore::AudioSpinTryLock lock(_configMutex);
+
+    if (!lock.isLocked()) {
+        // Being reconfigured, the splitter mustn't be given the host's buffer as it may not be the
+        // size it expects
+        _processBypassed(buffer);
+        return;
+    }
+
+    if (_blockSize == 0) {
+        // Disabled, process as normal
+        _processCallback(buffer, midiMessages, playHead);
+        return;
+    }
+
+    const int numChannels {std::min(buffer.getNumChannels(), _numChannels)};
+    int bufferPosition {0};
+    _outputMidi.clear();
+
+    while (bufferPosition < buffer.getNumSamples()) {
+        juce::AudioBuffer<float>& inputBlock = _blocks[_inputBlockIndex];
+        juce::AudioBuffer<float>& outputBlock = _blocks[1 - _inputBlockIndex];
+        juce::MidiBuffer& inputMidi = _blockMidi[_inputBlockIndex];
+        const juce::MidiBuffer& outputMidi = _blockMidi[1 - _inputBlockIndex];
+
+        // Swap this part of the buffer with the same part of the processed block
+        const int numSamples {std::min(buffer.getNumSamples() - bufferPosition, _blockSize - _blockPosition)};
+
+        for (int channel {0}; channel < numChannels; channel++) {
+            inputBlock.copyFrom(channel, _blockPosition, buffer, channel, bufferPosition, numSamples);
+            buffer.copyFrom(channel, bufferPosition, outputBlock, channel, _blockPosition, numSamples);
+        }
+
+        // The events are moved to the same positions in the blocks as their audio
+        inputMidi.addEvents(midiMessages, bufferPosition, numSamples, _blockPosition - bufferPosition);
+        _outputMidi.addEvents(outputMidi, _blockPosition, numSamples, bufferPosition - _blockPosition);
+
+        bufferPosition += numSamples;
+        _blockPosition += numSamples;
+
+        if (_blockPosition == _blockSize) {
+            // The whole of the output block has been read, so process the input block in place
+            // and it becomes the next output block
+            // This block started _blockSize samples before the current position in the buffer
+            _blockPlayHead.setFrom(playHead);
+            _blockPlayHead.advance(bufferPosition - _blockSize, _sampleRate);
+
+            _processCallback(inputBlock, inputMidi, &_blockPlayHead);
+
+            _inputBlockIndex = 1 - _inputBlockIndex;
+            _blockPosition = 0;
+
+            // The events from the old output block have all been read
+            _blockMidi[_inputBlockIndex].clear();
+        }
+    }
+
+    midiMessages.clear();
+    midiMessages.addEvents(_outputMidi, 0, -1, 0);
+}
+
+void FixedBlockProcessor::_reconfigure(double sampleRate, int numChannels, int blockSize) {
+    // Allocate everything before locking, the old buffers are deleted after unlocking
+    std::array<juce::AudioBuffer<float>, 2> blocks;
+    for (juce::AudioBuffer<float>& block : blocks) {
+        block.setSize(numChannels, blockSize);
+        block.clear();
+    }
+
+    std::array<juce::MidiBuffer, 2> blockMidi;
+    for (juce::MidiBuffer& midi : blockMidi) {
+        midi.ensureSize(MIDI_BUFFER_SIZE);
+    }
+
+    juce::MidiBuffer outputMidi;
+    outputMidi.ensureSize(MIDI_BUFFER_SIZE);
+
+    juce::AudioBuffer<float> bypassDelay(numChannels, blockSize);
+    bypassDelay.clear();
+
+    // The bypass delay is swapped first, so it's ready to be used while the blocks are swapped
+    {
+        WECore::AudioSpinLock lock(_bypassMutex);
+        std::swap(_bypassDelay, bypassDelay);
+        _bypassPosition = 0;
+    }
+
+    {
+        WECore::AudioSpinLock lock(_configMutex);
+        std::swap(_blocks, blocks);
+        std::swap(_blockMidi, blockMidi);
+        std::swap(_outputMidi, outputMidi);
+
+        _sampleRate = sampleRate;
+        _numChannels = numChannels;
+        _blockSize = blockSize;
+        _inputBlockIndex = 0;
+        _blockPosition = 0;
+    }
+}
+
+void FixedBlockProcessor::_processBypassed(juce::AudioBuffer<float>& buffer) {
+    WECore::AudioSpinTryLock lock(_bypassMutex);
+
+    // Only one of the locks is held at a time, so this should only fail if the processor is being
+    // reconfigured again straight away. If so (or the block size is 0) the buffer is left as it is.
+    const int delaySize {_bypassDelay.getNumSamples()};
+    if (!lock.isLocked() || delaySize == 0) {
+        return;
+    }
+
+    const int numChannels {std::min(buffer.getNumChannels(), _bypassDelay.getNumChannels())};
+    int bufferPosition {0};
+
+    while (bufferPosition < buffer.getNumSamples()) {
+        const int numSamples {std::min(buffer.getNumSamples() - bufferPosition, delaySize - _bypassPosition)};
+
+        // Swap this part of the buffer with the same part of the delay
+        for (int channel {0}; channel < numChannels; channel++) {
+            float* bufferData {buffer.getWritePointer(channel, bufferPosition)};
+            std::swap_ranges(bufferData, bufferData + numSamples, _bypassDelay.getWritePointer(channel, _bypassPosition));
+        }
+
+        bufferPosition += numSamples;
+        _bypassPosition = (_bypassPosition + numSamples) % delaySize;
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "General/AudioSpinMutex.h"
+#include "PositionPlayHead.h"
+
+/**
+ * Splits or combines the host's buffers so the splitter is always processed in blocks of the same
+ * size, regardless of the host's buffer size.
+ *
+ * At very small host buffer sizes this avoids paying the fixed overhead of processing the graph
+ * (modulation lookups, per slot calls, latency compensation, splitter copies) for every tiny block.
+ * The block size is added as latency, which must be reported to the host. MIDI is delayed along
+ * with the audio.
+ *
+ * The buffers are allocated before locking and swapped in, so the audio thread is rarely held up
+ * by a reconfiguration. If it is, the host's buffer is passed through a delay of the block size
+ * instead of processing the splitter, so the splitter is never given a block of a different size.
+ */
+class FixedBlockProcessor {
+public:
+    typedef std::function<void(juce::AudioBuffer<float>&, juce::MidiBuffer&, juce::AudioPlayHead*)> ProcessCallback;
+
+    explicit FixedBlockProcessor(ProcessCallback processCallback);
+    ~FixedBlockProcessor() = default;
+
+    /**
+     * Sets the size of the blocks the splitter is processed in, 0 processes the host's buffers
+     * directly.
+     */
+    void setBlockSize(int numSamples);
+
+    /**
+     * @see setBlockSize
+     */
+    int getBlockSize() const { return _blockSize; }
+
+    /**
+     * Returns the latency added by this processor, which should be added to the latency reported
+     * to the host.
+     */
+    int getLatencySamples() const { return _blockSize; }
+
+    /**
+     * Allocates the buffers. Must be called before processing and whenever the configuration
+     * changes.
+     */
+    void prepare(double sampleRate, int numChannels);
+
+    void process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, juce::AudioPlayHead* playHead);
+
+private:
+    static constexpr int MIDI_BUFFER_SIZE {2048};
+
+    ProcessCallback _processCallback;
+
+    // Held while the buffers are swapped for newly allocated ones
+    WECore::AudioSpinMutex _configMutex;
+
+    std::atomic<int> _blockSize;
+    double _sampleRate;
+    int _numChannels;
+
+    // Input is collected in one block while the output is read from the other, which was
+    // processed when it was last filled
+    std::array<juce::AudioBuffer<float>, 2> _blocks;
+    std::array<juce::MidiBuffer, 2> _blockMidi;
+    int _inputBlockIndex;
+    int _blockPosition;
+
+    // The events from the output block for the host's buffer
+    juce::MidiBuffer _outputMidi;
+
+    PositionPlayHead _blockPlayHead;
+
+    // Used instead of the blocks while they're being swapped, it has its own lock so it can be
+    // swapped at a different time
+    WECore::AudioSpinMutex _bypassMutex;
+    juce::AudioBuffer<float> _bypassDelay;
+    int _bypassPosition;
+
+    void _reconfigure(double sampleRate, int numChannels, int blockSize);
+
+    /**
+     * Delays the buffer by the block size without processing it, MIDI is passed straight through.
+     */
+    void _processBypassed(juce::AudioBuffer<float>& buffer);
+};
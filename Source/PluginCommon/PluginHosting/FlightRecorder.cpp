@@ -0,0 +1,335 @@
+#include "FlightRecorder.h"
+#include "PluginSplitter.h"
+#include "PluginChain.h"
+
+namespace {
+    thread_local FlightRecorder* currentRecorder {nullptr};
+
+    double ticksToMilliseconds(juce::int64 ticks) {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1000;
+    }
+
+    juce::String describeEvent(const FlightRecorder::Event& event, const FlightRecorder::ReportContext& context) {
+        if (event.owner == nullptr) {
+            return FlightRecorder::stageToString(event.stage);
+        }
+
+        juce::String name;
+        const auto nameIterator = context.names.find({event.owner, event.stage == FLIGHT_STAGE::SLOT ? event.slotIndex : -1});
+        if (nameIterator != context.names.end()) {
+            name = nameIterator->second;
+        } else {
+            // The chain has been removed since the block was recorded
+            name = event.stage == FLIGHT_STAGE::SLOT ? "removed chain slot " + juce::String(event.slotIndex + 1) : "removed chain";
+        }
+
+        return event.stage == FLIGHT_STAGE::LATENCY_COMPENSATION ? name + " " + FlightRecorder::stageToString(event.stage) : name;
+    }
+}
+
+FlightRecorder::ThreadScope::ThreadScope(FlightRecorder* recorder) : _previousRecorder(currentRecorder) {
+    currentRecorder = recorder;
+}
+
+FlightRecorder::ThreadScope::~ThreadScope() {
+    currentRecorder = _previousRecorder;
+}
+
+FlightRecorder::StageTimer::StageTimer(FLIGHT_STAGE stage, const void* owner, int slotIndex) :
+        _traceScope(stageToString(stage), "engine", slotIndex >= 0 ? "slot" : nullptr, slotIndex),
+        _recorder(FlightRecorder::getCurrent()),
+        _stage(stage),
+        _owner(owner),
+        _slotIndex(slotIndex),
+        _startTicks(_recorder != nullptr ? juce::Time::getHighResolutionTicks() : 0) {
+}
+
+FlightRecorder::StageTimer::~StageTimer() {
+    if (_recorder != nullptr) {
+        _recorder->_recordEvent({_stage, _owner, _slotIndex, _startTicks, juce::Time::getHighResolutionTicks(), juce::Thread::getCurrentThreadId()});
+    }
+}
+
+FlightRecorder::FlightRecorder(juce::File reportDirectory) :
+        _reportDirectory(reportDirectory),
+        _threshold(DEFAULT_THRESHOLD),
+        _sampleRate(44100),
+        _hostBlockSize(0),
+        _currentBlockIndex(0),
+        _isBlockInProgress(false),
+        _isFrozen(false),
+        _numActiveWriters(0),
+        _missBlockNumber(-1),
+        _nextBlockNumber(0),
+        _blocksUntilFreeze(0),
+        _secondsSinceReport(MIN_REPORT_INTERVAL_S) {
+    for (BlockRecord& block : _blocks) {
+        block.blockNumber = -1;
+        block.startTicks = 0;
+        block.endTicks = 0;
+        block.numSamples = 0;
+        block.numEvents = 0;
+    }
+}
+
+FlightRecorder::~FlightRecorder() {
+    cancelPendingUpdate();
+}
+
+void FlightRecorder::prepareToPlay(double sampleRate, int hostBlockSize) {
+    _sampleRate = sampleRate;
+    _hostBlockSize = hostBlockSize;
+}
+
+void FlightRecorder::beginBlock() {
+    if (getThreshold() <= 0 || _isFrozen.load()) {
+        return;
+    }
+
+    const int blockIndex {static_cast<int>(_nextBlockNumber % NUM_BLOCKS)};
+    BlockRecord& block = _blocks[blockIndex];
+    block.blockNumber = _nextBlockNumber++;
+    block.startTicks = juce::Time::getHighResolutionTicks();
+    block.endTicks = block.startTicks;
+    block.numSamples = 0;
+    block.numEvents.store(0, std::memory_order_relaxed);
+
+    _currentBlockIndex.store(blockIndex, std::memory_order_relaxed);
+    _isBlockInProgress.store(true, std::memory_order_release);
+}
+
+void FlightRecorder::endBlock(int numSamples) {
+    if (!_isBlockInProgress.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    _isBlockInProgress.store(false, std::memory_order_relaxed);
+
+    BlockRecord& block = _blocks[_currentBlockIndex.load(std::memory_order_relaxed)];
+    block.endTicks = juce::Time::getHighResolutionTicks();
+    block.numSamples = numSamples;
+
+    const double sampleRate {_sampleRate.load()};
+    if (numSamples <= 0 || sampleRate <= 0) {
+        return;
+    }
+
+    const double blockSeconds {numSamples / sampleRate};
+    _secondsSinceReport += blockSeconds;
+
+    if (_blocksUntilFreeze > 0) {
+        // Recording the blocks after a miss
+        _blocksUntilFreeze--;
+
+        if (_blocksUntilFreeze == 0) {
+            _isFrozen.store(true);
+            triggerAsyncUpdate();
+        }
+    } else if (_secondsSinceReport >= MIN_REPORT_INTERVAL_S) {
+        const double processingSeconds {juce::Time::highResolutionTicksToSeconds(block.endTicks - block.startTicks)};
+
+        if (processingSeconds > getThreshold() * blockSeconds) {
+            // Keep going so the report shows what happened afterwards too
+            _missBlockNumber.store(block.blockNumber);
+            _blocksUntilFreeze = NUM_BLOCKS / 2;
+            _secondsSinceReport = 0;
+        }
+    }
+}
+
+FlightRecorder* FlightRecorder::getCurrent() {
+    if (currentRecorder != nullptr && currentRecorder->_isBlockInProgress.load(std::memory_order_acquire)) {
+        return currentRecorder;
+    }
+
+    return nullptr;
+}
+
+void FlightRecorder::setThreshold(float threshold) {
+    _threshold.store(std::max(threshold, 0.0f), std::memory_order_relaxed);
+}
+
+void FlightRecorder::describeSplitter(PluginSplitter& splitter, juce::String prefix, ReportContext& context) {
+    context.description += prefix + splitTypeToString(splitter.getSplitType()) + " splitter plan:\n" + splitter.getPlanDescription();
+
+    for (size_t chainIndex {0}; chainIndex < splitter.getNumChains(); chainIndex++) {
+        const PluginChain* chain = splitter.getChain(static_cast<int>(chainIndex)).get();
+        const juce::String chainName {prefix + "chain " + juce::String(chainIndex + 1)};
+
+        juce::String chainState;
+        if (chain->isHibernated()) {
+            chainState = " (hibernated)";
+        } else if (chain->isFrozen()) {
+            chainState = " (frozen)";
+        } else if (chain->getChainBypass()) {
+            chainState = " (bypassed)";
+        } else if (chain->getChainMute()) {
+            chainState = " (muted)";
+        }
+
+        context.names[{chain, -1}] = chainName;
+        context.description += chainName + chainState + ", latency " + juce::String(chain->getLatencySamples()) + " samples\n";
+
+        for (size_t slotIndex {0}; slotIndex < chain->getNumSlots(); slotIndex++) {
+            const juce::String slotName {chainName + " slot " + juce::String(slotIndex + 1)};
+
+            std::shared_ptr<juce::AudioPluginInstance> plugin = chain->getPlugin(static_cast<int>(slotIndex));
+            PluginSplitter* nestedSplitter = chain->getSplitter(static_cast<int>(slotIndex));
+
+            juce::String slotDescription;
+            if (plugin != nullptr) {
+                slotDescription = plugin->getName() + ", latency " + juce::String(plugin->getLatencySamples()) + " samples";
+            } else if (nestedSplitter != nullptr) {
+                slotDescription = juce::String(splitTypeToString(nestedSplitter->getSplitType())) + " splitter";
+            } else {
+                slotDescription = "gain stage";
+            }
+
+            context.names[{chain, static_cast<int>(slotIndex)}] = slotName + " (" + slotDescription + ")";
+            context.description += "    " + slotName + ": " + slotDescription + "\n";
+
+            if (nestedSplitter != nullptr) {
+                describeSplitter(*nestedSplitter, slotName + " ", context);
+            }
+        }
+    }
+}
+
+const char* FlightRecorder::stageToString(FLIGHT_STAGE stage) {
+    switch (stage) {
+        case FLIGHT_STAGE::MODULATION_SOURCES:
+            return "modulation sources";
+        case FLIGHT_STAGE::SPLITTER:
+            return "splitter";
+        case FLIGHT_STAGE::CHAIN:
+            return "chain";
+        case FLIGHT_STAGE::LATENCY_COMPENSATION:
+            return "latency compensation";
+        case FLIGHT_STAGE::SLOT:
+            return "slot";
+        case FLIGHT_STAGE::OUTPUT:
+            return "output";
+    }
+
+    return "unknown";
+}
+
+void FlightRecorder::_recordEvent(const Event& event) {
+    // The writer count is incremented before checking if the ring is frozen, so the message thread
+    // can't start copying it while this is still writing
+    _numActiveWriters++;
+
+    if (!_isFrozen.load()) {
+        BlockRecord& block = _blocks[_currentBlockIndex.load(std::memory_order_relaxed)];
+
+        const int eventIndex {block.numEvents.fetch_add(1, std::memory_order_relaxed)};
+        if (eventIndex < MAX_EVENTS_PER_BLOCK) {
+            block.events[eventIndex] = event;
+        }
+    }
+
+    _numActiveWriters--;
+}
+
+void FlightRecorder::handleAsyncUpdate() {
+    if (!_isFrozen.load()) {
+        return;
+    }
+
+    if (_numActiveWriters.load() != 0) {
+        // A stage is still being written, try again shortly
+        triggerAsyncUpdate();
+        return;
+    }
+
+    std::vector<BlockSnapshot> blocks;
+    for (const BlockRecord& block : _blocks) {
+        if (block.blockNumber >= 0) {
+            const int numEvents {block.numEvents.load(std::memory_order_relaxed)};
+            const int numRecordedEvents {std::min(numEvents, MAX_EVENTS_PER_BLOCK)};
+
+            blocks.push_back({block.blockNumber,
+                              block.startTicks,
+                              block.endTicks,
+                              block.numSamples,
+                              numEvents,
+                              std::vector<Event>(block.events.begin(), block.events.begin() + numRecordedEvents)});
+        }
+    }
+
+    const juce::int64 missBlockNumber {_missBlockNumber.load()};
+
+    // The audio thread can start recording again now
+    _isFrozen.store(false);
+
+    std::sort(blocks.begin(), blocks.end(), [](const BlockSnapshot& a, const BlockSnapshot& b) {
+        return a.blockNumber < b.blockNumber;
+    });
+
+    const juce::File reportFile {
+        _reportDirectory.getChildFile("DeadlineMiss_" + juce::Time::getCurrentTime().formatted("%Y-%m-%d_%H-%M-%S") + ".txt")
+    };
+
+    _reportDirectory.createDirectory();
+    if (reportFile.replaceWithText(_createReport(blocks, missBlockNumber))) {
+        juce::Logger::writeToLog("Block " + juce::String(missBlockNumber) + " missed its deadline, report written to " + reportFile.getFullPathName());
+    } else {
+        juce::Logger::writeToLog("Block " + juce::String(missBlockNumber) + " missed its deadline, failed to write report to " + reportFile.getFullPathName());
+    }
+}
+
+juce::String FlightRecorder::_createReport(const std::vector<BlockSnapshot>& blocks, juce::int64 missBlockNumber) const {
+    const ReportContext context {_getReportContext != nullptr ? _getReportContext() : ReportContext()};
+    const double sampleRate {_sampleRate.load()};
+
+    juce::String retVal;
+    retVal += "Deadline miss report " + juce::Time::getCurrentTime().toString(true, true) + "\n";
+    retVal += "Block " + juce::String(missBlockNumber) + " took more than " + juce::String(juce::roundToInt(getThreshold() * 100)) + "% of its duration\n";
+    retVal += "Sample rate: " + juce::String(sampleRate) + "\n";
+    retVal += "Host block size: " + juce::String(_hostBlockSize.load()) + "\n\n";
+
+    if (context.description.isNotEmpty()) {
+        retVal += context.description + "\n";
+    }
+
+    // Threads are numbered in the order they first appear
+    std::vector<juce::Thread::ThreadID> threadIds;
+    auto getThreadNumber = [&threadIds](juce::Thread::ThreadID threadId) {
+        auto threadIterator = std::find(threadIds.begin(), threadIds.end(), threadId);
+        if (threadIterator == threadIds.end()) {
+            threadIds.push_back(threadId);
+            return static_cast<int>(threadIds.size());
+        }
+
+        return static_cast<int>(std::distance(threadIds.begin(), threadIterator)) + 1;
+    };
+
+    for (const BlockSnapshot& block : blocks) {
+        const double durationMs {ticksToMilliseconds(block.endTicks - block.startTicks)};
+        const double deadlineMs {sampleRate > 0 ? block.numSamples / sampleRate * 1000 : 0};
+
+        retVal += "Block " + juce::String(block.blockNumber) + ": "
+            + juce::String(block.numSamples) + " samples, "
+            + juce::String(durationMs, 3) + " ms of " + juce::String(deadlineMs, 3) + " ms"
+            + (deadlineMs > 0 ? " (" + juce::String(juce::roundToInt(durationMs / deadlineMs * 100)) + "%)" : juce::String())
+            + (block.blockNumber == missBlockNumber ? " <-- miss" : "") + "\n";
+
+        std::vector<Event> events(block.events);
+        std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+            return a.startTicks < b.startTicks;
+        });
+
+        for (const Event& event : events) {
+            retVal += "    +" + juce::String(ticksToMilliseconds(event.startTicks - block.startTicks), 3) + " ms "
+                + juce::String(ticksToMilliseconds(event.endTicks - event.startTicks), 3) + " ms"
+                + " thread " + juce::String(getThreadNumber(event.threadId)) + " "
+                + describeEvent(event, context) + "\n";
+        }
+
+        if (block.numEvents > MAX_EVENTS_PER_BLOCK) {
+            retVal += "    " + juce::String(block.numEvents - MAX_EVENTS_PER_BLOCK) + " more stages not recorded\n";
+        }
+    }
+
+    return retVal;
+}
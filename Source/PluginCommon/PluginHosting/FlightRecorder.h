@@ -0,0 +1,202 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "Tracer.h"
+
+class PluginSplitter;
+
+/**
+ * The parts of a block that are timed by the flight recorder.
+ */
+enum class FLIGHT_STAGE {
+    // Advancing the LFOs and envelopes
+    MODULATION_SOURCES,
+
+    // Everything passed to the splitter, including waiting for anticipative processing
+    SPLITTER,
+
+    // A chain or crossover band, from its latency compensation to its last slot
+    CHAIN,
+
+    // A chain's latency compensation delay line
+    LATENCY_COMPENSATION,
+
+    // A single slot of a chain
+    SLOT,
+
+    // Output gain, balance and metering
+    OUTPUT
+};
+
+/**
+ * Records how long each stage of the last NUM_BLOCKS blocks took so that dropouts can be
+ * diagnosed after the fact.
+ *
+ * When a block takes longer than the threshold fraction of its duration, recording continues for
+ * another half of the ring and then stops while the ring is copied on the message thread and
+ * written to a report file, along with a description of the graph.
+ *
+ * Reports are written to the user's disk, so the recorder is disabled until a threshold is set.
+ *
+ * beginBlock() and endBlock() are called on the audio thread. Stages can be recorded from any
+ * thread while a block is in progress using a StageTimer, they're recorded to whichever recorder
+ * the calling thread is currently in the ThreadScope of.
+ */
+class FlightRecorder : private juce::AsyncUpdater {
+public:
+    static constexpr int NUM_BLOCKS {32};
+    static constexpr int MAX_EVENTS_PER_BLOCK {128};
+
+    // Fraction of the block's duration which can be spent processing it before it's reported, zero
+    // disables the recorder
+    static constexpr float DEFAULT_THRESHOLD {0.0f};
+
+    struct Event {
+        FLIGHT_STAGE stage;
+
+        // The chain the stage belongs to, if any
+        const void* owner;
+
+        // The position of the slot in its chain for SLOT events
+        int slotIndex;
+
+        juce::int64 startTicks;
+        juce::int64 endTicks;
+        juce::Thread::ThreadID threadId;
+    };
+
+    /**
+     * Describes the graph when a report is written.
+     */
+    struct ReportContext {
+        juce::String description;
+
+        // Names of the chains and slots which may appear in an event, keyed by owner and slot index
+        // (-1 for the chain itself)
+        std::map<std::pair<const void*, int>, juce::String> names;
+    };
+
+    /**
+     * Makes the given recorder the one used by StageTimers on the calling thread until the scope
+     * ends. Nullptr stops stages being recorded.
+     */
+    class ThreadScope {
+    public:
+        explicit ThreadScope(FlightRecorder* recorder);
+        ~ThreadScope();
+
+    private:
+        FlightRecorder* _previousRecorder;
+    };
+
+    /**
+     * Records a stage that starts when the timer is created and ends when it's destroyed, if the
+     * calling thread is recording. The stage is also traced if tracing is enabled.
+     */
+    class StageTimer {
+    public:
+        StageTimer(FLIGHT_STAGE stage, const void* owner = nullptr, int slotIndex = -1);
+        ~StageTimer();
+
+    private:
+        Tracer::Scope _traceScope;
+        FlightRecorder* _recorder;
+        FLIGHT_STAGE _stage;
+        const void* _owner;
+        int _slotIndex;
+        juce::int64 _startTicks;
+    };
+
+    explicit FlightRecorder(juce::File reportDirectory);
+    ~FlightRecorder() override;
+
+    void prepareToPlay(double sampleRate, int hostBlockSize);
+
+    void beginBlock();
+    void endBlock(int numSamples);
+
+    /**
+     * Returns the recorder for the calling thread, or nullptr if there isn't one or it isn't
+     * recording a block at the moment.
+     */
+    static FlightRecorder* getCurrent();
+
+    /**
+     * Sets the fraction of each block's duration that processing may use before a report is
+     * written. Zero disables the recorder.
+     */
+    void setThreshold(float threshold);
+    float getThreshold() const { return _threshold.load(std::memory_order_relaxed); }
+
+    /**
+     * Sets the callback used on the message thread to describe the graph in each report.
+     */
+    void setReportContextCallback(std::function<ReportContext()> callback) { _getReportContext = callback; }
+
+    /**
+     * Adds the plan, chains and slots of the given splitter and any nested splitters to the
+     * context, naming each chain after the prefix and its position. Must be called on the message
+     * thread.
+     */
+    static void describeSplitter(PluginSplitter& splitter, juce::String prefix, ReportContext& context);
+
+    static const char* stageToString(FLIGHT_STAGE stage);
+
+private:
+    struct BlockRecord {
+        juce::int64 blockNumber;
+        juce::int64 startTicks;
+        juce::int64 endTicks;
+        int numSamples;
+
+        // May exceed MAX_EVENTS_PER_BLOCK, in which case the extra events weren't recorded
+        std::atomic<int> numEvents;
+        std::array<Event, MAX_EVENTS_PER_BLOCK> events;
+    };
+
+    // A copy of a block made when writing a report
+    struct BlockSnapshot {
+        juce::int64 blockNumber;
+        juce::int64 startTicks;
+        juce::int64 endTicks;
+        int numSamples;
+        int numEvents;
+        std::vector<Event> events;
+    };
+
+    // Minimum time between reports, so a session that's constantly overloaded doesn't fill the disk
+    static constexpr double MIN_REPORT_INTERVAL_S {30};
+
+    const juce::File _reportDirectory;
+    std::function<ReportContext()> _getReportContext;
+
+    std::atomic<float> _threshold;
+    std::atomic<double> _sampleRate;
+    std::atomic<int> _hostBlockSize;
+
+    std::array<BlockRecord, NUM_BLOCKS> _blocks;
+    std::atomic<int> _currentBlockIndex;
+    std::atomic<bool> _isBlockInProgress;
+
+    // Set by the audio thread once the window around a miss has been recorded, cleared by the
+    // message thread once it's been copied. Nothing is written to the ring while it's set.
+    std::atomic<bool> _isFrozen;
+
+    // Number of threads in the middle of writing an event, the ring is only copied once this is zero
+    std::atomic<int> _numActiveWriters;
+
+    // The block that triggered the current report
+    std::atomic<juce::int64> _missBlockNumber;
+
+    // Audio thread only
+    juce::int64 _nextBlockNumber;
+    int _blocksUntilFreeze;
+    double _secondsSinceReport;
+
+    void _recordEvent(const Event& event);
+
+    void handleAsyncUpdate() override;
+
+    juce::String _createReport(const std::vector<BlockSnapshot>& blocks, juce::int64 missBlockNumber) const;
+};
@@ -0,0 +1,79 @@
+#include "GainPanMeter.h"
+
+GainPanMeter::GainPanMeter() : _sampleRate(44100), _hasChannelGains(false) {
+    reset();
+}
+
+void GainPanMeter::prepareToPlay(double sampleRate) {
+    _sampleRate = sampleRate;
+    reset();
+}
+
+void GainPanMeter::reset() {
+    _hasChannelGains = false;
+
+    for (int channel {0}; channel < MAX_NUM_CHANNELS; channel++) {
+        _channelGains[channel] = 1;
+        _meanSquares[channel] = 0;
+        _outputAmplitudes[channel].store(0, std::memory_order_relaxed);
+        _outputPeaks[channel].store(0, std::memory_order_relaxed);
+    }
+}
+
+void GainPanMeter::process(juce::AudioBuffer<float>& buffer, int numChannels, float gain, float pan) {
+    numChannels = std::min({numChannels, buffer.getNumChannels(), MAX_NUM_CHANNELS});
+
+    // Pick the specialised version once per block rather than branching on the channel count
+    // inside it
+    if (numChannels == 2) {
+        _process<2>(buffer, gain, pan);
+    } else if (numChannels == 1) {
+        _process<1>(buffer, gain, pan);
+    }
+}
+
+template <int NUM_CHANNELS>
+void GainPanMeter::_process(juce::AudioBuffer<float>& buffer, float gain, float pan) {
+    const int numSamples {buffer.getNumSamples()};
+
+    std::array<float, NUM_CHANNELS> targetGains;
+    targetGains.fill(gain);
+
+    if constexpr (NUM_CHANNELS == 2) {
+        // Balance linearly attenuates the opposite channel
+        if (pan > 0) {
+            targetGains[0] *= 1 - pan;
+        } else if (pan < 0) {
+            targetGains[1] *= 1 + pan;
+        }
+    }
+
+    // Don't ramp from the default on the first block
+    if (!_hasChannelGains) {
+        std::copy(targetGains.begin(), targetGains.end(), _channelGains.begin());
+        _hasChannelGains = true;
+    }
+
+    const DspKernels::KernelTable& kernels = DspKernels::get();
+
+    for (int channel {0}; channel < NUM_CHANNELS; channel++) {
+        const ChannelLevels levels {
+            kernels.applyGainAndMeasure(buffer.getWritePointer(channel), numSamples, _channelGains[channel], targetGains[channel])
+        };
+
+        _channelGains[channel] = targetGains[channel];
+        _updateMeter(channel, levels, numSamples);
+    }
+}
+
+void GainPanMeter::_updateMeter(int channel, const ChannelLevels& levels, int numSamples) {
+    // Move towards the level of this block as a one pole filter would have over the same number of
+    // samples
+    const double timeMs {levels.meanSquare > _meanSquares[channel] ? ATTACK_TIME_MS : RELEASE_TIME_MS};
+    const double coefficient {std::exp(-numSamples / (timeMs * 0.001 * _sampleRate))};
+
+    _meanSquares[channel] = static_cast<float>(levels.meanSquare + coefficient * (_meanSquares[channel] - levels.meanSquare));
+
+    _outputAmplitudes[channel].store(std::sqrt(_meanSquares[channel]), std::memory_order_relaxed);
+    _outputPeaks[channel].store(levels.peak, std::memory_order_relaxed);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspKernels.h"
+
+/**
+ * Applies gain and balance to one or two channels and measures the result, making a single pass
+ * over each channel.
+ *
+ * Gain and balance changes are ramped across the next block rather than applied as a step. Balance
+ * is folded into the gain of each channel, so it doesn't need a pass of its own.
+ *
+ * The meter follows the mean square of each block with the same attack and release as the envelope
+ * followers it replaces, and can be read from any thread.
+ */
+class GainPanMeter {
+public:
+    static constexpr int MAX_NUM_CHANNELS {2};
+
+    GainPanMeter();
+    ~GainPanMeter() = default;
+
+    void prepareToPlay(double sampleRate);
+    void reset();
+
+    /**
+     * Applies the gain to the first numChannels channels of the buffer, and the balance as well if
+     * numChannels is 2. Pan is from -1 to 1.
+     */
+    void process(juce::AudioBuffer<float>& buffer, int numChannels, float gain, float pan);
+
+    /**
+     * Returns the smoothed RMS level.
+     */
+    float getOutputAmplitude(int channel) const { return _outputAmplitudes[channel].load(std::memory_order_relaxed); }
+
+    /**
+     * Returns the peak level of the last block.
+     */
+    float getOutputPeak(int channel) const { return _outputPeaks[channel].load(std::memory_order_relaxed); }
+
+private:
+    static constexpr double ATTACK_TIME_MS {1};
+    static constexpr double RELEASE_TIME_MS {50};
+
+    double _sampleRate;
+
+    // The gain each channel ended the last block with, ramped from at the start of the next
+    std::array<float, MAX_NUM_CHANNELS> _channelGains;
+    bool _hasChannelGains;
+
+    std::array<float, MAX_NUM_CHANNELS> _meanSquares;
+    std::array<std::atomic<float>, MAX_NUM_CHANNELS> _outputAmplitudes;
+    std::array<std::atomic<float>, MAX_NUM_CHANNELS> _outputPeaks;
+
+    template <int NUM_CHANNELS>
+    void _process(juce::AudioBuffer<float>& buffer, float gain, float pan);
+
+    void _updateMeter(int channel, const ChannelLevels& levels, int numSamples);
+};
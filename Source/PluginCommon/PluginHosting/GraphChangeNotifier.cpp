@@ -0,0 +1,25 @@
+#include "GraphChangeNotifier.h"
+#include "Tracer.h"
+
+void GraphChangeNotifier::notify(GRAPH_CHANGE change, int target) {
+    {
+        const juce::SpinLock::ScopedLockType lock(_pendingMutex);
+        _pending._targets[static_cast<int>(change)].insert(target);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void GraphChangeNotifier::handleAsyncUpdate() {
+    Tracer::Scope traceScope("graphChanged", "ui");
+
+    // Take the changes so anything notified by a listener is sent on the next iteration rather
+    // than being lost
+    Changes changes;
+    {
+        const juce::SpinLock::ScopedLockType lock(_pendingMutex);
+        std::swap(changes, _pending);
+    }
+
+    _listeners.call([&changes](Listener& listener) { listener.onGraphChanged(changes); });
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <set>
+#include <JuceHeader.h>
+
+/**
+ * The kinds of change to the graph that the UI can refresh individually.
+ */
+enum class GRAPH_CHANGE {
+    // A crossover frequency has moved, the target is the index of the crossover
+    CROSSOVER,
+
+    // A chain's bypass, mute, or solo has changed
+    CHAIN_FLAGS,
+
+    // A slot has been added, removed, replaced, or moved in a chain
+    SLOT,
+
+    // The modulation sources or targets of a slot have changed, or its modulation tray has been
+    // opened or closed
+    MODULATION_ROUTING
+};
+
+/**
+ * Collects changes to the graph and passes them to the listeners on the message thread, coalesced
+ * so each listener is called at most once per message loop iteration however many changes were
+ * made since the last one.
+ *
+ * Changes that affect the structure of the graph (split type, number of chains) aren't sent this
+ * way, they still need a full rebuild of the UI.
+ */
+class GraphChangeNotifier : private juce::AsyncUpdater {
+public:
+    static constexpr int NUM_CHANGE_TYPES {4};
+
+    /**
+     * The changes made since the listeners were last called.
+     */
+    class Changes {
+    public:
+        bool contains(GRAPH_CHANGE change) const { return !getTargets(change).empty(); }
+
+        /**
+         * Returns the chains (or crossovers for CROSSOVER) affected by the given kind of change.
+         */
+        const std::set<int>& getTargets(GRAPH_CHANGE change) const { return _targets[static_cast<int>(change)]; }
+
+    private:
+        friend class GraphChangeNotifier;
+
+        std::array<std::set<int>, NUM_CHANGE_TYPES> _targets;
+    };
+
+    class Listener {
+    public:
+        virtual ~Listener() = default;
+
+        /**
+         * Called on the message thread.
+         */
+        virtual void onGraphChanged(const Changes& changes) = 0;
+    };
+
+    GraphChangeNotifier() = default;
+    ~GraphChangeNotifier() override = default;
+
+    /**
+     * Records a change to be sent to the listeners. Can be called from any thread except the audio
+     * thread, as it may allocate.
+     */
+    void notify(GRAPH_CHANGE change, int target);
+
+    /**
+     * Listeners must be added and removed on the message thread.
+     */
+    void addListener(Listener* listener) { _listeners.add(listener); }
+    void removeListener(Listener* listener) { _listeners.remove(listener); }
+
+private:
+    juce::SpinLock _pendingMutex;
+    Changes _pending;
+
+    juce::ListenerList<Listener> _listeners;
+
+    void handleAsyncUpdate() override;
+};
@@ -0,0 +1,280 @@
+#include "GraphHistory.h"
+#include "ChainSlotSplitter.h"
+#include "Tracer.h"
+
+void GraphHistory::beginEdit(PluginSplitter& splitter) {
+    if (!validate(splitter)) {
+        // Nothing to undo yet, start from the graph as it is now
+        _current = _createSnapshot(splitter, nullptr);
+    }
+}
+
+void GraphHistory::keepSlot(std::unique_ptr<ChainSlotBase> slot) {
+    if (slot != nullptr) {
+        _releasedSlots.push_back(std::move(slot));
+    }
+}
+
+void GraphHistory::endEdit(PluginSplitter& splitter) {
+    if (_current == nullptr) {
+        // beginEdit() wasn't called, so there's nothing to compare to
+        _releasedSlots.clear();
+        return;
+    }
+
+    std::shared_ptr<const Snapshot> next = _createSnapshot(splitter, _current.get());
+
+    // Slots released by the edit are kept by their records in the previous version, slots that
+    // were added and removed again during the edit aren't in any version so are deleted
+    std::map<juce::uint64, std::shared_ptr<SlotRecord>> records = _getRecords(*_current);
+    for (std::unique_ptr<ChainSlotBase>& slot : _releasedSlots) {
+        auto recordIter = records.find(slot->id);
+        if (recordIter != records.end()) {
+            recordIter->second->releasedSlot = std::move(slot);
+        }
+    }
+    _releasedSlots.clear();
+
+    if (next->chains == _current->chains) {
+        // Nothing changed
+        return;
+    }
+
+    _undoSnapshots.push_back(_current);
+    _current = next;
+
+    // Redoing from here would skip this edit
+    _redoSnapshots.clear();
+
+    while (_undoSnapshots.size() > MAX_UNDO_STEPS) {
+        _undoSnapshots.erase(_undoSnapshots.begin());
+    }
+
+    // Dropping the oldest version deletes any slots only it was keeping
+    while (!_undoSnapshots.empty() && _getReleasedBytes() > MAX_RELEASED_BYTES) {
+        _undoSnapshots.erase(_undoSnapshots.begin());
+    }
+}
+
+bool GraphHistory::validate(PluginSplitter& splitter) {
+    if (_current != nullptr && !_splitterMatches(splitter, *_current)) {
+        juce::Logger::writeToLog("GraphHistory::validate: Graph has changed outside of the history, clearing it");
+        clear();
+    }
+
+    return _current != nullptr;
+}
+
+bool GraphHistory::undo(PluginSplitter& splitter, std::set<int>& changedChains) {
+    if (_current == nullptr || _undoSnapshots.empty()) {
+        return false;
+    }
+
+    Tracer::Scope traceScope("undo", "state");
+
+    std::shared_ptr<const Snapshot> target = _undoSnapshots.back();
+    _undoSnapshots.pop_back();
+
+    _moveTo(splitter, *target, changedChains);
+    _redoSnapshots.push_back(_current);
+    _current = target;
+
+    return true;
+}
+
+bool GraphHistory::redo(PluginSplitter& splitter, std::set<int>& changedChains) {
+    if (_current == nullptr || _redoSnapshots.empty()) {
+        return false;
+    }
+
+    Tracer::Scope traceScope("redo", "state");
+
+    std::shared_ptr<const Snapshot> target = _redoSnapshots.back();
+    _redoSnapshots.pop_back();
+
+    _moveTo(splitter, *target, changedChains);
+    _undoSnapshots.push_back(_current);
+    _current = target;
+
+    return true;
+}
+
+void GraphHistory::clear() {
+    _current.reset();
+    _undoSnapshots.clear();
+    _redoSnapshots.clear();
+    _releasedSlots.clear();
+}
+
+std::shared_ptr<const GraphHistory::Snapshot> GraphHistory::_createSnapshot(PluginSplitter& splitter, const Snapshot* previous) {
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+
+    // Slots can move between chains, so look for their records in any chain
+    std::map<juce::uint64, std::shared_ptr<SlotRecord>> previousRecords;
+    if (previous != nullptr) {
+        previousRecords = _getRecords(*previous);
+    }
+
+    for (int chainNumber {0}; chainNumber < splitter.getNumChains(); chainNumber++) {
+        PluginChain& chain = *splitter.getChain(chainNumber);
+
+        // Share the chain if it hasn't changed
+        if (previous != nullptr &&
+                chainNumber < previous->chains.size() &&
+                _chainMatches(chain, *previous->chains[chainNumber])) {
+            snapshot->chains.push_back(previous->chains[chainNumber]);
+            continue;
+        }
+
+        std::shared_ptr<ChainSnapshot> chainSnapshot = std::make_shared<ChainSnapshot>();
+        for (int slotNumber {0}; slotNumber < chain.getNumSlots(); slotNumber++) {
+            const ChainSlotBase* slot {chain.getSlot(slotNumber)};
+
+            auto recordIter = previousRecords.find(slot->id);
+            if (recordIter != previousRecords.end()) {
+                chainSnapshot->slots.push_back(recordIter->second);
+            } else {
+                chainSnapshot->slots.push_back(std::make_shared<SlotRecord>(SlotRecord{slot->id, nullptr, std::nullopt}));
+            }
+        }
+
+        snapshot->chains.push_back(chainSnapshot);
+    }
+
+    return snapshot;
+}
+
+std::map<juce::uint64, std::shared_ptr<GraphHistory::SlotRecord>> GraphHistory::_getRecords(const Snapshot& snapshot) {
+    std::map<juce::uint64, std::shared_ptr<SlotRecord>> records;
+
+    for (const std::shared_ptr<const ChainSnapshot>& chainSnapshot : snapshot.chains) {
+        for (const std::shared_ptr<SlotRecord>& record : chainSnapshot->slots) {
+            records[record->slotId] = record;
+        }
+    }
+
+    return records;
+}
+
+size_t GraphHistory::_getReleasedBytes() {
+    // Records are shared between snapshots, so each is only counted once
+    std::set<SlotRecord*> releasedRecords;
+
+    for (const std::vector<std::shared_ptr<const Snapshot>>* snapshots : {&_undoSnapshots, &_redoSnapshots}) {
+        for (const std::shared_ptr<const Snapshot>& snapshot : *snapshots) {
+            for (const std::shared_ptr<const ChainSnapshot>& chainSnapshot : snapshot->chains) {
+                for (const std::shared_ptr<SlotRecord>& record : chainSnapshot->slots) {
+                    if (record->releasedSlot != nullptr) {
+                        releasedRecords.insert(record.get());
+                    }
+                }
+            }
+        }
+    }
+
+    size_t retVal {0};
+    for (SlotRecord* record : releasedRecords) {
+        if (!record->estimatedBytes.has_value()) {
+            record->estimatedBytes = _estimateBytes(*record->releasedSlot);
+        }
+
+        retVal += *record->estimatedBytes;
+    }
+
+    return retVal;
+}
+
+size_t GraphHistory::_estimateBytes(const ChainSlotBase& slot) {
+    const ChainSlotPlugin* pluginSlot = dynamic_cast<const ChainSlotPlugin*>(&slot);
+    const ChainSlotSplitter* splitterSlot = dynamic_cast<const ChainSlotSplitter*>(&slot);
+
+    if (pluginSlot != nullptr) {
+        juce::MemoryBlock state;
+        pluginSlot->plugin->getStateInformation(state);
+        return ESTIMATED_PLUGIN_BYTES + state.getSize();
+    }
+
+    if (splitterSlot != nullptr) {
+        size_t retVal {sizeof(ChainSlotSplitter)};
+
+        for (int chainNumber {0}; chainNumber < splitterSlot->splitter->getNumChains(); chainNumber++) {
+            PluginChain& chain = *splitterSlot->splitter->getChain(chainNumber);
+
+            for (int slotNumber {0}; slotNumber < chain.getNumSlots(); slotNumber++) {
+                retVal += _estimateBytes(*chain.getSlot(slotNumber));
+            }
+        }
+
+        return retVal;
+    }
+
+    return sizeof(ChainSlotGainStage);
+}
+
+bool GraphHistory::_chainMatches(PluginChain& chain, const ChainSnapshot& chainSnapshot) {
+    if (chain.getNumSlots() != chainSnapshot.slots.size()) {
+        return false;
+    }
+
+    for (int slotNumber {0}; slotNumber < chainSnapshot.slots.size(); slotNumber++) {
+        if (chain.getSlot(slotNumber)->id != chainSnapshot.slots[slotNumber]->slotId) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool GraphHistory::_splitterMatches(PluginSplitter& splitter, const Snapshot& snapshot) {
+    if (splitter.getNumChains() != snapshot.chains.size()) {
+        return false;
+    }
+
+    for (int chainNumber {0}; chainNumber < snapshot.chains.size(); chainNumber++) {
+        if (!_chainMatches(*splitter.getChain(chainNumber), *snapshot.chains[chainNumber])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void GraphHistory::_moveTo(PluginSplitter& splitter, const Snapshot& target, std::set<int>& changedChains) {
+    // Every version in the history has the same number of chains, otherwise it would have been
+    // cleared
+    jassert(target.chains.size() == _current->chains.size());
+
+    std::vector<int> chainsToMove;
+    for (int chainNumber {0}; chainNumber < target.chains.size(); chainNumber++) {
+        // Chains shared between the versions don't need touching
+        if (target.chains[chainNumber] != _current->chains[chainNumber]) {
+            chainsToMove.push_back(chainNumber);
+        }
+    }
+
+    // Release the slots of every chain that's changing first, as they may be moving to another one
+    for (int chainNumber : chainsToMove) {
+        PluginChain& chain = *splitter.getChain(chainNumber);
+        const ChainSnapshot& chainSnapshot = *_current->chains[chainNumber];
+
+        for (int slotNumber {static_cast<int>(chainSnapshot.slots.size()) - 1}; slotNumber >= 0; slotNumber--) {
+            chainSnapshot.slots[slotNumber]->releasedSlot = chain.releaseSlot(slotNumber);
+        }
+    }
+
+    for (int chainNumber : chainsToMove) {
+        PluginChain& chain = *splitter.getChain(chainNumber);
+        const ChainSnapshot& chainSnapshot = *target.chains[chainNumber];
+
+        for (int slotNumber {0}; slotNumber < chainSnapshot.slots.size(); slotNumber++) {
+            std::unique_ptr<ChainSlotBase>& slot = chainSnapshot.slots[slotNumber]->releasedSlot;
+            jassert(slot != nullptr);
+
+            if (slot != nullptr) {
+                chain.insertSlot(std::move(slot), slotNumber);
+            }
+        }
+
+        changedChains.insert(chainNumber);
+    }
+}
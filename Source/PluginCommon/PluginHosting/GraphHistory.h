@@ -0,0 +1,140 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <set>
+#include <JuceHeader.h>
+
+#include "PluginSplitter.h"
+
+/**
+ * Undo and redo for edits to the slots of a splitter's chains.
+ *
+ * Each version of the graph is an immutable snapshot of which slots are in each chain. Chains an
+ * edit didn't change are shared with the previous snapshot, and each slot has a single record
+ * shared by every snapshot it appears in, so a snapshot only costs as much as the chains that
+ * changed.
+ *
+ * A slot removed from the graph isn't deleted while a snapshot still refers to it, its record
+ * keeps the slot with its plugin still instantiated, prepared, and in the same state. Undoing or
+ * redoing only moves slots between the chains and their records, nothing is serialised or
+ * instantiated. As each of these slots keeps its plugin's memory, the oldest versions are dropped
+ * once the slots being kept out of the graph are estimated to use more than MAX_RELEASED_BYTES.
+ *
+ * Slots are identified by their id rather than their address, as a deleted slot's address may be
+ * reused by a new one.
+ *
+ * Only edits made between beginEdit() and endEdit() can be undone. If the graph has been changed
+ * some other way since the last one (eg. the number of chains has changed or a chain has been
+ * hibernated) the history no longer matches it and is cleared.
+ *
+ * Must only be used on the message thread.
+ */
+class GraphHistory {
+public:
+    static constexpr int MAX_UNDO_STEPS {50};
+    static constexpr size_t MAX_RELEASED_BYTES {512 * 1024 * 1024};
+
+    // A plugin's memory can't be measured, so each is assumed to use this much as well as the size
+    // of its state
+    static constexpr size_t ESTIMATED_PLUGIN_BYTES {16 * 1024 * 1024};
+
+    GraphHistory() = default;
+    ~GraphHistory() = default;
+
+    /**
+     * Called before an edit to the given splitter. The splitter doesn't need to be locked.
+     */
+    void beginEdit(PluginSplitter& splitter);
+
+    /**
+     * Takes a slot released from the splitter during an edit, it's kept for as long as a snapshot
+     * refers to it. Can be called with the splitter locked.
+     */
+    void keepSlot(std::unique_ptr<ChainSlotBase> slot);
+
+    /**
+     * Called after an edit to record the new version of the graph. Any slots that can no longer be
+     * undone or redone are deleted here, so the splitter shouldn't be locked.
+     */
+    void endEdit(PluginSplitter& splitter);
+
+    /**
+     * Clears the history if the graph has been changed outside of an edit. Returns false if there's
+     * no history left. The splitter doesn't need to be locked.
+     */
+    bool validate(PluginSplitter& splitter);
+
+    /**
+     * Moves the slots of the splitter back to the previous or next version, adding the chains that
+     * changed to changedChains. The splitter mustn't be processed meanwhile and must have been
+     * validated first, and the changed chains need their layouts configuring and preparing before
+     * they're next processed.
+     *
+     * Returns false if there's nothing to undo or redo.
+     */
+    bool undo(PluginSplitter& splitter, std::set<int>& changedChains);
+    bool redo(PluginSplitter& splitter, std::set<int>& changedChains);
+
+    bool canUndo() const { return !_undoSnapshots.empty(); }
+    bool canRedo() const { return !_redoSnapshots.empty(); }
+
+    /**
+     * Deletes every version and any slots only they were keeping. The splitter shouldn't be locked.
+     */
+    void clear();
+
+private:
+    struct SlotRecord {
+        // Identifies the slot while it's in the graph
+        juce::uint64 slotId;
+
+        // Owns the slot while it isn't in the graph
+        std::unique_ptr<ChainSlotBase> releasedSlot;
+
+        // Estimated the first time the slot is counted while it's kept out of the graph
+        std::optional<size_t> estimatedBytes;
+    };
+
+    // Snapshots are never modified once created, only the records' ownership of their slots changes
+    struct ChainSnapshot {
+        std::vector<std::shared_ptr<SlotRecord>> slots;
+    };
+
+    struct Snapshot {
+        std::vector<std::shared_ptr<const ChainSnapshot>> chains;
+    };
+
+    // Matches the graph as long as it's only been changed by edits
+    std::shared_ptr<const Snapshot> _current;
+
+    std::vector<std::shared_ptr<const Snapshot>> _undoSnapshots;
+    std::vector<std::shared_ptr<const Snapshot>> _redoSnapshots;
+
+    // Slots released by the edit in progress
+    std::vector<std::unique_ptr<ChainSlotBase>> _releasedSlots;
+
+    /**
+     * Creates a snapshot of the splitter, sharing any chains and slot records that haven't changed
+     * since the previous snapshot.
+     */
+    static std::shared_ptr<const Snapshot> _createSnapshot(PluginSplitter& splitter, const Snapshot* previous);
+
+    static std::map<juce::uint64, std::shared_ptr<SlotRecord>> _getRecords(const Snapshot& snapshot);
+
+    /**
+     * Estimates the memory used by the slots kept out of the graph by the records of the undo and
+     * redo snapshots.
+     */
+    size_t _getReleasedBytes();
+
+    static size_t _estimateBytes(const ChainSlotBase& slot);
+
+    static bool _chainMatches(PluginChain& chain, const ChainSnapshot& chainSnapshot);
+    static bool _splitterMatches(PluginSplitter& splitter, const Snapshot& snapshot);
+
+    /**
+     * Moves the slots of any chains that differ between the current snapshot and the target.
+     */
+    void _moveTo(PluginSplitter& splitter, const Snapshot& target, std::set<int>& changedChains);
+};
@@ -9,17 +9,38 @@
 */
 
 #include "PluginChain.h"
+#include "ChainSlotSplitter.h"
+#include "FlightRecorder.h"
 
 namespace {
     const char* XML_IS_CHAIN_BYPASSED_STR {"isChainBypassed"};
     const char* XML_IS_CHAIN_MUTED_STR {"isChainMuted"};
     const char* XML_PLUGINS_STR {"Plugins"};
+    const char* XML_HIBERNATED_CHAIN_STR {"HibernatedChain"};
+    const char* XML_FROZEN_STR {"Frozen"};
+    const char* XML_FROZEN_LATENCY_STR {"FrozenLatency"};
 
     std::string getSlotXMLName(int pluginNumber) {
         std::string retVal("Slot_");
         retVal += std::to_string(pluginNumber);
         return retVal;
     }
+
+    bool reconfigurePlugin(std::shared_ptr<juce::AudioPluginInstance> plugin,
+                           HostConfiguration configuration,
+                           const PluginConfigurator& pluginConfigurator) {
+        // The layout can only be changed while the plugin isn't prepared
+        plugin->releaseResources();
+
+        const bool success {pluginConfigurator.configure(plugin, configuration)};
+
+        if (!success) {
+            // The plugin keeps its previous layout, it just needs preparing again
+            plugin->prepareToPlay(configuration.sampleRate, configuration.blockSize);
+        }
+
+        return success;
+    }
 }
 
 PluginChain::PluginChain(std::function<float(int, MODULATION_TYPE)> getModulationValueCallback) :
@@ -28,7 +49,14 @@ PluginChain::PluginChain(std::function<float(int, MODULATION_TYPE)> getModulatio
                                         .withInput("Sidechain", juce::AudioChannelSet::stereo(), true)),
         _isChainBypassed(false),
         _isChainMuted(false),
-        _getModulationValueCallback(getModulationValueCallback) {
+        _isMonoLayout(false),
+        _isPrepared(false),
+        _isHibernated(false),
+        _hibernatedLatencySamples(0),
+        _isFrozen(false),
+        _frozenLatencySamples(0),
+        _getModulationValueCallback(getModulationValueCallback),
+        _compensationLatencySamples(0) {
     _latencyCompLine.reset(new juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None>(0));
     _latencyCompLine->setDelay(0);
 }
@@ -47,15 +75,11 @@ void PluginChain::insertPlugin(std::shared_ptr<juce::AudioPluginInstance> plugin
 
 void PluginChain::replacePlugin(std::shared_ptr<juce::AudioPluginInstance> plugin, int position) {
     if (_chain.size() > position) {
-        plugin->setBusesLayout(getBusesLayout());
-
-        // If it's a plugin remove the listener so we don't continue getting updates if it's kept
-        // alive somewhere else
-        const ChainSlotPlugin* oldPluginSlot = dynamic_cast<const ChainSlotPlugin*>(_chain[position].get());
-        if (oldPluginSlot != nullptr) {
-            oldPluginSlot->plugin->removeListener(this);
+        if (!_isMonoLayout) {
+            plugin->setBusesLayout(getBusesLayout());
         }
 
+        _removeSlotListener(_chain[position].get());
         _chain[position] = std::make_unique<ChainSlotPlugin>(plugin, false, _getModulationValueCallback);
     } else {
         // If the position is bigger than the chain just add it to the end
@@ -67,27 +91,58 @@ void PluginChain::replacePlugin(std::shared_ptr<juce::AudioPluginInstance> plugi
 }
 
 bool PluginChain::removeSlot(int position) {
-    bool success {false};
-
-    if (_chain.size() > position) {
+    return releaseSlot(position) != nullptr;
+}
 
-        // If it's a plugin remove the listener so we don't continue getting updates if it's kept
-        // alive somewhere else
-        const ChainSlotPlugin* oldPluginSlot = dynamic_cast<const ChainSlotPlugin*>(_chain[position].get());
-        if (oldPluginSlot != nullptr) {
-            oldPluginSlot->plugin->removeListener(this);
-        }
+std::unique_ptr<ChainSlotBase> PluginChain::releaseSlot(int position) {
+    std::unique_ptr<ChainSlotBase> slot;
 
+    if (_chain.size() > position) {
+        _removeSlotListener(_chain[position].get());
+        slot = std::move(_chain[position]);
         _chain.erase(_chain.begin() + position);
         _onLatencyChange();
-        success = true;
     }
 
-    return success;
+    return slot;
+}
+
+void PluginChain::insertSlot(std::unique_ptr<ChainSlotBase> slot, int position) {
+    _addSlotListener(slot.get());
+
+    if (_chain.size() > position) {
+        _chain.insert(_chain.begin() + position, std::move(slot));
+    } else {
+        // If the position is bigger than the chain just add it to the end
+        _chain.push_back(std::move(slot));
+    }
+
+    _onLatencyChange();
+}
+
+int PluginChain::getSlotNumMainChannels(const ChainSlotBase& slot, const HostConfiguration& configuration) {
+    const ChainSlotPlugin* pluginSlot = dynamic_cast<const ChainSlotPlugin*>(&slot);
+    if (pluginSlot != nullptr) {
+        return pluginSlot->plugin->getMainBusNumInputChannels();
+    }
+
+    const ChainSlotGainStage* gainStage = dynamic_cast<const ChainSlotGainStage*>(&slot);
+    if (gainStage != nullptr) {
+        return gainStage->getNumChannels();
+    }
+
+    return configuration.layout.getMainInputChannels();
+}
+
+const ChainSlotBase* PluginChain::getSlot(int position) const {
+    return _chain.size() > position ? _chain[position].get() : nullptr;
 }
 
 void PluginChain::insertGainStage(int position, const juce::AudioProcessor::BusesLayout& busesLayout) {
     std::unique_ptr<ChainSlotGainStage> gainStage = std::make_unique<ChainSlotGainStage>(1, 0, false, busesLayout);
+    if (_isMonoLayout) {
+        gainStage->setNumChannels(1);
+    }
     gainStage->prepareToPlay(getSampleRate(), getBlockSize());
 
     if (_chain.size() > position) {
@@ -98,6 +153,24 @@ void PluginChain::insertGainStage(int position, const juce::AudioProcessor::Buse
     }
 }
 
+std::unique_ptr<ChainSlotBase> PluginChain::createSplitterSlot(SPLIT_TYPE splitType,
+                                                              HostConfiguration configuration,
+                                                              const PluginConfigurator& pluginConfigurator) const {
+    std::unique_ptr<PluginSplitter> splitter = ChainSlotSplitter::createSplitter(splitType, _getModulationValueCallback, configuration);
+
+    if (splitter == nullptr) {
+        return nullptr;
+    }
+
+    // The listener is added by insertSlot()
+    splitter->configureChainLayouts(configuration, pluginConfigurator);
+
+    std::unique_ptr<ChainSlotSplitter> splitterSlot = std::make_unique<ChainSlotSplitter>(std::move(splitter), false);
+    splitterSlot->prepareToPlay(getSampleRate(), getBlockSize());
+
+    return splitterSlot;
+}
+
 std::shared_ptr<juce::AudioPluginInstance> PluginChain::getPlugin(int position) const {
     std::shared_ptr<juce::AudioPluginInstance> retVal;
 
@@ -112,6 +185,34 @@ std::shared_ptr<juce::AudioPluginInstance> PluginChain::getPlugin(int position)
     return retVal;
 }
 
+PluginParameterCache* PluginChain::getPluginParameterCache(int position) const {
+    PluginParameterCache* retVal {nullptr};
+
+    if (_chain.size() > position) {
+        const ChainSlotPlugin* pluginSlot = dynamic_cast<const ChainSlotPlugin*>(_chain[position].get());
+
+        if (pluginSlot != nullptr) {
+            retVal = pluginSlot->parameterCache.get();
+        }
+    }
+
+    return retVal;
+}
+
+PluginSplitter* PluginChain::getSplitter(int position) const {
+    PluginSplitter* retVal {nullptr};
+
+    if (_chain.size() > position) {
+        const ChainSlotSplitter* splitterSlot = dynamic_cast<const ChainSlotSplitter*>(_chain[position].get());
+
+        if (splitterSlot != nullptr) {
+            retVal = splitterSlot->splitter.get();
+        }
+    }
+
+    return retVal;
+}
+
 bool PluginChain::setPluginModulationConfig(PluginModulationConfig config, int position) {
     bool retVal {false};
 
@@ -119,7 +220,7 @@ bool PluginChain::setPluginModulationConfig(PluginModulationConfig config, int p
         ChainSlotPlugin* pluginSlot = dynamic_cast<ChainSlotPlugin*>(_chain[position].get());
 
         if (pluginSlot != nullptr) {
-            pluginSlot->modulationConfig = config;
+            pluginSlot->setModulationConfig(config);
             retVal = true;
         }
     }
@@ -127,6 +228,27 @@ bool PluginChain::setPluginModulationConfig(PluginModulationConfig config, int p
     return retVal;
 }
 
+void PluginChain::removeModulationSource(ModulationSourceDefinition definition) {
+    if (_isHibernated) {
+        // The plugins only exist as the state stored when hibernating
+        ChainSlotPlugin::removeModulationSourceFromXml(_hibernatedState.get(), definition);
+        return;
+    }
+
+    for (std::unique_ptr<ChainSlotBase>& slot : _chain) {
+        ChainSlotPlugin* pluginSlot = dynamic_cast<ChainSlotPlugin*>(slot.get());
+        ChainSlotSplitter* splitterSlot = dynamic_cast<ChainSlotSplitter*>(slot.get());
+
+        if (pluginSlot != nullptr) {
+            PluginModulationConfig config = pluginSlot->getModulationConfig();
+            config.removeSource(definition);
+            pluginSlot->setModulationConfig(config);
+        } else if (splitterSlot != nullptr) {
+            splitterSlot->splitter->removeModulationSource(definition);
+        }
+    }
+}
+
 PluginModulationConfig PluginChain::getPluginModulationConfig(int position) const {
     PluginModulationConfig retVal;
 
@@ -134,7 +256,7 @@ PluginModulationConfig PluginChain::getPluginModulationConfig(int position) cons
         const ChainSlotPlugin* pluginSlot = dynamic_cast<const ChainSlotPlugin*>(_chain[position].get());
 
         if (pluginSlot != nullptr) {
-            retVal = pluginSlot->modulationConfig;
+            retVal = pluginSlot->getModulationConfig();
         }
     }
 
@@ -251,16 +373,150 @@ void PluginChain::setRequiredLatency(int numSamples) {
     // If this is the slowest chain owned by the splitter this should be 0
     const int compensation {std::max(numSamples - getLatencySamples(), 0)};
 
-    WECore::AudioSpinLock lock(_latencyCompLineMutex);
-    _latencyCompLine.reset(new juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None>(compensation));
-    _latencyCompLine->prepare({getSampleRate(), static_cast<juce::uint32>(getBlockSize()), 4});
-    _latencyCompLine->setDelay(compensation);
+    // The splitter tells every chain whenever any of them changes, so most of the time nothing
+    // needs reallocating
+    if (compensation == _compensationLatencySamples) {
+        return;
+    }
+
+    _compensationLatencySamples = compensation;
+
+    // The new delay line is allocated before the lock is taken, so the audio thread only skips the
+    // compensation if it processes during the swap
+    std::unique_ptr<juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None>> newLine(
+        new juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None>(compensation));
+    newLine->prepare({getSampleRate(), static_cast<juce::uint32>(getBlockSize()), 4});
+    newLine->setDelay(compensation);
+
+    {
+        WECore::AudioSpinLock lock(_latencyCompLineMutex);
+        std::swap(_latencyCompLine, newLine);
+    }
+}
+
+void PluginChain::configureLayout(HostConfiguration configuration,
+                                  bool preferMono,
+                                  const PluginConfigurator& pluginConfigurator) {
+    bool useMono {preferMono && configuration.layout.getMainInputChannels() == 2};
+    const HostConfiguration monoConfiguration {pluginConfigurator.getMonoConfiguration(configuration)};
+
+    if (useMono) {
+        for (std::unique_ptr<ChainSlotBase>& slot : _chain) {
+            if (dynamic_cast<ChainSlotSplitter*>(slot.get()) != nullptr) {
+                // Nested splitters expect a stereo signal
+                juce::Logger::writeToLog("PluginChain::configureLayout: Chain contains a splitter, using stereo for this chain");
+                useMono = false;
+                break;
+            }
+
+            ChainSlotPlugin* pluginSlot = dynamic_cast<ChainSlotPlugin*>(slot.get());
+
+            if (pluginSlot != nullptr && pluginSlot->plugin->getMainBusNumInputChannels() != 1) {
+                if (!reconfigurePlugin(pluginSlot->plugin, monoConfiguration, pluginConfigurator)) {
+                    juce::Logger::writeToLog("PluginChain::configureLayout: " + pluginSlot->plugin->getPluginDescription().name + " doesn't support mono, using stereo for this chain");
+                    useMono = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    // If we couldn't use mono make sure any plugins that were already moved to mono are restored
+    const HostConfiguration& targetConfiguration {useMono ? monoConfiguration : configuration};
+    const int numMainChannels {targetConfiguration.layout.getMainInputChannels()};
+
+    for (std::unique_ptr<ChainSlotBase>& slot : _chain) {
+        ChainSlotPlugin* pluginSlot = dynamic_cast<ChainSlotPlugin*>(slot.get());
+
+        if (pluginSlot != nullptr) {
+            if (pluginSlot->plugin->getMainBusNumInputChannels() != numMainChannels) {
+                reconfigurePlugin(pluginSlot->plugin, targetConfiguration, pluginConfigurator);
+            }
+        } else {
+            ChainSlotGainStage* gainStage = dynamic_cast<ChainSlotGainStage*>(slot.get());
+            ChainSlotSplitter* splitterSlot = dynamic_cast<ChainSlotSplitter*>(slot.get());
+
+            if (gainStage != nullptr) {
+                gainStage->setNumChannels(numMainChannels);
+            } else if (splitterSlot != nullptr) {
+                splitterSlot->splitter->configureChainLayouts(targetConfiguration, pluginConfigurator);
+            }
+        }
+    }
+
+    _isMonoLayout = useMono;
+
+    // Reconfiguring may have changed the latency of some plugins
+    _onLatencyChange();
 }
 
 void PluginChain::restoreFromXml(juce::XmlElement* element,
                                  HostConfiguration configuration,
                                  const PluginConfigurator& pluginConfigurator,
                                  std::function<void(juce::String)> onErrorCallback) {
+    _restoreChainFlagsFromXml(element);
+
+    if (_restoreFreezerFromXml(element, configuration.sampleRate)) {
+        // The recording plays in place of the plugins, so they aren't needed until it's unfrozen
+        _restoreHibernatedStateFromXml(element);
+    } else {
+        // Load each plugin
+        _restoreSlotsFromXml(element->getChildByName(XML_PLUGINS_STR), configuration, pluginConfigurator, onErrorCallback);
+    }
+
+    _onLatencyChange();
+}
+
+void PluginChain::restoreHibernatedFromXml(juce::XmlElement* element, double sampleRate) {
+    _restoreChainFlagsFromXml(element);
+    _restoreFreezerFromXml(element, sampleRate);
+    _restoreHibernatedStateFromXml(element);
+
+    _onLatencyChange();
+}
+
+void PluginChain::_restoreHibernatedStateFromXml(juce::XmlElement* element) {
+    // Keep the plugins' state exactly as hibernate() would have stored it
+    _hibernatedState = std::make_unique<juce::XmlElement>(XML_HIBERNATED_CHAIN_STR);
+    juce::XmlElement* pluginsElement = element->getChildByName(XML_PLUGINS_STR);
+    if (pluginsElement != nullptr) {
+        _hibernatedState->addChildElement(new juce::XmlElement(*pluginsElement));
+    } else {
+        juce::Logger::writeToLog("Missing element " + juce::String(XML_PLUGINS_STR));
+        _hibernatedState->createNewChildElement(XML_PLUGINS_STR);
+    }
+
+    _hibernatedLatencySamples = 0;
+    _isHibernated = true;
+}
+
+bool PluginChain::_restoreFreezerFromXml(juce::XmlElement* element, double sampleRate) {
+    juce::XmlElement* frozenElement = element->getChildByName(XML_FROZEN_STR);
+    if (frozenElement == nullptr) {
+        return false;
+    }
+
+    std::unique_ptr<ChainFreezer> freezer = ChainFreezer::restoreFromXml(frozenElement);
+    if (freezer == nullptr) {
+        juce::Logger::writeToLog("PluginChain::_restoreFreezerFromXml: Failed to restore recording, restoring unfrozen");
+        return false;
+    }
+
+    // The recording can't be resampled, so the chain has to be processed live instead
+    if (sampleRate > 0 && freezer->getSampleRate() != sampleRate) {
+        juce::Logger::writeToLog("PluginChain::_restoreFreezerFromXml: Recording was made at " +
+                                 juce::String(freezer->getSampleRate()) + "Hz, restoring unfrozen");
+        return false;
+    }
+
+    _freezer = std::move(freezer);
+    _frozenLatencySamples = frozenElement->getIntAttribute(XML_FROZEN_LATENCY_STR);
+    _isFrozen = true;
+
+    return true;
+}
+
+void PluginChain::_restoreChainFlagsFromXml(juce::XmlElement* element) {
     // Restore chain level bypass and mute
     if (element->hasAttribute(XML_IS_CHAIN_BYPASSED_STR)) {
         _isChainBypassed = element->getBoolAttribute(XML_IS_CHAIN_BYPASSED_STR);
@@ -273,9 +529,140 @@ void PluginChain::restoreFromXml(juce::XmlElement* element,
     } else {
         juce::Logger::writeToLog("Missing attribute " + juce::String(XML_IS_CHAIN_MUTED_STR));
     }
+}
 
-    // Load each plugin
-    juce::XmlElement* pluginsElement = element->getChildByName(XML_PLUGINS_STR);
+void PluginChain::writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates) {
+    // Store chain level bypass and mute
+    element->setAttribute(XML_IS_CHAIN_BYPASSED_STR, _isChainBypassed.load());
+    element->setAttribute(XML_IS_CHAIN_MUTED_STR, _isChainMuted.load());
+
+    if (_isFrozen) {
+        juce::XmlElement* frozenElement = element->createNewChildElement(XML_FROZEN_STR);
+        frozenElement->setAttribute(XML_FROZEN_LATENCY_STR, _frozenLatencySamples);
+        _freezer->writeToXml(frozenElement);
+    }
+
+    if (_isHibernated) {
+        // The plugins don't exist at the moment, store the state we kept when hibernating
+        juce::XmlElement* hibernatedPluginsElement = _hibernatedState->getChildByName(XML_PLUGINS_STR);
+        element->addChildElement(new juce::XmlElement(*hibernatedPluginsElement));
+        return;
+    }
+
+    _writeSlotsToXml(element, deferredStates);
+}
+
+void PluginChain::_writeSlotsToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates) {
+    // Store each plugin
+    juce::XmlElement* pluginsElement = element->createNewChildElement(XML_PLUGINS_STR);
+    for (int pluginNumber {0}; pluginNumber < _chain.size(); pluginNumber++) {
+        juce::Logger::writeToLog("Storing plugin " + juce::String(pluginNumber));
+
+        juce::XmlElement* thisPluginElement = pluginsElement->createNewChildElement(getSlotXMLName(pluginNumber));
+        _chain[pluginNumber]->writeToXml(thisPluginElement, deferredStates);
+    }
+}
+
+void PluginChain::hibernate(bool shouldKeepLatency) {
+    if (!_isHibernated) {
+        // The slots are deleted when they go out of scope
+        detachSlotsToHibernate(createHibernatedState(), shouldKeepLatency);
+    }
+}
+
+std::unique_ptr<juce::XmlElement> PluginChain::createHibernatedState() {
+    // Only the slots are needed to wake the chain, anything else is still stored by the chain
+    std::unique_ptr<juce::XmlElement> retVal = std::make_unique<juce::XmlElement>(XML_HIBERNATED_CHAIN_STR);
+    _writeSlotsToXml(retVal.get(), nullptr);
+
+    return retVal;
+}
+
+std::vector<std::unique_ptr<ChainSlotBase>> PluginChain::detachSlotsToHibernate(std::unique_ptr<juce::XmlElement> state,
+                                                                                bool shouldKeepLatency) {
+    std::vector<std::unique_ptr<ChainSlotBase>> retVal;
+
+    if (!_isHibernated && state != nullptr) {
+        juce::Logger::writeToLog("PluginChain::hibernate: Hibernating chain with " + juce::String(_chain.size()) + " slots");
+
+        _hibernatedState = std::move(state);
+        _hibernatedLatencySamples = shouldKeepLatency ? getLatencySamples() : 0;
+        _isHibernated = true;
+
+        // Remove the listeners before the plugins are deleted, in case they're kept alive
+        // somewhere else
+        for (std::unique_ptr<ChainSlotBase>& slot : _chain) {
+            _removeSlotListener(slot.get());
+        }
+
+        std::swap(retVal, _chain);
+        _onLatencyChange();
+    }
+
+    return retVal;
+}
+
+void PluginChain::wake(HostConfiguration configuration,
+                       bool preferMono,
+                       const PluginConfigurator& pluginConfigurator,
+                       std::function<void(juce::String)> onErrorCallback) {
+    if (_isHibernated) {
+        juce::Logger::writeToLog("PluginChain::wake: Restoring hibernated chain");
+
+        // The audio thread doesn't touch the slots while we're hibernated, so we can safely build
+        // them here and only make them visible to it once they're ready
+        _restoreSlotsFromXml(_hibernatedState->getChildByName(XML_PLUGINS_STR), configuration, pluginConfigurator, onErrorCallback);
+        configureLayout(configuration, preferMono, pluginConfigurator);
+        prepareToPlayIfNeeded(configuration.sampleRate, configuration.blockSize);
+
+        _hibernatedState.reset();
+        _hibernatedLatencySamples = 0;
+        _isHibernated = false;
+
+        _onLatencyChange();
+    }
+}
+
+void PluginChain::startFreeze(std::unique_ptr<ChainFreezer> freezer) {
+    if (!_isFrozen) {
+        _freezer = std::move(freezer);
+    }
+}
+
+std::unique_ptr<ChainFreezer> PluginChain::stopFreeze() {
+    if (_isFrozen) {
+        return nullptr;
+    }
+
+    return std::move(_freezer);
+}
+
+void PluginChain::completeFreeze(std::unique_ptr<ChainFreezer> freezer) {
+    if (freezer != nullptr && !_isFrozen) {
+        _freezer = std::move(freezer);
+        _frozenLatencySamples = getLatencySamples();
+        _isFrozen = true;
+    }
+}
+
+std::unique_ptr<ChainFreezer> PluginChain::unfreeze() {
+    std::unique_ptr<ChainFreezer> retVal;
+
+    if (_isFrozen) {
+        _isFrozen = false;
+        retVal = std::move(_freezer);
+
+        // Report the latency of the plugins again
+        _onLatencyChange();
+    }
+
+    return retVal;
+}
+
+void PluginChain::_restoreSlotsFromXml(juce::XmlElement* pluginsElement,
+                                       HostConfiguration configuration,
+                                       const PluginConfigurator& pluginConfigurator,
+                                       std::function<void(juce::String)> onErrorCallback) {
     const int numPlugins {pluginsElement->getNumChildElements()};
 
     for (int pluginNumber {0}; pluginNumber < numPlugins; pluginNumber++) {
@@ -304,27 +691,17 @@ void PluginChain::restoreFromXml(juce::XmlElement* element,
                 newGainStage->prepareToPlay(configuration.sampleRate, configuration.blockSize);
                 _chain.push_back(std::move(newGainStage));
             }
+        } else if (ChainSlotBase::XmlElementIsSplitter(thisPluginElement)) {
+            std::unique_ptr<ChainSlotSplitter> newSplitter = ChainSlotSplitter::restoreFromXml(thisPluginElement, _getModulationValueCallback, configuration, pluginConfigurator, onErrorCallback);
+
+            if (newSplitter != nullptr) {
+                newSplitter->splitter->addListener(this);
+                _chain.push_back(std::move(newSplitter));
+            }
         } else {
             juce::Logger::writeToLog("Can't determine slot type");
         }
     }
-
-    _onLatencyChange();
-}
-
-void PluginChain::writeToXml(juce::XmlElement* element) {
-    // Store chain level bypass and mute
-    element->setAttribute(XML_IS_CHAIN_BYPASSED_STR, _isChainBypassed);
-    element->setAttribute(XML_IS_CHAIN_MUTED_STR, _isChainMuted);
-
-    // Store each plugin
-    juce::XmlElement* pluginsElement = element->createNewChildElement(XML_PLUGINS_STR);
-    for (int pluginNumber {0}; pluginNumber < _chain.size(); pluginNumber++) {
-        juce::Logger::writeToLog("Storing plugin " + juce::String(pluginNumber));
-
-        juce::XmlElement* thisPluginElement = pluginsElement->createNewChildElement(getSlotXMLName(pluginNumber));
-        _chain[pluginNumber]->writeToXml(thisPluginElement);
-    }
 }
 
 // AudioProcessor methods
@@ -340,12 +717,37 @@ void PluginChain::prepareToPlay(double sampleRate, int samplesPerBlock) {
     for (std::unique_ptr<ChainSlotBase>& slot : _chain) {
         slot->prepareToPlay(sampleRate, samplesPerBlock);
     }
+
+    _isPrepared = true;
+}
+
+void PluginChain::prepareToPlayIfNeeded(double sampleRate, int samplesPerBlock) {
+    const bool isChainPrepared {
+        _isPrepared &&
+        WECore::CoreMath::compareFloatsEqual(getSampleRate(), sampleRate) &&
+        getBlockSize() == samplesPerBlock
+    };
+
+    if (!isChainPrepared) {
+        setRateAndBufferSizeDetails(sampleRate, samplesPerBlock);
+        _latencyCompLine->prepare({sampleRate, static_cast<juce::uint32>(samplesPerBlock), 4});
+        _isPrepared = true;
+    }
+
+    // Slots may have been added since the chain was prepared, so check each one
+    for (std::unique_ptr<ChainSlotBase>& slot : _chain) {
+        if (!slot->isPreparedFor(sampleRate, samplesPerBlock)) {
+            slot->prepareToPlay(sampleRate, samplesPerBlock);
+        }
+    }
 }
 
 void PluginChain::releaseResources() {
     for (std::unique_ptr<ChainSlotBase>& slot : _chain) {
         slot->releaseResources();
     }
+
+    _isPrepared = false;
 }
 
 void PluginChain::reset() {
@@ -355,27 +757,62 @@ void PluginChain::reset() {
 }
 
 void PluginChain::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+    FlightRecorder::StageTimer chainTimer(FLIGHT_STAGE::CHAIN, this);
+
     // Add the latency compensation
     juce::dsp::AudioBlock<float> bufferBlock(buffer);
     juce::dsp::ProcessContextReplacing<float> context(bufferBlock);
 
+    // The freezer records and plays back without the compensation, so it needs to know how much
+    // was applied
+    int compensationSamples {0};
+
     {
+        FlightRecorder::StageTimer latencyCompTimer(FLIGHT_STAGE::LATENCY_COMPENSATION, this);
         WECore::AudioSpinTryLock lock(_latencyCompLineMutex);
         if (lock.isLocked()) {
             _latencyCompLine->process(context);
+            compensationSamples = static_cast<int>(_latencyCompLine->getDelay());
         }
     }
 
-    if (_isChainBypassed) {
+    const bool isChainBypassed {_isChainBypassed};
+    const bool isChainMuted {_isChainMuted};
+
+    if (isChainBypassed) {
         // Bypassed - do nothing
-    } else if (_isChainMuted) {
+    } else if (isChainMuted) {
         // Muted - return empty buffers
         juce::FloatVectorOperations::fill(buffer.getWritePointer(0), 0, buffer.getNumSamples());
         juce::FloatVectorOperations::fill(buffer.getWritePointer(1), 0, buffer.getNumSamples());
+    } else if (_isFrozen) {
+        // Frozen - play back the captured audio instead of the plugins
+        _freezer->playBlock(buffer, _getPlayHeadPosition(), compensationSamples);
+    } else if (_isHibernated) {
+        // Hibernated - the plugins don't exist at the moment so just pass the audio through. Only
+        // reached while the chain is being woken, unmuted chains are woken before they're processed
     } else {
         // Chain is active - process as normal
-        for (std::unique_ptr<ChainSlotBase>& slot : _chain) {
-            slot->processBlock(buffer, midiMessages);
+        for (size_t slotIndex {0}; slotIndex < _chain.size(); slotIndex++) {
+            FlightRecorder::StageTimer slotTimer(FLIGHT_STAGE::SLOT, this, static_cast<int>(slotIndex));
+            _chain[slotIndex]->processBlock(buffer, midiMessages);
+        }
+    }
+
+    if (_freezer != nullptr && !_isFrozen) {
+        _freezer->captureBlock(buffer, _getPlayHeadPosition(), compensationSamples);
+    }
+}
+
+void PluginChain::setPlayHead(juce::AudioPlayHead* newPlayHead) {
+    juce::AudioProcessor::setPlayHead(newPlayHead);
+
+    // Nested splitters may contain frozen chains, which need the timeline position
+    for (std::unique_ptr<ChainSlotBase>& slot : _chain) {
+        ChainSlotSplitter* splitterSlot = dynamic_cast<ChainSlotSplitter*>(slot.get());
+
+        if (splitterSlot != nullptr) {
+            splitterSlot->splitter->setPlayHead(newPlayHead);
         }
     }
 }
@@ -439,13 +876,20 @@ void PluginChain::_onLatencyChange() {
     int totalLatency {0};
 
     // If the chain is bypassed the reported latency should be 0
-    if (!_isChainBypassed) {
+    if (!_isChainBypassed && _isFrozen) {
+        totalLatency = _frozenLatencySamples;
+    } else if (!_isChainBypassed && _isHibernated) {
+        totalLatency = _hibernatedLatencySamples;
+    } else if (!_isChainBypassed) {
         for (int index {0}; index < _chain.size(); index++) {
             const ChainSlotPlugin* pluginSlot = dynamic_cast<const ChainSlotPlugin*>(_chain[index].get());
+            const ChainSlotSplitter* splitterSlot = dynamic_cast<const ChainSlotSplitter*>(_chain[index].get());
 
-            // If this slot is a plugin and it's not bypassed, add it to the total
+            // If this slot is a plugin or splitter and it's not bypassed, add it to the total
             if (pluginSlot != nullptr && !pluginSlot->isBypassed) {
                 totalLatency += pluginSlot->plugin->getLatencySamples();
+            } else if (splitterSlot != nullptr && !splitterSlot->isBypassed) {
+                totalLatency += splitterSlot->splitter->getLatencySamples();
             }
         }
     }
@@ -454,3 +898,41 @@ void PluginChain::_onLatencyChange() {
     // apply the new latency compensation
     setLatencySamples(totalLatency);
 }
+
+juce::AudioPlayHead::CurrentPositionInfo PluginChain::_getPlayHeadPosition() {
+    juce::AudioPlayHead::CurrentPositionInfo position;
+    juce::AudioPlayHead* playHead = getPlayHead();
+
+    if (playHead == nullptr || !playHead->getCurrentPosition(position)) {
+        position.resetToDefault();
+    }
+
+    return position;
+}
+
+void PluginChain::_addSlotListener(ChainSlotBase* slot) {
+    // Gain stages don't have any latency to listen for
+    ChainSlotPlugin* pluginSlot = dynamic_cast<ChainSlotPlugin*>(slot);
+    if (pluginSlot != nullptr) {
+        pluginSlot->plugin->addListener(this);
+    }
+
+    ChainSlotSplitter* splitterSlot = dynamic_cast<ChainSlotSplitter*>(slot);
+    if (splitterSlot != nullptr) {
+        splitterSlot->splitter->addListener(this);
+    }
+}
+
+void PluginChain::_removeSlotListener(ChainSlotBase* slot) {
+    // Remove the listener so we don't continue getting updates if the slot's processor is kept
+    // alive somewhere else
+    ChainSlotPlugin* pluginSlot = dynamic_cast<ChainSlotPlugin*>(slot);
+    if (pluginSlot != nullptr) {
+        pluginSlot->plugin->removeListener(this);
+    }
+
+    ChainSlotSplitter* splitterSlot = dynamic_cast<ChainSlotSplitter*>(slot);
+    if (splitterSlot != nullptr) {
+        splitterSlot->splitter->removeListener(this);
+    }
+}
@@ -13,8 +13,13 @@
 #include <JuceHeader.h>
 #include "ChainSlotPlugin.h"
 #include "ChainSlotGainStage.h"
+#include "ChainFreezer.h"
 #include "LatencyListener.h"
+#include "SplitTypes.h"
 #include "General/AudioSpinMutex.h"
+#include "General/CoreMath.h"
+
+class PluginSplitter;
 
 class PluginChain : public juce::AudioProcessor, public LatencyListener {
 public:
@@ -36,16 +41,67 @@ public:
      */
     bool removeSlot(int position);
 
+    /**
+     * Removes the slot at the given position from the chain without deleting it, or returns
+     * nullptr if there isn't one.
+     */
+    std::unique_ptr<ChainSlotBase> releaseSlot(int position);
+
+    /**
+     * Inserts a slot released from this or another chain at the given position, or at the end if
+     * that position doesn't exist.
+     *
+     * The chain's layout should be configured and the slot prepared before the chain is next
+     * processed, in case the slot came from a chain with a different layout or wasn't prepared.
+     */
+    void insertSlot(std::unique_ptr<ChainSlotBase> slot, int position);
+
+    /**
+     * Returns the number of main channels the slot processes. Nested splitters always process the
+     * host's layout.
+     */
+    static int getSlotNumMainChannels(const ChainSlotBase& slot, const HostConfiguration& configuration);
+
+    /**
+     * Returns the slot at the given position, only to tell slots apart. Nullptr if there isn't one.
+     */
+    const ChainSlotBase* getSlot(int position) const;
+
     /**
      * Inserts a gain stage at the given position, or at the end if that position doesn't exist.
      */
     void insertGainStage(int position, const juce::AudioProcessor::BusesLayout& busesLayout);
 
+    /**
+     * Creates a nested splitter of the given type, configured and prepared so it's ready to be
+     * added to this chain with insertSlot(). Returns nullptr if the split type can't be used with
+     * the given configuration.
+     *
+     * Doesn't change the chain, so can be called while it's being processed.
+     *
+     * A chain containing a splitter always uses the stereo layout.
+     */
+    std::unique_ptr<ChainSlotBase> createSplitterSlot(SPLIT_TYPE splitType,
+                                                      HostConfiguration configuration,
+                                                      const PluginConfigurator& pluginConfigurator) const;
+
     /**
      * Returns a pointer to the plugin at the given position.
      */
     std::shared_ptr<juce::AudioPluginInstance> getPlugin(int position) const;
 
+    /**
+     * Returns the parameter metadata of the plugin at the given position, or nullptr if that slot
+     * isn't a plugin.
+     */
+    PluginParameterCache* getPluginParameterCache(int position) const;
+
+    /**
+     * Returns a pointer to the nested splitter at the given position, or nullptr if that slot
+     * isn't a splitter.
+     */
+    PluginSplitter* getSplitter(int position) const;
+
     /**
      * Set the modulation config for the given plugin to the one provided.
      */
@@ -56,6 +112,12 @@ public:
      */
     PluginModulationConfig getPluginModulationConfig(int position) const;
 
+    /**
+     * Removes the given modulation source from every plugin in this chain (including those in
+     * nested splitters and those stored while hibernated), renumbering the sources that follow it.
+     */
+    void removeModulationSource(ModulationSourceDefinition definition);
+
     /**
      * Returns the number of plugins and gain stages in this chain.
      */
@@ -110,12 +172,12 @@ public:
     /**
      * @see setChainBypass
      */
-    bool getChainBypass() { return _isChainBypassed; }
+    bool getChainBypass() const { return _isChainBypassed; }
 
     /**
      * @see setChainMute
      */
-    bool getChainMute() { return _isChainMuted; }
+    bool getChainMute() const { return _isChainMuted; }
 
     /**
      * Sets the total amount of latency this chain should aim for to keep it inline with other
@@ -126,11 +188,136 @@ public:
      */
     void setRequiredLatency(int numSamples);
 
+    /**
+     * Configures the layouts of the plugins and gain stages in this chain.
+     *
+     * If preferMono is true and Syndicate is stereo, each plugin will be reconfigured to run in
+     * mono. If any plugin doesn't support a mono layout the whole chain falls back to the stereo
+     * layout given in the configuration.
+     *
+     * Only plugins whose current layout doesn't match will be reconfigured, so this is cheap to
+     * call again after inserting or moving plugins.
+     */
+    void configureLayout(HostConfiguration configuration,
+                         bool preferMono,
+                         const PluginConfigurator& pluginConfigurator);
+
+    /**
+     * Returns true if the plugins in this chain have been configured in mono within a stereo
+     * instance of Syndicate. In this case the chain expects a buffer with the mono signal in
+     * channel 0 and the mono sidechain in channel 1.
+     */
+    bool isMonoLayout() const { return _isMonoLayout; }
+
+    /**
+     * Prepares the chain and any slots in it which haven't already been prepared with the given
+     * sample rate and block size.
+     *
+     * Used when a chain is handed over to a new splitter so that plugins which are already
+     * prepared aren't prepared again.
+     */
+    void prepareToPlayIfNeeded(double sampleRate, int samplesPerBlock);
+
+    /**
+     * Stores the state of every slot in this chain and deletes the plugin instances, so a chain
+     * which isn't being used by the current split type doesn't hold on to memory, threads and
+     * licences.
+     *
+     * If shouldKeepLatency is true the chain keeps reporting the latency of its plugins while
+     * hibernated, so the other chains stay aligned with it (eg. when a muted chain is hibernated).
+     *
+     * Must only be called while the chain isn't being processed, chains that are should use
+     * createHibernatedState() and detachSlotsToHibernate() instead.
+     */
+    void hibernate(bool shouldKeepLatency = false);
+
+    /**
+     * Returns the state hibernate() would store, without changing the chain. Storing the plugins'
+     * state can be slow, so this is done before locking the chain's splitter.
+     */
+    std::unique_ptr<juce::XmlElement> createHibernatedState();
+
+    /**
+     * Hibernates the chain with a state from createHibernatedState(), the slots mustn't have changed
+     * since it was created. The slots are returned rather than deleted, so this can be called with
+     * the chain's splitter locked and the plugins deleted once it's unlocked.
+     */
+    std::vector<std::unique_ptr<ChainSlotBase>> detachSlotsToHibernate(std::unique_ptr<juce::XmlElement> state,
+                                                                       bool shouldKeepLatency);
+
+    /**
+     * Recreates the plugins of a hibernated chain from the state stored by hibernate().
+     *
+     * This can be called while the chain is being processed, but the audio thread passes audio
+     * through the chain unprocessed until the plugins are ready, so chains which aren't muted
+     * should be woken before they're processed.
+     */
+    void wake(HostConfiguration configuration,
+              bool preferMono,
+              const PluginConfigurator& pluginConfigurator,
+              std::function<void(juce::String)> onErrorCallback);
+
+    /**
+     * @see hibernate
+     */
+    bool isHibernated() const { return _isHibernated; }
+
+    /**
+     * Starts capturing the output of this chain with the given freezer, the next time the host
+     * plays through the region to be frozen.
+     *
+     * Must only be called while the chain isn't being processed.
+     */
+    void startFreeze(std::unique_ptr<ChainFreezer> freezer);
+
+    /**
+     * Stops capturing and returns the freezer, so the recording can be finished (see
+     * ChainFreezer::finishCapture()) without the chain being locked. Returns nullptr if the chain
+     * isn't being frozen.
+     *
+     * Must only be called while the chain isn't being processed.
+     */
+    std::unique_ptr<ChainFreezer> stopFreeze();
+
+    /**
+     * Plays back the freezer's finished recording in place of the chain from now on.
+     *
+     * The plugins are still loaded after this, they can be unloaded with hibernate().
+     *
+     * Must only be called while the chain isn't being processed.
+     */
+    void completeFreeze(std::unique_ptr<ChainFreezer> freezer);
+
+    /**
+     * Returns the chain to normal processing. The plugins should be woken before this is called.
+     * Returns the freezer so it can be deleted once the chain is no longer locked.
+     *
+     * Must only be called while the chain isn't being processed.
+     */
+    std::unique_ptr<ChainFreezer> unfreeze();
+
+    /**
+     * Returns true while the chain output is being captured for a freeze.
+     */
+    bool isFreezing() const { return _freezer != nullptr && !_isFrozen; }
+
+    /**
+     * Returns true if the chain is playing back its captured audio.
+     */
+    bool isFrozen() const { return _isFrozen; }
+
     void restoreFromXml(juce::XmlElement* element,
                         HostConfiguration configuration,
                         const PluginConfigurator& pluginConfigurator,
                         std::function<void(juce::String)> onErrorCallback);
-    void writeToXml(juce::XmlElement* element);
+
+    /**
+     * Restores the chain straight into the hibernated state, without loading its plugins. Used for
+     * chains the split type being restored doesn't process.
+     */
+    void restoreHibernatedFromXml(juce::XmlElement* element, double sampleRate);
+
+    void writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates = nullptr);
 
     // AudioProcessor methods
     virtual const juce::String getName() const override;
@@ -138,6 +325,7 @@ public:
     virtual void releaseResources() override;
     virtual void reset() override;
     virtual void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    virtual void setPlayHead(juce::AudioPlayHead* newPlayHead) override;
     virtual double getTailLengthSeconds() const override;
     virtual bool acceptsMidi() const override;
     virtual bool producesMidi() const override;
@@ -157,13 +345,53 @@ private:
     // (insertion may be slower this way but that'll be on a less important thread)
     std::vector<std::unique_ptr<ChainSlotBase>> _chain;
 
-    bool _isChainBypassed;
-    bool _isChainMuted;
+    // Set from the message thread and read once per block, so these don't need the chain to be
+    // locked
+    std::atomic<bool> _isChainBypassed;
+    std::atomic<bool> _isChainMuted;
+    bool _isMonoLayout;
+    bool _isPrepared;
+
+    // Set while the plugins only exist as the state in _hibernatedState
+    std::atomic<bool> _isHibernated;
+    std::unique_ptr<juce::XmlElement> _hibernatedState;
+    int _hibernatedLatencySamples;
+
+    // Set while the freezer's recording is being played in place of the plugins
+    std::atomic<bool> _isFrozen;
+    std::unique_ptr<ChainFreezer> _freezer;
+
+    // The latency of the plugins when the chain was frozen, this is still reported so the recording
+    // stays aligned with the other chains
+    int _frozenLatencySamples;
 
     std::function<float(int, MODULATION_TYPE)> _getModulationValueCallback;
 
     std::unique_ptr<juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None>> _latencyCompLine;
     WECore::AudioSpinMutex _latencyCompLineMutex;
 
+    // The delay of the latency compensation line, message thread only
+    int _compensationLatencySamples;
+
+    void _writeSlotsToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates);
+    void _restoreChainFlagsFromXml(juce::XmlElement* element);
+    void _restoreHibernatedStateFromXml(juce::XmlElement* element);
+
+    /**
+     * Restores the frozen recording if there is one that can be played at the given sample rate.
+     * Returns true if the chain is frozen.
+     */
+    bool _restoreFreezerFromXml(juce::XmlElement* element, double sampleRate);
+
+    void _restoreSlotsFromXml(juce::XmlElement* pluginsElement,
+                              HostConfiguration configuration,
+                              const PluginConfigurator& pluginConfigurator,
+                              std::function<void(juce::String)> onErrorCallback);
+
+    juce::AudioPlayHead::CurrentPositionInfo _getPlayHeadPosition();
+
+    void _addSlotListener(ChainSlotBase* slot);
+    void _removeSlotListener(ChainSlotBase* slot);
+
     void _onLatencyChange() override;
 };
@@ -52,3 +52,8 @@ bool PluginConfigurator::configure(std::shared_ptr<juce::AudioPluginInstance> pl
 
     return setLayoutOk;
 }
+
+HostConfiguration PluginConfigurator::getMonoConfiguration(HostConfiguration configuration) const {
+    configuration.layout = monoInMonoOutSC;
+    return configuration;
+}
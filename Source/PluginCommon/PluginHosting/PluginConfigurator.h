@@ -22,13 +22,19 @@ public:
      * We assume the buses layout will never change while the plugin is running, so only need to be
      * configured when a plugin is added by the user or has been restored from XML.
      *
-     * We could do things like try to load plugins in mono for split types that only ever need mono
-     * (ie. left/right and mid/side) but that gets really complicated and most users won't see any
-     * benefit from it.
+     * Split types that only ever need mono (ie. left/right and mid/side) can ask for a mono
+     * configuration instead using getMonoConfiguration(), in which case the plugin will be
+     * configured with a mono main bus and mono sidechain.
      */
     bool configure(std::shared_ptr<juce::AudioPluginInstance> plugin,
                    HostConfiguration configuration) const;
 
+    /**
+     * Returns a copy of the given configuration using a mono in/out layout with a mono sidechain,
+     * for use when configuring plugins in chains that only process a single channel.
+     */
+    HostConfiguration getMonoConfiguration(HostConfiguration configuration) const;
+
 private:
     juce::AudioProcessor::BusesLayout monoInMonoOut;
     juce::AudioProcessor::BusesLayout monoInMonoOutSC;
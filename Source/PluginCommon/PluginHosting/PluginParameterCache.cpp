@@ -0,0 +1,113 @@
+#include "PluginParameterCache.h"
+
+#include "ChainSlotPlugin.h"
+
+PluginParameterCache::PluginParameterCache(std::shared_ptr<juce::AudioPluginInstance> plugin) :
+        _plugin(plugin),
+        _numChanges(0),
+        _numChangesRebuilt(0) {
+    _data = _buildData();
+    _plugin->addListener(this);
+}
+
+PluginParameterCache::~PluginParameterCache() {
+    _plugin->removeListener(this);
+    cancelPendingUpdate();
+}
+
+const CachedParameterInfo* PluginParameterCache::findByName(const juce::String& name) const {
+    const auto iter = _data->nameToPosition.find(name);
+    return iter != _data->nameToPosition.end() ? &_data->parameters[iter->second] : nullptr;
+}
+
+const CachedParameterInfo* PluginParameterCache::findByID(const juce::String& id) const {
+    const auto iter = _data->idToPosition.find(id);
+    return iter != _data->idToPosition.end() ? &_data->parameters[iter->second] : nullptr;
+}
+
+const CachedParameterInfo* PluginParameterCache::findByIndex(int index) const {
+    // Parameters are stored in index order
+    return index >= 0 && index < static_cast<int>(_data->parameters.size()) ? &_data->parameters[index] : nullptr;
+}
+
+const CachedParameterInfo* PluginParameterCache::findByParameter(const juce::AudioProcessorParameter* parameter) const {
+    return parameter != nullptr ? findByIndex(parameter->getParameterIndex()) : nullptr;
+}
+
+const CachedParameterInfo* PluginParameterCache::findTarget(const juce::String& id, int index, const juce::String& name) const {
+    if (id.isNotEmpty()) {
+        const CachedParameterInfo* info {findByID(id)};
+        if (info != nullptr) {
+            return info;
+        }
+    }
+
+    // Only trust the index if it still points to the same parameter, otherwise the plugin may have
+    // reordered them
+    const CachedParameterInfo* info {findByIndex(index)};
+    if (info != nullptr && info->name == name) {
+        return info;
+    }
+
+    return findByName(name);
+}
+
+void PluginParameterCache::handleAsyncUpdate() {
+    // Any changes reported after this point will trigger another rebuild
+    const int numChanges {_numChanges};
+
+    _data = _buildData();
+
+    if (_onRebuiltCallback) {
+        _onRebuiltCallback();
+    }
+
+    _numChangesRebuilt = numChanges;
+}
+
+void PluginParameterCache::audioProcessorChanged(juce::AudioProcessor* /*processor*/, const ChangeDetails& details) {
+    if (details.parameterInfoChanged) {
+        // Rebuild on the message thread, until then anything resolved from the cache is stale
+        _numChanges++;
+        triggerAsyncUpdate();
+    }
+}
+
+std::unique_ptr<PluginParameterCache::CacheData> PluginParameterCache::_buildData() const {
+    std::unique_ptr<CacheData> retVal = std::make_unique<CacheData>();
+
+    const juce::Array<juce::AudioProcessorParameter*>& parameters = _plugin->getParameters();
+    retVal->parameters.reserve(parameters.size());
+
+    for (juce::AudioProcessorParameter* parameter : parameters) {
+        CachedParameterInfo info;
+        info.parameter = parameter;
+        info.index = parameter->getParameterIndex();
+        info.name = parameter->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT);
+        info.label = parameter->getLabel();
+        info.defaultValue = parameter->getDefaultValue();
+        info.numSteps = parameter->getNumSteps();
+        info.isDiscrete = parameter->isDiscrete();
+        info.isBoolean = parameter->isBoolean();
+        info.category = parameter->getCategory();
+
+        juce::HostedAudioProcessorParameter* hostedParameter = dynamic_cast<juce::HostedAudioProcessorParameter*>(parameter);
+        if (hostedParameter != nullptr) {
+            info.id = hostedParameter->getParameterID();
+        }
+
+        juce::RangedAudioProcessorParameter* rangedParameter = dynamic_cast<juce::RangedAudioProcessorParameter*>(parameter);
+        if (rangedParameter != nullptr) {
+            info.range = rangedParameter->getNormalisableRange();
+        }
+
+        // If names are duplicated only the first one can be found by name
+        retVal->nameToPosition.emplace(info.name, retVal->parameters.size());
+        if (info.id.isNotEmpty()) {
+            retVal->idToPosition.emplace(info.id, retVal->parameters.size());
+        }
+        retVal->parameters.push_back(info);
+    }
+
+    return retVal;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Metadata about one of a guest plugin's parameters, read once when the cache is built.
+ */
+struct CachedParameterInfo {
+    juce::AudioProcessorParameter* parameter;
+
+    // Position in the plugin's parameter list
+    int index;
+
+    // The plugin's own ID for the parameter, empty if it doesn't provide one
+    juce::String id;
+
+    // Name truncated in the same way as modulation target names
+    juce::String name;
+
+    juce::String label;
+    juce::NormalisableRange<float> range;
+    float defaultValue;
+    int numSteps;
+    bool isDiscrete;
+    bool isBoolean;
+    juce::AudioProcessorParameter::Category category;
+};
+
+/**
+ * Caches the parameter metadata of a guest plugin so it doesn't need to be requested from the
+ * plugin each time it's needed, which can be slow for plugins with thousands of parameters.
+ *
+ * The cache is rebuilt on the message thread whenever the plugin reports that its parameter info
+ * has changed.
+ */
+class PluginParameterCache : public juce::AsyncUpdater,
+                             public juce::AudioProcessorListener {
+public:
+    explicit PluginParameterCache(std::shared_ptr<juce::AudioPluginInstance> plugin);
+    ~PluginParameterCache();
+
+    /**
+     * Returns the metadata of every parameter in the order the plugin provides them. Message
+     * thread only.
+     */
+    const std::vector<CachedParameterInfo>& getParameters() const { return _data->parameters; }
+
+    /**
+     * Lookups return nullptr if there is no matching parameter. Message thread only.
+     */
+    const CachedParameterInfo* findByName(const juce::String& name) const;
+    const CachedParameterInfo* findByID(const juce::String& id) const;
+    const CachedParameterInfo* findByIndex(int index) const;
+    const CachedParameterInfo* findByParameter(const juce::AudioProcessorParameter* parameter) const;
+
+    /**
+     * Finds a parameter saved in a config by ID, then by index if the name at that index still
+     * matches, then by name. The ID and index may be empty for configs saved before they were
+     * stored. Message thread only.
+     */
+    const CachedParameterInfo* findTarget(const juce::String& id, int index, const juce::String& name) const;
+
+    /**
+     * True from when the plugin reports its parameter info has changed until the cache has been
+     * rebuilt and the rebuilt callback has returned. Parameters resolved from the cache shouldn't
+     * be used while this is true. Safe to call from the audio thread.
+     */
+    bool isStale() const { return _numChanges != _numChangesRebuilt; }
+
+    /**
+     * Called on the message thread after the cache has been rebuilt.
+     */
+    void setOnRebuiltCallback(std::function<void()> callback) { _onRebuiltCallback = callback; }
+
+    void handleAsyncUpdate() override;
+
+    void audioProcessorParameterChanged(juce::AudioProcessor* /*processor*/,
+                                        int /*parameterIndex*/,
+                                        float /*newValue*/) override {
+        // Do nothing
+    }
+
+    /**
+     * Called by the plugin, possibly on the audio thread.
+     */
+    void audioProcessorChanged(juce::AudioProcessor* processor, const ChangeDetails& details) override;
+
+private:
+    struct CacheData {
+        std::vector<CachedParameterInfo> parameters;
+        std::map<juce::String, size_t> nameToPosition;
+        std::map<juce::String, size_t> idToPosition;
+    };
+
+    std::shared_ptr<juce::AudioPluginInstance> _plugin;
+    std::unique_ptr<CacheData> _data;
+    std::atomic<int> _numChanges;
+    std::atomic<int> _numChangesRebuilt;
+    std::function<void()> _onRebuiltCallback;
+
+    std::unique_ptr<CacheData> _buildData() const;
+};
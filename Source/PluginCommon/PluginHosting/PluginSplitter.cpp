@@ -9,6 +9,7 @@
 */
 
 #include "PluginSplitter.h"
+#include "Tracer.h"
 
 namespace {
     const char* XML_CHAINS_STR {"Chains"};
@@ -21,13 +22,40 @@ namespace {
     }
 }
 
+PluginSplitter::BatchScope::BatchScope(PluginSplitter& splitter) : _splitter(splitter) {
+    _splitter._batchDepth++;
+}
+
+PluginSplitter::BatchScope::~BatchScope() {
+    _splitter._batchDepth--;
+
+    if (_splitter._batchDepth == 0) {
+        // Chains report latency changes asynchronously, so pick up any that were reported during
+        // the batch now rather than in another pass on the next message loop iteration
+        if (_splitter._needsLatencyUpdate || _splitter.isUpdatePending()) {
+            _splitter.cancelPendingUpdate();
+            _splitter._needsLatencyUpdate = false;
+            _splitter._onLatencyChange();
+        }
+
+        if (_splitter._needsPlanRebuild) {
+            _splitter._needsPlanRebuild = false;
+            _splitter._rebuildPlan();
+        }
+    }
+}
+
 PluginSplitter::PluginSplitter(int defaultNumChains,
                                std::function<float(int, MODULATION_TYPE)> getModulationValueCallback) :
         AudioProcessor(BusesProperties().withInput("Input", juce::AudioChannelSet::stereo(), true)
                                         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
                                         .withInput("Sidechain", juce::AudioChannelSet::stereo(), true)),
         _numChainsSoloed(0),
-        _getModulationValueCallback(getModulationValueCallback) {
+        _getModulationValueCallback(getModulationValueCallback),
+        _workerPool(nullptr),
+        _batchDepth(0),
+        _needsPlanRebuild(false),
+        _needsLatencyUpdate(false) {
     // Set up the default number of chains
     for (int idx {0}; idx < defaultNumChains; idx++) {
         _chains.emplace_back(std::make_unique<PluginChain>(_getModulationValueCallback), false);
@@ -43,7 +71,11 @@ PluginSplitter::PluginSplitter(std::vector<PluginChainWrapper>& chains,
                                         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
                                         .withInput("Sidechain", juce::AudioChannelSet::stereo(), true)),
         _numChainsSoloed(0),
-        _getModulationValueCallback(getModulationValueCallback) {
+        _getModulationValueCallback(getModulationValueCallback),
+        _workerPool(nullptr),
+        _batchDepth(0),
+        _needsPlanRebuild(false),
+        _needsLatencyUpdate(false) {
 
     // Carry all the chains over from the previous splitter
     for (size_t index {0}; index < chains.size(); index++) {
@@ -103,6 +135,27 @@ bool PluginSplitter::removeSlot(int chainNumber, int positionInChain) {
     return success;
 }
 
+std::unique_ptr<ChainSlotBase> PluginSplitter::releaseSlot(int chainNumber, int positionInChain) {
+    std::unique_ptr<ChainSlotBase> slot;
+
+    if (_chains.size() > chainNumber) {
+        slot = _chains[chainNumber].chain->releaseSlot(positionInChain);
+    }
+
+    return slot;
+}
+
+bool PluginSplitter::insertSlot(std::unique_ptr<ChainSlotBase> slot, int chainNumber, int positionInChain) {
+    bool success {false};
+
+    if (_chains.size() > chainNumber) {
+        _chains[chainNumber].chain->insertSlot(std::move(slot), positionInChain);
+        success = true;
+    }
+
+    return success;
+}
+
 bool PluginSplitter::insertGainStage(int chainNumber, int positionInChain, const juce::AudioProcessor::BusesLayout& busesLayout) {
     bool success {false};
 
@@ -125,6 +178,17 @@ std::shared_ptr<juce::AudioPluginInstance> PluginSplitter::getPlugin(int chainNu
     return retVal;
 }
 
+PluginParameterCache* PluginSplitter::getPluginParameterCache(int chainNumber, int positionInChain) {
+
+    PluginParameterCache* retVal {nullptr};
+
+    if (_chains.size() > chainNumber) {
+        retVal = _chains[chainNumber].chain->getPluginParameterCache(positionInChain);
+    }
+
+    return retVal;
+}
+
 bool PluginSplitter::setPluginModulationConfig(PluginModulationConfig config, int chainNumber, int positionInChain) {
     bool retVal {false};
 
@@ -145,6 +209,12 @@ PluginModulationConfig PluginSplitter::getPluginModulationConfig(int chainNumber
     return retVal;
 }
 
+void PluginSplitter::removeModulationSource(ModulationSourceDefinition definition) {
+    for (PluginChainWrapper& chain : _chains) {
+        chain.chain->removeModulationSource(definition);
+    }
+}
+
 std::vector<PluginChainWrapper>& PluginSplitter::releaseChains() {
     for (PluginChainWrapper& chain : _chains) {
         chain.chain->removeListener(this);
@@ -242,10 +312,169 @@ float PluginSplitter::getPan(int chainNumber, int positionInChain) {
     return retVal;
 }
 
+void PluginSplitter::configureChainLayouts(HostConfiguration configuration, const PluginConfigurator& pluginConfigurator) {
+    for (PluginChainWrapper& chain : _chains) {
+        chain.chain->configureLayout(configuration, canUseMonoChains(), pluginConfigurator);
+    }
+
+    // Mono chains are routed differently
+    _rebuildPlan();
+}
+
+void PluginSplitter::configureChainLayout(int chainNumber, HostConfiguration configuration, const PluginConfigurator& pluginConfigurator) {
+    if (chainNumber >= 0 && chainNumber < _chains.size()) {
+        _chains[chainNumber].chain->configureLayout(configuration, canUseMonoChains(), pluginConfigurator);
+
+        // Mono chains are routed differently
+        _rebuildPlan();
+    }
+}
+
+bool PluginSplitter::needsLayoutChange(int chainNumber, int numMainChannels, const HostConfiguration& configuration) {
+    if (chainNumber < 0 || chainNumber >= _chains.size()) {
+        return false;
+    }
+
+    const PluginChain& chain = *_chains[chainNumber].chain;
+    const int numHostChannels {configuration.layout.getMainInputChannels()};
+
+    if (numMainChannels == 0) {
+        return !chain.isMonoLayout() && canUseMonoChains() && numHostChannels == 2;
+    }
+
+    return numMainChannels != (chain.isMonoLayout() ? 1 : numHostChannels);
+}
+
+void PluginSplitter::hibernateUnusedChains() {
+    for (size_t chainNumber {getNumActiveChains()}; chainNumber < _chains.size(); chainNumber++) {
+        _chains[chainNumber].chain->hibernate();
+    }
+}
+
+std::map<int, std::unique_ptr<juce::XmlElement>> PluginSplitter::createChainStates() {
+    std::map<int, std::unique_ptr<juce::XmlElement>> retVal;
+
+    for (size_t chainNumber {0}; chainNumber < _chains.size(); chainNumber++) {
+        PluginChain& chain = *_chains[chainNumber].chain;
+
+        if (!chain.isHibernated() && chain.getNumSlots() > 0) {
+            retVal[static_cast<int>(chainNumber)] = chain.createHibernatedState();
+        }
+    }
+
+    return retVal;
+}
+
+std::vector<std::unique_ptr<ChainSlotBase>> PluginSplitter::hibernateChains(std::map<int, std::unique_ptr<juce::XmlElement>> states) {
+    std::vector<std::unique_ptr<ChainSlotBase>> retVal;
+
+    for (auto& [chainNumber, state] : states) {
+        if (chainNumber < static_cast<int>(_chains.size())) {
+            std::vector<std::unique_ptr<ChainSlotBase>> slots = _chains[chainNumber].chain->detachSlotsToHibernate(std::move(state), true);
+            std::move(slots.begin(), slots.end(), std::back_inserter(retVal));
+        }
+    }
+
+    return retVal;
+}
+
+void PluginSplitter::configureEmptyChainLayouts(HostConfiguration configuration, const PluginConfigurator& pluginConfigurator) {
+    for (PluginChainWrapper& chain : _chains) {
+        if (chain.chain->getNumSlots() == 0) {
+            chain.chain->configureLayout(configuration, canUseMonoChains(), pluginConfigurator);
+        }
+    }
+
+    // Mono chains are routed differently
+    _rebuildPlan();
+}
+
+std::map<int, std::unique_ptr<juce::XmlElement>> PluginSplitter::createMutedChainStates() {
+    std::map<int, std::unique_ptr<juce::XmlElement>> retVal;
+
+    const size_t numActiveChains {std::min(getNumActiveChains(), _chains.size())};
+    for (size_t chainNumber {0}; chainNumber < numActiveChains; chainNumber++) {
+        PluginChain& chain = *_chains[chainNumber].chain;
+
+        if (chain.getChainMute() && !chain.isHibernated() && !chain.isFreezing()) {
+            retVal[static_cast<int>(chainNumber)] = chain.createHibernatedState();
+        }
+    }
+
+    return retVal;
+}
+
+std::vector<std::unique_ptr<ChainSlotBase>> PluginSplitter::hibernateMutedChains(std::map<int, std::unique_ptr<juce::XmlElement>> states) {
+    std::vector<std::unique_ptr<ChainSlotBase>> retVal;
+
+    for (auto& [chainNumber, state] : states) {
+        if (chainNumber >= static_cast<int>(std::min(getNumActiveChains(), _chains.size()))) {
+            continue;
+        }
+
+        // Check again in case the chain has changed since the state was stored
+        PluginChain& chain = *_chains[chainNumber].chain;
+        if (chain.getChainMute() && !chain.isFreezing()) {
+            std::vector<std::unique_ptr<ChainSlotBase>> slots = chain.detachSlotsToHibernate(std::move(state), true);
+            std::move(slots.begin(), slots.end(), std::back_inserter(retVal));
+        }
+    }
+
+    return retVal;
+}
+
+bool PluginSplitter::hasHibernatedActiveChains(bool includeMutedChains) const {
+    return findHibernatedActiveChain(includeMutedChains) >= 0;
+}
+
+int PluginSplitter::findHibernatedActiveChain(bool includeMutedChains) const {
+    const size_t numActiveChains {std::min(getNumActiveChains(), _chains.size())};
+    for (size_t chainNumber {0}; chainNumber < numActiveChains; chainNumber++) {
+        const PluginChain& chain = *_chains[chainNumber].chain;
+
+        if (chain.isHibernated() && !chain.isFrozen() && (includeMutedChains || !chain.getChainMute())) {
+            return static_cast<int>(chainNumber);
+        }
+    }
+
+    return -1;
+}
+
+void PluginSplitter::wakeActiveChains(HostConfiguration configuration,
+                                      const PluginConfigurator& pluginConfigurator,
+                                      std::function<void(juce::String)> onErrorCallback,
+                                      bool includeMutedChains) {
+    const size_t numActiveChains {std::min(getNumActiveChains(), _chains.size())};
+    for (size_t chainNumber {0}; chainNumber < numActiveChains; chainNumber++) {
+        if (_chains[chainNumber].chain->isFrozen() ||
+            (!includeMutedChains && _chains[chainNumber].chain->getChainMute())) {
+            continue;
+        }
+
+        _chains[chainNumber].chain->wake(configuration, canUseMonoChains(), pluginConfigurator, onErrorCallback);
+    }
+
+    // Waking may have changed the layout of the chains
+    _rebuildPlan();
+}
+
+void PluginSplitter::wakeChain(int chainNumber,
+                               HostConfiguration configuration,
+                               const PluginConfigurator& pluginConfigurator,
+                               std::function<void(juce::String)> onErrorCallback) {
+    if (chainNumber < _chains.size()) {
+        _chains[chainNumber].chain->wake(configuration, canUseMonoChains(), pluginConfigurator, onErrorCallback);
+        _rebuildPlan();
+    }
+}
+
 void PluginSplitter::restoreFromXml(juce::XmlElement* element,
                                     HostConfiguration configuration,
                                     const PluginConfigurator& pluginConfigurator,
                                     std::function<void(juce::String)> onErrorCallback) {
+    // The chains report their latency as each slot is restored, only recalculate it once at the end
+    BatchScope batch(*this);
+
     // Reset state
     _numChainsSoloed = 0;
     while (!_chains.empty()) {
@@ -277,14 +506,26 @@ void PluginSplitter::restoreFromXml(juce::XmlElement* element,
             PluginChainWrapper& thisChain = _chains[_chains.size() - 1];
             thisChain.chain->addListener(this);
             thisChain.isSoloed = isSoloed;
-            thisChain.chain->restoreFromXml(thisChainElement, configuration, pluginConfigurator, onErrorCallback);
+
+            // Chains this split type doesn't process don't need their plugins loading until a
+            // split type that does is selected
+            if (chainNumber < getNumActiveChains()) {
+                thisChain.chain->restoreFromXml(thisChainElement, configuration, pluginConfigurator, onErrorCallback);
+            } else {
+                thisChain.chain->restoreHibernatedFromXml(thisChainElement, configuration.sampleRate);
+            }
+
+            if (isSoloed) {
+                _numChainsSoloed++;
+            }
         }
     }
 
     _onLatencyChange();
+    _rebuildPlan();
 }
 
-void PluginSplitter::writeToXml(juce::XmlElement* element) {
+void PluginSplitter::writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates) {
     juce::Logger::writeToLog("Storing splitter state");
 
     juce::XmlElement* chainsElement = element->createNewChildElement(XML_CHAINS_STR);
@@ -295,8 +536,8 @@ void PluginSplitter::writeToXml(juce::XmlElement* element) {
         juce::XmlElement* thisChainElement = chainsElement->createNewChildElement(getChainXMLName(chainNumber));
         PluginChainWrapper& thisChain = _chains[chainNumber];
 
-        thisChainElement->setAttribute(XML_ISSOLOED_STR, thisChain.isSoloed);
-        thisChain.chain->writeToXml(thisChainElement);
+        thisChainElement->setAttribute(XML_ISSOLOED_STR, thisChain.isSoloed.load());
+        thisChain.chain->writeToXml(thisChainElement, deferredStates);
     }
 }
 
@@ -307,10 +548,25 @@ const juce::String PluginSplitter::getName() const {
 }
 void PluginSplitter::prepareToPlay(double sampleRate, int samplesPerBlock) {
     setRateAndBufferSizeDetails(sampleRate, samplesPerBlock);
+    _prepareSplitter(sampleRate, samplesPerBlock);
 
     for (PluginChainWrapper& chainWrapper : _chains) {
         chainWrapper.chain->prepareToPlay(sampleRate, samplesPerBlock);
     }
+
+    // The plan's buffers need to match the block size
+    _rebuildPlan();
+}
+
+void PluginSplitter::prepareToPlayIfNeeded(double sampleRate, int samplesPerBlock) {
+    setRateAndBufferSizeDetails(sampleRate, samplesPerBlock);
+    _prepareSplitter(sampleRate, samplesPerBlock);
+
+    for (PluginChainWrapper& chainWrapper : _chains) {
+        chainWrapper.chain->prepareToPlayIfNeeded(sampleRate, samplesPerBlock);
+    }
+
+    _rebuildPlan();
 }
 
 void PluginSplitter::releaseResources() {
@@ -319,6 +575,25 @@ void PluginSplitter::releaseResources() {
     }
 }
 
+void PluginSplitter::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+    WECore::AudioSpinTryLock lock(_planMutex);
+    if (lock.isLocked() && _plan != nullptr) {
+        // The pool gives priority to whichever instance's block is due soonest
+        const juce::int64 deadlineTicks {_workerPool != nullptr ?
+            WorkerPool::getDeadlineForBlock(buffer.getNumSamples(), getSampleRate()) : 0};
+
+        _plan->process(buffer, midiMessages, _chains, _numChainsSoloed, _workerPool, deadlineTicks);
+    }
+}
+
+void PluginSplitter::setPlayHead(juce::AudioPlayHead* newPlayHead) {
+    juce::AudioProcessor::setPlayHead(newPlayHead);
+
+    for (PluginChainWrapper& chainWrapper : _chains) {
+        chainWrapper.chain->setPlayHead(newPlayHead);
+    }
+}
+
 void PluginSplitter::reset() {
     for (PluginChainWrapper& chainWrapper : _chains) {
         chainWrapper.chain->reset();
@@ -379,37 +654,38 @@ void PluginSplitter::setStateInformation(const void* data, int sizeInBytes) {
     // TODO
 }
 
-void PluginSplitter::_copyBuffer(juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& destination) {
-    if (source.getNumSamples() == destination.getNumSamples()) {
-
-        int channelsToCopy {std::min(source.getNumChannels(), destination.getNumChannels())};
-
-        // For each channel, copy each sample
-        for (int channelIndex {0}; channelIndex < channelsToCopy; channelIndex++) {
-            const float* readPointer = source.getReadPointer(channelIndex);
-            float* writePointer = destination.getWritePointer(channelIndex);
+void PluginSplitter::_rebuildPlan() {
+    if (_batchDepth > 0) {
+        _needsPlanRebuild = true;
+        return;
+    }
 
-            juce::FloatVectorOperations::copy(writePointer, readPointer, source.getNumSamples());
-        }
+    if (getBlockSize() <= 0) {
+        // prepareToPlay() will build it
+        return;
     }
-}
 
-void PluginSplitter::_addBuffers(juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& destination) {
-    if (source.getNumSamples() == destination.getNumSamples()) {
+    Tracer::Scope traceScope("rebuildPlan", "graph");
 
-        int channelsToCopy {std::min(source.getNumChannels(), destination.getNumChannels())};
+    ProcessingPlanBuilder builder;
+    _buildPlan(builder);
 
-        // For each channel, add each sample
-        for (int channelIndex {0}; channelIndex < channelsToCopy; channelIndex++) {
-            const float* readPointer = source.getReadPointer(channelIndex);
-            float* writePointer = destination.getWritePointer(channelIndex);
+    std::unique_ptr<ProcessingPlan> newPlan = builder.compile(getBlockSize());
 
-            juce::FloatVectorOperations::add(writePointer, readPointer, source.getNumSamples());
-        }
+    {
+        WECore::AudioSpinLock lock(_planMutex);
+        std::swap(_plan, newPlan);
     }
+
+    // The old plan is deleted here, outside the lock
 }
 
 void PluginSplitter::_onLatencyChange() {
+    if (_batchDepth > 0) {
+        _needsLatencyUpdate = true;
+        return;
+    }
+
     // The latency of the splitter is the latency of the slowest chain, so iterate through each
     // chain and report the highest latency
     int highestLatency {0};
@@ -10,10 +10,12 @@
 
 #pragma once
 
+#include <map>
 #include <vector>
 #include <JuceHeader.h>
 
 #include "PluginChain.h"
+#include "ProcessingPlan.h"
 #include "LatencyListener.h"
 #include "SplitTypes.h"
 
@@ -24,24 +26,54 @@ struct PluginChainWrapper {
     PluginChainWrapper(std::unique_ptr<PluginChain> newChain, bool newIsSoloed)
             : chain(std::move(newChain)), isSoloed(newIsSoloed) {}
 
+    PluginChainWrapper(PluginChainWrapper&& other)
+            : chain(std::move(other.chain)), isSoloed(other.isSoloed.load()) {}
+
+    PluginChainWrapper& operator=(PluginChainWrapper&& other) {
+        chain = std::move(other.chain);
+        isSoloed = other.isSoloed.load();
+        return *this;
+    }
+
     std::unique_ptr<PluginChain> chain;
-    bool isSoloed;
+
+    // Read by the plan on the audio thread
+    std::atomic<bool> isSoloed;
 };
 
 /**
  * Base class which provides the audio splitting functionality.
  *
- * Each derived class contains one or more plugin chains (one for each split).
+ * Each derived class contains one or more plugin chains (one for each split), and describes how
+ * audio is routed through them by building a ProcessingPlan. The plan is rebuilt on the message
+ * thread whenever the routing changes (eg. chains are added or change layout) and is run by
+ * processBlock(). Soloing is applied by the plan as it runs so doesn't need a rebuild.
  *
  * A splitter may contain more chains than it can actually use if they have been carried over from
  * a previous splitter that could handle more. In this case its processBlock will just ignore the
- * extra chains.
- *
- * TODO: Ideally the state of the plugins in the unused chains would be stored and the plugin
- * instances removed until they are eventually needed, but for now we just keep them.
+ * extra chains, and they can be hibernated so their plugin instances are removed until they are
+ * eventually needed.
  */
 class PluginSplitter : public juce::AudioProcessor, public LatencyListener {
 public:
+    /**
+     * Defers rebuilding the plan and recalculating the latency compensation until the outermost
+     * scope ends, so a batch of edits only does each once however many edits there are.
+     *
+     * Must only be used on the message thread. The plan won't match the chains until the scope
+     * ends, so the splitter mustn't be processed during the batch if chains are added or removed or
+     * change layout. Edits to the slots within chains don't change the plan, so the splitter can be
+     * processed while the scope is held and only needs locking for each edit.
+     */
+    class BatchScope {
+    public:
+        explicit BatchScope(PluginSplitter& splitter);
+        ~BatchScope();
+
+    private:
+        PluginSplitter& _splitter;
+    };
+
     PluginSplitter(int defaultNumChains,
                    std::function<float(int, MODULATION_TYPE)> _getModulationValueCallback);
     PluginSplitter(std::vector<PluginChainWrapper>& chains,
@@ -53,13 +85,22 @@ public:
     bool insertPlugin(std::shared_ptr<juce::AudioPluginInstance> plugin, int chainNumber, int positionInChain);
     bool replacePlugin(std::shared_ptr<juce::AudioPluginInstance> plugin, int chainNumber, int positionInChain);
     bool removeSlot(int chainNumber, int positionInChain);
+    std::unique_ptr<ChainSlotBase> releaseSlot(int chainNumber, int positionInChain);
+    bool insertSlot(std::unique_ptr<ChainSlotBase> slot, int chainNumber, int positionInChain);
     bool insertGainStage(int chainNumber, int positionInChain, const juce::AudioProcessor::BusesLayout& busesLayout);
 
     std::shared_ptr<juce::AudioPluginInstance> getPlugin(int chainNumber, int positionInChain);
+    PluginParameterCache* getPluginParameterCache(int chainNumber, int positionInChain);
 
     bool setPluginModulationConfig(PluginModulationConfig config, int chainNumber, int positionInChain);
     PluginModulationConfig getPluginModulationConfig(int chainNumber, int positionInChain) const;
 
+    /**
+     * Removes the given modulation source from every plugin in every chain, renumbering the
+     * sources that follow it.
+     */
+    void removeModulationSource(ModulationSourceDefinition definition);
+
     std::unique_ptr<PluginChain>& getChain(int chainNumber) { return _chains[chainNumber].chain; }
     std::vector<PluginChainWrapper>& getChains() { return _chains; }
     std::vector<PluginChainWrapper>& releaseChains();
@@ -80,16 +121,163 @@ public:
 
     virtual SPLIT_TYPE getSplitType() = 0;
 
+    /**
+     * Returns true if each chain only ever processes a single channel (eg. left/right or
+     * mid/side), so the plugins in it can be configured in mono.
+     */
+    virtual bool canUseMonoChains() const { return false; }
+
+    /**
+     * Configures the layouts of the plugins in each chain to suit this split type.
+     *
+     * Should be called after the splitter is created and after any plugins are added or moved.
+     */
+    void configureChainLayouts(HostConfiguration configuration, const PluginConfigurator& pluginConfigurator);
+
+    /**
+     * Configures the layout of a single chain, for when only that chain's slots have changed.
+     */
+    void configureChainLayout(int chainNumber, HostConfiguration configuration, const PluginConfigurator& pluginConfigurator);
+
+    /**
+     * Returns true if the chain's layout would need configuring after inserting a slot which
+     * processes the given number of main channels, or after removing a slot if numMainChannels is 0
+     * (as a stereo chain may then be able to use mono).
+     *
+     * Configuring a layout renegotiates the buses of the chain's plugins, so it can't be done while
+     * the chain is being processed.
+     */
+    bool needsLayoutChange(int chainNumber, int numMainChannels, const HostConfiguration& configuration);
+
+    /**
+     * Prepares the splitter's own buffers and filters, but only prepares the chains and slots
+     * which haven't already been prepared with the given sample rate and block size.
+     *
+     * Used after changing split type, where the chains carried over from the previous splitter
+     * have usually already been prepared.
+     */
+    void prepareToPlayIfNeeded(double sampleRate, int samplesPerBlock);
+
+    /**
+     * Returns the number of chains this split type actually processes, any chains after these
+     * have been carried over from a previous splitter.
+     */
+    virtual size_t getNumActiveChains() const { return _chains.size(); }
+
+    /**
+     * Hibernates any chains which this split type doesn't process. Restoring from XML already
+     * leaves these chains hibernated, this is for chains carried over from a previous splitter.
+     *
+     * The plan doesn't refer to these chains, so this can be called while the splitter is being
+     * processed. Deletes their plugins, so shouldn't be called with the splitter locked.
+     */
+    void hibernateUnusedChains();
+
+    /**
+     * Stores the state of every chain that has slots and isn't already hibernated, by chain
+     * number. Can be called while the splitter is being processed.
+     */
+    std::map<int, std::unique_ptr<juce::XmlElement>> createChainStates();
+
+    /**
+     * Hibernates the chains whose states were stored by createChainStates(), keeping their latency
+     * so the other chains stay aligned. Used when the chains are being given to a splitter whose
+     * layout they can't be reconfigured for while they're processed, they're woken again one at a
+     * time by wakeChain().
+     *
+     * Must be called with the splitter locked or not yet visible to the audio thread. Returns the
+     * chains' slots so the plugins can be deleted once the splitter is unlocked.
+     */
+    std::vector<std::unique_ptr<ChainSlotBase>> hibernateChains(std::map<int, std::unique_ptr<juce::XmlElement>> states);
+
+    /**
+     * Configures the layouts of the chains which don't have any slots (eg. new or hibernated
+     * chains), which doesn't touch any plugins so can be done with the splitter locked.
+     */
+    void configureEmptyChainLayouts(HostConfiguration configuration, const PluginConfigurator& pluginConfigurator);
+
+    /**
+     * Stores the state of each muted chain this split type processes that isn't already hibernated
+     * or being frozen, by chain number. Can be called while the splitter is being processed.
+     */
+    std::map<int, std::unique_ptr<juce::XmlElement>> createMutedChainStates();
+
+    /**
+     * Hibernates the chains whose states were stored by createMutedChainStates(), keeping their
+     * latency so the other chains stay aligned. Used to save resources when overloaded (see
+     * CpuGovernor), the chains are woken again by wakeActiveChains().
+     *
+     * Must be called with the splitter locked, on the thread that mutes and unmutes the chains
+     * (the message thread). Returns the chains' slots so the plugins can be deleted once the
+     * splitter is unlocked.
+     */
+    std::vector<std::unique_ptr<ChainSlotBase>> hibernateMutedChains(std::map<int, std::unique_ptr<juce::XmlElement>> states);
+
+    /**
+     * Returns true if any of the chains this split type processes are hibernated and need to be
+     * woken. Frozen chains stay hibernated until they're unfrozen, and muted chains are ignored if
+     * includeMutedChains is false.
+     */
+    bool hasHibernatedActiveChains(bool includeMutedChains = true) const;
+
+    /**
+     * Returns the number of the first chain hasHibernatedActiveChains() would find, or -1 if there
+     * isn't one.
+     */
+    int findHibernatedActiveChain(bool includeMutedChains = true) const;
+
+    /**
+     * Recreates the plugins of any hibernated chains this split type processes, except muted
+     * chains if includeMutedChains is false. Must be called on the message thread, but can be
+     * called while the splitter is being processed.
+     */
+    void wakeActiveChains(HostConfiguration configuration,
+                          const PluginConfigurator& pluginConfigurator,
+                          std::function<void(juce::String)> onErrorCallback,
+                          bool includeMutedChains = true);
+
+    /**
+     * Recreates the plugins of the given hibernated chain. Must be called on the message thread,
+     * but can be called while the splitter is being processed.
+     */
+    void wakeChain(int chainNumber,
+                   HostConfiguration configuration,
+                   const PluginConfigurator& pluginConfigurator,
+                   std::function<void(juce::String)> onErrorCallback);
+
+    /**
+     * Sets the pool used to process independent chains concurrently, or nullptr to process
+     * everything on the calling thread. The pool is owned by the caller and is usually the one
+     * shared by every instance (see WorkerPool::getShared()).
+     *
+     * Only set this on the top level splitter - nested splitters are already being processed by
+     * the pool.
+     */
+    void setWorkerPool(WorkerPool* workerPool) { _workerPool = workerPool; }
+
+    /**
+     * Returns a description of each step of the current plan. Must be called on the message
+     * thread, which is the only thread that replaces the plan.
+     */
+    juce::String getPlanDescription() const { return _plan != nullptr ? _plan->toString() : juce::String(); }
+
     void restoreFromXml(juce::XmlElement* element,
                         HostConfiguration configuration,
                         const PluginConfigurator& pluginConfigurator,
                         std::function<void(juce::String)> onErrorCallback);
-    void writeToXml(juce::XmlElement* element);
+    /**
+     * Writes the splitter to the given element. If deferredStates is provided the plugins' states
+     * are added to it to be written later, so the splitter only needs to be locked while the
+     * structure is written.
+     */
+    void writeToXml(juce::XmlElement* element, DeferredPluginStates* deferredStates = nullptr);
 
     // AudioProcessor methods
     virtual const juce::String getName() const override;
     virtual void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     virtual void releaseResources() override;
+    virtual void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    virtual void setPlayHead(juce::AudioPlayHead* newPlayHead) override;
     virtual void reset() override;
     virtual double getTailLengthSeconds() const override;
     virtual bool acceptsMidi() const override;
@@ -106,7 +294,7 @@ public:
 
 protected:
     std::vector<PluginChainWrapper> _chains;
-    size_t _numChainsSoloed;
+    std::atomic<size_t> _numChainsSoloed;
     std::function<float(int, MODULATION_TYPE)> _getModulationValueCallback;
 
     /**
@@ -115,9 +303,36 @@ protected:
      */
     virtual void _onChainRestored() { _chains.emplace_back(std::make_unique<PluginChain>(_getModulationValueCallback), false); }
 
-    // Helper methods for subclasses that need to use multiple buffers
-    void _copyBuffer(juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& destination);
-    void _addBuffers(juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& destination);
+    /**
+     * Called when preparing to play before the chains are prepared.
+     * Inheriting classes can override it to prepare any buffers or filters they need.
+     */
+    virtual void _prepareSplitter(double /*sampleRate*/, int /*samplesPerBlock*/) {}
+
+    /**
+     * Called whenever the plan needs to be rebuilt. Inheriting classes describe how audio is routed
+     * through their chains using the builder.
+     *
+     * Buffer ProcessingPlan::IO_BUFFER contains the input when the plan starts and must contain the
+     * output when it finishes.
+     */
+    virtual void _buildPlan(ProcessingPlanBuilder& /*builder*/) {}
+
+    /**
+     * Builds and compiles a new plan, then swaps it with the one in use. Nothing is built until
+     * the splitter has been prepared, as the plan's buffers are sized for the block size.
+     */
+    void _rebuildPlan();
 
     void _onLatencyChange() override;
+
+private:
+    std::unique_ptr<ProcessingPlan> _plan;
+    WECore::AudioSpinMutex _planMutex;
+    WorkerPool* _workerPool;
+
+    // Message thread only, set while a BatchScope is deferring work
+    int _batchDepth;
+    bool _needsPlanRebuild;
+    bool _needsLatencyUpdate;
 };
@@ -9,47 +9,50 @@ PluginSplitterLeftRight::PluginSplitterLeftRight(std::vector<PluginChainWrapper>
         : PluginSplitter(chains, DEFAULT_NUM_CHAINS, getModulationValueCallback) {
 }
 
-void PluginSplitterLeftRight::prepareToPlay(double sampleRate, int samplesPerBlock) {
-    _leftBuffer.reset(new juce::AudioBuffer<float>(4, samplesPerBlock)); // stereo main + stereo sidechain
-    _rightBuffer.reset(new juce::AudioBuffer<float>(4, samplesPerBlock)); // stereo main + stereo sidechain
-
-    PluginSplitter::prepareToPlay(sampleRate, samplesPerBlock);
-}
-
-void PluginSplitterLeftRight::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
-    // TODO: maybe this should be done using mono buffers? (depends if plugins can handle it reliably)
-
-    // Make sure to clear the buffers each time, as on a previous call the plugins may have left
-    // data in the unused channel of each buffer, and since it's not used it won't get implicitly
-    // overwritten (but it'll still be copied to the output)
-    _leftBuffer->clear();
-    _rightBuffer->clear();
+void PluginSplitterLeftRight::_buildPlan(ProcessingPlanBuilder& builder) {
+    const bool isLeftMono {_chains[0].chain->isMonoLayout()};
+    const bool isRightMono {_chains[1].chain->isMonoLayout()};
 
     // Copy the left and right channels to separate buffers
-    if (_numChainsSoloed == 0 || _chains[0].isSoloed) {
-        const float* leftRead {buffer.getReadPointer(0)};
-        float* leftWrite {_leftBuffer->getWritePointer(0)};
-        juce::FloatVectorOperations::copy(leftWrite, leftRead, buffer.getNumSamples());
+    // Mono chains get the signal in channel 0 and the matching sidechain channel in channel 1,
+    // stereo chains get the signal in its original channel
+    // Make sure to clear the buffers first, as the plugins may have left data in the unused
+    // channels of a previous block, and since they're not used they won't get implicitly
+    // overwritten (but they'll still be copied to the output)
+    const int leftBuffer {builder.createBuffer()};
+    builder.clear(leftBuffer);
+    builder.copy(ProcessingPlan::IO_BUFFER, 0, leftBuffer, 0, 1);
+
+    if (isLeftMono) {
+        builder.copy(ProcessingPlan::IO_BUFFER, 2, leftBuffer, 1, 1);
     }
 
-    if (_numChainsSoloed == 0 || _chains[1].isSoloed) {
-        const float* rightRead {buffer.getReadPointer(1)};
-        float* rightWrite {_rightBuffer->getWritePointer(1)};
-        juce::FloatVectorOperations::copy(rightWrite, rightRead, buffer.getNumSamples());
+    const int rightBuffer {builder.createBuffer()};
+    builder.clear(rightBuffer);
+    builder.copy(ProcessingPlan::IO_BUFFER, 1, rightBuffer, isRightMono ? 0 : 1, 1);
+
+    if (isRightMono) {
+        builder.copy(ProcessingPlan::IO_BUFFER, 3, rightBuffer, 1, 1);
     }
 
     // Now the input has been copied we can clear the original
-    buffer.clear();
-
-    // Process the left chain
-    if (_numChainsSoloed == 0 || _chains[0].isSoloed) {
-        _chains[0].chain->processBlock(*(_leftBuffer.get()), midiMessages);
-        _addBuffers(*(_leftBuffer.get()), buffer);
+    builder.clear(ProcessingPlan::IO_BUFFER);
+
+    // Process the left chain, if only the other one is soloed its buffer is cleared instead
+    if (isLeftMono) {
+        builder.processChain(0, leftBuffer, 2, true);
+        builder.add(leftBuffer, 0, ProcessingPlan::IO_BUFFER, 0, 1);
+    } else {
+        builder.processChain(0, leftBuffer, ProcessingPlanBuilder::ALL_CHANNELS, true);
+        builder.add(leftBuffer, 0, ProcessingPlan::IO_BUFFER, 0, ProcessingPlanBuilder::ALL_CHANNELS);
     }
 
     // Process the right chain
-    if (_numChainsSoloed == 0 || _chains[1].isSoloed) {
-        _chains[1].chain->processBlock(*(_rightBuffer.get()), midiMessages);
-        _addBuffers(*(_rightBuffer.get()), buffer);
+    if (isRightMono) {
+        builder.processChain(1, rightBuffer, 2, true);
+        builder.add(rightBuffer, 0, ProcessingPlan::IO_BUFFER, 1, 1);
+    } else {
+        builder.processChain(1, rightBuffer, ProcessingPlanBuilder::ALL_CHANNELS, true);
+        builder.add(rightBuffer, 0, ProcessingPlan::IO_BUFFER, 0, ProcessingPlanBuilder::ALL_CHANNELS);
     }
 }
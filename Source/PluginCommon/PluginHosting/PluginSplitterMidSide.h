@@ -15,13 +15,13 @@ public:
 
     SPLIT_TYPE getSplitType() override { return SPLIT_TYPE::MIDSIDE; }
 
-    // AudioProcessor methods
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    bool canUseMonoChains() const override { return true; }
+
+    size_t getNumActiveChains() const override { return DEFAULT_NUM_CHAINS; }
+
+protected:
+    void _buildPlan(ProcessingPlanBuilder& builder) override;
 
 private:
     static constexpr int DEFAULT_NUM_CHAINS {2};
-
-    std::unique_ptr<juce::AudioBuffer<float>> _midBuffer;
-    std::unique_ptr<juce::AudioBuffer<float>> _sideBuffer;
 };
@@ -72,14 +72,14 @@ void FFTProvider::processBlock(juce::AudioBuffer<float>& buffer) {
 }
 
 PluginSplitterMultiband::PluginSplitterMultiband(std::function<float(int, MODULATION_TYPE)> getModulationValueCallback, bool isStereo)
-        : PluginSplitter(DEFAULT_NUM_CHAINS, getModulationValueCallback) {
+        : PluginSplitter(DEFAULT_NUM_CHAINS, getModulationValueCallback), _isVisualiserEnabled(true) {
     juce::Logger::writeToLog("Constructed PluginSplitterMultiband");
 
     _crossover.setIsStereo(isStereo);
 }
 
 PluginSplitterMultiband::PluginSplitterMultiband(std::vector<PluginChainWrapper>& chains, std::function<float(int, MODULATION_TYPE)> getModulationValueCallback, bool isStereo)
-        : PluginSplitter(chains, DEFAULT_NUM_CHAINS, getModulationValueCallback) {
+        : PluginSplitter(chains, DEFAULT_NUM_CHAINS, getModulationValueCallback), _isVisualiserEnabled(true) {
 
     // Set the crossover to have the correct number of bands and the correct frequencies (TODO)
     // Use _chains rather that chains, as they may be different if chains doesn't meet DEFAULT_NUM_CHAINS
@@ -152,16 +152,18 @@ bool PluginSplitterMultiband::getChainSolo(int chainNumber) {
     return _crossover.getIsSoloed(chainNumber);
 }
 
-void PluginSplitterMultiband::prepareToPlay(double sampleRate, int samplesPerBlock) {
+void PluginSplitterMultiband::_prepareSplitter(double sampleRate, int samplesPerBlock) {
     _crossover.reset();
     _crossover.setSampleRate(sampleRate);
     _fftProvider.reset();
     _fftProvider.setSampleRate(sampleRate);
-    PluginSplitter::prepareToPlay(sampleRate, samplesPerBlock);
 }
 
 void PluginSplitterMultiband::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
-    _fftProvider.processBlock(buffer);
+    if (_isVisualiserEnabled) {
+        _fftProvider.processBlock(buffer);
+    }
+
     _crossover.processBlock(buffer);
 }
 
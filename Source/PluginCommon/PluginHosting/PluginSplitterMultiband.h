@@ -49,6 +49,11 @@ public:
     bool addBand();
     bool removeBand();
     size_t getNumBands();
+
+    /**
+     * The crossover moves to the new frequency gradually while processing, see
+     * SplitterCrossover::setCrossoverFrequency(). Can be called while processing.
+     */
     void setCrossoverFrequency(size_t index, double val);
     double getCrossoverFrequency(size_t index);
 
@@ -58,15 +63,22 @@ public:
     int getFFTOutputsSize() { return FFTProvider::NUM_OUTPUTS; }
     const float* getFFTOutputs() { return _fftProvider.getOutputs(); }
 
+    /**
+     * Used to save CPU when overloaded, see CpuGovernor. Both can be called while processing.
+     */
+    void setIsEconomyCrossover(bool val) { _crossover.setIsEconomyMode(val); }
+    void setIsVisualiserEnabled(bool val) { _isVisualiserEnabled = val; }
+
     // AudioProcessor methods
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
 
 protected:
     virtual void _onChainRestored() override;
+    void _prepareSplitter(double sampleRate, int samplesPerBlock) override;
 
 private:
     static constexpr int DEFAULT_NUM_CHAINS {2};
     SplitterCrossover _crossover;
     FFTProvider _fftProvider;
+    std::atomic<bool> _isVisualiserEnabled;
 };
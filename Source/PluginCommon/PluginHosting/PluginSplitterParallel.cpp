@@ -21,6 +21,7 @@ bool PluginSplitterParallel::addChain() {
         _chains[_chains.size() - 1].chain->addListener(this);
 
         _onLatencyChange();
+        _rebuildPlan();
         success = true;
     }
 
@@ -35,39 +36,39 @@ bool PluginSplitterParallel::removeChain(int chainNumber) {
         _chains.erase(_chains.begin() + chainNumber);
 
         _onLatencyChange();
+        _rebuildPlan();
         success = true;
     }
 
     return success;
 }
 
-void PluginSplitterParallel::prepareToPlay(double sampleRate, int samplesPerBlock) {
-    _inputBuffer.reset(new juce::AudioBuffer<float>(4, samplesPerBlock)); // stereo main + stereo sidechain
-    _outputBuffer.reset(new juce::AudioBuffer<float>(2, samplesPerBlock)); // stereo main
-
-    PluginSplitter::prepareToPlay(sampleRate, samplesPerBlock);
-}
-
-void PluginSplitterParallel::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
-    _outputBuffer->clear();
+void PluginSplitterParallel::_buildPlan(ProcessingPlanBuilder& builder) {
+    if (_chains.empty()) {
+        builder.clear(ProcessingPlan::IO_BUFFER, 0, 2);
+        return;
+    }
 
-    for (PluginChainWrapper& chain : _chains) {
+    // Each chain except the last processes its own copy of the input and is summed into the output
+    // buffer, the last chain doesn't need to preserve the input so it processes it in place
+    // Chains that are soloed out are silent so add nothing to the output
+    // TODO: do the same for midi
+    const int numChains {static_cast<int>(_chains.size())};
+    const int outputBuffer {numChains > 1 ? builder.createBuffer() : ProcessingPlan::IO_BUFFER};
+    if (numChains > 1) {
+        builder.clear(outputBuffer, 0, 2);
+    }
 
-        // Only process if no bands are soloed or this one is soloed
-        if (_numChainsSoloed == 0 || chain.isSoloed) {
-            // Make a copy of the input buffer for us to process, preserving the original for the other
-            // chains
-            // TODO: do the same for midi
-            _copyBuffer(buffer, *(_inputBuffer.get()));
+    for (int chainNumber {0}; chainNumber + 1 < numChains; chainNumber++) {
+        const int chainBuffer {builder.createBuffer()};
+        builder.copy(ProcessingPlan::IO_BUFFER, 0, chainBuffer, 0, ProcessingPlanBuilder::ALL_CHANNELS);
+        builder.processChain(chainNumber, chainBuffer, ProcessingPlanBuilder::IO_CHANNELS, true);
+        builder.add(chainBuffer, 0, outputBuffer, 0, 2);
+    }
 
-            // Process the newly copied buffer
-            chain.chain->processBlock(*(_inputBuffer.get()), midiMessages);
+    builder.processChain(numChains - 1, ProcessingPlan::IO_BUFFER, ProcessingPlanBuilder::ALL_CHANNELS, true);
 
-            // Add the output of this chain to the output buffer
-            _addBuffers(*(_inputBuffer.get()), *(_outputBuffer.get()));
-        }
+    if (outputBuffer != ProcessingPlan::IO_BUFFER) {
+        builder.add(outputBuffer, 0, ProcessingPlan::IO_BUFFER, 0, 2);
     }
-
-    // Overwrite the original buffer with our own output
-    _copyBuffer(*(_outputBuffer.get()), buffer);
 }
@@ -18,16 +18,10 @@ public:
     bool addChain();
     bool removeChain(int chainNumber);
 
-    // AudioProcessor methods
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
-
 protected:
     virtual void _onChainRestored() override { addChain(); }
+    void _buildPlan(ProcessingPlanBuilder& builder) override;
 
 private:
     static constexpr int DEFAULT_NUM_CHAINS {1};
-
-    std::unique_ptr<juce::AudioBuffer<float>> _inputBuffer;
-    std::unique_ptr<juce::AudioBuffer<float>> _outputBuffer;
 };
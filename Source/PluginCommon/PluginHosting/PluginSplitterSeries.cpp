@@ -22,6 +22,7 @@ PluginSplitterSeries::PluginSplitterSeries(std::vector<PluginChainWrapper>& chai
     _chains[0].chain->setChainMute(false);
 }
 
-void PluginSplitterSeries::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
-    _chains[0].chain->processBlock(buffer, midiMessages);
+void PluginSplitterSeries::_buildPlan(ProcessingPlanBuilder& builder) {
+    // The only chain can't be soloed
+    builder.processChain(0, ProcessingPlan::IO_BUFFER);
 }
@@ -25,8 +25,10 @@ public:
 
     SPLIT_TYPE getSplitType() override { return SPLIT_TYPE::SERIES; }
 
-    // AudioProcessor methods
-    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    size_t getNumActiveChains() const override { return DEFAULT_NUM_CHAINS; }
+
+protected:
+    void _buildPlan(ProcessingPlanBuilder& builder) override;
 
 private:
     static constexpr int DEFAULT_NUM_CHAINS {1};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * A playhead which reports a stored position.
+ *
+ * The host's playhead can only be used during its audio callback and only describes the start of
+ * the host's buffer, so this is given to the splitter when it processes blocks which don't line up
+ * with the host's buffers.
+ */
+class PositionPlayHead : public juce::AudioPlayHead {
+public:
+    juce::AudioPlayHead::CurrentPositionInfo position;
+
+    PositionPlayHead() { position.resetToDefault(); }
+
+    bool getCurrentPosition(juce::AudioPlayHead::CurrentPositionInfo& result) override {
+        result = position;
+        return true;
+    }
+
+    /**
+     * Sets the position to the current position of the given playhead.
+     */
+    void setFrom(juce::AudioPlayHead* playHead) {
+        if (playHead == nullptr || !playHead->getCurrentPosition(position)) {
+            position.resetToDefault();
+        }
+    }
+
+    /**
+     * Moves the position by the given number of samples, which may be negative.
+     */
+    void advance(int numSamples, double sampleRate) {
+        position.timeInSamples += numSamples;
+        position.timeInSeconds = position.timeInSamples / sampleRate;
+        position.ppqPosition += (numSamples / sampleRate) * (position.bpm / 60);
+    }
+};
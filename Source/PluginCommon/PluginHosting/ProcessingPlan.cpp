@@ -0,0 +1,435 @@
+#include <numeric>
+
+#include "ProcessingPlan.h"
+#include "PluginSplitter.h"
+#include "DspKernels.h"
+#include "FlightRecorder.h"
+#include "Tracer.h"
+
+namespace {
+    juce::String opToString(PLAN_OP op) {
+        switch (op) {
+            case PLAN_OP::CLEAR:
+                return "clear";
+            case PLAN_OP::COPY:
+                return "copy";
+            case PLAN_OP::ADD:
+                return "add";
+            case PLAN_OP::ENCODE_MID_SIDE:
+                return "encodeMidSide";
+            case PLAN_OP::DECODE_MID_SIDE:
+                return "decodeMidSide";
+            case PLAN_OP::PROCESS_CHAIN:
+                return "processChain";
+        }
+
+        return "unknown";
+    }
+
+    // Returns the number of channels an op can use, given the channel offset it starts at in each
+    // buffer
+    int getNumUsableChannels(int requestedChannels,
+                             const juce::AudioBuffer<float>& source,
+                             int sourceChannel,
+                             const juce::AudioBuffer<float>& destination,
+                             int destinationChannel) {
+        const int available {std::min(source.getNumChannels() - sourceChannel, destination.getNumChannels() - destinationChannel)};
+
+        if (requestedChannels == ProcessingPlanBuilder::ALL_CHANNELS) {
+            return std::max(available, 0);
+        }
+
+        return std::max(std::min(requestedChannels, available), 0);
+    }
+}
+
+ProcessingPlan::ProcessingPlan(std::vector<PlanStep> steps, std::vector<size_t> stageStarts, int numScratchBuffers, int maxBlockSize) :
+        _steps(steps),
+        _stageStarts(stageStarts),
+        _maxBlockSize(maxBlockSize) {
+    for (int index {0}; index < numScratchBuffers; index++) {
+        _scratchBuffers.emplace_back(NUM_BUFFER_CHANNELS, maxBlockSize);
+        _scratchBuffers.back().clear();
+    }
+
+    // Only stages with more than one chain are worth running concurrently, the other steps are
+    // too cheap to be worth handing over to the workers
+    size_t maxStageSize {0};
+    for (size_t stageIndex {0}; stageIndex < _stageStarts.size(); stageIndex++) {
+        int numChains {0};
+        for (size_t stepIndex {_stageStarts[stageIndex]}; stepIndex < _getStageEnd(stageIndex); stepIndex++) {
+            if (_steps[stepIndex].op == PLAN_OP::PROCESS_CHAIN) {
+                numChains++;
+            }
+        }
+
+        _isStageConcurrent.push_back(numChains > 1);
+
+        if (numChains > 1) {
+            maxStageSize = std::max(maxStageSize, _getStageEnd(stageIndex) - _stageStarts[stageIndex]);
+        }
+    }
+
+    _taskMidiBuffers.resize(maxStageSize);
+    for (juce::MidiBuffer& midiBuffer : _taskMidiBuffers) {
+        midiBuffer.ensureSize(MIDI_BUFFER_SIZE);
+    }
+}
+
+void ProcessingPlan::process(juce::AudioBuffer<float>& buffer,
+                             juce::MidiBuffer& midiMessages,
+                             const std::vector<PluginChainWrapper>& chains,
+                             size_t numChainsSoloed,
+                             WorkerPool* workerPool,
+                             juce::int64 deadlineTicks) {
+    if (buffer.getNumSamples() > _maxBlockSize) {
+        // The scratch buffers aren't big enough, this shouldn't happen as long as the splitter was
+        // prepared with the right block size
+        return;
+    }
+
+    for (size_t stageIndex {0}; stageIndex < _stageStarts.size(); stageIndex++) {
+        Tracer::Scope traceScope("planStage", "engine", "stage", static_cast<int>(stageIndex));
+
+        const size_t stageStart {_stageStarts[stageIndex]};
+        const size_t stageEnd {_getStageEnd(stageIndex)};
+
+        if (workerPool != nullptr && _isStageConcurrent[stageIndex]) {
+            // Each task gets its own copy of the MIDI so chains don't modify each other's input
+            for (size_t taskIndex {0}; taskIndex < stageEnd - stageStart; taskIndex++) {
+                _taskMidiBuffers[taskIndex].clear();
+                _taskMidiBuffers[taskIndex].addEvents(midiMessages, 0, -1, 0);
+            }
+
+            // The workers record their stages to the same flight recorder as this thread
+            StageJob job(*this, buffer, chains, numChainsSoloed, stageStart, FlightRecorder::getCurrent());
+            workerPool->run(job, static_cast<int>(stageEnd - stageStart), deadlineTicks);
+        } else {
+            for (size_t stepIndex {stageStart}; stepIndex < stageEnd; stepIndex++) {
+                _runStep(_steps[stepIndex], buffer, midiMessages, chains, numChainsSoloed);
+            }
+        }
+    }
+}
+
+void ProcessingPlan::StageJob::runTask(int taskIndex) {
+    FlightRecorder::ThreadScope recorderScope(_recorder);
+    Tracer::Scope traceScope("planTask", "engine", "step", static_cast<int>(_firstStep) + taskIndex);
+    _plan._runStep(_plan._steps[_firstStep + taskIndex], _ioBuffer, _plan._taskMidiBuffers[taskIndex], _chains, _numChainsSoloed);
+}
+
+size_t ProcessingPlan::_getStageEnd(size_t stageIndex) const {
+    return stageIndex + 1 < _stageStarts.size() ? _stageStarts[stageIndex + 1] : _steps.size();
+}
+
+void ProcessingPlan::_runStep(const PlanStep& step,
+                              juce::AudioBuffer<float>& buffer,
+                              juce::MidiBuffer& midiMessages,
+                              const std::vector<PluginChainWrapper>& chains,
+                              size_t numChainsSoloed) {
+    const int numSamples {buffer.getNumSamples()};
+    juce::AudioBuffer<float>& destination = _getBuffer(step.buffer, buffer);
+
+    switch (step.op) {
+        case PLAN_OP::CLEAR: {
+            const int numChannels {getNumUsableChannels(step.numChannels, destination, step.channel, destination, step.channel)};
+            for (int channel {step.channel}; channel < step.channel + numChannels; channel++) {
+                juce::FloatVectorOperations::fill(destination.getWritePointer(channel), 0, numSamples);
+            }
+            break;
+        }
+        case PLAN_OP::COPY:
+        case PLAN_OP::ADD: {
+            const juce::AudioBuffer<float>& source = _getBuffer(step.sourceBuffer, buffer);
+            const int numChannels {getNumUsableChannels(step.numChannels, source, step.sourceChannel, destination, step.channel)};
+
+            for (int offset {0}; offset < numChannels; offset++) {
+                float* writePointer {destination.getWritePointer(step.channel + offset)};
+                const float* readPointer {source.getReadPointer(step.sourceChannel + offset)};
+
+                if (step.op == PLAN_OP::COPY) {
+                    juce::FloatVectorOperations::copy(writePointer, readPointer, numSamples);
+                } else {
+                    DspKernels::get().add(writePointer, readPointer, numSamples);
+                }
+            }
+            break;
+        }
+        case PLAN_OP::ENCODE_MID_SIDE: {
+            const juce::AudioBuffer<float>& source = _getBuffer(step.sourceBuffer, buffer);
+            juce::AudioBuffer<float>& side = _getBuffer(step.sideBuffer, buffer);
+
+            if (source.getNumChannels() > step.sourceChannel + 1 &&
+                destination.getNumChannels() > step.channel &&
+                side.getNumChannels() > step.channel) {
+
+                const float* leftRead {source.getReadPointer(step.sourceChannel)};
+                const float* rightRead {source.getReadPointer(step.sourceChannel + 1)};
+                float* midWrite {destination.getWritePointer(step.channel)};
+                float* sideWrite {side.getWritePointer(step.channel)};
+
+                // Add the right channel to get the mid, subtract it to get the side, both halved in
+                // the same pass
+                DspKernels::get().encodeMidSide(midWrite, sideWrite, leftRead, rightRead, numSamples);
+            }
+            break;
+        }
+        case PLAN_OP::DECODE_MID_SIDE: {
+            const juce::AudioBuffer<float>& mid = _getBuffer(step.sourceBuffer, buffer);
+            const juce::AudioBuffer<float>& side = _getBuffer(step.sideBuffer, buffer);
+
+            if (mid.getNumChannels() > step.sourceChannel &&
+                side.getNumChannels() > step.sourceChannel &&
+                destination.getNumChannels() > step.channel + 1) {
+
+                const float* midRead {mid.getReadPointer(step.sourceChannel)};
+                const float* sideRead {side.getReadPointer(step.sourceChannel)};
+
+                // Subtract side from mid to get the left buffer, add them to get the right buffer
+                DspKernels::get().decodeMidSide(destination.getWritePointer(step.channel),
+                                                destination.getWritePointer(step.channel + 1),
+                                                midRead,
+                                                sideRead,
+                                                numSamples);
+            }
+            break;
+        }
+        case PLAN_OP::PROCESS_CHAIN: {
+            const int requestedChannels {
+                step.numChannels == ProcessingPlanBuilder::IO_CHANNELS ? buffer.getNumChannels() : step.numChannels
+            };
+            const int numChannels {getNumUsableChannels(requestedChannels, destination, 0, destination, 0)};
+
+            if (step.chainNumber >= chains.size()) {
+                // The chains have changed and the new plan hasn't been swapped in yet
+                break;
+            }
+
+            PluginChain& chain = *chains[step.chainNumber].chain;
+
+            if (step.isSoloable && numChainsSoloed > 0 && !chains[step.chainNumber].isSoloed) {
+                // Another chain is soloed, so this one is silent
+                for (int channel {0}; channel < numChannels; channel++) {
+                    juce::FloatVectorOperations::fill(destination.getWritePointer(channel), 0, numSamples);
+                }
+            } else if (&destination == &buffer && numChannels == buffer.getNumChannels()) {
+                chain.processBlock(buffer, midiMessages);
+            } else {
+                // Refer to the part of the buffer the chain needs - this doesn't allocate
+                juce::AudioBuffer<float> chainBuffer(destination.getArrayOfWritePointers(), numChannels, numSamples);
+                chain.processBlock(chainBuffer, midiMessages);
+            }
+            break;
+        }
+    }
+}
+
+juce::String ProcessingPlan::toString() const {
+    juce::String retVal;
+
+    for (size_t stageIndex {0}; stageIndex < _stageStarts.size(); stageIndex++) {
+        retVal += "stage " + juce::String(stageIndex) + (_isStageConcurrent[stageIndex] ? " (concurrent)" : "") + "\n";
+
+        for (size_t stepIndex {_stageStarts[stageIndex]}; stepIndex < _getStageEnd(stageIndex); stepIndex++) {
+            const PlanStep& step = _steps[stepIndex];
+            retVal += "    " + opToString(step.op)
+                + " buffer " + juce::String(step.buffer) + ":" + juce::String(step.channel)
+                + " (" + juce::String(step.numChannels) + ")"
+                + " source " + juce::String(step.sourceBuffer) + ":" + juce::String(step.sourceChannel)
+                + " side " + juce::String(step.sideBuffer)
+                + (step.op == PLAN_OP::PROCESS_CHAIN ? " chain " + juce::String(step.chainNumber) : juce::String())
+                + "\n";
+        }
+    }
+
+    return retVal;
+}
+
+juce::AudioBuffer<float>& ProcessingPlan::_getBuffer(int index, juce::AudioBuffer<float>& ioBuffer) {
+    if (index == IO_BUFFER) {
+        return ioBuffer;
+    }
+
+    return _scratchBuffers[index - 1];
+}
+
+void ProcessingPlanBuilder::clear(int buffer, int channel, int numChannels) {
+    _addStep(PLAN_OP::CLEAR, buffer, channel, numChannels, -1, 0, -1);
+}
+
+void ProcessingPlanBuilder::copy(int sourceBuffer, int sourceChannel, int buffer, int channel, int numChannels) {
+    _addStep(PLAN_OP::COPY, buffer, channel, numChannels, sourceBuffer, sourceChannel, -1);
+}
+
+void ProcessingPlanBuilder::add(int sourceBuffer, int sourceChannel, int buffer, int channel, int numChannels) {
+    _addStep(PLAN_OP::ADD, buffer, channel, numChannels, sourceBuffer, sourceChannel, -1);
+}
+
+void ProcessingPlanBuilder::encodeMidSide(int sourceBuffer, int sourceChannel, int midBuffer, int sideBuffer, int channel) {
+    _addStep(PLAN_OP::ENCODE_MID_SIDE, midBuffer, channel, 1, sourceBuffer, sourceChannel, sideBuffer);
+}
+
+void ProcessingPlanBuilder::decodeMidSide(int midBuffer, int sideBuffer, int sourceChannel, int buffer, int channel) {
+    _addStep(PLAN_OP::DECODE_MID_SIDE, buffer, channel, 2, midBuffer, sourceChannel, sideBuffer);
+}
+
+void ProcessingPlanBuilder::processChain(int chainNumber, int buffer, int numChannels, bool isSoloable) {
+    _addStep(PLAN_OP::PROCESS_CHAIN, buffer, 0, numChannels, -1, 0, -1, chainNumber, isSoloable);
+}
+
+std::unique_ptr<ProcessingPlan> ProcessingPlanBuilder::compile(int maxBlockSize) const {
+    // Order the steps by stage, keeping the order they were added in within each stage
+    const std::vector<int> stepStages {_getStepStages()};
+
+    std::vector<size_t> order(_steps.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&stepStages](size_t a, size_t b) {
+        return stepStages[a] < stepStages[b];
+    });
+
+    // Find the last step each virtual buffer is used in
+    std::vector<int> lastUse(_numVirtualBuffers, -1);
+    for (int orderIndex {0}; orderIndex < order.size(); orderIndex++) {
+        const PlanStep& step = _steps[order[orderIndex]];
+        for (int virtualBuffer : {step.buffer, step.sourceBuffer, step.sideBuffer}) {
+            if (virtualBuffer >= 0) {
+                lastUse[virtualBuffer] = orderIndex;
+            }
+        }
+    }
+
+    // Assign each virtual buffer to a scratch buffer when it's first used, and make the scratch
+    // buffer available again after its last use
+    // Steps in the same stage may run at the same time, so a released buffer can only be reused
+    // from the next stage onwards
+    struct FreeBuffer {
+        int scratchBuffer;
+        int releasedInStage;
+    };
+
+    std::vector<int> assigned(_numVirtualBuffers, -1);
+    assigned[ProcessingPlan::IO_BUFFER] = ProcessingPlan::IO_BUFFER;
+
+    std::vector<FreeBuffer> freeBuffers;
+    int numScratchBuffers {0};
+
+    auto assign = [&](int virtualBuffer, int stage) {
+        if (virtualBuffer < 0) {
+            return -1;
+        }
+
+        if (assigned[virtualBuffer] == -1) {
+            auto freeBuffer = std::find_if(freeBuffers.begin(), freeBuffers.end(), [stage](const FreeBuffer& buffer) {
+                return buffer.releasedInStage < stage;
+            });
+
+            if (freeBuffer == freeBuffers.end()) {
+                numScratchBuffers++;
+                assigned[virtualBuffer] = numScratchBuffers;
+            } else {
+                assigned[virtualBuffer] = freeBuffer->scratchBuffer;
+                freeBuffers.erase(freeBuffer);
+            }
+        }
+
+        return assigned[virtualBuffer];
+    };
+
+    std::vector<PlanStep> steps;
+    std::vector<size_t> stageStarts;
+    for (int orderIndex {0}; orderIndex < order.size(); orderIndex++) {
+        const PlanStep& virtualStep = _steps[order[orderIndex]];
+        const int stage {stepStages[order[orderIndex]]};
+
+        if (stageStarts.size() <= stage) {
+            stageStarts.push_back(steps.size());
+        }
+
+        PlanStep step = virtualStep;
+        step.buffer = assign(virtualStep.buffer, stage);
+        step.sourceBuffer = assign(virtualStep.sourceBuffer, stage);
+        step.sideBuffer = assign(virtualStep.sideBuffer, stage);
+        steps.push_back(step);
+
+        // Release any buffers that aren't needed after this step
+        for (int virtualBuffer : {virtualStep.buffer, virtualStep.sourceBuffer, virtualStep.sideBuffer}) {
+            if (virtualBuffer > ProcessingPlan::IO_BUFFER && lastUse[virtualBuffer] == orderIndex) {
+                const bool isAlreadyFree {
+                    std::any_of(freeBuffers.begin(), freeBuffers.end(), [&](const FreeBuffer& buffer) {
+                        return buffer.scratchBuffer == assigned[virtualBuffer];
+                    })
+                };
+
+                if (!isAlreadyFree) {
+                    freeBuffers.push_back({assigned[virtualBuffer], stage});
+                }
+            }
+        }
+    }
+
+    return std::make_unique<ProcessingPlan>(steps, stageStarts, numScratchBuffers, maxBlockSize);
+}
+
+std::vector<int> ProcessingPlanBuilder::_getStepStages() const {
+    // A step has to run after any earlier steps that write to the buffers it uses, and after any
+    // earlier steps that read from the buffers it writes to
+    std::vector<int> lastWriteStage(_numVirtualBuffers, -1);
+    std::vector<int> lastReadStage(_numVirtualBuffers, -1);
+    std::vector<int> stepStages;
+
+    for (const PlanStep& step : _steps) {
+        std::vector<int> reads;
+        std::vector<int> writes;
+
+        switch (step.op) {
+            case PLAN_OP::CLEAR:
+                writes = {step.buffer};
+                break;
+            case PLAN_OP::COPY:
+                reads = {step.sourceBuffer};
+                writes = {step.buffer};
+                break;
+            case PLAN_OP::ADD:
+                reads = {step.sourceBuffer, step.buffer};
+                writes = {step.buffer};
+                break;
+            case PLAN_OP::ENCODE_MID_SIDE:
+                reads = {step.sourceBuffer};
+                writes = {step.buffer, step.sideBuffer};
+                break;
+            case PLAN_OP::DECODE_MID_SIDE:
+                reads = {step.sourceBuffer, step.sideBuffer};
+                writes = {step.buffer};
+                break;
+            case PLAN_OP::PROCESS_CHAIN:
+                reads = {step.buffer};
+                writes = {step.buffer};
+                break;
+        }
+
+        int stage {0};
+        for (int buffer : reads) {
+            stage = std::max(stage, lastWriteStage[buffer] + 1);
+        }
+
+        for (int buffer : writes) {
+            stage = std::max({stage, lastWriteStage[buffer] + 1, lastReadStage[buffer] + 1});
+        }
+
+        for (int buffer : reads) {
+            lastReadStage[buffer] = std::max(lastReadStage[buffer], stage);
+        }
+
+        for (int buffer : writes) {
+            lastWriteStage[buffer] = stage;
+        }
+
+        stepStages.push_back(stage);
+    }
+
+    return stepStages;
+}
+
+void ProcessingPlanBuilder::_addStep(PLAN_OP op, int buffer, int channel, int numChannels, int sourceBuffer, int sourceChannel, int sideBuffer, int chainNumber, bool isSoloable) {
+    _steps.push_back({op, buffer, channel, numChannels, sourceBuffer, sourceChannel, sideBuffer, chainNumber, isSoloable});
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "WorkerPool.h"
+
+struct PluginChainWrapper;
+class FlightRecorder;
+
+enum class PLAN_OP {
+    CLEAR,
+    COPY,
+    ADD,
+    ENCODE_MID_SIDE,
+    DECODE_MID_SIDE,
+    PROCESS_CHAIN
+};
+
+/**
+ * A single operation in a processing plan.
+ *
+ * Buffers are referred to by index, buffer 0 is always the buffer passed to the plan by the host.
+ */
+struct PlanStep {
+    PLAN_OP op;
+
+    // The buffer and channels written to (or processed in place)
+    int buffer;
+    int channel;
+    int numChannels;
+
+    // The buffer and channel read from
+    int sourceBuffer;
+    int sourceChannel;
+
+    // The second buffer for mid/side ops - the side destination when encoding, the side source
+    // when decoding
+    int sideBuffer;
+
+    // The chain is looked up when the plan runs, so a plan that's about to be replaced never
+    // refers to a chain that's been deleted
+    int chainNumber;
+
+    // If set the chain's channels are cleared instead of processed while another chain is soloed
+    bool isSoloable;
+};
+
+/**
+ * A splitter's routing compiled into a flat list of operations on a set of scratch buffers, which
+ * is run by a single interpreter on the audio thread.
+ *
+ * Soloing is applied as the plan runs rather than being compiled in, so it can change without the
+ * plan being rebuilt.
+ *
+ * The steps are grouped into stages, where each step only depends on steps in earlier stages. If a
+ * worker pool is provided, stages containing more than one chain have their steps run
+ * concurrently.
+ *
+ * Plans are created by ProcessingPlanBuilder and are immutable once compiled, a splitter replaces
+ * its plan whenever its routing changes.
+ */
+class ProcessingPlan {
+public:
+    static constexpr int IO_BUFFER {0};
+    static constexpr int NUM_BUFFER_CHANNELS {4}; // stereo main + stereo sidechain
+
+    /**
+     * The steps must be ordered by stage, stageStarts contains the index of the first step in each
+     * stage.
+     */
+    ProcessingPlan(std::vector<PlanStep> steps, std::vector<size_t> stageStarts, int numScratchBuffers, int maxBlockSize);
+    ~ProcessingPlan() = default;
+
+    /**
+     * Runs each step of the plan on the given buffer with the splitter's chains, using the worker
+     * pool for stages that can run chains concurrently if one is provided. The deadline (in high
+     * resolution ticks) is used by the pool to prioritise between instances.
+     *
+     * Chains which run concurrently are each given their own copy of the MIDI.
+     */
+    void process(juce::AudioBuffer<float>& buffer,
+                 juce::MidiBuffer& midiMessages,
+                 const std::vector<PluginChainWrapper>& chains,
+                 size_t numChainsSoloed,
+                 WorkerPool* workerPool = nullptr,
+                 juce::int64 deadlineTicks = 0);
+
+    size_t getNumSteps() const { return _steps.size(); }
+    size_t getNumStages() const { return _stageStarts.size(); }
+    size_t getNumScratchBuffers() const { return _scratchBuffers.size(); }
+    int getMaxBlockSize() const { return _maxBlockSize; }
+
+    /**
+     * Returns a description of each step for logging.
+     */
+    juce::String toString() const;
+
+private:
+    /**
+     * Runs the steps of a stage as tasks on a worker pool.
+     */
+    class StageJob : public WorkerPool::Job {
+    public:
+        StageJob(ProcessingPlan& plan,
+                 juce::AudioBuffer<float>& ioBuffer,
+                 const std::vector<PluginChainWrapper>& chains,
+                 size_t numChainsSoloed,
+                 size_t firstStep,
+                 FlightRecorder* recorder) :
+                _plan(plan),
+                _ioBuffer(ioBuffer),
+                _chains(chains),
+                _numChainsSoloed(numChainsSoloed),
+                _firstStep(firstStep),
+                _recorder(recorder) {}
+
+        void runTask(int taskIndex) override;
+
+    private:
+        ProcessingPlan& _plan;
+        juce::AudioBuffer<float>& _ioBuffer;
+        const std::vector<PluginChainWrapper>& _chains;
+        const size_t _numChainsSoloed;
+        const size_t _firstStep;
+        FlightRecorder* const _recorder;
+    };
+
+    static constexpr int MIDI_BUFFER_SIZE {2048};
+
+    const std::vector<PlanStep> _steps;
+    const std::vector<size_t> _stageStarts;
+    std::vector<bool> _isStageConcurrent;
+    std::vector<juce::AudioBuffer<float>> _scratchBuffers;
+    std::vector<juce::MidiBuffer> _taskMidiBuffers;
+    const int _maxBlockSize;
+
+    size_t _getStageEnd(size_t stageIndex) const;
+    void _runStep(const PlanStep& step,
+                  juce::AudioBuffer<float>& ioBuffer,
+                  juce::MidiBuffer& midiMessages,
+                  const std::vector<PluginChainWrapper>& chains,
+                  size_t numChainsSoloed);
+    juce::AudioBuffer<float>& _getBuffer(int index, juce::AudioBuffer<float>& ioBuffer);
+};
+
+/**
+ * Used by the splitters to describe their routing, then compiles it into a ProcessingPlan.
+ *
+ * Steps are added in the order they'd run sequentially. When the plan is compiled each step is
+ * placed in the earliest stage in which everything it depends on has already run, so independent
+ * branches of the routing end up in the same stages.
+ *
+ * Buffers created here are virtual, when the plan is compiled they're assigned to scratch buffers
+ * so that buffers which are no longer needed can be reused by steps in later stages.
+ */
+class ProcessingPlanBuilder {
+public:
+    static constexpr int ALL_CHANNELS {-1};
+    static constexpr int IO_CHANNELS {-2}; // the number of channels the host passes to the plan
+
+    ProcessingPlanBuilder() : _numVirtualBuffers(1) {}
+    ~ProcessingPlanBuilder() = default;
+
+    /**
+     * Returns a new buffer for the plan to use. Its contents are undefined until they're cleared
+     * or written to.
+     */
+    int createBuffer() { return _numVirtualBuffers++; }
+
+    void clear(int buffer, int channel = 0, int numChannels = ALL_CHANNELS);
+    void copy(int sourceBuffer, int sourceChannel, int buffer, int channel, int numChannels);
+    void add(int sourceBuffer, int sourceChannel, int buffer, int channel, int numChannels);
+
+    /**
+     * Encodes the pair of channels starting at sourceChannel into the given channel of the mid and
+     * side buffers.
+     */
+    void encodeMidSide(int sourceBuffer, int sourceChannel, int midBuffer, int sideBuffer, int channel);
+
+    /**
+     * Decodes the given channel of the mid and side buffers into the pair of channels starting at
+     * channel.
+     */
+    void decodeMidSide(int midBuffer, int sideBuffer, int sourceChannel, int buffer, int channel);
+
+    /**
+     * Processes the given chain of the splitter. If isSoloable is set and other chains are soloed
+     * the chain's channels are cleared instead.
+     */
+    void processChain(int chainNumber, int buffer, int numChannels = ALL_CHANNELS, bool isSoloable = false);
+
+    /**
+     * Orders the steps into stages, assigns the virtual buffers to scratch buffers and creates
+     * the plan.
+     */
+    std::unique_ptr<ProcessingPlan> compile(int maxBlockSize) const;
+
+private:
+    std::vector<PlanStep> _steps;
+    int _numVirtualBuffers;
+
+    std::vector<int> _getStepStages() const;
+
+    void _addStep(PLAN_OP op, int buffer, int channel, int numChannels, int sourceBuffer, int sourceChannel, int sideBuffer, int chainNumber = -1, bool isSoloable = false);
+};
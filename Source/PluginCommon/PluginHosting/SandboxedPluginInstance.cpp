@@ -0,0 +1,538 @@
+#include "SandboxedPluginInstance.h"
+
+#include "AllUtils.h"
+
+std::unique_ptr<SandboxedPluginInstance> SandboxedPluginInstance::create(const juce::PluginDescription& description,
+                                                                         double sampleRate,
+                                                                         int blockSize,
+                                                                         juce::String& errorMessage) {
+    std::unique_ptr<SandboxedPluginInstance> retVal;
+
+    std::unique_ptr<ServerConnection> connection = std::make_unique<ServerConnection>();
+
+    juce::Logger::writeToLog("SandboxedPluginInstance::create: Starting plugin host server from location: " + Utils::PluginHostServerBinary.getFullPathName());
+
+    if (connection->launchSlaveProcess(Utils::PluginHostServerBinary, Utils::PLUGIN_HOST_SERVER_UID, 8000)) {
+        juce::MemoryOutputStream request;
+        request.writeString(description.createXml()->toString());
+        request.writeDouble(sampleRate);
+        request.writeInt(blockSize);
+
+        const std::vector<BusesLayout> layoutsToCheck = _getLayoutsToCheck();
+        request.writeInt(static_cast<int>(layoutsToCheck.size()));
+        for (const BusesLayout& layout : layoutsToCheck) {
+            Sandbox::writeLayout(request, layout);
+        }
+
+        juce::MemoryBlock reply;
+        if (connection->sendRequest(Sandbox::MESSAGE_TYPE::LOAD_PLUGIN, request.getMemoryBlock(), reply, LOAD_TIMEOUT_MS)) {
+            juce::MemoryInputStream replyStream(reply, false);
+
+            if (replyStream.readBool()) {
+                // Mirror the guest's buses so layouts can be negotiated in the same way as an in
+                // process plugin
+                const BusesLayout defaultLayout = Sandbox::readLayout(replyStream);
+
+                BusesProperties buses;
+                for (int busIndex {0}; busIndex < defaultLayout.inputBuses.size(); busIndex++) {
+                    buses.addBus(true, "Input " + juce::String(busIndex), defaultLayout.inputBuses[busIndex]);
+                }
+
+                for (int busIndex {0}; busIndex < defaultLayout.outputBuses.size(); busIndex++) {
+                    buses.addBus(false, "Output " + juce::String(busIndex), defaultLayout.outputBuses[busIndex]);
+                }
+
+                retVal.reset(new SandboxedPluginInstance(description, std::move(connection), buses, blockSize, replyStream));
+                juce::Logger::writeToLog("SandboxedPluginInstance::create: Loaded " + description.name);
+            } else {
+                errorMessage = replyStream.readString();
+            }
+        } else {
+            errorMessage = "No response from the plugin host server";
+        }
+    } else {
+        errorMessage = "Failed to start the plugin host server";
+    }
+
+    if (retVal == nullptr) {
+        juce::Logger::writeToLog("SandboxedPluginInstance::create: " + errorMessage);
+    }
+
+    return retVal;
+}
+
+SandboxedPluginInstance::SandboxedPluginInstance(const juce::PluginDescription& description,
+                                                 std::unique_ptr<ServerConnection> connection,
+                                                 const BusesProperties& buses,
+                                                 int blockSize,
+                                                 juce::MemoryInputStream& loadReply) :
+        juce::AudioPluginInstance(buses),
+        _description(description),
+        _connection(std::move(connection)),
+        _fifoReadPosition(0),
+        _fifoWritePosition(0),
+        _sentSequence(0),
+        _pendingNumSamples(0),
+        _isPendingBlockSent(false),
+        _blockTimeoutMs(0),
+        _numDroppedBlocks(0),
+        _latencyUpdater(*this) {
+
+    _tailLengthSeconds = loadReply.readDouble();
+    _acceptsMidi = loadReply.readBool();
+    _producesMidi = loadReply.readBool();
+    _guestLatencySamples = loadReply.readInt();
+
+    const int numParameters {loadReply.readInt()};
+    for (int parameterIndex {0}; parameterIndex < numParameters; parameterIndex++) {
+        SandboxedParameter* parameter = new SandboxedParameter(loadReply);
+        _parameters.push_back(parameter);
+        addParameter(parameter);
+    }
+
+    for (const BusesLayout& layout : _getLayoutsToCheck()) {
+        _checkedLayouts.emplace_back(layout, loadReply.readBool());
+    }
+
+    _outputMidi.ensureSize(Sandbox::MAX_MIDI_BYTES);
+
+    // Report the latency from the start, so the chain doesn't need to change its compensation when
+    // the plugin is prepared
+    _latencyBlockSize = blockSize;
+    _updateLatency();
+}
+
+SandboxedPluginInstance::~SandboxedPluginInstance() {
+    // Stop the server before removing the file it has mapped
+    _connection.reset();
+    _sharedBlock.reset();
+    _removeSharedFile();
+}
+
+void SandboxedPluginInstance::prepareToPlay(double sampleRate, int samplesPerBlock) {
+    const int numChannels {std::max(getTotalNumInputChannels(), getTotalNumOutputChannels())};
+
+    // Each prepare gets a new file, so the server never sees one that's being resized
+    _sharedBlock.reset();
+    _removeSharedFile();
+
+    _sharedFile = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("SyndicateSandbox", ".shm");
+
+    if (Sandbox::SharedAudioBlock::createFile(_sharedFile, numChannels, samplesPerBlock, static_cast<int>(_parameters.size()))) {
+        _sharedBlock = std::make_unique<Sandbox::SharedAudioBlock>(_sharedFile, numChannels, samplesPerBlock, static_cast<int>(_parameters.size()));
+    }
+
+    if (_sharedBlock != nullptr && _sharedBlock->isValid()) {
+        juce::MemoryOutputStream request;
+        request.writeString(_sharedFile.getFullPathName());
+        request.writeDouble(sampleRate);
+        request.writeInt(samplesPerBlock);
+        request.writeInt(numChannels);
+
+        // Blocks sent before the server has mapped the file are output as silence, and the guest's
+        // new latency is picked up from the first block it processes
+        if (!_connection->postRequest(Sandbox::MESSAGE_TYPE::PREPARE, request.getMemoryBlock())) {
+            juce::Logger::writeToLog("SandboxedPluginInstance::prepareToPlay: Failed to send to server");
+        }
+    } else {
+        juce::Logger::writeToLog("SandboxedPluginInstance::prepareToPlay: Failed to create shared file");
+        _sharedBlock.reset();
+    }
+
+    // Start with a block of silence in the FIFO, this is the extra block of latency
+    _outputFifo.setSize(numChannels, 2 * samplesPerBlock);
+    _outputFifo.clear();
+    _fifoReadPosition = 0;
+    _fifoWritePosition = samplesPerBlock;
+
+    _pendingInput.setSize(numChannels, samplesPerBlock);
+    _pendingInput.clear();
+
+    _outputMidi.clear();
+    _sentSequence = 0;
+    _pendingNumSamples = 0;
+    _isPendingBlockSent = false;
+
+    // The server has had a whole block to process the previous one, so it should usually be ready
+    // already. Waiting any longer would eat into the time the rest of the chain has for this block.
+    _blockTimeoutMs = 1000 * BLOCK_TIMEOUT_PROPORTION * samplesPerBlock / sampleRate;
+
+    _latencyBlockSize = samplesPerBlock;
+    _latencyUpdater.cancelPendingUpdate();
+    _updateLatency();
+}
+
+void SandboxedPluginInstance::releaseResources() {
+    _connection->postRequest(Sandbox::MESSAGE_TYPE::RELEASE, {});
+}
+
+void SandboxedPluginInstance::reset() {
+    _connection->postRequest(Sandbox::MESSAGE_TYPE::RESET, {});
+}
+
+void SandboxedPluginInstance::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+    if (!_connection->isConnected() ||
+        _sharedBlock == nullptr ||
+        buffer.getNumSamples() > _sharedBlock->getMaxBlockSize()) {
+
+        buffer.clear();
+        midiMessages.clear();
+        return;
+    }
+
+    const int numChannels {std::min(buffer.getNumChannels(), _sharedBlock->getNumChannels())};
+
+    _collectPendingBlock(numChannels);
+    _sendBlock(buffer, midiMessages, numChannels);
+    _popFromFifo(buffer, numChannels);
+
+    // Output the MIDI from the previous block
+    midiMessages.clear();
+    for (const juce::MidiMessageMetadata metadata : _outputMidi) {
+        midiMessages.addEvent(metadata.data, metadata.numBytes, std::min(metadata.samplePosition, buffer.getNumSamples() - 1));
+    }
+}
+
+juce::AudioProcessorEditor* SandboxedPluginInstance::createEditor() {
+    return new juce::GenericAudioProcessorEditor(*this);
+}
+
+void SandboxedPluginInstance::getStateInformation(juce::MemoryBlock& destData) {
+    juce::MemoryBlock reply;
+    if (_connection->sendRequest(Sandbox::MESSAGE_TYPE::GET_STATE, {}, reply, REQUEST_TIMEOUT_MS)) {
+        juce::MemoryInputStream replyStream(reply, false);
+        destData = Sandbox::readMemoryBlock(replyStream);
+    } else {
+        juce::Logger::writeToLog("SandboxedPluginInstance::getStateInformation: No response from server");
+    }
+}
+
+void SandboxedPluginInstance::setStateInformation(const void* data, int sizeInBytes) {
+    juce::MemoryOutputStream request;
+    Sandbox::writeMemoryBlock(request, juce::MemoryBlock(data, sizeInBytes));
+
+    juce::MemoryBlock reply;
+    if (_connection->sendRequest(Sandbox::MESSAGE_TYPE::SET_STATE, request.getMemoryBlock(), reply, REQUEST_TIMEOUT_MS)) {
+        // The guest's parameters will probably have changed
+        juce::MemoryInputStream replyStream(reply, false);
+        _updateParameterValues(replyStream);
+    } else {
+        juce::Logger::writeToLog("SandboxedPluginInstance::setStateInformation: No response from server");
+    }
+}
+
+bool SandboxedPluginInstance::canApplyBusesLayout(const BusesLayout& layouts) const {
+    // Layouts that weren't checked when loading are refused rather than waiting for the server
+    for (const std::pair<BusesLayout, bool>& checkedLayout : _checkedLayouts) {
+        if (checkedLayout.first == layouts) {
+            return checkedLayout.second;
+        }
+    }
+
+    return false;
+}
+
+void SandboxedPluginInstance::processorLayoutsChanged() {
+    // The guest has already said it supports this layout, so it's safe to apply it there too
+    juce::MemoryOutputStream request;
+    Sandbox::writeLayout(request, getBusesLayout());
+    _connection->postRequest(Sandbox::MESSAGE_TYPE::SET_LAYOUT, request.getMemoryBlock());
+}
+
+std::vector<juce::AudioProcessor::BusesLayout> SandboxedPluginInstance::_getLayoutsToCheck() {
+    std::vector<BusesLayout> retVal;
+
+    for (const juce::AudioChannelSet& channelSet : {juce::AudioChannelSet::mono(), juce::AudioChannelSet::stereo()}) {
+        BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.outputBuses.add(channelSet);
+        retVal.push_back(layout);
+
+        // With a sidechain
+        layout.inputBuses.add(channelSet);
+        retVal.push_back(layout);
+    }
+
+    return retVal;
+}
+
+void SandboxedPluginInstance::_collectPendingBlock(int numChannels) {
+    if (_pendingNumSamples == 0) {
+        return;
+    }
+
+    Sandbox::SharedHeader* header {_sharedBlock->getHeader()};
+    bool isOutputReady {false};
+
+    if (_isPendingBlockSent) {
+        const double timeoutTime {juce::Time::getMillisecondCounterHiRes() + _blockTimeoutMs};
+
+        while (!isOutputReady && juce::Time::getMillisecondCounterHiRes() < timeoutTime) {
+            isOutputReady = header->outputSequence.load(std::memory_order_acquire) == _sentSequence;
+
+            if (!isOutputReady) {
+                juce::Thread::yield();
+            }
+        }
+    }
+
+    _outputMidi.clear();
+
+    if (isOutputReady) {
+        _pushToFifo(_sharedBlock.get(), _pendingNumSamples, numChannels);
+        Sandbox::SharedAudioBlock::readMidi(_sharedBlock->getOutputMidi(), header->numOutputMidiBytes, _outputMidi);
+
+        // Pick up any changes made by the guest itself
+        const float* outputParameters {_sharedBlock->getOutputParameters()};
+        const float* inputParameters {_sharedBlock->getInputParameters()};
+        for (size_t parameterIndex {0}; parameterIndex < _parameters.size(); parameterIndex++) {
+            if (outputParameters[parameterIndex] != inputParameters[parameterIndex]) {
+                _parameters[parameterIndex]->setValue(outputParameters[parameterIndex]);
+            }
+        }
+
+        if (header->latencySamples != _guestLatencySamples) {
+            _guestLatencySamples = header->latencySamples;
+            _latencyUpdater.triggerAsyncUpdate();
+        }
+    } else {
+        // Pass the input through rather than leaving a gap, it's delayed by the same block as the
+        // guest's output would have been
+        _pushInputToFifo(_pendingNumSamples, numChannels);
+        _numDroppedBlocks++;
+    }
+
+    _pendingNumSamples = 0;
+}
+
+void SandboxedPluginInstance::_sendBlock(const juce::AudioBuffer<float>& buffer,
+                                         const juce::MidiBuffer& midiMessages,
+                                         int numChannels) {
+    Sandbox::SharedHeader* header {_sharedBlock->getHeader()};
+    const int numSamples {buffer.getNumSamples()};
+
+    _pendingNumSamples = numSamples;
+
+    for (int channel {0}; channel < numChannels; channel++) {
+        _pendingInput.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+    }
+
+    // If the server is still working on an earlier block its input can't be overwritten, so this
+    // block's input will be passed through instead
+    _isPendingBlockSent = header->outputSequence.load(std::memory_order_acquire) == _sentSequence;
+
+    if (_isPendingBlockSent) {
+        for (int channel {0}; channel < numChannels; channel++) {
+            juce::FloatVectorOperations::copy(_sharedBlock->getInputChannel(channel), buffer.getReadPointer(channel), numSamples);
+        }
+
+        for (int channel {numChannels}; channel < _sharedBlock->getNumChannels(); channel++) {
+            juce::FloatVectorOperations::clear(_sharedBlock->getInputChannel(channel), numSamples);
+        }
+
+        float* inputParameters {_sharedBlock->getInputParameters()};
+        for (size_t parameterIndex {0}; parameterIndex < _parameters.size(); parameterIndex++) {
+            inputParameters[parameterIndex] = _parameters[parameterIndex]->getValue();
+        }
+
+        header->numSamples = numSamples;
+        header->numInputMidiBytes = Sandbox::SharedAudioBlock::writeMidi(midiMessages, _sharedBlock->getInputMidi());
+
+        _sentSequence++;
+        header->inputSequence.store(_sentSequence, std::memory_order_release);
+    }
+}
+
+void SandboxedPluginInstance::_pushToFifo(Sandbox::SharedAudioBlock* source, int numSamples, int numChannels) {
+    const int fifoSize {_outputFifo.getNumSamples()};
+    int numSamplesPushed {0};
+
+    while (numSamplesPushed < numSamples) {
+        const int numSamplesToPush {std::min(numSamples - numSamplesPushed, fifoSize - _fifoWritePosition)};
+
+        for (int channel {0}; channel < _outputFifo.getNumChannels(); channel++) {
+            if (channel < numChannels) {
+                _outputFifo.copyFrom(channel, _fifoWritePosition, source->getOutputChannel(channel) + numSamplesPushed, numSamplesToPush);
+            } else {
+                _outputFifo.clear(channel, _fifoWritePosition, numSamplesToPush);
+            }
+        }
+
+        numSamplesPushed += numSamplesToPush;
+        _fifoWritePosition = (_fifoWritePosition + numSamplesToPush) % fifoSize;
+    }
+}
+
+void SandboxedPluginInstance::_pushInputToFifo(int numSamples, int numChannels) {
+    const int fifoSize {_outputFifo.getNumSamples()};
+    int numSamplesPushed {0};
+
+    while (numSamplesPushed < numSamples) {
+        const int numSamplesToPush {std::min(numSamples - numSamplesPushed, fifoSize - _fifoWritePosition)};
+
+        for (int channel {0}; channel < _outputFifo.getNumChannels(); channel++) {
+            if (channel < numChannels) {
+                _outputFifo.copyFrom(channel, _fifoWritePosition, _pendingInput, channel, numSamplesPushed, numSamplesToPush);
+            } else {
+                _outputFifo.clear(channel, _fifoWritePosition, numSamplesToPush);
+            }
+        }
+
+        numSamplesPushed += numSamplesToPush;
+        _fifoWritePosition = (_fifoWritePosition + numSamplesToPush) % fifoSize;
+    }
+}
+
+void SandboxedPluginInstance::_popFromFifo(juce::AudioBuffer<float>& buffer, int numChannels) {
+    const int fifoSize {_outputFifo.getNumSamples()};
+    const int numSamples {buffer.getNumSamples()};
+    int numSamplesPopped {0};
+
+    while (numSamplesPopped < numSamples) {
+        const int numSamplesToPop {std::min(numSamples - numSamplesPopped, fifoSize - _fifoReadPosition)};
+
+        for (int channel {0}; channel < numChannels; channel++) {
+            buffer.copyFrom(channel, numSamplesPopped, _outputFifo, channel, _fifoReadPosition, numSamplesToPop);
+        }
+
+        numSamplesPopped += numSamplesToPop;
+        _fifoReadPosition = (_fifoReadPosition + numSamplesToPop) % fifoSize;
+    }
+
+    for (int channel {numChannels}; channel < buffer.getNumChannels(); channel++) {
+        buffer.clear(channel, 0, numSamples);
+    }
+}
+
+void SandboxedPluginInstance::_updateParameterValues(juce::MemoryInputStream& stream) {
+    const int numParameters {stream.readInt()};
+
+    for (int parameterIndex {0}; parameterIndex < numParameters; parameterIndex++) {
+        const float value {stream.readFloat()};
+
+        if (parameterIndex < static_cast<int>(_parameters.size())) {
+            _parameters[parameterIndex]->setValue(value);
+        }
+    }
+}
+
+void SandboxedPluginInstance::_updateLatency() {
+    setLatencySamples(_guestLatencySamples + _latencyBlockSize);
+}
+
+void SandboxedPluginInstance::_removeSharedFile() {
+    if (_sharedFile != juce::File()) {
+        _sharedFile.deleteFile();
+        _sharedFile = juce::File();
+    }
+}
+
+bool SandboxedPluginInstance::ServerConnection::sendRequest(Sandbox::MESSAGE_TYPE type,
+                                                            const juce::MemoryBlock& payload,
+                                                            juce::MemoryBlock& reply,
+                                                            int timeoutMs) {
+    // Only one request can be waiting for a reply at a time
+    const juce::ScopedLock requestLock(_requestMutex);
+
+    if (!_isConnected) {
+        return false;
+    }
+
+    juce::int32 requestId;
+    {
+        const juce::ScopedLock replyLock(_replyMutex);
+        requestId = _nextRequestId++;
+        _pendingRequestId = requestId;
+        _replyReceived.reset();
+    }
+
+    if (!sendMessageToSlave(Sandbox::createMessage(type, requestId, payload))) {
+        return false;
+    }
+
+    _replyReceived.wait(timeoutMs);
+
+    // The event is also signalled if the connection is lost, so check a reply actually arrived
+    const juce::ScopedLock replyLock(_replyMutex);
+    const bool retVal {_pendingRequestId != requestId};
+
+    if (retVal) {
+        reply = std::move(_reply);
+    } else {
+        _pendingRequestId = -1;
+    }
+
+    return retVal;
+}
+
+bool SandboxedPluginInstance::ServerConnection::postRequest(Sandbox::MESSAGE_TYPE type, const juce::MemoryBlock& payload) {
+    if (!_isConnected) {
+        return false;
+    }
+
+    // Doesn't take _requestMutex, so isn't held up by a request that's waiting for a reply
+    juce::int32 requestId;
+    {
+        const juce::ScopedLock replyLock(_replyMutex);
+        requestId = _nextRequestId++;
+    }
+
+    return sendMessageToSlave(Sandbox::createMessage(type, requestId, payload));
+}
+
+void SandboxedPluginInstance::ServerConnection::handleMessageFromSlave(const juce::MemoryBlock& message) {
+    Sandbox::MESSAGE_TYPE type;
+    juce::int32 requestId;
+    juce::MemoryBlock payload;
+    Sandbox::parseMessage(message, type, requestId, payload);
+
+    // Ignore replies to requests that have already timed out
+    const juce::ScopedLock replyLock(_replyMutex);
+    if (requestId == _pendingRequestId) {
+        _reply = std::move(payload);
+        _pendingRequestId = -1;
+        _replyReceived.signal();
+    }
+}
+
+void SandboxedPluginInstance::ServerConnection::handleConnectionLost() {
+    // The guest has probably crashed, from now on it just outputs silence
+    juce::Logger::writeToLog("SandboxedPluginInstance: Lost connection to plugin host server");
+    _isConnected = false;
+    _replyReceived.signal();
+}
+
+SandboxedPluginInstance::SandboxedParameter::SandboxedParameter(juce::MemoryInputStream& stream) {
+    _name = stream.readString();
+    _label = stream.readString();
+    _defaultValue = stream.readFloat();
+    _numSteps = stream.readInt();
+    _isDiscrete = stream.readBool();
+    _isBoolean = stream.readBool();
+    _value = stream.readFloat();
+
+    const int numTexts {stream.readInt()};
+    for (int textIndex {0}; textIndex < numTexts; textIndex++) {
+        _texts.add(stream.readString());
+    }
+}
+
+juce::String SandboxedPluginInstance::SandboxedParameter::getText(float value, int maximumStringLength) const {
+    if (_texts.isEmpty()) {
+        return juce::String(value, 2).substring(0, maximumStringLength);
+    }
+
+    // Use the nearest value the guest formatted
+    const int textIndex {juce::jlimit(0, _texts.size() - 1, juce::roundToInt(value * (_texts.size() - 1)))};
+    return _texts[textIndex].substring(0, maximumStringLength);
+}
+
+float SandboxedPluginInstance::SandboxedParameter::getValueForText(const juce::String& text) const {
+    const int textIndex {_texts.indexOf(text.trim())};
+
+    if (textIndex >= 0 && _texts.size() > 1) {
+        return static_cast<float>(textIndex) / (_texts.size() - 1);
+    }
+
+    return juce::jlimit(0.0f, 1.0f, text.getFloatValue());
+}
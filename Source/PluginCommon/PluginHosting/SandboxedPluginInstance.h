@@ -0,0 +1,218 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "SandboxTransport.h"
+
+/**
+ * Stands in for a guest plugin which is actually running in a plugin host server process, so a
+ * crashing guest can't take down the DAW and heavy guests can run on other cores.
+ *
+ * Each block's input is handed to the server and the output of the previous block is returned,
+ * so the guest's reported latency is increased by one block. If the server doesn't finish a block
+ * in time the block's input is output instead, delayed by the same block, and if the server has
+ * crashed silence is output.
+ *
+ * The guest's own editor isn't available, the generic parameter editor is shown instead.
+ *
+ * Preparing, resetting, releasing and changing the layout may happen while Syndicate's splitter is
+ * locked, so these are posted to the server without waiting for it. The layouts Syndicate might
+ * ask for are checked once when the guest is loaded, so checking a layout doesn't wait either.
+ */
+class SandboxedPluginInstance : public juce::AudioPluginInstance {
+public:
+    /**
+     * Starts a server process and loads the described plugin in it, returns nullptr and sets the
+     * error message on failure.
+     */
+    static std::unique_ptr<SandboxedPluginInstance> create(const juce::PluginDescription& description,
+                                                           double sampleRate,
+                                                           int blockSize,
+                                                           juce::String& errorMessage);
+
+    virtual ~SandboxedPluginInstance();
+
+    const juce::String getName() const override { return _description.name; }
+    void fillInPluginDescription(juce::PluginDescription& description) const override { description = _description; }
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+    void reset() override;
+    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+
+    double getTailLengthSeconds() const override { return _tailLengthSeconds; }
+    bool acceptsMidi() const override { return _acceptsMidi; }
+    bool producesMidi() const override { return _producesMidi; }
+
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int /*index*/) override {}
+    const juce::String getProgramName(int /*index*/) override { return {}; }
+    void changeProgramName(int /*index*/, const juce::String& /*newName*/) override {}
+
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    /**
+     * Returns the number of blocks the server didn't finish in time.
+     */
+    int getNumDroppedBlocks() const { return _numDroppedBlocks; }
+
+protected:
+    bool canApplyBusesLayout(const BusesLayout& layouts) const override;
+    void processorLayoutsChanged() override;
+
+private:
+    /**
+     * The connection to the server, requests are sent as messages and either block until the
+     * server replies or are posted without waiting for a reply.
+     */
+    class ServerConnection : public juce::ChildProcessMaster {
+    public:
+        ServerConnection() : _nextRequestId(0), _pendingRequestId(-1), _isConnected(true) {}
+
+        bool sendRequest(Sandbox::MESSAGE_TYPE type,
+                         const juce::MemoryBlock& payload,
+                         juce::MemoryBlock& reply,
+                         int timeoutMs);
+
+        /**
+         * Sends a request without waiting, the server's reply is ignored. Requests are handled
+         * by the server in the order they're sent.
+         */
+        bool postRequest(Sandbox::MESSAGE_TYPE type, const juce::MemoryBlock& payload);
+
+        void handleMessageFromSlave(const juce::MemoryBlock& message) override;
+        void handleConnectionLost() override;
+
+        bool isConnected() const { return _isConnected; }
+
+    private:
+        juce::CriticalSection _requestMutex;
+        juce::CriticalSection _replyMutex;
+        juce::WaitableEvent _replyReceived;
+        juce::int32 _nextRequestId;
+        juce::int32 _pendingRequestId;
+        juce::MemoryBlock _reply;
+        std::atomic<bool> _isConnected;
+    };
+
+    /**
+     * Mirrors one of the guest's parameters, the value is sent to the server with each block.
+     *
+     * The guest's text for the parameter is looked up from values it formatted when it was loaded.
+     */
+    class SandboxedParameter : public juce::AudioProcessorParameter {
+    public:
+        SandboxedParameter(juce::MemoryInputStream& stream);
+
+        float getValue() const override { return _value; }
+        void setValue(float newValue) override { _value = newValue; }
+        float getDefaultValue() const override { return _defaultValue; }
+        juce::String getName(int maximumStringLength) const override { return _name.substring(0, maximumStringLength); }
+        juce::String getLabel() const override { return _label; }
+        int getNumSteps() const override { return _numSteps; }
+        bool isDiscrete() const override { return _isDiscrete; }
+        bool isBoolean() const override { return _isBoolean; }
+        juce::String getText(float value, int maximumStringLength) const override;
+        float getValueForText(const juce::String& text) const override;
+
+    private:
+        std::atomic<float> _value;
+        juce::String _name;
+        juce::String _label;
+        float _defaultValue;
+        int _numSteps;
+        bool _isDiscrete;
+        bool _isBoolean;
+
+        // The guest's text for evenly spaced values from 0 to 1
+        juce::StringArray _texts;
+    };
+
+    /**
+     * Reports a change to the guest's latency on the message thread, as the audio thread notices
+     * it but can't call setLatencySamples().
+     */
+    class LatencyUpdater : public juce::AsyncUpdater {
+    public:
+        explicit LatencyUpdater(SandboxedPluginInstance& instance) : _instance(instance) { }
+
+        void handleAsyncUpdate() override { _instance._updateLatency(); }
+
+    private:
+        SandboxedPluginInstance& _instance;
+    };
+
+    static constexpr int LOAD_TIMEOUT_MS {20000};
+    static constexpr int REQUEST_TIMEOUT_MS {5000};
+
+    // How long the audio thread waits for the server to finish the previous block, as a
+    // proportion of the block's duration
+    static constexpr double BLOCK_TIMEOUT_PROPORTION {0.25};
+
+    juce::PluginDescription _description;
+    std::unique_ptr<ServerConnection> _connection;
+    std::unique_ptr<Sandbox::SharedAudioBlock> _sharedBlock;
+    juce::File _sharedFile;
+    std::vector<SandboxedParameter*> _parameters;
+    double _tailLengthSeconds;
+    bool _acceptsMidi;
+    bool _producesMidi;
+    std::atomic<int> _guestLatencySamples;
+
+    // The block size the latency was last reported with, message thread only
+    int _latencyBlockSize;
+
+    // Whether the guest supports each of the layouts from _getLayoutsToCheck()
+    std::vector<std::pair<BusesLayout, bool>> _checkedLayouts;
+
+    // Delays the server's output so it lines up with the reported latency
+    juce::AudioBuffer<float> _outputFifo;
+    int _fifoReadPosition;
+    int _fifoWritePosition;
+
+    // Output MIDI of the previous block
+    juce::MidiBuffer _outputMidi;
+
+    // Input sequence of the last block sent to the server
+    juce::uint32 _sentSequence;
+
+    // Samples in the block sent to the server that haven't been collected yet, and whether the
+    // block was actually sent (blocks are skipped while the server is still busy)
+    int _pendingNumSamples;
+    bool _isPendingBlockSent;
+
+    // Copy of the pending block's input, output instead if the server doesn't finish it in time
+    juce::AudioBuffer<float> _pendingInput;
+
+    // How long the audio thread waits for the server, from BLOCK_TIMEOUT_PROPORTION
+    double _blockTimeoutMs;
+
+    std::atomic<int> _numDroppedBlocks;
+
+    LatencyUpdater _latencyUpdater;
+
+    SandboxedPluginInstance(const juce::PluginDescription& description,
+                            std::unique_ptr<ServerConnection> connection,
+                            const BusesProperties& buses,
+                            int blockSize,
+                            juce::MemoryInputStream& loadReply);
+
+    /**
+     * The layouts PluginConfigurator may try, checked by the server when the guest is loaded.
+     */
+    static std::vector<BusesLayout> _getLayoutsToCheck();
+
+    void _collectPendingBlock(int numChannels);
+    void _sendBlock(const juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages, int numChannels);
+    void _pushToFifo(Sandbox::SharedAudioBlock* source, int numSamples, int numChannels);
+    void _pushInputToFifo(int numSamples, int numChannels);
+    void _popFromFifo(juce::AudioBuffer<float>& buffer, int numChannels);
+    void _updateParameterValues(juce::MemoryInputStream& stream);
+    void _updateLatency();
+    void _removeSharedFile();
+};
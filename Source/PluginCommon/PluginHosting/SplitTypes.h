@@ -1,9 +1,58 @@
 #pragma once
 
+#include <JuceHeader.h>
+
 enum class SPLIT_TYPE {
     SERIES,
     PARALLEL,
     MULTIBAND,
     LEFTRIGHT,
     MIDSIDE
-};
\ No newline at end of file
+};
+
+inline const char* XML_SPLIT_TYPE_SERIES_STR {"series"};
+inline const char* XML_SPLIT_TYPE_PARALLEL_STR {"parallel"};
+inline const char* XML_SPLIT_TYPE_MULTIBAND_STR {"multiband"};
+inline const char* XML_SPLIT_TYPE_LEFTRIGHT_STR {"leftright"};
+inline const char* XML_SPLIT_TYPE_MIDSIDE_STR {"midside"};
+
+inline const char* splitTypeToString(SPLIT_TYPE splitType) {
+    switch (splitType) {
+        case SPLIT_TYPE::SERIES:
+            return XML_SPLIT_TYPE_SERIES_STR;
+        case SPLIT_TYPE::PARALLEL:
+            return XML_SPLIT_TYPE_PARALLEL_STR;
+        case SPLIT_TYPE::MULTIBAND:
+            return XML_SPLIT_TYPE_MULTIBAND_STR;
+        case SPLIT_TYPE::LEFTRIGHT:
+            return XML_SPLIT_TYPE_LEFTRIGHT_STR;
+        case SPLIT_TYPE::MIDSIDE:
+            return XML_SPLIT_TYPE_MIDSIDE_STR;
+    }
+
+    return XML_SPLIT_TYPE_SERIES_STR;
+}
+
+/**
+ * Returns true if each chain of this split type only processes a single channel, so its plugins
+ * can be configured in mono. Matches PluginSplitter::canUseMonoChains().
+ */
+inline bool canSplitTypeUseMonoChains(SPLIT_TYPE splitType) {
+    return splitType == SPLIT_TYPE::LEFTRIGHT || splitType == SPLIT_TYPE::MIDSIDE;
+}
+
+inline SPLIT_TYPE stringToSplitType(juce::String splitTypeString) {
+    SPLIT_TYPE retVal {SPLIT_TYPE::SERIES};
+
+    if (splitTypeString == XML_SPLIT_TYPE_PARALLEL_STR) {
+        retVal = SPLIT_TYPE::PARALLEL;
+    } else if (splitTypeString == XML_SPLIT_TYPE_MULTIBAND_STR) {
+        retVal = SPLIT_TYPE::MULTIBAND;
+    } else if (splitTypeString == XML_SPLIT_TYPE_LEFTRIGHT_STR) {
+        retVal = SPLIT_TYPE::LEFTRIGHT;
+    } else if (splitTypeString == XML_SPLIT_TYPE_MIDSIDE_STR) {
+        retVal = SPLIT_TYPE::MIDSIDE;
+    }
+
+    return retVal;
+}
@@ -2,26 +2,21 @@
 
 void SplitterBand::setLowCutoff(double val) {
     _lowCutoffHz = WECore::MONSTR::Parameters::CROSSOVER_FREQUENCY.BoundsCheck(val);
-    _monoFilters.setupLow(_sampleRate, _lowCutoffHz);
-    _stereoFilters.setupLow(_sampleRate, _lowCutoffHz);
+    _filters->setupLow(_sampleRate, _lowCutoffHz);
 
     // Move the high cutoff up if necessary as they shouldn't swap places
     if (_lowCutoffHz > _highCutoffHz) {
-        _monoFilters.setupHigh(_sampleRate, _lowCutoffHz);
-        _stereoFilters.setupHigh(_sampleRate, _lowCutoffHz);
-
+        _filters->setupHigh(_sampleRate, _lowCutoffHz);
     }
 }
 
 void SplitterBand::setHighCutoff(double val) {
     _highCutoffHz = WECore::MONSTR::Parameters::CROSSOVER_FREQUENCY.BoundsCheck(val);
-    _monoFilters.setupHigh(_sampleRate, _highCutoffHz);
-    _stereoFilters.setupHigh(_sampleRate, _highCutoffHz);
+    _filters->setupHigh(_sampleRate, _highCutoffHz);
 
     // Move the low cutoff down if necessary as they shouldn't swap places
     if (_lowCutoffHz > _highCutoffHz) {
-        _monoFilters.setupLow(_sampleRate, _highCutoffHz);
-        _stereoFilters.setupLow(_sampleRate, _highCutoffHz);
+        _filters->setupLow(_sampleRate, _highCutoffHz);
     }
 }
 
@@ -39,21 +34,20 @@ void SplitterBand::setSampleRate(double newSampleRate) {
 }
 
 void SplitterBand::setIsStereo(bool val) {
-    _isStereo = val;
+    if (val != _isStereo) {
+        _isStereo = val;
+        _createFilters();
+    }
 }
 
-void SplitterBand::processBlock(juce::AudioBuffer<float>& buffer) {
+void SplitterBand::processBlock(juce::AudioBuffer<float>& buffer, bool isEconomy) {
     if (_isMuted) {
         // TODO don't clear side chain - check mute on other splitters for this
         // Muted - set the output to 0 for this band
         buffer.clear();
     } else {
         // Apply the filtering before processing
-        if (_isStereo) {
-            _stereoFilters.processBlock(buffer, _bandType);
-        } else {
-            _monoFilters.processBlock(buffer, _bandType);
-        }
+        _filters->processBlock(buffer, _bandType, isEconomy);
 
         if (_isActive) {
             if (_chain != nullptr) {
@@ -66,6 +60,16 @@ void SplitterBand::processBlock(juce::AudioBuffer<float>& buffer) {
 }
 
 void SplitterBand::reset() {
-    _monoFilters.reset();
-    _stereoFilters.reset();
+    _filters->reset();
+}
+
+void SplitterBand::_createFilters() {
+    if (_isStereo) {
+        _filters = std::make_unique<FilterBankImpl<2>>();
+    } else {
+        _filters = std::make_unique<FilterBankImpl<1>>();
+    }
+
+    _filters->setupLow(_sampleRate, std::min(_lowCutoffHz, _highCutoffHz));
+    _filters->setupHigh(_sampleRate, std::max(_lowCutoffHz, _highCutoffHz));
 }
@@ -36,103 +36,87 @@ enum class BandType {
     UPPER
 };
 
-class MonoFilterBank {
+/**
+ * The crossover filters for one band.
+ */
+class FilterBank {
 public:
-    MonoFilterBank() = default;
+    virtual ~FilterBank() = default;
 
-    void setupLow(double sampleRate, double lowCutoffHz) {
-        _lowCut1.setup(FILTER_ORDER, sampleRate, lowCutoffHz);
-        _lowCut2.setup(FILTER_ORDER, sampleRate, lowCutoffHz);
-    }
-
-    void setupHigh(double sampleRate, double highCutoffHz) {
-        _highCut1.setup(FILTER_ORDER, sampleRate, highCutoffHz);
-        _highCut2.setup(FILTER_ORDER, sampleRate, highCutoffHz);
-    }
-
-    void reset() {
-        _lowCut1.reset();
-        _lowCut2.reset();
-        _highCut1.reset();
-        _highCut2.reset();
-    }
-
-    void processBlock(juce::AudioBuffer<float>& buffer, BandType bandType) {
-        float* channelsArray[1];
+    virtual void setupLow(double sampleRate, double lowCutoffHz) = 0;
+    virtual void setupHigh(double sampleRate, double highCutoffHz) = 0;
+    virtual void reset() = 0;
 
-        channelsArray[0] = buffer.getWritePointer(0);
-
-        if (bandType == BandType::LOWER) {
-            _highCut1.process(buffer.getNumSamples(), channelsArray);
-            _highCut2.process(buffer.getNumSamples(), channelsArray);
-        } else if (bandType == BandType::UPPER) {
-            _lowCut1.process(buffer.getNumSamples(), channelsArray);
-            _lowCut2.process(buffer.getNumSamples(), channelsArray);
-        } else {
-            _lowCut1.process(buffer.getNumSamples(), channelsArray);
-            _lowCut2.process(buffer.getNumSamples(), channelsArray);
-            _highCut1.process(buffer.getNumSamples(), channelsArray);
-            _highCut2.process(buffer.getNumSamples(), channelsArray);
-        }
-    }
-
-private:
-    static constexpr int FILTER_ORDER {2};
-
-    Dsp::SimpleFilter<Dsp::Butterworth::HighPass<FILTER_ORDER>, 1> _lowCut1;
-    Dsp::SimpleFilter<Dsp::Butterworth::HighPass<FILTER_ORDER>, 1> _lowCut2;
-    Dsp::SimpleFilter<Dsp::Butterworth::LowPass<FILTER_ORDER>, 1> _highCut1;
-    Dsp::SimpleFilter<Dsp::Butterworth::LowPass<FILTER_ORDER>, 1> _highCut2;
+    /**
+     * In economy mode only the first of the two cascaded filters is applied.
+     */
+    virtual void processBlock(juce::AudioBuffer<float>& buffer, BandType bandType, bool isEconomy) = 0;
 };
 
-class StereoFilterBank {
+/**
+ * Filters specialised for a fixed number of channels, so a band only keeps the filter state and
+ * calculates the coefficients for the channel configuration it's actually processing.
+ */
+template <int NUM_CHANNELS>
+class FilterBankImpl : public FilterBank {
 public:
-    StereoFilterBank() = default;
+    FilterBankImpl() : _isEconomy(false) {}
 
-    void setupLow(double sampleRate, double lowCutoffHz) {
+    void setupLow(double sampleRate, double lowCutoffHz) override {
         _lowCut1.setup(FILTER_ORDER, sampleRate, lowCutoffHz);
         _lowCut2.setup(FILTER_ORDER, sampleRate, lowCutoffHz);
     }
 
-    void setupHigh(double sampleRate, double highCutoffHz) {
+    void setupHigh(double sampleRate, double highCutoffHz) override {
         _highCut1.setup(FILTER_ORDER, sampleRate, highCutoffHz);
         _highCut2.setup(FILTER_ORDER, sampleRate, highCutoffHz);
     }
 
-    void reset() {
+    void reset() override {
         _lowCut1.reset();
         _lowCut2.reset();
         _highCut1.reset();
         _highCut2.reset();
     }
 
-    void processBlock(juce::AudioBuffer<float>& buffer, BandType bandType) {
-        float* channelsArray[2];
+    void processBlock(juce::AudioBuffer<float>& buffer, BandType bandType, bool isEconomy) override {
+        float* channelsArray[NUM_CHANNELS];
 
-        channelsArray[0] = buffer.getWritePointer(0);
-        channelsArray[1] = buffer.getWritePointer(1);
+        for (int channel {0}; channel < NUM_CHANNELS; channel++) {
+            channelsArray[channel] = buffer.getWritePointer(channel);
+        }
 
-        if (bandType == BandType::LOWER) {
-            _highCut1.process(buffer.getNumSamples(), channelsArray);
-            _highCut2.process(buffer.getNumSamples(), channelsArray);
-        } else if (bandType == BandType::UPPER) {
-            _lowCut1.process(buffer.getNumSamples(), channelsArray);
-            _lowCut2.process(buffer.getNumSamples(), channelsArray);
-        } else {
+        // The second stage's state is stale after economy mode, so start it again from silence
+        if (_isEconomy && !isEconomy) {
+            _lowCut2.reset();
+            _highCut2.reset();
+        }
+        _isEconomy = isEconomy;
+
+        if (bandType == BandType::UPPER || bandType == BandType::MIDDLE) {
             _lowCut1.process(buffer.getNumSamples(), channelsArray);
-            _lowCut2.process(buffer.getNumSamples(), channelsArray);
+            if (!isEconomy) {
+                _lowCut2.process(buffer.getNumSamples(), channelsArray);
+            }
+        }
+
+        if (bandType == BandType::LOWER || bandType == BandType::MIDDLE) {
             _highCut1.process(buffer.getNumSamples(), channelsArray);
-            _highCut2.process(buffer.getNumSamples(), channelsArray);
+            if (!isEconomy) {
+                _highCut2.process(buffer.getNumSamples(), channelsArray);
+            }
         }
     }
 
 private:
     static constexpr int FILTER_ORDER {2};
 
-    Dsp::SimpleFilter<Dsp::Butterworth::HighPass<FILTER_ORDER>, 2> _lowCut1;
-    Dsp::SimpleFilter<Dsp::Butterworth::HighPass<FILTER_ORDER>, 2> _lowCut2;
-    Dsp::SimpleFilter<Dsp::Butterworth::LowPass<FILTER_ORDER>, 2> _highCut1;
-    Dsp::SimpleFilter<Dsp::Butterworth::LowPass<FILTER_ORDER>, 2> _highCut2;
+    Dsp::SimpleFilter<Dsp::Butterworth::HighPass<FILTER_ORDER>, NUM_CHANNELS> _lowCut1;
+    Dsp::SimpleFilter<Dsp::Butterworth::HighPass<FILTER_ORDER>, NUM_CHANNELS> _lowCut2;
+    Dsp::SimpleFilter<Dsp::Butterworth::LowPass<FILTER_ORDER>, NUM_CHANNELS> _highCut1;
+    Dsp::SimpleFilter<Dsp::Butterworth::LowPass<FILTER_ORDER>, NUM_CHANNELS> _highCut2;
+
+    bool _isEconomy;
 };
 
 class SplitterBand {
@@ -145,10 +129,7 @@ public:
                                       _sampleRate(44100),
                                       _chain(nullptr),
                                       _isStereo(false) {
-        _monoFilters.setupLow(_sampleRate, _lowCutoffHz);
-        _stereoFilters.setupLow(_sampleRate, _lowCutoffHz);
-        _monoFilters.setupHigh(_sampleRate, _highCutoffHz);
-        _stereoFilters.setupHigh(_sampleRate, _highCutoffHz);
+        _createFilters();
     }
 
     virtual ~SplitterBand() = default;
@@ -160,6 +141,11 @@ public:
     void setBandType(BandType bandType);
     void setSampleRate(double newSampleRate);
     void setPluginChain(PluginChain* chain) { _chain = chain; }
+
+    /**
+     * Replaces the filters with ones for the new channel configuration, so must not be called while
+     * processing.
+     */
     void setIsStereo(bool val);
 
     bool getIsActive() const { return _isActive; }
@@ -167,7 +153,7 @@ public:
     double getLowCutoff() const { return _lowCutoffHz; }
     double getHighCutoff() const { return _highCutoffHz; }
 
-    void processBlock(juce::AudioBuffer<float>& buffer);
+    void processBlock(juce::AudioBuffer<float>& buffer, bool isEconomy);
 
     void reset();
 
@@ -182,10 +168,11 @@ private:
 
     double _sampleRate;
 
-    MonoFilterBank _monoFilters;
-    StereoFilterBank _stereoFilters;
+    std::unique_ptr<FilterBank> _filters;
 
     PluginChain* _chain;
 
     bool _isStereo;
+
+    void _createFilters();
 };
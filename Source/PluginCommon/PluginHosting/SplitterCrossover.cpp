@@ -1,6 +1,13 @@
 #include "SplitterCrossover.h"
 
-SplitterCrossover::SplitterCrossover() : _numBands(WECore::MONSTR::Parameters::_DEFAULT_NUM_BANDS), _numBandsSoloed(0) {
+SplitterCrossover::SplitterCrossover() : _numBands(WECore::MONSTR::Parameters::_DEFAULT_NUM_BANDS),
+                                         _numBandsSoloed(0),
+                                         _isEconomyMode(false),
+                                         _sampleRate(44100) {
+
+    for (size_t index {0}; index < _targetFrequencies.size(); index++) {
+        _targetFrequencies[index] = _bands[index].band.getHighCutoff();
+    }
 
     // The bands are defaulted to lower, set them correctly
     static_assert(WECore::MONSTR::Parameters::_DEFAULT_NUM_BANDS == 3,
@@ -10,6 +17,7 @@ SplitterCrossover::SplitterCrossover() : _numBands(WECore::MONSTR::Parameters::_
 
     setCrossoverFrequency(0, WECore::MONSTR::Parameters::CROSSOVER_LOWER_DEFAULT);
     setCrossoverFrequency(1, WECore::MONSTR::Parameters::CROSSOVER_UPPER_DEFAULT);
+    _updateBandCutoffs(1);
 }
 
 void SplitterCrossover::setIsActive(size_t index, bool isActive) {
@@ -43,12 +51,11 @@ void SplitterCrossover::setIsSoloed(size_t index, bool isSoloed) {
 
 void SplitterCrossover::setCrossoverFrequency(size_t index, double val) {
 
-    if (index < _bands.size() - 1) {
+    if (index < _targetFrequencies.size()) {
 
-        // Set the crossover frequency
+        // Set the crossover frequency, the bands will be moved to it while processing
         val = WECore::MONSTR::Parameters::CROSSOVER_FREQUENCY.BoundsCheck(val);
-        _bands[index].band.setHighCutoff(val);
-        _bands[index + 1].band.setLowCutoff(val);
+        _targetFrequencies[index] = val;
 
         // Make sure the crossover frequencies are still in the correct order
         for (size_t otherCrossoverIndex {0}; otherCrossoverIndex < _bands.size() - 1; otherCrossoverIndex++) {
@@ -82,6 +89,8 @@ void SplitterCrossover::setPluginChain(size_t index, PluginChain* chain) {
 }
 
 void SplitterCrossover::setSampleRate(double newSampleRate) {
+    _sampleRate = newSampleRate;
+
     for (BandWrapper band : _bands) {
         band.band.setSampleRate(newSampleRate);
     }
@@ -141,8 +150,8 @@ bool SplitterCrossover::getIsSoloed(size_t index) const {
 double SplitterCrossover::getCrossoverFrequency(size_t index) const {
     double retVal {0};
 
-    if (index < _bands.size()) {
-        retVal = _bands[index].band.getHighCutoff();
+    if (index < _targetFrequencies.size()) {
+        retVal = _targetFrequencies[index];
     }
 
     return retVal;
@@ -206,6 +215,11 @@ void SplitterCrossover::processBlock(juce::AudioBuffer<float> buffer) {
         )};
 
     const int numChannels {std::min(buffer.getNumChannels(), INTERNAL_BUFFER_CHANNELS)};
+    const bool isEconomyMode {_isEconomyMode};
+
+    // Move the crossovers towards their targets once per block, this is a one pole smoother with a
+    // time constant of FREQUENCY_SMOOTHING_SECONDS
+    _updateBandCutoffs(1 - std::exp(-buffer.getNumSamples() / (FREQUENCY_SMOOTHING_SECONDS * _sampleRate)));
 
     for (size_t bufferNumber {0}; bufferNumber < numBuffersRequired; bufferNumber++) {
 
@@ -232,7 +246,7 @@ void SplitterCrossover::processBlock(juce::AudioBuffer<float> buffer) {
                 }
 
                 // Do processing
-                thisBand.band.processBlock(thisBand.buffer);
+                thisBand.band.processBlock(thisBand.buffer, isEconomyMode);
             }
         }
 
@@ -253,7 +267,33 @@ void SplitterCrossover::processBlock(juce::AudioBuffer<float> buffer) {
 }
 
 void SplitterCrossover::reset() {
+    _updateBandCutoffs(1);
+
     for (BandWrapper& band : _bands) {
         band.band.reset();
     }
 }
+
+void SplitterCrossover::_updateBandCutoffs(double proportion) {
+    for (size_t index {0}; index < _targetFrequencies.size(); index++) {
+        const double currentFrequency {_bands[index].band.getHighCutoff()};
+        const double targetFrequency {_targetFrequencies[index]};
+
+        if (currentFrequency == targetFrequency) {
+            continue;
+        }
+
+        // Smoothed on a log scale so the movement sounds even across the spectrum, and snapped to
+        // the target once it's close enough not to be heard
+        double newFrequency {
+            currentFrequency * std::pow(targetFrequency / currentFrequency, proportion)
+        };
+
+        if (proportion >= 1 || std::abs(newFrequency - targetFrequency) < 0.1) {
+            newFrequency = targetFrequency;
+        }
+
+        _bands[index].band.setHighCutoff(newFrequency);
+        _bands[index + 1].band.setLowCutoff(newFrequency);
+    }
+}
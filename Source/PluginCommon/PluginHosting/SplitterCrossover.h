@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include "SplitterBand.h"
 
 class SplitterCrossover {
@@ -12,12 +13,24 @@ public:
     void setIsActive(size_t index, bool isActive);
     void setIsMuted(size_t index, bool isMuted);
     void setIsSoloed(size_t index, bool isSoloed);
+
+    /**
+     * Sets the frequency the crossover moves towards, it's smoothed while processing so it can be
+     * changed for every movement of the mouse. Can be called while processing.
+     */
     void setCrossoverFrequency(size_t index, double val);
     void setPluginChain(size_t index, PluginChain* chain);
     void setSampleRate(double newSampleRate);
     void setNumBands(int val);
     void setIsStereo(bool val);
 
+    /**
+     * Uses a single filter stage per crossover rather than two to save CPU, at the expense of a
+     * shallower slope. Can be called while processing.
+     */
+    void setIsEconomyMode(bool val) { _isEconomyMode = val; }
+    bool getIsEconomyMode() const { return _isEconomyMode; }
+
     bool getIsActive(size_t index) const;
     bool getIsMuted(size_t index) const;
     bool getIsSoloed(size_t index) const;
@@ -34,6 +47,9 @@ private:
     static constexpr int INTERNAL_BUFFER_SIZE = 512;
     static constexpr int INTERNAL_BUFFER_CHANNELS = 4;
 
+    // Roughly how long a crossover takes to reach a new frequency
+    static constexpr double FREQUENCY_SMOOTHING_SECONDS {0.05};
+
     class BandWrapper {
     public:
         BandWrapper() : band(BandType::LOWER),
@@ -47,6 +63,18 @@ private:
     };
 
     size_t _numBands;
-    size_t _numBandsSoloed;
+    std::atomic<size_t> _numBandsSoloed;
+    std::atomic<bool> _isEconomyMode;
     std::array<BandWrapper, WECore::MONSTR::Parameters::_MAX_NUM_BANDS> _bands;
+
+    // The frequency each crossover is moving towards, the bands' cutoffs are only changed by
+    // _updateBandCutoffs()
+    std::array<std::atomic<double>, WECore::MONSTR::Parameters::_MAX_NUM_BANDS - 1> _targetFrequencies;
+    double _sampleRate;
+
+    /**
+     * Moves the cutoffs of the bands towards the target frequencies, by the given proportion of
+     * the remaining distance (1 jumps straight to them).
+     */
+    void _updateBandCutoffs(double proportion);
 };
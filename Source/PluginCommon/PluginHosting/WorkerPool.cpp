@@ -0,0 +1,260 @@
+#include <cerrno>
+
+#include "WorkerPool.h"
+
+#if JUCE_INTEL
+    #include <immintrin.h>
+#endif
+
+#if JUCE_WINDOWS
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#endif
+
+WorkerPool::WakeSemaphore::WakeSemaphore() {
+#if JUCE_MAC || JUCE_IOS
+    _semaphore = dispatch_semaphore_create(0);
+#elif JUCE_WINDOWS
+    _semaphore = CreateSemaphoreW(nullptr, 0, std::numeric_limits<LONG>::max(), nullptr);
+#else
+    sem_init(&_semaphore, 0, 0);
+#endif
+}
+
+WorkerPool::WakeSemaphore::~WakeSemaphore() {
+#if JUCE_MAC || JUCE_IOS
+    dispatch_release(_semaphore);
+#elif JUCE_WINDOWS
+    CloseHandle(_semaphore);
+#else
+    sem_destroy(&_semaphore);
+#endif
+}
+
+void WorkerPool::WakeSemaphore::signal(int count) {
+#if JUCE_WINDOWS
+    ReleaseSemaphore(_semaphore, count, nullptr);
+#else
+    for (int index {0}; index < count; index++) {
+    #if JUCE_MAC || JUCE_IOS
+        dispatch_semaphore_signal(_semaphore);
+    #else
+        sem_post(&_semaphore);
+    #endif
+    }
+#endif
+}
+
+void WorkerPool::WakeSemaphore::wait() {
+#if JUCE_MAC || JUCE_IOS
+    dispatch_semaphore_wait(_semaphore, DISPATCH_TIME_FOREVER);
+#elif JUCE_WINDOWS
+    WaitForSingleObject(_semaphore, INFINITE);
+#else
+    while (sem_wait(&_semaphore) == -1 && errno == EINTR) {
+    }
+#endif
+}
+
+WorkerPool::WorkerPool(int numThreads) : _numSleepingThreads(0) {
+    for (int index {0}; index < numThreads; index++) {
+        _threads.push_back(std::make_unique<WorkerThread>(*this));
+        _threads.back()->startRealtime();
+    }
+
+    juce::Logger::writeToLog("WorkerPool: Started " + juce::String(numThreads) + " threads");
+}
+
+WorkerPool::~WorkerPool() {
+    for (std::unique_ptr<WorkerThread>& thread : _threads) {
+        thread->signalThreadShouldExit();
+    }
+
+    _wakeSemaphore.signal(static_cast<int>(_threads.size()));
+
+    for (std::unique_ptr<WorkerThread>& thread : _threads) {
+        thread->stopThread(1000);
+    }
+}
+
+std::shared_ptr<WorkerPool> WorkerPool::getShared() {
+    static juce::CriticalSection sharedPoolMutex;
+    static std::weak_ptr<WorkerPool> sharedPool;
+
+    const juce::ScopedLock lock(sharedPoolMutex);
+
+    std::shared_ptr<WorkerPool> retVal = sharedPool.lock();
+
+    if (retVal == nullptr) {
+        // The calling threads also run tasks, so leave a core for them
+        retVal = std::make_shared<WorkerPool>(std::max(juce::SystemStats::getNumCpus() - 1, 1));
+        sharedPool = retVal;
+    }
+
+    return retVal;
+}
+
+juce::int64 WorkerPool::getDeadlineForBlock(int numSamples, double sampleRate) {
+    return juce::Time::getHighResolutionTicks() + juce::Time::secondsToHighResolutionTicks(numSamples / sampleRate);
+}
+
+void WorkerPool::run(Job& job, int numTasks, juce::int64 deadlineTicks) {
+    if (numTasks <= 0) {
+        return;
+    }
+
+    JobSlot* slot {numTasks > 1 && !_threads.empty() ? _claimSlot() : nullptr};
+
+    if (slot == nullptr) {
+        // Nothing to gain from the workers, or too many jobs in flight - just run it here
+        for (int taskIndex {0}; taskIndex < numTasks; taskIndex++) {
+            job.runTask(taskIndex);
+        }
+
+        return;
+    }
+
+    // Set up the slot before publishing the job, workers only read it once they've seen the job
+    slot->numTasks = numTasks;
+    slot->nextTask = 0;
+    slot->numTasksCompleted = 0;
+    slot->deadlineTicks = deadlineTicks;
+    slot->job = &job;
+
+    // This thread runs tasks too, so only the rest need workers
+    _wakeWorkers(numTasks - 1);
+
+    // Any task the workers haven't picked up by the time this thread gets to it is run here
+    while (_runNextTask(*slot)) {
+    }
+
+    // Wait for any tasks the workers are still running, helping with other instances' jobs in the
+    // meantime if they're due before ours
+    while (slot->numTasksCompleted < numTasks) {
+        JobSlot* urgentSlot {_findMostUrgentSlot(deadlineTicks)};
+
+        if (urgentSlot != nullptr && urgentSlot != slot) {
+            _runNextTask(*urgentSlot);
+        } else {
+            _pause();
+        }
+    }
+
+    // Make sure no other threads are still holding this job before it goes out of scope
+    slot->job = nullptr;
+
+    while (slot->numBusyThreads > 0) {
+        _pause();
+    }
+
+    slot->isInUse = false;
+}
+
+void WorkerPool::_pause() {
+#if JUCE_INTEL
+    _mm_pause();
+#elif JUCE_ARM && !JUCE_MSVC
+    __asm__ __volatile__("yield");
+#endif
+}
+
+void WorkerPool::_wakeWorkers(int maxNumThreads) {
+    // The workers are usually still spinning from the previous job, in which case there's nothing
+    // to signal
+    const int numSleepingThreads {_numSleepingThreads};
+    if (numSleepingThreads > 0) {
+        _wakeSemaphore.signal(std::min(numSleepingThreads, maxNumThreads));
+    }
+}
+
+WorkerPool::JobSlot* WorkerPool::_claimSlot() {
+    for (JobSlot& slot : _slots) {
+        bool expected {false};
+        if (slot.isInUse.compare_exchange_strong(expected, true)) {
+            return &slot;
+        }
+    }
+
+    return nullptr;
+}
+
+WorkerPool::JobSlot* WorkerPool::_findMostUrgentSlot(juce::int64 deadlineBeforeTicks) {
+    JobSlot* retVal {nullptr};
+    juce::int64 earliestDeadline {deadlineBeforeTicks};
+
+    for (JobSlot& slot : _slots) {
+        if (slot.job != nullptr && slot.nextTask < slot.numTasks && slot.deadlineTicks < earliestDeadline) {
+            retVal = &slot;
+            earliestDeadline = slot.deadlineTicks;
+        }
+    }
+
+    return retVal;
+}
+
+bool WorkerPool::_runNextTask(JobSlot& slot) {
+    bool retVal {false};
+
+    // Mark this thread as busy before looking at the job, so the caller waits for it
+    slot.numBusyThreads++;
+
+    Job* job {slot.job};
+    if (job != nullptr) {
+        const int taskIndex {slot.nextTask++};
+
+        if (taskIndex < slot.numTasks) {
+            job->runTask(taskIndex);
+            slot.numTasksCompleted++;
+            retVal = true;
+        }
+    }
+
+    slot.numBusyThreads--;
+
+    return retVal;
+}
+
+void WorkerPool::WorkerThread::startRealtime() {
+#if JUCE_MAJOR_VERSION >= 7
+    startRealtimeThread(juce::Thread::RealtimeOptions().withPriority(10));
+#elif JUCE_MAJOR_VERSION == 6 && JUCE_MINOR_VERSION >= 1
+    juce::Thread::RealtimeOptions options;
+    options.priority = 10;
+    startRealtimeThread(options);
+#else
+    // Priority 10 is JUCE's realtime priority
+    startThread(10);
+#endif
+}
+
+void WorkerPool::WorkerThread::run() {
+    int numIdleSpins {0};
+
+    while (!threadShouldExit()) {
+        JobSlot* slot {_pool._findMostUrgentSlot(std::numeric_limits<juce::int64>::max())};
+
+        if (slot != nullptr) {
+            // Only run one task before looking again, in case a more urgent job has arrived
+            _pool._runNextTask(*slot);
+            numIdleSpins = 0;
+        } else if (numIdleSpins < WORKER_SPIN_COUNT) {
+            // Jobs arrive in quick succession while the audio threads are busy, so keep looking for
+            // a while rather than paying to be woken for each one
+            _pause();
+            numIdleSpins++;
+        } else {
+            // Check again after counting this thread as asleep, so a job published in between
+            // isn't missed
+            _pool._numSleepingThreads++;
+
+            if (_pool._findMostUrgentSlot(std::numeric_limits<juce::int64>::max()) == nullptr && !threadShouldExit()) {
+                _pool._wakeSemaphore.wait();
+            }
+
+            _pool._numSleepingThreads--;
+            numIdleSpins = 0;
+        }
+    }
+}
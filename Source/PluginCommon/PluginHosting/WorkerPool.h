@@ -0,0 +1,153 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_MAC || JUCE_IOS
+    #include <dispatch/dispatch.h>
+#elif !JUCE_WINDOWS
+    #include <semaphore.h>
+#endif
+
+/**
+ * A set of worker threads which help the audio threads with work that can be split into
+ * independent tasks, such as chains in the same stage of a processing plan.
+ *
+ * A single pool is shared by every instance loaded in the same process (see getShared()), so a
+ * session with many instances doesn't start more threads than there are cores. Each job has a
+ * deadline, and the workers always take tasks from the job which is due soonest.
+ *
+ * The calling thread runs tasks alongside the workers, taking any task a worker hasn't picked up
+ * yet, so a job still completes (just more slowly) if the workers are busy with other instances,
+ * haven't woken up in time, or the pool is full.
+ *
+ * The workers run at realtime priority, as the audio threads are waiting for them.
+ *
+ * Idle workers spin for a short time before going to sleep on a semaphore. Publishing a job never
+ * takes a lock, the semaphore is only signalled if a worker is asleep.
+ */
+class WorkerPool {
+public:
+    /**
+     * Work which can be split into tasks that are safe to run concurrently.
+     */
+    class Job {
+    public:
+        virtual ~Job() = default;
+        virtual void runTask(int taskIndex) = 0;
+    };
+
+    explicit WorkerPool(int numThreads);
+    ~WorkerPool();
+
+    /**
+     * Returns the pool shared by every instance in this process, creating it if needed. The pool
+     * is deleted once the last instance has released it.
+     */
+    static std::shared_ptr<WorkerPool> getShared();
+
+    /**
+     * Returns the deadline for a block starting now, in high resolution ticks.
+     */
+    static juce::int64 getDeadlineForBlock(int numSamples, double sampleRate);
+
+    /**
+     * Runs each task of the job, returning once they have all finished. The deadline is the high
+     * resolution tick count the caller needs the job finished by.
+     *
+     * Can be called from several threads at once, but must not be called from within a task.
+     */
+    void run(Job& job, int numTasks, juce::int64 deadlineTicks);
+
+    size_t getNumThreads() const { return _threads.size(); }
+
+private:
+    /**
+     * A counting semaphore using the platform's native one, which (unlike juce::WaitableEvent)
+     * doesn't take a lock to signal.
+     */
+    class WakeSemaphore {
+    public:
+        WakeSemaphore();
+        ~WakeSemaphore();
+
+        void signal(int count);
+        void wait();
+
+    private:
+#if JUCE_MAC || JUCE_IOS
+        dispatch_semaphore_t _semaphore;
+#elif JUCE_WINDOWS
+        void* _semaphore;
+#else
+        sem_t _semaphore;
+#endif
+    };
+
+    class WorkerThread : public juce::Thread {
+    public:
+        explicit WorkerThread(WorkerPool& pool) : juce::Thread("Syndicate worker"), _pool(pool) {}
+
+        /**
+         * Starts the thread with the same scheduling as an audio thread, where JUCE supports it.
+         */
+        void startRealtime();
+
+        void run() override;
+
+    private:
+        WorkerPool& _pool;
+    };
+
+    /**
+     * A job which has been submitted to the pool.
+     */
+    struct JobSlot {
+        // Claimed by a caller for the duration of its job
+        std::atomic<bool> isInUse {false};
+
+        // The job being run, or nullptr before it has been published and after it's finished
+        std::atomic<Job*> job {nullptr};
+        std::atomic<int> numTasks {0};
+        std::atomic<int> nextTask {0};
+        std::atomic<int> numTasksCompleted {0};
+        std::atomic<juce::int64> deadlineTicks {0};
+
+        // Threads which may be holding a pointer to the job
+        std::atomic<int> numBusyThreads {0};
+    };
+
+    static constexpr int MAX_CONCURRENT_JOBS {64};
+
+    // How many times an idle worker looks for a job before going to sleep, a few tens of
+    // microseconds
+    static constexpr int WORKER_SPIN_COUNT {1000};
+
+    std::vector<std::unique_ptr<WorkerThread>> _threads;
+    std::array<JobSlot, MAX_CONCURRENT_JOBS> _slots;
+
+    WakeSemaphore _wakeSemaphore;
+    std::atomic<int> _numSleepingThreads;
+
+    /**
+     * Tells the CPU this thread is spinning, so it doesn't starve the other hyperthread on the core.
+     */
+    static void _pause();
+
+    /**
+     * Wakes up to the given number of sleeping workers.
+     */
+    void _wakeWorkers(int maxNumThreads);
+
+    JobSlot* _claimSlot();
+
+    /**
+     * Returns the slot with unclaimed tasks and the earliest deadline before the given one, or
+     * nullptr if there isn't one.
+     */
+    JobSlot* _findMostUrgentSlot(juce::int64 deadlineBeforeTicks);
+
+    /**
+     * Runs the next unclaimed task of the slot's job, returns false if there wasn't one.
+     */
+    bool _runNextTask(JobSlot& slot);
+};
@@ -1,4 +1,11 @@
 #include "PluginScanClient.h"
+#include "Tracer.h"
+
+namespace {
+    void sendMessageToServer(juce::ChildProcessMaster& processClient, const juce::String& message) {
+        processClient.sendMessageToSlave(juce::MemoryBlock(message.toRawUTF8(), message.getNumBytesAsUTF8()));
+    }
+}
 
 PluginScanClient::PluginScanClient() : juce::Thread("Scan Client"),
                                        _hasPreviousScan(false),
@@ -78,6 +85,10 @@ void PluginScanClient::startScan() {
 
             if (started) {
                 juce::Logger::writeToLog("Started plugin scan server");
+
+                if (Tracer::getInstance().isEnabled()) {
+                    sendMessageToServer(*_processClient, Utils::SCAN_SERVER_START_TRACE_MESSAGE);
+                }
             } else {
                 juce::Logger::writeToLog("Failed to start plugin scan server");
             }
@@ -138,6 +149,32 @@ void PluginScanClient::rescanCrashedPlugins() {
     }
 }
 
+void PluginScanClient::startTrace() {
+    if (_processClient != nullptr) {
+        _callbacksToHandle.push([&]() {
+            if (_processClient != nullptr) {
+                juce::Logger::writeToLog("Starting plugin scan server trace");
+                sendMessageToServer(*_processClient, Utils::SCAN_SERVER_START_TRACE_MESSAGE);
+            }
+        });
+
+        _messageEvent.signal();
+    }
+}
+
+void PluginScanClient::stopTrace(juce::File file) {
+    if (_processClient != nullptr) {
+        _callbacksToHandle.push([&, file]() {
+            if (_processClient != nullptr) {
+                juce::Logger::writeToLog("Stopping plugin scan server trace");
+                sendMessageToServer(*_processClient, Utils::SCAN_SERVER_STOP_TRACE_MESSAGE + file.getFullPathName());
+            }
+        });
+
+        _messageEvent.signal();
+    }
+}
+
 void PluginScanClient::addListener(juce::MessageListener* listener) {
     if (listener != nullptr) {
         std::scoped_lock lock(_listenersMutex);
@@ -171,7 +208,10 @@ void PluginScanClient::run() {
         if (_messageEvent.wait(1000)) {
             // Handle messages
             while (!_callbacksToHandle.empty()) {
-                _callbacksToHandle.front()();
+                {
+                    Tracer::Scope traceScope("scanClientCallback", "scan");
+                    _callbacksToHandle.front()();
+                }
                 _callbacksToHandle.pop();
 
                 if (_processClient == nullptr) {
@@ -223,6 +263,8 @@ void PluginScanClient::_onConnectionLost() {
 }
 
 void PluginScanClient::_readScannerFilesForUpdates() {
+    Tracer::Scope traceScope("readScanResults", "scan");
+
     // Check if the plugin scan files have been updated since we last checked them
     restore();
 
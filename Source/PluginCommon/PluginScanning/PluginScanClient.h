@@ -37,6 +37,17 @@ public:
      */
     void rescanCrashedPlugins();
 
+    /**
+     * Asks the scan server to start tracing if it's running. A scan started while the tracer is
+     * enabled is traced from the beginning.
+     */
+    void startTrace();
+
+    /**
+     * Asks the scan server to stop tracing and export its trace to the given file.
+     */
+    void stopTrace(juce::File file);
+
     void addListener(juce::MessageListener* listener);
 
     void removeListener(juce::MessageListener* listener);
@@ -37,23 +37,4 @@ namespace Utils {
 
         return retVal;
     }
-
-    inline void processBalance(float panValue, juce::AudioBuffer<float>& buffer) {
-        // Check we have enough channels
-        if (buffer.getNumChannels() >= 2) {
-            if (panValue > 0) {
-                // Balance is to the right - so linearly attenuate the left
-                const float leftGain {1 - panValue};
-                juce::FloatVectorOperations::multiply(buffer.getWritePointer(0),
-                                                      leftGain,
-                                                      buffer.getNumSamples());
-            } else if (panValue < 0) {
-                // Balance is to the left - so linearly attenuate the right
-                const float rightGain {1 + panValue};
-                juce::FloatVectorOperations::multiply(buffer.getWritePointer(1),
-                                                      rightGain,
-                                                      buffer.getNumSamples());
-            }
-        }
-    }
 }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "AllUtils.h"
+#include "MainLogger.h"
+#include "HostServerProcess.h"
+
+/**
+ * Hosts a single sandboxed guest plugin for an instance of Syndicate. Unlike the scan server one
+ * of these is started for each sandboxed plugin, so more than one instance is allowed.
+ */
+class HostServerApplication : public juce::JUCEApplicationBase {
+public:
+    HostServerApplication() : _logger("Syndicate Plugin Host Server", "0.0.1", Utils::PluginHostServerLogDirectory) {
+        juce::Logger::setCurrentLogger(&_logger);
+    }
+
+    ~HostServerApplication() {
+        // Logger must be removed before being deleted
+        // (this must be the last thing we do before exiting)
+        juce::Logger::setCurrentLogger(nullptr);
+    }
+
+    const juce::String getApplicationName() override { return "Syndicate Plugin Host Server"; }
+
+    const juce::String getApplicationVersion() override { return "0.0.1"; }
+
+    bool moreThanOneInstanceAllowed() override { return true; }
+
+    void initialise(const juce::String& commandLineParameters) override {
+        juce::Logger::writeToLog("Initialising");
+        _process.reset(new HostServerProcess());
+
+        if (_process->initialiseFromCommandLine(commandLineParameters, Utils::PLUGIN_HOST_SERVER_UID)) {
+            juce::Logger::writeToLog("Process started");
+        } else {
+            // Not started by Syndicate, nothing to do
+            quit();
+        }
+    }
+
+    void shutdown() override {
+        juce::Logger::writeToLog("Shutting down");
+        _process.reset();
+    }
+
+    void anotherInstanceStarted(const juce::String& /*commandLine*/) override {
+    }
+
+    void systemRequestedQuit() override {
+        juce::Logger::writeToLog("System Requested Quit");
+        _process->stop();
+        quit();
+    }
+
+    void suspended() override {
+    }
+
+    void resumed() override {
+    }
+
+    void unhandledException(const std::exception*,
+                            const juce::String& sourceFilename,
+                            int lineNumber) override {
+        juce::Logger::writeToLog("Unhandled exception");
+    }
+
+private:
+    MainLogger _logger;
+    std::unique_ptr<HostServerProcess> _process;
+};
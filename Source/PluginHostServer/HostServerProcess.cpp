@@ -0,0 +1,275 @@
+#include "HostServerProcess.h"
+
+HostServerProcess::HostServerProcess() : _audioThread(*this) {
+    _formatManager.addDefaultFormats();
+    _midiBuffer.ensureSize(Sandbox::MAX_MIDI_BYTES);
+}
+
+HostServerProcess::~HostServerProcess() {
+    stop();
+}
+
+void HostServerProcess::handleMessageFromMaster(const juce::MemoryBlock& message) {
+    Sandbox::MESSAGE_TYPE type;
+    juce::int32 requestId;
+    juce::MemoryBlock payload;
+    Sandbox::parseMessage(message, type, requestId, payload);
+
+    juce::MessageManager::callAsync([&, type, requestId, payload]() {
+        _handleRequest(type, requestId, payload);
+    });
+}
+
+void HostServerProcess::handleConnectionMade() {
+    juce::Logger::writeToLog("Connection made");
+}
+
+void HostServerProcess::handleConnectionLost() {
+    juce::Logger::writeToLog("Lost connection to client");
+    juce::MessageManager::callAsync([&]() {
+        stop();
+        juce::JUCEApplicationBase::quit();
+    });
+}
+
+void HostServerProcess::stop() {
+    _audioThread.stopThread(1000);
+    _plugin.reset();
+    _sharedBlock.reset();
+}
+
+void HostServerProcess::_handleRequest(Sandbox::MESSAGE_TYPE type, juce::int32 requestId, const juce::MemoryBlock& payload) {
+    juce::MemoryInputStream request(payload, false);
+    juce::MemoryOutputStream reply;
+
+    switch (type) {
+        case Sandbox::MESSAGE_TYPE::LOAD_PLUGIN:
+            _loadPlugin(request, reply);
+            break;
+        case Sandbox::MESSAGE_TYPE::SET_LAYOUT:
+            _setLayout(request, reply);
+            break;
+        case Sandbox::MESSAGE_TYPE::PREPARE:
+            _prepare(request, reply);
+            break;
+        case Sandbox::MESSAGE_TYPE::RELEASE:
+            _audioThread.stopThread(1000);
+            if (_plugin != nullptr) {
+                _plugin->releaseResources();
+            }
+            break;
+        case Sandbox::MESSAGE_TYPE::RESET:
+            if (_plugin != nullptr) {
+                _plugin->reset();
+            }
+            break;
+        case Sandbox::MESSAGE_TYPE::GET_STATE: {
+            juce::MemoryBlock state;
+            if (_plugin != nullptr) {
+                _plugin->getStateInformation(state);
+            }
+            Sandbox::writeMemoryBlock(reply, state);
+            break;
+        }
+        case Sandbox::MESSAGE_TYPE::SET_STATE: {
+            const juce::MemoryBlock state = Sandbox::readMemoryBlock(request);
+            if (_plugin != nullptr) {
+                _plugin->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+            }
+            _writeParameterValues(reply);
+            break;
+        }
+    }
+
+    sendMessageToMaster(Sandbox::createMessage(type, requestId, reply.getMemoryBlock()));
+}
+
+void HostServerProcess::_loadPlugin(juce::MemoryInputStream& request, juce::MemoryOutputStream& reply) {
+    std::unique_ptr<juce::XmlElement> descriptionXml = juce::parseXML(request.readString());
+    const double sampleRate {request.readDouble()};
+    const int blockSize {request.readInt()};
+
+    std::vector<juce::AudioProcessor::BusesLayout> layoutsToCheck;
+    const int numLayoutsToCheck {request.readInt()};
+    for (int layoutIndex {0}; layoutIndex < numLayoutsToCheck; layoutIndex++) {
+        layoutsToCheck.push_back(Sandbox::readLayout(request));
+    }
+
+    juce::PluginDescription description;
+    juce::String errorMessage;
+
+    if (descriptionXml != nullptr && description.loadFromXml(*descriptionXml)) {
+        juce::Logger::writeToLog("Loading plugin: " + description.name);
+        _plugin = _formatManager.createPluginInstance(description, sampleRate, blockSize, errorMessage);
+    } else {
+        errorMessage = "Failed to parse plugin description";
+    }
+
+    if (_plugin != nullptr) {
+        reply.writeBool(true);
+        Sandbox::writeLayout(reply, _plugin->getBusesLayout());
+        reply.writeDouble(_plugin->getTailLengthSeconds());
+        reply.writeBool(_plugin->acceptsMidi());
+        reply.writeBool(_plugin->producesMidi());
+        reply.writeInt(_plugin->getLatencySamples());
+
+        const juce::Array<juce::AudioProcessorParameter*>& parameters = _plugin->getParameters();
+        reply.writeInt(parameters.size());
+        for (juce::AudioProcessorParameter* parameter : parameters) {
+            reply.writeString(parameter->getName(100));
+            reply.writeString(parameter->getLabel());
+            reply.writeFloat(parameter->getDefaultValue());
+            reply.writeInt(parameter->getNumSteps());
+            reply.writeBool(parameter->isDiscrete());
+            reply.writeBool(parameter->isBoolean());
+            reply.writeFloat(parameter->getValue());
+
+            // Syndicate can't call the guest's getText() itself, so send it enough to look up
+            const int numTexts {juce::jlimit(2, Sandbox::MAX_PARAMETER_TEXTS, parameter->getNumSteps())};
+            reply.writeInt(numTexts);
+            for (int textIndex {0}; textIndex < numTexts; textIndex++) {
+                reply.writeString(parameter->getText(static_cast<float>(textIndex) / (numTexts - 1), 100));
+            }
+        }
+
+        // Only checks the layouts, they aren't applied until Syndicate sets one
+        for (const juce::AudioProcessor::BusesLayout& layout : layoutsToCheck) {
+            reply.writeBool(_plugin->checkBusesLayoutSupported(layout));
+        }
+    } else {
+        juce::Logger::writeToLog("Failed to load plugin: " + errorMessage);
+        reply.writeBool(false);
+        reply.writeString(errorMessage);
+    }
+}
+
+void HostServerProcess::_setLayout(juce::MemoryInputStream& request, juce::MemoryOutputStream& reply) {
+    const juce::AudioProcessor::BusesLayout layout = Sandbox::readLayout(request);
+
+    bool isLayoutSet {false};
+
+    if (_plugin != nullptr) {
+        // Layouts can't be changed while processing
+        _audioThread.stopThread(1000);
+
+        isLayoutSet = _plugin->setBusesLayout(layout);
+        if (isLayoutSet) {
+            _plugin->enableAllBuses();
+        }
+    }
+
+    reply.writeBool(isLayoutSet);
+}
+
+void HostServerProcess::_prepare(juce::MemoryInputStream& request, juce::MemoryOutputStream& reply) {
+    const juce::File sharedFile(request.readString());
+    const double sampleRate {request.readDouble()};
+    const int blockSize {request.readInt()};
+    const int numChannels {request.readInt()};
+
+    _audioThread.stopThread(1000);
+
+    if (_plugin != nullptr) {
+        const juce::Array<juce::AudioProcessorParameter*>& parameters = _plugin->getParameters();
+
+        _sharedBlock = std::make_unique<Sandbox::SharedAudioBlock>(sharedFile, numChannels, blockSize, parameters.size());
+
+        if (_sharedBlock->isValid()) {
+            // The guest processes in place on the output region
+            _channelPointers.clear();
+            for (int channel {0}; channel < numChannels; channel++) {
+                _channelPointers.push_back(_sharedBlock->getOutputChannel(channel));
+            }
+
+            _appliedParameterValues.clear();
+            for (juce::AudioProcessorParameter* parameter : parameters) {
+                _appliedParameterValues.push_back(parameter->getValue());
+            }
+
+            _plugin->setRateAndBufferSizeDetails(sampleRate, blockSize);
+            _plugin->prepareToPlay(sampleRate, blockSize);
+
+            _audioThread.startThread(9);
+        } else {
+            _sharedBlock.reset();
+        }
+
+        reply.writeInt(_plugin->getLatencySamples());
+    } else {
+        reply.writeInt(0);
+    }
+}
+
+void HostServerProcess::_writeParameterValues(juce::MemoryOutputStream& reply) {
+    if (_plugin != nullptr) {
+        const juce::Array<juce::AudioProcessorParameter*>& parameters = _plugin->getParameters();
+
+        reply.writeInt(parameters.size());
+        for (juce::AudioProcessorParameter* parameter : parameters) {
+            reply.writeFloat(parameter->getValue());
+        }
+    } else {
+        reply.writeInt(0);
+    }
+}
+
+void HostServerProcess::_processBlock() {
+    Sandbox::SharedHeader* header {_sharedBlock->getHeader()};
+    const int numSamples {std::min(static_cast<int>(header->numSamples), _sharedBlock->getMaxBlockSize())};
+    const int numChannels {_sharedBlock->getNumChannels()};
+
+    for (int channel {0}; channel < numChannels; channel++) {
+        juce::FloatVectorOperations::copy(_sharedBlock->getOutputChannel(channel), _sharedBlock->getInputChannel(channel), numSamples);
+    }
+
+    juce::AudioBuffer<float> buffer(_channelPointers.data(), numChannels, numSamples);
+
+    _midiBuffer.clear();
+    Sandbox::SharedAudioBlock::readMidi(_sharedBlock->getInputMidi(), header->numInputMidiBytes, _midiBuffer);
+
+    // Only pass on parameter changes, so the guest isn't flooded with updates
+    const juce::Array<juce::AudioProcessorParameter*>& parameters = _plugin->getParameters();
+    const float* inputParameters {_sharedBlock->getInputParameters()};
+    for (int parameterIndex {0}; parameterIndex < parameters.size(); parameterIndex++) {
+        if (inputParameters[parameterIndex] != _appliedParameterValues[parameterIndex]) {
+            parameters[parameterIndex]->setValue(inputParameters[parameterIndex]);
+            _appliedParameterValues[parameterIndex] = inputParameters[parameterIndex];
+        }
+    }
+
+    _plugin->processBlock(buffer, _midiBuffer);
+
+    header->numOutputMidiBytes = Sandbox::SharedAudioBlock::writeMidi(_midiBuffer, _sharedBlock->getOutputMidi());
+
+    float* outputParameters {_sharedBlock->getOutputParameters()};
+    for (int parameterIndex {0}; parameterIndex < parameters.size(); parameterIndex++) {
+        outputParameters[parameterIndex] = parameters[parameterIndex]->getValue();
+    }
+
+    header->latencySamples = _plugin->getLatencySamples();
+}
+
+void HostServerProcess::AudioThread::run() {
+    Sandbox::SharedHeader* header {_process._sharedBlock->getHeader()};
+
+    // Each prepare uses a new file, so the sequence always starts from zero
+    juce::uint32 lastSequence {0};
+    int numIdleChecks {0};
+
+    while (!threadShouldExit()) {
+        const juce::uint32 inputSequence {header->inputSequence.load(std::memory_order_acquire)};
+
+        if (inputSequence != lastSequence) {
+            _process._processBlock();
+            lastSequence = inputSequence;
+            header->outputSequence.store(inputSequence, std::memory_order_release);
+            numIdleChecks = 0;
+        } else if (numIdleChecks < NUM_SPIN_CHECKS) {
+            // Blocks usually arrive regularly, so keep checking for a while before sleeping
+            numIdleChecks++;
+            juce::Thread::yield();
+        } else {
+            juce::Thread::sleep(1);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "SandboxTransport.h"
+
+/**
+ * Loads a guest plugin on request from Syndicate and processes the blocks it writes to the shared
+ * file on a dedicated audio thread.
+ *
+ * Requests arrive on the connection's thread and are handled on the message thread, as most
+ * plugins expect to be created and configured there.
+ */
+class HostServerProcess : public juce::ChildProcessSlave {
+public:
+    HostServerProcess();
+    ~HostServerProcess();
+
+    void handleMessageFromMaster(const juce::MemoryBlock& message) override;
+
+    void handleConnectionMade() override;
+
+    void handleConnectionLost() override;
+
+    void stop();
+
+private:
+    /**
+     * Waits for Syndicate to signal a new block in the shared file and processes it.
+     */
+    class AudioThread : public juce::Thread {
+    public:
+        explicit AudioThread(HostServerProcess& process) : juce::Thread("Sandbox audio"), _process(process) {}
+        void run() override;
+
+    private:
+        HostServerProcess& _process;
+    };
+
+    // Number of times to check for a new block before falling back to sleeping between checks
+    static constexpr int NUM_SPIN_CHECKS {2000};
+
+    juce::AudioPluginFormatManager _formatManager;
+    std::unique_ptr<juce::AudioPluginInstance> _plugin;
+    std::unique_ptr<Sandbox::SharedAudioBlock> _sharedBlock;
+    std::vector<float*> _channelPointers;
+    std::vector<float> _appliedParameterValues;
+    juce::MidiBuffer _midiBuffer;
+    AudioThread _audioThread;
+
+    void _handleRequest(Sandbox::MESSAGE_TYPE type, juce::int32 requestId, const juce::MemoryBlock& payload);
+
+    void _loadPlugin(juce::MemoryInputStream& request, juce::MemoryOutputStream& reply);
+    void _setLayout(juce::MemoryInputStream& request, juce::MemoryOutputStream& reply);
+    void _prepare(juce::MemoryInputStream& request, juce::MemoryOutputStream& reply);
+    void _writeParameterValues(juce::MemoryOutputStream& reply);
+
+    /**
+     * Processes the block currently in the shared file, called on the audio thread.
+     */
+    void _processBlock();
+};
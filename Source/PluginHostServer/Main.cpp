@@ -0,0 +1,4 @@
+#include <JuceHeader.h>
+#include "HostServerApplication.h"
+
+START_JUCE_APPLICATION(HostServerApplication)
@@ -1,4 +1,5 @@
 #include "PluginScanJob.h"
+#include "Tracer.h"
 
 PluginScanJob::PluginScanJob(const juce::String& name,
                              juce::KnownPluginList& pluginList,
@@ -31,6 +32,7 @@ PluginScanJob::JobStatus PluginScanJob::runJob() {
         }
 
         // Scan the plugin
+        Tracer::Scope traceScope("scanPlugin", "scan");
         juce::Logger::writeToLog("[" + getJobName() + "] plugin #" + juce::String(_pluginList.getNumTypes()) + ": " + scanner.getNextPluginFileThatWillBeScanned());
         juce::String currentPluginName;
         isFinished = !scanner.scanNextFile(true, currentPluginName);
@@ -1,9 +1,17 @@
 #include "ServerProcess.h"
+#include "AllUtils.h"
+#include "Tracer.h"
 
 
-void ServerProcess::handleMessageFromMaster(const juce::MemoryBlock& /*block*/) {
-    // Log but do nothing
-    juce::Logger::writeToLog("Received message");
+void ServerProcess::handleMessageFromMaster(const juce::MemoryBlock& block) {
+    const juce::String message {block.toString()};
+    juce::Logger::writeToLog("Received message: " + message);
+
+    if (message == Utils::SCAN_SERVER_START_TRACE_MESSAGE) {
+        Tracer::getInstance().start("PluginScanServer");
+    } else if (message.startsWith(Utils::SCAN_SERVER_STOP_TRACE_MESSAGE)) {
+        Tracer::getInstance().stopAndExport(juce::File(message.fromFirstOccurrenceOf(Utils::SCAN_SERVER_STOP_TRACE_MESSAGE, false, false)));
+    }
 }
 
 void ServerProcess::handleConnectionMade() {
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+/**
+ * Holds up to CAPACITY modulation sources of one type, so they can be added and removed on the
+ * message thread while the audio thread (or any other thread processing the splitter) is using
+ * them.
+ *
+ * Sources are stored in a fixed pool of slots which is never reallocated. Their order, which
+ * determines the id of each ModulationSourceDefinition, is kept in an active list of slot indices.
+ * There are two copies of the active list: edits are made to the copy that isn't published, which is
+ * then published atomically. Readers access the sources through a ReadScope. A slot is only reset
+ * or reused once no ReadScope can still see it, so reading is lock-free and never allocates.
+ *
+ * Only one thread may make edits at a time. Usually this is the message thread, which can also read
+ * without a ReadScope as nothing else changes the list.
+ */
+template <typename T, int CAPACITY>
+class ModulationSourceRegistry {
+private:
+    struct ActiveList;
+
+public:
+    /**
+     * Gives access to the sources as they were when the scope was created. Keep these short lived,
+     * the message thread waits for them to be destroyed when a source is removed.
+     */
+    class ReadScope {
+    public:
+        explicit ReadScope(ModulationSourceRegistry& registry) :
+                _registry(registry), _list(registry._acquireList()) {}
+
+        ~ReadScope() { _list->numReaders.fetch_sub(1, std::memory_order_release); }
+
+        int size() const { return _list->size; }
+        T& operator[](int position) const { return _registry._slots[_list->slots[position]].value; }
+
+    private:
+        ModulationSourceRegistry& _registry;
+        ActiveList* _list;
+    };
+
+    ModulationSourceRegistry() : _publishedList(&_lists[0]) {}
+
+    /**
+     * Adds a source to the end of the list. Returns false if the registry is full.
+     */
+    bool add(T source) {
+        const int slot {_allocateSlot(std::move(source))};
+        if (slot < 0) {
+            return false;
+        }
+
+        ActiveList& newList = _getSpareList();
+        newList.slots[newList.size] = slot;
+        newList.size++;
+        _publish(newList);
+
+        return true;
+    }
+
+    /**
+     * Replaces the source at the given position. Returns false if the position is invalid or the
+     * registry is full, as the new source needs a slot of its own until the old one is released.
+     */
+    bool replace(int position, T source) {
+        if (position < 0 || position >= size()) {
+            return false;
+        }
+
+        const int slot {_allocateSlot(std::move(source))};
+        if (slot < 0) {
+            return false;
+        }
+
+        ActiveList& newList = _getSpareList();
+        const int oldSlot {newList.slots[position]};
+        newList.slots[position] = slot;
+        _publish(newList);
+        _releaseSlot(oldSlot);
+
+        return true;
+    }
+
+    /**
+     * Removes the source at the given position, later sources move up one position.
+     */
+    void remove(int position) {
+        if (position < 0 || position >= size()) {
+            return;
+        }
+
+        ActiveList& newList = _getSpareList();
+        const int oldSlot {newList.slots[position]};
+        for (int index {position}; index < newList.size - 1; index++) {
+            newList.slots[index] = newList.slots[index + 1];
+        }
+        newList.size--;
+        _publish(newList);
+        _releaseSlot(oldSlot);
+    }
+
+    void clear() {
+        while (size() > 0) {
+            remove(size() - 1);
+        }
+    }
+
+    /**
+     * Editing thread only, other threads need to use a ReadScope.
+     */
+    int size() const { return _publishedList.load()->size; }
+    T& operator[](int position) { return _slots[_publishedList.load()->slots[position]].value; }
+
+    static constexpr int getCapacity() { return CAPACITY; }
+
+private:
+    struct Slot {
+        T value {};
+        bool isInUse {false};
+    };
+
+    struct ActiveList {
+        std::array<int, CAPACITY> slots {};
+        int size {0};
+        std::atomic<int> numReaders {0};
+    };
+
+    std::array<Slot, CAPACITY> _slots;
+    std::array<ActiveList, 2> _lists;
+    std::atomic<ActiveList*> _publishedList;
+
+    ActiveList* _acquireList() {
+        // If the list is replaced between loading it and registering as a reader, the editing thread
+        // may not have seen this reader, so try again with the new list
+        while (true) {
+            ActiveList* list {_publishedList.load()};
+            list->numReaders.fetch_add(1);
+
+            if (_publishedList.load() == list) {
+                return list;
+            }
+
+            list->numReaders.fetch_sub(1);
+        }
+    }
+
+    /**
+     * Returns the unpublished list, initialised as a copy of the published one. No reader can be
+     * using it as _publish() waits for them to finish.
+     */
+    ActiveList& _getSpareList() {
+        ActiveList* publishedList {_publishedList.load()};
+        ActiveList& spareList = publishedList == &_lists[0] ? _lists[1] : _lists[0];
+
+        spareList.slots = publishedList->slots;
+        spareList.size = publishedList->size;
+
+        return spareList;
+    }
+
+    void _publish(ActiveList& newList) {
+        ActiveList* oldList {_publishedList.exchange(&newList)};
+
+        while (oldList->numReaders.load(std::memory_order_acquire) > 0) {
+            juce::Thread::yield();
+        }
+    }
+
+    int _allocateSlot(T value) {
+        for (int index {0}; index < CAPACITY; index++) {
+            if (!_slots[index].isInUse) {
+                _slots[index].value = std::move(value);
+                _slots[index].isInUse = true;
+                return index;
+            }
+        }
+
+        return -1;
+    }
+
+    void _releaseSlot(int index) {
+        // Reset here rather than when the slot is reused so the source is destroyed now
+        _slots[index].value = T();
+        _slots[index].isInUse = false;
+    }
+};
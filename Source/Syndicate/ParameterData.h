@@ -5,6 +5,8 @@
 #include "General/CoreMath.h"
 
 constexpr int NUM_MACROS {4};
+constexpr int MAX_NUM_LFOS {64};
+constexpr int MAX_NUM_ENVELOPES {64};
 
 const ParameterDefinition::RangedParameter<double> MACRO(0, 1, 0),
                                                    ENVELOPE_AMOUNT(-5, 5, 0),
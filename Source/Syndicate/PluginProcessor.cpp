@@ -17,47 +17,14 @@
 #include "PluginSplitterMidSide.h"
 #include "AllUtils.h"
 #include "PluginUtils.h"
+#include "SandboxedPluginInstance.h"
+#include "DspKernels.h"
+#include "Tracer.h"
 
 namespace {
     // Splitter
     const char* XML_SPLITTER_STR {"Splitter"};
     const char* XML_SPLIT_TYPE_STR {"SplitType"};
-    const char* XML_SPLIT_TYPE_SERIES_STR {"series"};
-    const char* XML_SPLIT_TYPE_PARALLEL_STR {"parallel"};
-    const char* XML_SPLIT_TYPE_MULTIBAND_STR {"multiband"};
-    const char* XML_SPLIT_TYPE_LEFTRIGHT_STR {"leftright"};
-    const char* XML_SPLIT_TYPE_MIDSIDE_STR {"midside"};
-
-    const char* splitTypeToString(SPLIT_TYPE splitType) {
-        switch (splitType) {
-            case SPLIT_TYPE::SERIES:
-                return XML_SPLIT_TYPE_SERIES_STR;
-            case SPLIT_TYPE::PARALLEL:
-                return XML_SPLIT_TYPE_PARALLEL_STR;
-            case SPLIT_TYPE::MULTIBAND:
-                return XML_SPLIT_TYPE_MULTIBAND_STR;
-            case SPLIT_TYPE::LEFTRIGHT:
-                return XML_SPLIT_TYPE_LEFTRIGHT_STR;
-            case SPLIT_TYPE::MIDSIDE:
-                return XML_SPLIT_TYPE_MIDSIDE_STR;
-        }
-    }
-
-    SPLIT_TYPE stringToSplitType(juce::String splitTypeString) {
-        SPLIT_TYPE retVal {SPLIT_TYPE::SERIES};
-
-        if (splitTypeString == XML_SPLIT_TYPE_PARALLEL_STR) {
-            retVal = SPLIT_TYPE::PARALLEL;
-        } else if (splitTypeString == XML_SPLIT_TYPE_MULTIBAND_STR) {
-            retVal = SPLIT_TYPE::MULTIBAND;
-        } else if (splitTypeString == XML_SPLIT_TYPE_LEFTRIGHT_STR) {
-            retVal = SPLIT_TYPE::LEFTRIGHT;
-        } else if (splitTypeString == XML_SPLIT_TYPE_MIDSIDE_STR) {
-            retVal = SPLIT_TYPE::MIDSIDE;
-        }
-
-        return retVal;
-    }
 
     // Modulation sources
     const char* XML_MODULATION_SOURCES_STR {"ModulationSources"};
@@ -86,6 +53,17 @@ namespace {
 
     const char* XML_MACRO_NAMES_STR {"MacroNames"};
 
+    const char* XML_ANTICIPATIVE_LATENCY_STR {"AnticipativeLatency"};
+    const char* XML_INTERNAL_BLOCK_SIZE_STR {"InternalBlockSize"};
+    const char* XML_SANDBOX_GUEST_PLUGINS_STR {"SandboxGuestPlugins"};
+    const char* XML_CPU_BUDGET_STR {"CpuBudget"};
+    const char* XML_CPU_FALLBACKS_STR {"CpuFallbacks"};
+    const char* XML_FLIGHT_RECORDER_THRESHOLD_STR {"FlightRecorderThreshold"};
+
+    const char* XML_SCENES_STR {"Scenes"};
+    const char* XML_CURRENT_SCENE_STR {"CurrentScene"};
+    const char* XML_SCENE_NAME_STR {"SceneName"};
+
     std::string getLfoXMLName(int lfoNumber) {
         std::string retVal("LFO_");
         retVal += std::to_string(lfoNumber);
@@ -103,6 +81,27 @@ namespace {
         retVal += juce::String(macroNumber);
         return retVal;
     }
+
+    juce::String getSceneXMLName(int sceneNumber) {
+        juce::String retVal("Scene_");
+        retVal += juce::String(sceneNumber);
+        return retVal;
+    }
+
+    juce::String getDefaultSceneName(int sceneNumber) {
+        return "Scene " + juce::String(sceneNumber + 1);
+    }
+
+    // Creates a splitter which takes over the chains of the previous splitter, or has the default
+    // chains if there isn't one
+    template <typename SplitterType, typename... Args>
+    std::unique_ptr<PluginSplitter> createSplitter(PluginSplitter* previousSplitter, Args... args) {
+        if (previousSplitter != nullptr) {
+            return std::make_unique<SplitterType>(previousSplitter->releaseChains(), args...);
+        }
+
+        return std::make_unique<SplitterType>(args...);
+    }
 }
 
 //==============================================================================
@@ -114,10 +113,67 @@ SyndicateAudioProcessor::SyndicateAudioProcessor() :
         _editor(nullptr),
         _splitType(SPLIT_TYPE::SERIES),
         _outputGainLinear(1),
-        _isSplitterInitialised(false)
+        _isSplitterInitialised(false),
+        _isSplitterSuspended(false),
+        _shouldSandboxGuestPlugins(false),
+        _chainParametersApplier(*this),
+        _cpuFallbackApplier(*this),
+        _chainWaker(*this),
+        _reportContextUpdater(*this),
+        _currentScene(0),
+        _outgoingScene(-1),
+        _sceneFadeLength(0),
+        _sceneFadeSamplesRemaining(0),
+        _isSceneFadeThroughSilence(false),
+        _sceneFadeCompleter(*this),
+        _pendingScene(-1),
+        _sceneSwitcher(*this),
+        _modulationRateDivider(1),
+        _nextModulationSample(0),
+        _blockModulationValues(nullptr),
+        _appliedCpuGovernorLevel(0),
+        _flightRecorder(Utils::PluginLogDirectory),
+        _workerPool(WorkerPool::getShared()),
+        _fixedBlockProcessor([&](juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, juce::AudioPlayHead* playHead) {
+            _processSplitter(buffer, midiMessages, playHead);
+        }),
+        _anticipativeProcessor(
+            [&](juce::AudioBuffer<float>& buffer,
+                juce::MidiBuffer& midiMessages,
+                juce::AudioPlayHead* playHead,
+                const std::vector<float>* modulationValues) {
+                _blockModulationValues = modulationValues;
+                _fixedBlockProcessor.process(buffer, midiMessages, playHead);
+                _blockModulationValues = nullptr;
+            },
+            [&](std::vector<float>& values) { _saveModulationValues(values); },
+            NUM_MODULATION_VALUES)
 {
     juce::Logger::setCurrentLogger(&_logger);
 
+    // Select and self test the DSP kernels now rather than on the first audio block
+    DspKernels::get();
+
+    // Called when a deadline miss report is written, only reads the copy of the graph description
+    // made on the message thread so it never walks the splitter while it's being changed
+    _flightRecorder.setReportContextCallback([&]() {
+        FlightRecorder::ReportContext context;
+
+        {
+            const juce::ScopedLock lock(_reportContextMutex);
+            context = _graphReportContext;
+        }
+
+        context.description = "Internal block size: " + juce::String(getInternalBlockSize()) + "\n"
+            + "Anticipative latency: " + juce::String(getAnticipativeLatency()) + "\n"
+            + "Reported latency: " + juce::String(getLatencySamples()) + "\n"
+            + "CPU governor level " + juce::String(_cpuGovernor.getLevel()) + " at load " + juce::String(_cpuGovernor.getLoad(), 2) + "\n"
+            + "DSP kernels: " + DspKernels::isaToString(DspKernels::get().isa) + "\n\n"
+            + context.description;
+
+        return context;
+    });
+
     constexpr float PRECISION {0.01f};
     registerPrivateParameter(_splitterParameters, "SplitterParameters");
 
@@ -136,7 +192,9 @@ SyndicateAudioProcessor::SyndicateAudioProcessor() :
     // Make sure everything is initialised
     _splitterParameters->setProcessor(this);
     setSplitType(SPLIT_TYPE::SERIES);
-    chainParameters.emplace_back([&]() { _splitterParameters->triggerUpdate(); });
+    _graphChangeNotifier.addListener(&_reportContextUpdater);
+    _updateReportContext();
+    chainParameters.emplace_back([&](const ChainParameters& params) { _onChainParametersUpdate(params); });
     _onParameterUpdate();
     pluginScanClient.restore();
 
@@ -144,16 +202,16 @@ SyndicateAudioProcessor::SyndicateAudioProcessor() :
         macroNames[index] = "Macro " + juce::String(index + 1);
     }
 
-    for (auto& env : meterEnvelopes) {
-        env.setAttackTimeMs(1);
-        env.setReleaseTimeMs(50);
-        env.setFilterEnabled(false);
+    for (int index {0}; index < _scenes.size(); index++) {
+        _scenes[index].name = getDefaultSceneName(index);
     }
 }
 
 SyndicateAudioProcessor::~SyndicateAudioProcessor()
 {
     pluginScanClient.stopScan();
+    _graphChangeNotifier.removeListener(&_reportContextUpdater);
+    _reportContextUpdater.cancelPendingUpdate();
 
     // Logger must be removed before being deleted
     // (this must be the last thing we do before exiting)
@@ -200,26 +258,37 @@ double SyndicateAudioProcessor::getTailLengthSeconds() const
 
 int SyndicateAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return NUM_SCENES;
 }
 
 int SyndicateAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    // The host expects to see the program it set even if it hasn't been switched to yet
+    const int pendingScene {_pendingScene.load()};
+    return pendingScene >= 0 ? pendingScene : getCurrentScene();
 }
 
 void SyndicateAudioProcessor::setCurrentProgram (int index)
 {
+    // Some hosts change program on the audio thread, and switching scenes may need to instantiate
+    // plugins
+    _pendingScene.store(index);
+
+    if (juce::MessageManager::existsAndIsCurrentThread()) {
+        _switchToPendingScene();
+    } else {
+        _sceneSwitcher.triggerAsyncUpdate();
+    }
 }
 
 const juce::String SyndicateAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return getSceneName(index);
 }
 
 void SyndicateAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    setSceneName(index, newName);
 }
 
 //==============================================================================
@@ -229,17 +298,28 @@ void SyndicateAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBl
     // initialisation that you need..
 
     // Update the modulation sources
-    for (std::shared_ptr<WECore::Richter::RichterLFO> lfo : lfos) {
-        lfo->setSampleRate(sampleRate);
-    }
+    {
+        LfoRegistry::ReadScope lfoScope(lfos);
+        for (int index {0}; index < lfoScope.size(); index++) {
+            lfoScope[index]->setSampleRate(sampleRate);
+        }
 
-    for (EnvelopeFollowerWrapper& env : envelopes) {
-        env.envelope->setSampleRate(sampleRate);
+        EnvelopeRegistry::ReadScope envelopeScope(envelopes);
+        for (int index {0}; index < envelopeScope.size(); index++) {
+            envelopeScope[index].envelope->setSampleRate(sampleRate);
+        }
     }
 
-    for (auto& env : meterEnvelopes) {
-        env.setSampleRate(sampleRate);
-    }
+    outputGainPanMeter.prepareToPlay(sampleRate);
+
+    // The governor starts again at full quality, the modulation sources have just been set to the
+    // full sample rate
+    _cpuGovernor.prepareToPlay(sampleRate);
+    _modulationRateDivider = 1;
+    _nextModulationSample = 0;
+    _cpuFallbackApplier.triggerAsyncUpdate();
+
+    _flightRecorder.prepareToPlay(sampleRate, samplesPerBlock);
 
     // Set the bus layout before calling prepare to play, the splitter will need the buses to be
     // correct before then
@@ -250,8 +330,25 @@ void SyndicateAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBl
     }
 
     if (pluginSplitter != nullptr) {
-        pluginSplitter->prepareToPlay(sampleRate, samplesPerBlock);
+        pluginSplitter->prepareToPlay(sampleRate, _getSplitterBlockSize());
     }
+
+    // The other scenes are kept prepared so they can be switched to at any time
+    _forEachSceneSplitter([&](PluginSplitter& splitter) {
+        splitter.setBusesLayout(getBusesLayout());
+        splitter.prepareToPlay(sampleRate, _getSplitterBlockSize());
+    });
+
+    // The splitter is given blocks of at most the internal block size, or the host's block size
+    _sceneFadeBuffer.setSize(std::max(getTotalNumInputChannels(), getTotalNumOutputChannels()),
+                             std::max(samplesPerBlock, _getSplitterBlockSize()));
+    _sceneFadeMidi.ensureSize(2048);
+
+    _fixedBlockProcessor.prepare(sampleRate, getTotalNumInputChannels());
+    _anticipativeProcessor.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels(), getMainBusNumOutputChannels());
+
+    // The anticipative latency can't be less than the host's block size
+    _onLatencyChange();
 }
 
 void SyndicateAudioProcessor::releaseResources()
@@ -263,20 +360,22 @@ void SyndicateAudioProcessor::releaseResources()
         pluginSplitter->releaseResources();
     }
 
+    _forEachSceneSplitter([](PluginSplitter& splitter) { splitter.releaseResources(); });
+
     _resetModulationSources();
 }
 
 void SyndicateAudioProcessor::reset() {
     _resetModulationSources();
 
-    for (auto& env : meterEnvelopes) {
-        env.reset();
-    }
+    outputGainPanMeter.reset();
 
     WECore::AudioSpinLock lock(pluginSplitterMutex);
     if (pluginSplitter != nullptr) {
         pluginSplitter->reset();
     }
+
+    _forEachSceneSplitter([](PluginSplitter& splitter) { splitter.reset(); });
 }
 
 bool SyndicateAudioProcessor::isBusesLayoutSupported(const BusesLayout& layout) const {
@@ -293,6 +392,13 @@ bool SyndicateAudioProcessor::isBusesLayoutSupported(const BusesLayout& layout)
 
 void SyndicateAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    Tracer::Scope traceScope("processBlock", "audio");
+    const juce::int64 blockStartTicks {juce::Time::getHighResolutionTicks()};
+
+    // Record the stages of this block in case it misses its deadline
+    FlightRecorder::ThreadScope recorderScope(&_flightRecorder);
+    _flightRecorder.beginBlock();
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -306,76 +412,132 @@ void SyndicateAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // Send tempo and playhead information to the LFOs
-    juce::AudioPlayHead::CurrentPositionInfo mTempoInfo;
-    getPlayHead()->getCurrentPosition(mTempoInfo);
-    for (std::shared_ptr<WECore::Richter::RichterLFO>& lfo : lfos) {
-        lfo->prepareForNextBuffer(mTempoInfo.bpm, mTempoInfo.timeInSeconds);
-    }
+    // While the CPU governor has reduced the modulation rate the sources are advanced every few
+    // samples at a correspondingly lower sample rate. The rate is set every block while reduced,
+    // since a source may have been added at the full rate since the last one.
+    const int modulationRateDivider {
+        _cpuGovernor.isFallbackActive(CPU_FALLBACK::REDUCED_MODULATION_RATE) ? CpuGovernor::REDUCED_MODULATION_RATE_DIVIDER : 1
+    };
+    const bool shouldSetModulationSampleRate {modulationRateDivider > 1 || _modulationRateDivider > 1};
+    const double modulationSampleRate {getSampleRate() / modulationRateDivider};
+    _modulationRateDivider = modulationRateDivider;
+
+    // Continue from where the last block left off so the rate doesn't depend on the block size
+    const int firstModulationSample {std::min(_nextModulationSample, modulationRateDivider - 1)};
+
+    {
+        FlightRecorder::StageTimer modulationTimer(FLIGHT_STAGE::MODULATION_SOURCES);
+
+        // Sources may be added or removed by the message thread at any time, so only use the ones
+        // in this scope
+        LfoRegistry::ReadScope lfoScope(lfos);
+
+        if (shouldSetModulationSampleRate) {
+            for (int index {0}; index < lfoScope.size(); index++) {
+                lfoScope[index]->setSampleRate(modulationSampleRate);
+            }
+        }
+
+        // Send tempo and playhead information to the LFOs
+        juce::AudioPlayHead::CurrentPositionInfo mTempoInfo;
+        getPlayHead()->getCurrentPosition(mTempoInfo);
+        for (int index {0}; index < lfoScope.size(); index++) {
+            lfoScope[index]->prepareForNextBuffer(mTempoInfo.bpm, mTempoInfo.timeInSeconds);
+        }
 
-    // Advance the modulation sources
-    // (the envelopes need to be done now before we overwrite the buffer)
-    for (std::shared_ptr<WECore::Richter::RichterLFO>& lfo : lfos) {
-        for (int sampleIndex {0}; sampleIndex < buffer.getNumSamples(); sampleIndex++) {
-            lfo->getNextOutput(0);
+        // Advance the modulation sources
+        // (the envelopes need to be done now before we overwrite the buffer)
+        for (int index {0}; index < lfoScope.size(); index++) {
+            for (int sampleIndex {firstModulationSample}; sampleIndex < buffer.getNumSamples(); sampleIndex += modulationRateDivider) {
+                lfoScope[index]->getNextOutput(0);
+            }
         }
     }
 
-    // TODO this could be faster
-    for (EnvelopeFollowerWrapper& env : envelopes) {
-        // Figure out which channels we need to be looking at
-        int startChannel {0};
-        int endChannel {0};
+    {
+        FlightRecorder::StageTimer modulationTimer(FLIGHT_STAGE::MODULATION_SOURCES);
 
-        if (env.useSidechainInput) {
-            startChannel = getMainBusNumInputChannels();
-            endChannel = totalNumInputChannels;
-        } else {
-            startChannel = 0;
-            endChannel = getMainBusNumInputChannels();
-        }
+        // TODO this could be faster
+        EnvelopeRegistry::ReadScope envelopeScope(envelopes);
+        for (int envIndex {0}; envIndex < envelopeScope.size(); envIndex++) {
+            EnvelopeFollowerWrapper& env = envelopeScope[envIndex];
 
-        for (int sampleIndex {0}; sampleIndex < buffer.getNumSamples(); sampleIndex++) {
-            // Average the samples across all channels
-            float averageSample {0};
-            for (int channelIndex {startChannel}; channelIndex < endChannel; channelIndex++) {
-                averageSample += buffer.getReadPointer(channelIndex)[sampleIndex];
+            // Envelopes with their filter enabled stay at the full rate, the filter cutoffs could be
+            // above the reduced Nyquist frequency
+            const bool isReducedRate {modulationRateDivider > 1 && !env.envelope->getFilterEnabled()};
+            const int envelopeFirstSample {isReducedRate ? firstModulationSample : 0};
+            const int envelopeStep {isReducedRate ? modulationRateDivider : 1};
+
+            if (shouldSetModulationSampleRate) {
+                env.envelope->setSampleRate(isReducedRate ? modulationSampleRate : getSampleRate());
+            }
+
+            // Figure out which channels we need to be looking at
+            int startChannel {0};
+            int endChannel {0};
+
+            if (env.useSidechainInput) {
+                startChannel = getMainBusNumInputChannels();
+                endChannel = totalNumInputChannels;
+            } else {
+                startChannel = 0;
+                endChannel = getMainBusNumInputChannels();
             }
-            averageSample /= totalNumInputChannels;
 
-            env.envelope->getNextOutput(averageSample);
+            for (int sampleIndex {envelopeFirstSample}; sampleIndex < buffer.getNumSamples(); sampleIndex += envelopeStep) {
+                // Average the samples across all channels
+                float averageSample {0};
+                for (int channelIndex {startChannel}; channelIndex < endChannel; channelIndex++) {
+                    averageSample += buffer.getReadPointer(channelIndex)[sampleIndex];
+                }
+                averageSample /= totalNumInputChannels;
+
+                env.envelope->getNextOutput(averageSample);
+            }
         }
     }
 
-
-    // Pass the audio through the splitter
     {
-        WECore::AudioSpinTryLock lock(pluginSplitterMutex);
-        if (lock.isLocked() && pluginSplitter != nullptr) {
-            pluginSplitter->processBlock(buffer, midiMessages);
-        }
+        // Pass the audio through the splitter, this may happen ahead of time on another thread
+        FlightRecorder::StageTimer splitterTimer(FLIGHT_STAGE::SPLITTER);
+        _anticipativeProcessor.process(buffer, midiMessages, getPlayHead());
     }
 
-    // Apply the output gain
-    for (int channel {0}; channel < getMainBusNumInputChannels(); channel++)
     {
-        juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel),
-                                              _outputGainLinear,
-                                              buffer.getNumSamples());
+        // Apply the output gain and balance (balance only with stereo input) and update the meters
+        // in one pass, the parameters are read once so the whole block uses the same values
+        FlightRecorder::StageTimer outputTimer(FLIGHT_STAGE::OUTPUT);
+        outputGainPanMeter.process(buffer,
+                                   getMainBusNumInputChannels(),
+                                   _outputGainLinear.load(),
+                                   canDoStereoSplitTypes() ? outputPan->get() : 0.0f);
     }
 
-    // Apply the output pan
-    if (canDoStereoSplitTypes()) {
-        // Stereo input - apply balance
-        Utils::processBalance(outputPan->get(), buffer);
+    // Work out where the modulation sources need to continue from in the next block
+    const int numSamples {buffer.getNumSamples()};
+    if (firstModulationSample < numSamples) {
+        const int numModulationSamples {(numSamples - 1 - firstModulationSample) / modulationRateDivider + 1};
+        _nextModulationSample = firstModulationSample + numModulationSamples * modulationRateDivider - numSamples;
+    } else {
+        _nextModulationSample = firstModulationSample - numSamples;
     }
 
-    // After processing everything, update the meter envelopes
-    for (int sampleIndex {0}; sampleIndex < buffer.getNumSamples(); sampleIndex++) {
-        for (int channel {0}; channel < std::min(getMainBusNumInputChannels(), static_cast<int>(meterEnvelopes.size())); channel++) {
-            meterEnvelopes[channel].getNextOutput(buffer.getReadPointer(channel)[sampleIndex]);
+    // Let the governor know how much of the block's time was used
+    const double processingSeconds {
+        juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks)
+    };
+
+    if (isNonRealtime()) {
+        // Offline renders can take as long as they need, so always render at full quality
+        if (_cpuGovernor.getLevel() > 0) {
+            _cpuGovernor.reset();
+            _cpuFallbackApplier.triggerAsyncUpdate();
         }
+    } else if (_cpuGovernor.onBlockProcessed(processingSeconds, numSamples)) {
+        _cpuFallbackApplier.triggerAsyncUpdate();
     }
+
+    _flightRecorder.endBlock(numSamples);
 }
 
 //==============================================================================
@@ -393,162 +555,188 @@ float SyndicateAudioProcessor::getModulationValueForSource(int id, MODULATION_TY
     // TODO This method may be called multiple times for each buffer, could be optimised
     const int index {id - 1};
 
+    // A block processed ahead of time uses the values from when it arrived, the sources have moved
+    // on since
+    const std::vector<float>* blockValues {_blockModulationValues};
+    if (blockValues != nullptr) {
+        switch (type) {
+            case MODULATION_TYPE::MACRO:
+                if (index < NUM_MACROS) {
+                    return (*blockValues)[index];
+                }
+                break;
+            case MODULATION_TYPE::LFO:
+                if (index < MAX_NUM_LFOS) {
+                    return (*blockValues)[NUM_MACROS + index];
+                }
+                break;
+            case MODULATION_TYPE::ENVELOPE:
+                if (index < MAX_NUM_ENVELOPES) {
+                    return (*blockValues)[NUM_MACROS + MAX_NUM_LFOS + index];
+                }
+                break;
+        };
+
+        return 0.0f;
+    }
+
     switch (type) {
         case MODULATION_TYPE::MACRO:
             if (index < macros.size()) {
                 return macros[index]->get();
             }
             break;
-        case MODULATION_TYPE::LFO:
-            if (index < lfos.size()) {
-                return lfos[index]->getLastOutput();
+        case MODULATION_TYPE::LFO: {
+            LfoRegistry::ReadScope lfoScope(lfos);
+            if (index < lfoScope.size()) {
+                return lfoScope[index]->getLastOutput();
             }
             break;
-        case MODULATION_TYPE::ENVELOPE:
-            if (index < envelopes.size()) {
-                return envelopes[index].envelope->getLastOutput() * envelopes[index].amount;
+        }
+        case MODULATION_TYPE::ENVELOPE: {
+            EnvelopeRegistry::ReadScope envelopeScope(envelopes);
+            if (index < envelopeScope.size()) {
+                return envelopeScope[index].envelope->getLastOutput() * envelopeScope[index].amount;
             }
             break;
+        }
     };
 
     return 0.0f;
 }
 
-void SyndicateAudioProcessor::addLfo() {
+bool SyndicateAudioProcessor::addLfo() {
     std::shared_ptr<WECore::Richter::RichterLFO> newLfo {new WECore::Richter::RichterLFO()};
     newLfo->setBypassSwitch(true);
     newLfo->setSampleRate(getSampleRate());
-    lfos.push_back(newLfo);
+
+    if (!lfos.add(newLfo)) {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::addLfo: Can't add more than " + juce::String(MAX_NUM_LFOS) + " LFOs");
+        return false;
+    }
+
+    return true;
 }
 
-void SyndicateAudioProcessor::addEnvelope() {
+bool SyndicateAudioProcessor::addEnvelope() {
     std::shared_ptr<WECore::AREnv::AREnvelopeFollowerSquareLaw> newEnv {new WECore::AREnv::AREnvelopeFollowerSquareLaw()};
     newEnv->setSampleRate(getSampleRate());
-    envelopes.push_back({newEnv, 0});
-}
 
-void SyndicateAudioProcessor::removeModulationSource(ModulationSourceDefinition definition) {
-    // Remove the source from the processor
-    if (definition.type == MODULATION_TYPE::LFO) {
-        const int index {definition.id - 1};
-        if (lfos.size() > index) {
-            lfos.erase(lfos.begin() + index);
-        }
-    } else if (definition.type == MODULATION_TYPE::ENVELOPE) {
-        const int index {definition.id - 1};
-        if (envelopes.size() > index) {
-            envelopes.erase(envelopes.begin() + index);
-        }
-    }
-
-    // Iterate through each plugin, remove the source if it has been assigned an renumber ones that
-    // are numbered higher
-    for (PluginChainWrapper& chain : pluginSplitter->getChains()) {
-        for (int slotIndex {0}; slotIndex < chain.chain->getNumSlots(); slotIndex++) {
-            PluginModulationConfig thisPluginConfig = chain.chain->getPluginModulationConfig(slotIndex);
-
-            // Iterate through each configured parameter
-            for (PluginParameterModulationConfig& parameterConfig : thisPluginConfig.parameterConfigs) {
-                bool needsToDelete {false};
-                int indexToDelete {0};
-
-                // Iterate through each configured source
-                for (int sourceIndex {0}; sourceIndex < parameterConfig.sources.size(); sourceIndex++) {
-                    PluginParameterModulationSource& thisSource = parameterConfig.sources[sourceIndex];
-
-                    if (thisSource.definition == definition) {
-                        // We need to come back and delete this one
-                        needsToDelete = true;
-                        indexToDelete = sourceIndex;
-                    } else if (thisSource.definition.type == definition.type &&
-                                thisSource.definition.id > definition.id) {
-                        // We need to renumber this one
-                        thisSource.definition.id--;
-                    }
-                }
+    if (!envelopes.add({newEnv, 0})) {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::addEnvelope: Can't add more than " + juce::String(MAX_NUM_ENVELOPES) + " envelopes");
+        return false;
+    }
 
-                if (needsToDelete) {
-                    parameterConfig.sources.erase(parameterConfig.sources.begin() + indexToDelete);
-                }
-            }
+    return true;
+}
 
-            chain.chain->setPluginModulationConfig(thisPluginConfig, slotIndex);
+void SyndicateAudioProcessor::removeModulationSource(ModulationSourceDefinition definition) {
+    {
+        // Sources are looked up by position, so while the plugins are being renumbered some of them
+        // would get the value of the wrong source. Nothing is looked up while the splitter is
+        // suspended, so it stays suspended until the plugins and the list of sources agree again.
+        SplitterSuspendScope suspendScope(*this);
+
+        // Remove the source from every plugin it has been assigned to and renumber ones that are
+        // numbered higher, this includes hibernated chains and the other scenes as they use the
+        // same sources
+        pluginSplitter->removeModulationSource(definition);
+        _forEachSceneSplitter([&](PluginSplitter& splitter) { splitter.removeModulationSource(definition); });
+
+        // Remove the source from the processor, this waits until the audio thread has stopped
+        // using it
+        if (definition.type == MODULATION_TYPE::LFO) {
+            lfos.remove(definition.id - 1);
+        } else if (definition.type == MODULATION_TYPE::ENVELOPE) {
+            envelopes.remove(definition.id - 1);
         }
     }
 
     // Make sure any changes to assigned sources are reflected in the UI
-    if (_editor != nullptr) {
-        _editor->needsGraphRebuild();
-    }
+    _notifyGraphRebuild();
 }
 
 void SyndicateAudioProcessor::setSplitType(SPLIT_TYPE splitType) {
-    WECore::AudioSpinLock lock(pluginSplitterMutex);
-
     if (!_isSplitterInitialised) {
+        WECore::AudioSpinLock lock(pluginSplitterMutex);
+        const juce::ScopedLock pointerLock(_splitterPointerMutex);
         pluginSplitter.reset(new PluginSplitterSeries([&](int id, MODULATION_TYPE type) {return getModulationValueForSource(id, type);}));
         pluginSplitter->addListener(this);
     }
 
     if (splitType != _splitType || !_isSplitterInitialised) {
-        _splitType = splitType;
-        _isSplitterInitialised = true;
+        const HostConfiguration configuration {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()};
+
+        // Switching between split types that do and don't run their chains in mono means the
+        // plugins need reconfiguring, which can't be done while they're processed. Instead the
+        // chains are hibernated as they're handed over and woken with the new layout afterwards.
+        // Their states are stored now, while the current splitter carries on processing them.
+        std::map<int, std::unique_ptr<juce::XmlElement>> chainStates;
+        if (pluginSplitter != nullptr &&
+                configuration.layout.getMainInputChannels() == 2 &&
+                canSplitTypeUseMonoChains(splitType) != pluginSplitter->canUseMonoChains()) {
+            chainStates = pluginSplitter->createChainStates();
+        }
 
-        switch (splitType) {
-            case SPLIT_TYPE::SERIES:
-                pluginSplitter.reset(new PluginSplitterSeries(pluginSplitter->releaseChains(),
-                                     [&](int id, MODULATION_TYPE type) {return getModulationValueForSource(id, type);}));
-                break;
-            case SPLIT_TYPE::PARALLEL:
-                pluginSplitter.reset(new PluginSplitterParallel(pluginSplitter->releaseChains(),
-                                     [&](int id, MODULATION_TYPE type) {return getModulationValueForSource(id, type);}));
-                break;
-            case SPLIT_TYPE::MULTIBAND:
-                pluginSplitter.reset(new PluginSplitterMultiband(pluginSplitter->releaseChains(),
-                                     [&](int id, MODULATION_TYPE type) {return getModulationValueForSource(id, type);},
-                                     canDoStereoSplitTypes()));
-                break;
-            case SPLIT_TYPE::LEFTRIGHT:
-                if (canDoStereoSplitTypes()) {
-                    pluginSplitter.reset(new PluginSplitterLeftRight(pluginSplitter->releaseChains(),
-                                         [&](int id, MODULATION_TYPE type) {return getModulationValueForSource(id, type);}));
-                } else {
-                    juce::Logger::writeToLog("SyndicateAudioProcessor::setSplitType: Attempted to use left/right split while not in 2in2out configuration");
-                    assert(false);
-                }
-                break;
-            case SPLIT_TYPE::MIDSIDE:
-                if (canDoStereoSplitTypes()) {
-                    pluginSplitter.reset(new PluginSplitterMidSide(pluginSplitter->releaseChains(),
-                                         [&](int id, MODULATION_TYPE type) {return getModulationValueForSource(id, type);}));
-                } else {
-                    juce::Logger::writeToLog("SyndicateAudioProcessor::setSplitType: Attempted to use mid/side split while not in 2in2out configuration");
-                    assert(false);
-                }
-                break;
+        std::shared_ptr<PluginSplitter> previousSplitter;
+        std::vector<std::unique_ptr<ChainSlotBase>> hibernatedSlots;
+
+        {
+            // The new splitter takes over the chains and is swapped in within a single lock. Only
+            // the chains without any plugins have their layouts configured here, and the chains
+            // carried over from the old splitter are already prepared, so preparing only sets up
+            // the splitter's own buffers and plan.
+            WECore::AudioSpinLock lock(pluginSplitterMutex);
+            const juce::ScopedLock pointerLock(_splitterPointerMutex);
+
+            std::unique_ptr<PluginSplitter> newSplitter = _createSplitter(splitType, pluginSplitter.get());
+            if (newSplitter == nullptr) {
+                return;
+            }
+
+            hibernatedSlots = newSplitter->hibernateChains(std::move(chainStates));
+            newSplitter->configureEmptyChainLayouts(configuration, pluginConfigurator);
+
+            // Make sure prepareToPlay has been called on the splitter as we don't actually know if the host
+            // will call it via the PluginProcessor
+            newSplitter->prepareToPlayIfNeeded(getSampleRate(), _getSplitterBlockSize());
+
+            newSplitter->addListener(this);
+            newSplitter->setWorkerPool(_workerPool.get());
+
+            previousSplitter = std::move(pluginSplitter);
+            pluginSplitter = std::move(newSplitter);
+            _splitType = splitType;
+            _isSplitterInitialised = true;
         }
 
+        // The previous splitter no longer has any chains, and the plugins of the hibernated chains
+        // are deleted outside the lock
+        previousSplitter.reset();
+        hibernatedSlots.clear();
+
+        // The new splitter doesn't process any chains beyond the ones it needs, so their plugins can
+        // be deleted while it's processing
+        pluginSplitter->hibernateUnusedChains();
+
+        // The slots of the hibernated chains have been deleted, so the history no longer applies
+        _graphHistory.clear();
+
+        // Chains carried over from a split type that didn't use them, or that need a different
+        // layout, pass audio through until they're woken
+        _chainWaker.triggerAsyncUpdate();
+
         // Add chain parameters if needed
         while (chainParameters.size() < pluginSplitter->getNumChains()) {
-            chainParameters.emplace_back([&]() { _splitterParameters->triggerUpdate(); });
-        }
-
-        // Make sure prepareToPlay has been called on the splitter as we don't actually know if the host
-        // will call it via the PluginProcessor
-        if (pluginSplitter != nullptr) {
-            pluginSplitter->prepareToPlay(getSampleRate(), getBlockSize());
+            chainParameters.emplace_back([&](const ChainParameters& params) { _onChainParametersUpdate(params); });
         }
 
-        pluginSplitter->addListener(this);
+        // The new splitter needs the CPU governor's fallbacks applying
+        _cpuFallbackApplier.triggerAsyncUpdate();
 
         // For graph state changes we need to make sure the processor has updated its state first,
         // then the UI can rebuild based on the processor state
-        if (_editor != nullptr) {
-            // Need to unlock the mutex first since methods called from needsGraphRebuild() will
-            // need to lock it
-            lock.unlock();
-            _editor->needsGraphRebuild();
-        }
+        _notifyGraphRebuild();
     }
 }
 
@@ -559,11 +747,9 @@ void SyndicateAudioProcessor::addParallelChain() {
     if (parallelSplitter != nullptr) {
         if (parallelSplitter->addChain()) {
             lock.unlock();
-            chainParameters.emplace_back([&]() { _splitterParameters->triggerUpdate(); });
+            chainParameters.emplace_back([&](const ChainParameters& params) { _onChainParametersUpdate(params); });
 
-            if (_editor != nullptr) {
-                _editor->needsGraphRebuild();
-            }
+            _notifyGraphRebuild();
         }
     }
 }
@@ -577,9 +763,7 @@ void SyndicateAudioProcessor::removeParallelChain(int chainNumber) {
             lock.unlock();
             chainParameters.erase(chainParameters.begin() + chainNumber);
 
-            if (_editor != nullptr) {
-                _editor->needsGraphRebuild();
-            }
+            _notifyGraphRebuild();
         }
     }
 }
@@ -591,11 +775,9 @@ void SyndicateAudioProcessor::addCrossoverBand() {
     if (multibandSplitter != nullptr) {
         if (multibandSplitter->addBand()) {
             lock.unlock();
-            chainParameters.emplace_back([&]() { _splitterParameters->triggerUpdate(); });
+            chainParameters.emplace_back([&](const ChainParameters& params) { _onChainParametersUpdate(params); });
 
-            if (_editor != nullptr) {
-                _editor->needsGraphRebuild();
-            }
+            _notifyGraphRebuild();
         }
     }
 }
@@ -609,33 +791,34 @@ void SyndicateAudioProcessor::removeCrossoverBand() {
             lock.unlock();
             chainParameters.erase(chainParameters.begin() + chainParameters.size() - 1);
 
-            if (_editor != nullptr) {
-                _editor->needsGraphRebuild();
-            }
+            _notifyGraphRebuild();
         }
     }
 }
 
 void SyndicateAudioProcessor::setCrossoverFrequency(size_t index, float val) {
-    WECore::AudioSpinLock lock(pluginSplitterMutex);
-    PluginSplitterMultiband* multibandSplitter = dynamic_cast<PluginSplitterMultiband*>(pluginSplitter.get());
+    // The splitter smooths the change on the audio thread, so this doesn't need the audio lock
+    std::shared_ptr<PluginSplitter> splitter = _getSplitter();
+    PluginSplitterMultiband* multibandSplitter = dynamic_cast<PluginSplitterMultiband*>(splitter.get());
 
     if (multibandSplitter != nullptr) {
         if (index < multibandSplitter->getNumBands() - 1) {
 
             // Changing the frequency of one crossover may affect others if they also need to be
             // moved - so we set the splitter first, it will update all the frequencies internally,
-            // then update the parameter
+            // then update the UI
             multibandSplitter->setCrossoverFrequency(index, val);
-            lock.unlock();
-            _splitterParameters->triggerUpdate();
+
+            // This is called for every mouse movement while a crossover is dragged, so only the
+            // crossover is redrawn, and only once per message loop iteration
+            _graphChangeNotifier.notify(GRAPH_CHANGE::CROSSOVER, static_cast<int>(index));
         }
     }
 }
 
 float SyndicateAudioProcessor::getCrossoverFrequency(size_t index) {
-    WECore::AudioSpinLock lock(pluginSplitterMutex);
-    PluginSplitterMultiband* multibandSplitter = dynamic_cast<PluginSplitterMultiband*>(pluginSplitter.get());
+    std::shared_ptr<PluginSplitter> splitter = _getSplitter();
+    PluginSplitterMultiband* multibandSplitter = dynamic_cast<PluginSplitterMultiband*>(splitter.get());
 
     float retVal {0};
 
@@ -654,174 +837,1136 @@ bool SyndicateAudioProcessor::onPluginSelectedByUser(std::shared_ptr<juce::Audio
 
     juce::Logger::writeToLog("SyndicateAudioProcessor::onPluginSelectedByUser: Loading plugin");
 
-    if (pluginConfigurator.configure(plugin,
-                                     {getBusesLayout(), getSampleRate(), getBlockSize()})) {
-        juce::Logger::writeToLog("SyndicateAudioProcessor::onPluginSelectedByUser: Plugin configured");
+    GraphTransaction transaction;
+    transaction.replacePlugin(std::move(plugin), chainNumber, pluginNumber);
+    return applyGraphTransaction(std::move(transaction));
+}
 
-        // Hand the plugin over to the splitter
-        {
-            WECore::AudioSpinLock lock(pluginSplitterMutex);
-            pluginSplitter->replacePlugin(std::move(plugin), chainNumber, pluginNumber);
+void SyndicateAudioProcessor::removePlugin(int chainNumber, int pluginNumber) {
+    juce::Logger::writeToLog("Removing slot from graph: " + juce::String(chainNumber) + " " + juce::String(pluginNumber));
+
+    GraphTransaction transaction;
+    transaction.removeSlot(chainNumber, pluginNumber);
+    applyGraphTransaction(std::move(transaction));
+}
+
+void SyndicateAudioProcessor::insertGainStage(int chainNumber, int pluginNumber) {
+    juce::Logger::writeToLog("Inserting gain stage: " + juce::String(chainNumber) + " " + juce::String(pluginNumber));
+
+    GraphTransaction transaction;
+    transaction.insertGainStage(chainNumber, pluginNumber);
+    applyGraphTransaction(std::move(transaction));
+}
+
+bool SyndicateAudioProcessor::applyGraphTransaction(GraphTransaction transaction) {
+    Tracer::Scope traceScope("applyGraphTransaction", "graph", "numEdits", static_cast<int>(transaction._edits.size()));
+
+    const HostConfiguration configuration {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()};
+    bool success {true};
+
+    // Get the plugins ready before locking, as this can take a while
+    for (GraphTransaction::Edit& edit : transaction._edits) {
+        if (edit.type == GraphTransaction::EDIT_TYPE::INSERT_PLUGIN ||
+                edit.type == GraphTransaction::EDIT_TYPE::REPLACE_PLUGIN) {
+            if (edit.plugin != nullptr) {
+                edit.plugin = _configurePlugin(std::move(edit.plugin), edit.chainNumber, configuration);
+            }
+
+            success = success && edit.plugin != nullptr;
+        }
+    }
+
+    if (pluginSplitter != nullptr) {
+        // The plugins have been configured for their chain's layout. If a plugin couldn't be loaded
+        // in mono its chain will need to switch to stereo, and removing one may let a chain switch
+        // back to mono.
+        std::set<int> chainsToConfigure;
+        for (const GraphTransaction::Edit& edit : transaction._edits) {
+            const bool isInsert {edit.type == GraphTransaction::EDIT_TYPE::INSERT_PLUGIN ||
+                                 edit.type == GraphTransaction::EDIT_TYPE::REPLACE_PLUGIN};
+            const bool isRemove {edit.type == GraphTransaction::EDIT_TYPE::REMOVE_SLOT ||
+                                 edit.type == GraphTransaction::EDIT_TYPE::REPLACE_PLUGIN};
+
+            if ((isInsert && edit.plugin != nullptr &&
+                    pluginSplitter->needsLayoutChange(edit.chainNumber, edit.plugin->getMainBusNumInputChannels(), configuration)) ||
+                    (isRemove && pluginSplitter->needsLayoutChange(edit.chainNumber, 0, configuration))) {
+                chainsToConfigure.insert(edit.chainNumber);
+            }
         }
 
-        // Ideally we'd like to handle plugin selection like any other parameter - just update the
-        // parameter and just action the update in the callback
-        // We can't do that though as the splitters are stateful, but we still update the parameter
-        // so the UI also gets the update - need to do this last though as the UI pulls its state
-        // from the splitter
-        if (_editor != nullptr) {
-            _editor->needsGraphRebuild();
+        _graphHistory.beginEdit(*pluginSplitter);
+
+        {
+            // Changing a chain's layout reconfigures its plugins, so the splitter is suspended for
+            // those edits. Otherwise the audio thread carries on processing and the splitter is
+            // only locked while the slots are inserted and removed.
+            std::optional<SplitterSuspendScope> suspendScope;
+            if (!chainsToConfigure.empty()) {
+                suspendScope.emplace(*this);
+            }
+
+            // The plan and latency compensation are updated once when the batch ends, after the
+            // splitter is unlocked
+            PluginSplitter::BatchScope batch(*pluginSplitter);
+
+            {
+                WECore::AudioSpinLock lock(pluginSplitterMutex);
+
+                for (GraphTransaction::Edit& edit : transaction._edits) {
+                    switch (edit.type) {
+                        case GraphTransaction::EDIT_TYPE::INSERT_PLUGIN:
+                            if (edit.plugin != nullptr) {
+                                pluginSplitter->insertPlugin(std::move(edit.plugin), edit.chainNumber, edit.slotNumber);
+                            }
+                            break;
+                        case GraphTransaction::EDIT_TYPE::REPLACE_PLUGIN:
+                            if (edit.plugin != nullptr) {
+                                // The replaced slot is kept in case the edit is undone
+                                _graphHistory.keepSlot(pluginSplitter->releaseSlot(edit.chainNumber, edit.slotNumber));
+                                pluginSplitter->insertPlugin(std::move(edit.plugin), edit.chainNumber, edit.slotNumber);
+                            }
+                            break;
+                        case GraphTransaction::EDIT_TYPE::REMOVE_SLOT:
+                            _graphHistory.keepSlot(pluginSplitter->releaseSlot(edit.chainNumber, edit.slotNumber));
+                            break;
+                        case GraphTransaction::EDIT_TYPE::INSERT_GAIN_STAGE:
+                            pluginSplitter->insertGainStage(edit.chainNumber, edit.slotNumber, getBusesLayout());
+                            break;
+                    }
+                }
+            }
+
+            for (int chainNumber : chainsToConfigure) {
+                pluginSplitter->configureChainLayout(chainNumber, configuration, pluginConfigurator);
+            }
         }
 
-        return true;
-    } else {
-        juce::Logger::writeToLog("SyndicateAudioProcessor::onPluginSelectedByUser: Failed to configure plugin");
-        return false;
+        // Any slots that can no longer be redone are deleted here, outside the lock
+        _graphHistory.endEdit(*pluginSplitter);
     }
+
+    // The UI pulls its state from the splitter, so this needs to be done last
+    for (const GraphTransaction::Edit& edit : transaction._edits) {
+        _graphChangeNotifier.notify(GRAPH_CHANGE::SLOT, edit.chainNumber);
+    }
+
+    return success;
 }
 
-void SyndicateAudioProcessor::removePlugin(int chainNumber, int pluginNumber) {
-    juce::Logger::writeToLog("Removing slot from graph: " + juce::String(chainNumber) + " " + juce::String(pluginNumber));
+bool SyndicateAudioProcessor::insertSplitter(int chainNumber, int slotNumber, SPLIT_TYPE splitType) {
+    juce::Logger::writeToLog("Inserting splitter: " + juce::String(chainNumber) + " " + juce::String(slotNumber));
 
-    {
-        WECore::AudioSpinLock lock(pluginSplitterMutex);
-        if (pluginSplitter != nullptr) {
-            pluginSplitter->removeSlot(chainNumber, pluginNumber);
-        }
+    bool success {false};
+
+    if (pluginSplitter == nullptr || chainNumber < 0 || chainNumber >= pluginSplitter->getNumChains()) {
+        return success;
     }
 
-    if (_editor != nullptr) {
-        _editor->needsGraphRebuild();
+    // The nested splitter is created and prepared before locking, as this can take a while. It's
+    // deleted outside the lock if it isn't inserted.
+    const HostConfiguration configuration {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()};
+    std::unique_ptr<ChainSlotBase> splitterSlot =
+        pluginSplitter->getChain(chainNumber)->createSplitterSlot(splitType, configuration, pluginConfigurator);
+
+    if (splitterSlot == nullptr) {
+        return success;
     }
-}
 
-void SyndicateAudioProcessor::insertGainStage(int chainNumber, int pluginNumber) {
-    juce::Logger::writeToLog("Inserting gain stage: " + juce::String(chainNumber) + " " + juce::String(pluginNumber));
+    // A chain containing a splitter can't run in mono, so a mono chain is switched to stereo with
+    // the splitter suspended
+    const bool shouldConfigureLayout {pluginSplitter->needsLayoutChange(
+        chainNumber, PluginChain::getSlotNumMainChannels(*splitterSlot, configuration), configuration)};
+
+    _graphHistory.beginEdit(*pluginSplitter);
 
     {
-        WECore::AudioSpinLock lock(pluginSplitterMutex);
-        if (pluginSplitter != nullptr) {
-            pluginSplitter->insertGainStage(chainNumber, pluginNumber, getBusesLayout());
+        std::optional<SplitterSuspendScope> suspendScope;
+        if (shouldConfigureLayout) {
+            suspendScope.emplace(*this);
         }
-    }
 
-    if (_editor != nullptr) {
-        _editor->needsGraphRebuild();
+        PluginSplitter::BatchScope batch(*pluginSplitter);
+
+        {
+            WECore::AudioSpinLock lock(pluginSplitterMutex);
+            pluginSplitter->getChain(chainNumber)->insertSlot(std::move(splitterSlot), slotNumber);
+            success = true;
+        }
+
+        if (shouldConfigureLayout) {
+            pluginSplitter->configureChainLayout(chainNumber, configuration, pluginConfigurator);
+        }
     }
+
+    _graphHistory.endEdit(*pluginSplitter);
+
+    _graphChangeNotifier.notify(GRAPH_CHANGE::SLOT, chainNumber);
+
+    return success;
+}
+
+void SyndicateAudioProcessor::setAnticipativeLatency(int numSamples) {
+    juce::Logger::writeToLog("Setting anticipative latency: " + juce::String(numSamples));
+
+    _anticipativeProcessor.setLatencySamples(numSamples);
+    _onLatencyChange();
 }
 
-void SyndicateAudioProcessor::moveSlot(int fromChainNumber, int fromSlotNumber, int toChainNumber, int toSlotNumber) {
-    // Copy everything we need
-    std::shared_ptr<juce::AudioPluginInstance> plugin =
-        pluginSplitter->getPlugin(fromChainNumber, fromSlotNumber);
+void SyndicateAudioProcessor::setInternalBlockSize(int numSamples) {
+    // This is called on every restore, so don't prepare every plugin again unless it's changed
+    if (std::max(numSamples, 0) == _fixedBlockProcessor.getBlockSize()) {
+        return;
+    }
 
-    if (plugin != nullptr) {
-        // This is a plugin
-        PluginModulationConfig config =
-            pluginSplitter->getPluginModulationConfig(fromChainNumber, fromSlotNumber);
+    juce::Logger::writeToLog("Setting internal block size: " + juce::String(numSamples));
 
-        // Remove it from the chain
-        pluginSplitter->removeSlot(fromChainNumber, fromSlotNumber);
+    // The plugins need to be prepared for the new block size, which may take a while so it's done
+    // outside the lock
+    {
+        SplitterSuspendScope suspendScope(*this);
 
-        // Add it in the new position
-        pluginSplitter->insertPlugin(plugin, toChainNumber, toSlotNumber);
-        pluginSplitter->setPluginModulationConfig(config, toChainNumber, toSlotNumber);
+        _fixedBlockProcessor.setBlockSize(numSamples);
 
-    } else {
-        // This is a gain stage
-        const float gain {pluginSplitter->getGainLinear(fromChainNumber, fromSlotNumber)};
-        const float pan {pluginSplitter->getPan(fromChainNumber, fromSlotNumber)};
+        if (pluginSplitter != nullptr) {
+            pluginSplitter->prepareToPlay(getSampleRate(), _getSplitterBlockSize());
+        }
 
-        // Remove it from the chain
-        pluginSplitter->removeSlot(fromChainNumber, fromSlotNumber);
+        _forEachSceneSplitter([&](PluginSplitter& splitter) {
+            splitter.prepareToPlay(getSampleRate(), _getSplitterBlockSize());
+        });
 
-        // Add it in the new position
-        pluginSplitter->insertGainStage(toChainNumber, toSlotNumber, getBusesLayout());
-        pluginSplitter->setGainLinear(toChainNumber, toSlotNumber, gain);
-        pluginSplitter->setPan(toChainNumber, toSlotNumber, pan);
+        _sceneFadeBuffer.setSize(std::max(getTotalNumInputChannels(), getTotalNumOutputChannels()),
+                                 std::max(getBlockSize(), _getSplitterBlockSize()));
     }
 
-    if (_editor != nullptr) {
-        _editor->needsGraphRebuild();
-    }
+    _onLatencyChange();
 }
 
-bool SyndicateAudioProcessor::canDoStereoSplitTypes() const {
-    return getMainBusNumInputChannels() == getMainBusNumOutputChannels() &&
-           getMainBusNumOutputChannels() == 2;
+void SyndicateAudioProcessor::setSandboxGuestPlugins(bool shouldSandbox) {
+    juce::Logger::writeToLog("Setting sandbox guest plugins: " + juce::String(shouldSandbox ? "true" : "false"));
+
+    // Only applies to plugins selected from now on, existing plugins stay where they are
+    _shouldSandboxGuestPlugins = shouldSandbox;
 }
 
-std::vector<juce::String> SyndicateAudioProcessor::_provideParamNamesForMigration() {
-    // No parameters to migrate
-    return std::vector<juce::String>();
+void SyndicateAudioProcessor::setCpuBudget(float budget) {
+    juce::Logger::writeToLog("Setting CPU budget: " + juce::String(budget));
+
+    // The governor will change level on the next block if it needs to
+    _cpuGovernor.setBudget(budget);
 }
 
-void SyndicateAudioProcessor::_migrateParamValues(std::vector<float>& /*paramValues*/) {
-    // Do nothing - no parameters to migrate
+void SyndicateAudioProcessor::setCpuFallbackEnabled(CPU_FALLBACK fallback, bool isEnabled) {
+    juce::Logger::writeToLog("Setting CPU fallback " + CpuGovernor::fallbackToString(fallback) + ": " + juce::String(isEnabled ? "enabled" : "disabled"));
+
+    // Changes which fallbacks are active without necessarily changing the level
+    _cpuGovernor.setFallbackEnabled(fallback, isEnabled);
+    _cpuFallbackApplier.triggerAsyncUpdate();
 }
 
-void SyndicateAudioProcessor::_onParameterUpdate() {
-    _outputGainLinear = WECore::CoreMath::dBToLinear(outputGainLog->get());
+void SyndicateAudioProcessor::setFlightRecorderThreshold(float threshold) {
+    juce::Logger::writeToLog("Setting flight recorder threshold: " + juce::String(threshold));
 
-    // Set the bypass/mute/solo for each chain
-    // TODO - try to avoid locking here
-    WECore::AudioSpinLock lock(pluginSplitterMutex);
-    if (pluginSplitter != nullptr) {
-        switch (_splitType) {
-            case SPLIT_TYPE::SERIES:
-                pluginSplitter->getChain(0)->setChainBypass(chainParameters[0].getBypass());
-                break;
-            case SPLIT_TYPE::PARALLEL:
-            case SPLIT_TYPE::MULTIBAND:
-                for (size_t chainIndex {0}; chainIndex < chainParameters.size(); chainIndex++) {
-                    const ChainParameters& params = chainParameters[chainIndex];
-
-                    pluginSplitter->getChain(chainIndex)->setChainBypass(params.getBypass());
-                    pluginSplitter->getChain(chainIndex)->setChainMute(params.getMute());
-                    pluginSplitter->setChainSolo(chainIndex, params.getSolo());
-                }
-                break;
-            case SPLIT_TYPE::LEFTRIGHT:
-            case SPLIT_TYPE::MIDSIDE:
-                pluginSplitter->getChain(0)->setChainBypass(chainParameters[0].getBypass());
-                pluginSplitter->getChain(0)->setChainMute(chainParameters[0].getMute());
-                pluginSplitter->setChainSolo(0, chainParameters[0].getSolo());
-
-                pluginSplitter->getChain(1)->setChainBypass(chainParameters[1].getBypass());
-                pluginSplitter->getChain(1)->setChainMute(chainParameters[1].getMute());
-                pluginSplitter->setChainSolo(1, chainParameters[1].getSolo());
-                break;
-        }
-    }
+    _flightRecorder.setThreshold(threshold);
 }
 
-void SyndicateAudioProcessor::_resetModulationSources() {
-    for (std::shared_ptr<WECore::Richter::RichterLFO>& lfo : lfos) {
-        lfo->reset();
+bool SyndicateAudioProcessor::startTrace() {
+    if (!Tracer::getInstance().start(JucePlugin_Name)) {
+        return false;
     }
 
-    for (EnvelopeFollowerWrapper& env : envelopes) {
-        env.envelope->reset();
-    }
+    pluginScanClient.startTrace();
+    return true;
 }
 
-void SyndicateAudioProcessor::SplitterParameters::restoreFromXml(juce::XmlElement* element) {
-#ifdef DEMO_BUILD
-    juce::Logger::writeToLog("Not restoring state - demo build");
-#else
-    juce::Logger::writeToLog("Restoring plugin state from XML");
+juce::File SyndicateAudioProcessor::stopTrace() {
+    const juce::String fileName {"Trace_" + juce::Time::getCurrentTime().formatted("%Y-%m-%d_%H-%M-%S")};
+    const juce::File traceFile {Utils::PluginLogDirectory.getChildFile(fileName + ".json")};
 
-    if (_processor != nullptr) {
-        juce::XmlElement* splitterElement = element->getChildByName(XML_SPLITTER_STR);
-        if (splitterElement != nullptr) {
-            // Restore the splitter first as we need to know how many chains there are
-            _restoreSplitterFromXml(splitterElement);
+    // The scan server writes its own file, load both into the same Perfetto session to see them
+    // on one timeline
+    pluginScanClient.stopTrace(Utils::PluginScanServerLogDirectory.getChildFile(fileName + ".json"));
 
-            // Now make sure the chain parameters are configured
-            _restoreChainParameters();
-        } else {
-            juce::Logger::writeToLog("Missing element " + juce::String(XML_SPLITTER_STR));
-        }
+    if (!Tracer::getInstance().stopAndExport(traceFile)) {
+        return {};
+    }
+
+    return traceFile;
+}
+
+bool SyndicateAudioProcessor::isTracing() const {
+    return Tracer::getInstance().isEnabled();
+}
+
+bool SyndicateAudioProcessor::switchToScene(int index) {
+    if (index < 0 || index >= NUM_SCENES) {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::switchToScene: Invalid scene " + juce::String(index));
+        return false;
+    }
+
+    if (index == _currentScene) {
+        return true;
+    }
+
+    juce::Logger::writeToLog("Switching to scene " + juce::String(index));
+    Tracer::Scope traceScope("switchScene", "state", "scene", index);
+
+    // Only one scene can be faded out at a time, so cut short any fade that's still going
+    _completeSceneFade();
+
+    // An empty scene starts as a copy of the current one, this is the only time switching needs
+    // to instantiate plugins
+    bool hasSplitter {false};
+    {
+        WECore::AudioSpinLock lock(pluginSplitterMutex);
+        hasSplitter = _scenes[index].splitter != nullptr;
+    }
+
+    if (!hasSplitter) {
+        std::unique_ptr<PluginSplitter> newSplitter = _copySplitter();
+        if (newSplitter == nullptr) {
+            juce::Logger::writeToLog("SyndicateAudioProcessor::switchToScene: Failed to create scene " + juce::String(index));
+            return false;
+        }
+
+        WECore::AudioSpinLock lock(pluginSplitterMutex);
+        _scenes[index].splitter = std::move(newSplitter);
+    }
+
+    // Only this thread touches the splitters of the other scenes, so the scene's chains can be
+    // woken before the audio thread sees them
+    _wakeHibernatedChains(*_scenes[index].splitter);
+
+    {
+        WECore::AudioSpinLock lock(pluginSplitterMutex);
+
+        // The layout may have changed to one the scene's split type can't be used with since it
+        // was created
+        const SPLIT_TYPE splitType {_scenes[index].splitter->getSplitType()};
+        if ((splitType == SPLIT_TYPE::LEFTRIGHT || splitType == SPLIT_TYPE::MIDSIDE) && !canDoStereoSplitTypes()) {
+            juce::Logger::writeToLog("SyndicateAudioProcessor::switchToScene: Scene needs a stereo layout");
+            return false;
+        }
+
+        // The audio thread processes both splitters and crossfades between them until the fade
+        // completes, then the outgoing one goes back to its scene
+        const juce::ScopedLock pointerLock(_splitterPointerMutex);
+        _outgoingSplitter = std::move(pluginSplitter);
+        _outgoingScene = _currentScene;
+        pluginSplitter = std::move(_scenes[index].splitter);
+        _currentScene = index;
+        _splitType = splitType;
+
+        _sceneFadeLength = std::max(1, static_cast<int>(getSampleRate() * SCENE_FADE_SECONDS));
+        _sceneFadeSamplesRemaining = _sceneFadeLength;
+        _isSceneFadeThroughSilence = _outgoingSplitter->getLatencySamples() != pluginSplitter->getLatencySamples();
+    }
+
+    // The history only applies to the scene it was made in
+    _graphHistory.clear();
+
+    _updateChainParametersFromSplitter();
+    _onLatencyChange();
+
+    // The new splitter needs the CPU governor's fallbacks applying
+    _cpuFallbackApplier.triggerAsyncUpdate();
+
+    updateHostDisplay();
+
+    _notifyGraphRebuild();
+
+    return true;
+}
+
+juce::String SyndicateAudioProcessor::getSceneName(int index) const {
+    if (index < 0 || index >= NUM_SCENES) {
+        return {};
+    }
+
+    return _scenes[index].name;
+}
+
+void SyndicateAudioProcessor::setSceneName(int index, const juce::String& name) {
+    if (index >= 0 && index < NUM_SCENES) {
+        _scenes[index].name = name;
+        updateHostDisplay();
+    }
+}
+
+void SyndicateAudioProcessor::startChainFreeze(int chainNumber) {
+    juce::Logger::writeToLog("Starting freeze of chain " + juce::String(chainNumber));
+
+    // Create the recording file before locking
+    std::unique_ptr<ChainFreezer> freezer = ChainFreezer::startCapture(getSampleRate(), _getSplitterBlockSize());
+
+    if (freezer != nullptr) {
+        {
+            WECore::AudioSpinLock lock(pluginSplitterMutex);
+            if (pluginSplitter != nullptr && chainNumber < pluginSplitter->getNumChains()) {
+                pluginSplitter->getChain(chainNumber)->startFreeze(std::move(freezer));
+            }
+        }
+
+        _notifyGraphRebuild();
+    }
+}
+
+bool SyndicateAudioProcessor::completeChainFreeze(int chainNumber) {
+    juce::Logger::writeToLog("Completing freeze of chain " + juce::String(chainNumber));
+
+    // Held for the whole freeze, so the chain still exists even if the splitter is replaced while
+    // the recording is being finished
+    std::shared_ptr<PluginSplitter> splitter = _getSplitter();
+    std::unique_ptr<ChainFreezer> freezer;
+
+    if (splitter == nullptr || chainNumber < 0 || chainNumber >= splitter->getNumChains()) {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::completeChainFreeze: Invalid chain " + juce::String(chainNumber));
+        return false;
+    }
+
+    {
+        WECore::AudioSpinLock lock(pluginSplitterMutex);
+        freezer = splitter->getChain(chainNumber)->stopFreeze();
+    }
+
+    // Mapping the recording reads the whole file, so it's done without holding the lock. If it
+    // fails the freeze is cancelled and the freezer deleted here.
+    const bool isFrozen {freezer != nullptr && freezer->finishCapture()};
+
+    if (isFrozen) {
+        // The plugins are unloaded now they've been recorded. Their state is stored before locking
+        // and they're deleted after unlocking, so only detaching them needs the lock.
+        std::unique_ptr<juce::XmlElement> hibernatedState = splitter->getChain(chainNumber)->createHibernatedState();
+        std::vector<std::unique_ptr<ChainSlotBase>> hibernatedSlots;
+
+        {
+            WECore::AudioSpinLock lock(pluginSplitterMutex);
+            PluginChain& chain = *splitter->getChain(chainNumber);
+            chain.completeFreeze(std::move(freezer));
+            hibernatedSlots = chain.detachSlotsToHibernate(std::move(hibernatedState), false);
+        }
+    }
+
+    // The chain is no longer being frozen either way
+    _notifyGraphRebuild();
+
+    return isFrozen;
+}
+
+void SyndicateAudioProcessor::unfreezeChain(int chainNumber) {
+    juce::Logger::writeToLog("Unfreezing chain " + juce::String(chainNumber));
+
+    if (pluginSplitter != nullptr && chainNumber < pluginSplitter->getNumChains()) {
+        // Recreate the plugins first, the frozen audio keeps playing until they're ready
+        pluginSplitter->wakeChain(
+            chainNumber,
+            {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()},
+            pluginConfigurator,
+            [&](juce::String errorText) { restoreErrors.push_back(errorText); });
+
+        // The freezer unmaps the recording, so it's deleted after unlocking
+        std::unique_ptr<ChainFreezer> freezer;
+
+        {
+            WECore::AudioSpinLock lock(pluginSplitterMutex);
+            freezer = pluginSplitter->getChain(chainNumber)->unfreeze();
+        }
+    }
+
+    _notifyGraphRebuild();
+}
+
+bool SyndicateAudioProcessor::moveSlot(int fromChainNumber, int fromSlotNumber, int toChainNumber, int toSlotNumber) {
+    if (pluginSplitter == nullptr) {
+        return false;
+    }
+
+    if (fromChainNumber < 0 || fromChainNumber >= pluginSplitter->getNumChains()) {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::moveSlot: Invalid source chain " + juce::String(fromChainNumber));
+        return false;
+    }
+
+    if (toChainNumber < 0 || toChainNumber >= pluginSplitter->getNumChains()) {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::moveSlot: Invalid destination chain " + juce::String(toChainNumber));
+        return false;
+    }
+
+    const ChainSlotBase* slotToMove {pluginSplitter->getChain(fromChainNumber)->getSlot(fromSlotNumber)};
+    if (slotToMove == nullptr) {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::moveSlot: Invalid source slot " + juce::String(fromSlotNumber));
+        return false;
+    }
+
+    // The destination chain may use a different layout, and the source chain may now be able to
+    // use mono. Changing a chain's layout reconfigures its plugins, so the splitter is suspended
+    // rather than locked if either needs it.
+    const HostConfiguration configuration {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()};
+    std::set<int> chainsToConfigure;
+
+    if (fromChainNumber != toChainNumber) {
+        if (pluginSplitter->needsLayoutChange(toChainNumber, PluginChain::getSlotNumMainChannels(*slotToMove, configuration), configuration)) {
+            chainsToConfigure.insert(toChainNumber);
+        }
+
+        if (pluginSplitter->needsLayoutChange(fromChainNumber, 0, configuration)) {
+            chainsToConfigure.insert(fromChainNumber);
+        }
+    }
+
+    _graphHistory.beginEdit(*pluginSplitter);
+
+    {
+        std::optional<SplitterSuspendScope> suspendScope;
+        if (!chainsToConfigure.empty()) {
+            suspendScope.emplace(*this);
+        }
+
+        PluginSplitter::BatchScope batch(*pluginSplitter);
+
+        {
+            WECore::AudioSpinLock lock(pluginSplitterMutex);
+
+            // The slot itself is moved, so it keeps its plugin's modulation config or its gain and pan
+            std::unique_ptr<ChainSlotBase> slot = pluginSplitter->releaseSlot(fromChainNumber, fromSlotNumber);
+            if (slot != nullptr) {
+                pluginSplitter->insertSlot(std::move(slot), toChainNumber, toSlotNumber);
+            }
+        }
+
+        for (int chainNumber : chainsToConfigure) {
+            pluginSplitter->configureChainLayout(chainNumber, configuration, pluginConfigurator);
+        }
+    }
+
+    _graphHistory.endEdit(*pluginSplitter);
+
+    _graphChangeNotifier.notify(GRAPH_CHANGE::SLOT, fromChainNumber);
+    _graphChangeNotifier.notify(GRAPH_CHANGE::SLOT, toChainNumber);
+
+    return true;
+}
+
+bool SyndicateAudioProcessor::undoGraphEdit() {
+    return _applyGraphHistory(true);
+}
+
+bool SyndicateAudioProcessor::redoGraphEdit() {
+    return _applyGraphHistory(false);
+}
+
+bool SyndicateAudioProcessor::canDoStereoSplitTypes() const {
+    return getMainBusNumInputChannels() == getMainBusNumOutputChannels() &&
+           getMainBusNumOutputChannels() == 2;
+}
+
+std::vector<juce::String> SyndicateAudioProcessor::_provideParamNamesForMigration() {
+    // No parameters to migrate
+    return std::vector<juce::String>();
+}
+
+void SyndicateAudioProcessor::_migrateParamValues(std::vector<float>& /*paramValues*/) {
+    // Do nothing - no parameters to migrate
+}
+
+void SyndicateAudioProcessor::_onParameterUpdate() {
+    // This may be called on the audio thread when a parameter is automated, so only touch atomics
+    // here
+    _outputGainLinear.store(static_cast<float>(WECore::CoreMath::dBToLinear(outputGainLog->get())));
+
+    if (juce::MessageManager::existsAndIsCurrentThread()) {
+        _applyChainParameters();
+    } else {
+        _chainParametersApplier.triggerAsyncUpdate();
+    }
+}
+
+void SyndicateAudioProcessor::_applyChainParameters() {
+    // Each chain checks the splitter's chains itself, as they may change between chains
+    for (size_t chainIndex {0}; chainIndex < chainParameters.size(); chainIndex++) {
+        if (_applyChainParameters(chainIndex)) {
+            _graphChangeNotifier.notify(GRAPH_CHANGE::CHAIN_FLAGS, static_cast<int>(chainIndex));
+        }
+    }
+}
+
+bool SyndicateAudioProcessor::_applyChainParameters(size_t chainIndex) {
+    // Set the bypass/mute/solo for the chain
+    // The flags are atomics the audio thread reads as it processes (soloing doesn't rebuild the
+    // plan), so pluginSplitterMutex isn't needed. The splitter may be replaced while restoring, so
+    // a reference is held to keep it alive while it's used.
+    bool hasChanged {false};
+    bool isNewlyMuted {false};
+
+    if (chainIndex >= chainParameters.size()) {
+        return hasChanged;
+    }
+
+    const ChainParameters& params = chainParameters[chainIndex];
+
+    // The series splitter's only chain can't be muted or soloed
+    const bool canMute {_splitType != SPLIT_TYPE::SERIES};
+
+    std::shared_ptr<PluginSplitter> splitter = _getSplitter();
+
+    // A chain the CPU governor has unloaded would pass audio through unprocessed once it's
+    // unmuted, so its plugins are recreated first. This is always on the message thread, and like
+    // the other wakes doesn't need the lock as the audio thread doesn't touch a hibernated chain's
+    // slots.
+    if (canMute && !params.getMute() &&
+            splitter != nullptr &&
+            chainIndex < splitter->getNumActiveChains()) {
+        const PluginChain& chain = *splitter->getChain(chainIndex);
+
+        if (chain.isHibernated() && !chain.isFrozen()) {
+            splitter->wakeChain(
+                static_cast<int>(chainIndex),
+                {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()},
+                pluginConfigurator,
+                [&](juce::String errorText) { restoreErrors.push_back(errorText); });
+
+            _notifyGraphRebuild();
+        }
+    }
+
+    if (splitter != nullptr && chainIndex < splitter->getNumActiveChains()) {
+        PluginChain& chain = *splitter->getChain(chainIndex);
+
+        // Bypassing changes the latency, which may reallocate the compensation, so it's only set
+        // if it's changed
+        if (chain.getChainBypass() != params.getBypass()) {
+            chain.setChainBypass(params.getBypass());
+            hasChanged = true;
+        }
+
+        if (canMute) {
+            if (chain.getChainMute() != params.getMute()) {
+                isNewlyMuted = params.getMute();
+                chain.setChainMute(params.getMute());
+                hasChanged = true;
+            }
+
+            if (splitter->getChainSolo(chainIndex) != params.getSolo()) {
+                splitter->setChainSolo(chainIndex, params.getSolo());
+                hasChanged = true;
+            }
+        }
+    }
+
+    // Newly muted chains can be unloaded
+    if (isNewlyMuted && _cpuGovernor.isFallbackActive(CPU_FALLBACK::HIBERNATE_MUTED_CHAINS)) {
+        _cpuFallbackApplier.triggerAsyncUpdate();
+    }
+
+    return hasChanged;
+}
+
+void SyndicateAudioProcessor::_onChainParametersUpdate(const ChainParameters& params) {
+    // Only the chain that changed needs applying and redrawing, rather than all of them
+    const size_t chainIndex {static_cast<size_t>(&params - chainParameters.data())};
+
+    if (juce::MessageManager::existsAndIsCurrentThread()) {
+        _applyChainParameters(chainIndex);
+    } else {
+        _chainParametersApplier.triggerAsyncUpdate();
+    }
+
+    _graphChangeNotifier.notify(GRAPH_CHANGE::CHAIN_FLAGS, static_cast<int>(chainIndex));
+}
+
+void SyndicateAudioProcessor::_updateChainParametersFromSplitter() {
+    while (chainParameters.size() > pluginSplitter->getNumChains()) {
+        // More parameters than chains, delete them
+        chainParameters.erase(chainParameters.begin());
+    }
+
+    for (int chainNumber {0}; chainNumber < pluginSplitter->getNumChains(); chainNumber++) {
+        // Add parameters if needed
+        if (chainParameters.size() <= chainNumber) {
+            chainParameters.emplace_back([&](const ChainParameters& params) { _onChainParametersUpdate(params); });
+        }
+
+        chainParameters[chainNumber].setBypass(pluginSplitter->getChain(chainNumber)->getChainBypass());
+        chainParameters[chainNumber].setMute(pluginSplitter->getChain(chainNumber)->getChainMute());
+        chainParameters[chainNumber].setSolo(pluginSplitter->getChainSolo(chainNumber));
+    }
+}
+
+bool SyndicateAudioProcessor::_applyGraphHistory(bool isUndo) {
+    if (pluginSplitter == nullptr || !_graphHistory.validate(*pluginSplitter)) {
+        return false;
+    }
+
+    std::set<int> changedChains;
+    bool success {false};
+
+    {
+        // Preparing the moved slots may take a while, so the splitter is suspended rather than
+        // locked
+        SplitterSuspendScope suspendScope(*this);
+        PluginSplitter::BatchScope batch(*pluginSplitter);
+
+        success = isUndo ? _graphHistory.undo(*pluginSplitter, changedChains) : _graphHistory.redo(*pluginSplitter, changedChains);
+
+        if (success) {
+            // Slots may have moved to a chain with a different layout, and slots that were out of
+            // the graph when the sample rate or block size changed need preparing again
+            const HostConfiguration configuration {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()};
+            pluginSplitter->configureChainLayouts(configuration, pluginConfigurator);
+
+            for (int chainNumber : changedChains) {
+                pluginSplitter->getChain(chainNumber)->prepareToPlayIfNeeded(configuration.sampleRate, configuration.blockSize);
+            }
+        }
+    }
+
+    for (int chainNumber : changedChains) {
+        _graphChangeNotifier.notify(GRAPH_CHANGE::SLOT, chainNumber);
+    }
+
+    return success;
+}
+
+void SyndicateAudioProcessor::_resetModulationSources() {
+    LfoRegistry::ReadScope lfoScope(lfos);
+    for (int index {0}; index < lfoScope.size(); index++) {
+        lfoScope[index]->reset();
+    }
+
+    EnvelopeRegistry::ReadScope envelopeScope(envelopes);
+    for (int index {0}; index < envelopeScope.size(); index++) {
+        envelopeScope[index].envelope->reset();
+    }
+}
+
+void SyndicateAudioProcessor::_saveModulationValues(std::vector<float>& values) {
+    std::fill(values.begin(), values.end(), 0.0f);
+
+    for (int index {0}; index < NUM_MACROS; index++) {
+        values[index] = macros[index]->get();
+    }
+
+    LfoRegistry::ReadScope lfoScope(lfos);
+    for (int index {0}; index < lfoScope.size(); index++) {
+        values[NUM_MACROS + index] = lfoScope[index]->getLastOutput();
+    }
+
+    EnvelopeRegistry::ReadScope envelopeScope(envelopes);
+    for (int index {0}; index < envelopeScope.size(); index++) {
+        values[NUM_MACROS + MAX_NUM_LFOS + index] = envelopeScope[index].envelope->getLastOutput() * envelopeScope[index].amount;
+    }
+}
+
+void SyndicateAudioProcessor::_wakeHibernatedChains(PluginSplitter& splitter) {
+    const bool includeMutedChains {!_cpuGovernor.isFallbackActive(CPU_FALLBACK::HIBERNATE_MUTED_CHAINS)};
+
+    if (splitter.hasHibernatedActiveChains(includeMutedChains)) {
+        splitter.wakeActiveChains(
+            {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()},
+            pluginConfigurator,
+            [&](juce::String errorText) { restoreErrors.push_back(errorText); },
+            includeMutedChains);
+
+        _notifyGraphRebuild();
+    }
+}
+
+void SyndicateAudioProcessor::_wakeNextHibernatedChain() {
+    if (pluginSplitter == nullptr) {
+        return;
+    }
+
+    // Muted chains the CPU governor has unloaded are left hibernated
+    const bool includeMutedChains {!_cpuGovernor.isFallbackActive(CPU_FALLBACK::HIBERNATE_MUTED_CHAINS)};
+    const int chainNumber {pluginSplitter->findHibernatedActiveChain(includeMutedChains)};
+
+    if (chainNumber >= 0) {
+        // The audio thread doesn't touch a hibernated chain's slots, so this doesn't need the lock
+        pluginSplitter->wakeChain(
+            chainNumber,
+            {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()},
+            pluginConfigurator,
+            [&](juce::String errorText) { restoreErrors.push_back(errorText); });
+
+        _graphChangeNotifier.notify(GRAPH_CHANGE::SLOT, chainNumber);
+
+        // The next chain is woken on the next message loop iteration
+        if (pluginSplitter->hasHibernatedActiveChains(includeMutedChains)) {
+            _chainWaker.triggerAsyncUpdate();
+        }
+    }
+}
+
+std::shared_ptr<PluginSplitter> SyndicateAudioProcessor::_getSplitter() {
+    const juce::ScopedLock pointerLock(_splitterPointerMutex);
+    return pluginSplitter;
+}
+
+void SyndicateAudioProcessor::_updateReportContext() {
+    // Built outside the lock so a report being written only waits for the swap
+    FlightRecorder::ReportContext context;
+
+    std::shared_ptr<PluginSplitter> splitter = _getSplitter();
+    if (splitter != nullptr) {
+        FlightRecorder::describeSplitter(*splitter, "", context);
+    }
+
+    const juce::ScopedLock lock(_reportContextMutex);
+    std::swap(_graphReportContext, context);
+}
+
+void SyndicateAudioProcessor::_notifyGraphRebuild() {
+    _reportContextUpdater.triggerAsyncUpdate();
+
+    if (_editor != nullptr) {
+        _editor->needsGraphRebuild();
+    }
+}
+
+void SyndicateAudioProcessor::_applyCpuFallbacks() {
+    const int level {_cpuGovernor.getLevel()};
+    if (level != _appliedCpuGovernorLevel) {
+        juce::String fallbacksString;
+        for (int index {0}; index < CpuGovernor::NUM_FALLBACKS; index++) {
+            const CPU_FALLBACK fallback {static_cast<CPU_FALLBACK>(index)};
+            if (_cpuGovernor.isFallbackActive(fallback)) {
+                fallbacksString += "\n  " + CpuGovernor::fallbackToString(fallback);
+            }
+        }
+
+        juce::Logger::writeToLog("CPU governor level " + juce::String(level) +
+                                 " at load " + juce::String(_cpuGovernor.getLoad(), 2) + fallbacksString);
+        _appliedCpuGovernorLevel = level;
+    }
+
+    if (pluginSplitter == nullptr) {
+        return;
+    }
+
+    // These are only flags read by the audio thread, so the splitter doesn't need to be locked
+    PluginSplitterMultiband* multibandSplitter = dynamic_cast<PluginSplitterMultiband*>(pluginSplitter.get());
+    if (multibandSplitter != nullptr) {
+        multibandSplitter->setIsEconomyCrossover(_cpuGovernor.isFallbackActive(CPU_FALLBACK::ECONOMY_CROSSOVER));
+        multibandSplitter->setIsVisualiserEnabled(!_cpuGovernor.isFallbackActive(CPU_FALLBACK::NO_VISUALISER));
+    }
+
+    // Storing the muted chains' state is slow so is done before locking, and their plugins are
+    // deleted after unlocking
+    if (_cpuGovernor.isFallbackActive(CPU_FALLBACK::HIBERNATE_MUTED_CHAINS)) {
+        std::map<int, std::unique_ptr<juce::XmlElement>> mutedChainStates = pluginSplitter->createMutedChainStates();
+
+        if (!mutedChainStates.empty()) {
+            std::vector<std::unique_ptr<ChainSlotBase>> hibernatedSlots;
+
+            {
+                WECore::AudioSpinLock lock(pluginSplitterMutex);
+                hibernatedSlots = pluginSplitter->hibernateMutedChains(std::move(mutedChainStates));
+            }
+
+            _notifyGraphRebuild();
+        }
+    }
+
+    // Wake any chains which have been unmuted or are no longer hibernated to save CPU
+    _wakeHibernatedChains(*pluginSplitter);
+}
+
+void SyndicateAudioProcessor::_processSplitter(juce::AudioBuffer<float>& buffer,
+                                               juce::MidiBuffer& midiMessages,
+                                               juce::AudioPlayHead* playHead) {
+    // This may be on the anticipative processing thread, so the chains need to be told where to
+    // record their stages
+    FlightRecorder::ThreadScope recorderScope(&_flightRecorder);
+
+    WECore::AudioSpinTryLock lock(pluginSplitterMutex);
+    if (lock.isLocked() && !_isSplitterSuspended && pluginSplitter != nullptr) {
+        const int numSamples {buffer.getNumSamples()};
+        bool isFading {_outgoingSplitter != nullptr && _sceneFadeSamplesRemaining > 0};
+
+        if (isFading
+                && (buffer.getNumChannels() > _sceneFadeBuffer.getNumChannels()
+                    || numSamples > _sceneFadeBuffer.getNumSamples())) {
+            // The host has sent a bigger block than it said it would, there's no room to process
+            // the outgoing scene so cut straight to the new one
+            isFading = false;
+            _sceneFadeSamplesRemaining = 0;
+            _sceneFadeCompleter.triggerAsyncUpdate();
+        }
+
+        // Refers to the preallocated buffer, so nothing is allocated here
+        juce::AudioBuffer<float> fadeBlock(_sceneFadeBuffer.getArrayOfWritePointers(),
+                                           std::min(buffer.getNumChannels(), _sceneFadeBuffer.getNumChannels()),
+                                           std::min(numSamples, _sceneFadeBuffer.getNumSamples()));
+
+        if (isFading) {
+            // The outgoing scene processes its own copy of the block
+            for (int channel {0}; channel < buffer.getNumChannels(); channel++) {
+                fadeBlock.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+            }
+
+            _sceneFadeMidi.clear();
+            _sceneFadeMidi.addEvents(midiMessages, 0, numSamples, 0);
+
+            _outgoingSplitter->setPlayHead(playHead);
+            _outgoingSplitter->processBlock(fadeBlock, _sceneFadeMidi);
+        }
+
+        // Frozen chains need the timeline position to play back their audio
+        pluginSplitter->setPlayHead(playHead);
+        pluginSplitter->processBlock(buffer, midiMessages);
+
+        if (isFading) {
+            // Linear crossfade, the rest of the block after the fade is only the new scene
+            const int numFadeSamples {std::min(numSamples, _sceneFadeSamplesRemaining)};
+            const float startGain {1 - static_cast<float>(_sceneFadeSamplesRemaining) / _sceneFadeLength};
+            const float endGain {1 - static_cast<float>(_sceneFadeSamplesRemaining - numFadeSamples) / _sceneFadeLength};
+
+            if (_isSceneFadeThroughSilence) {
+                // The scenes aren't aligned, so the outgoing scene fades out over the first half
+                // and the new one fades in over the second half without overlapping
+                for (int channel {0}; channel < buffer.getNumChannels(); channel++) {
+                    float* output {buffer.getWritePointer(channel)};
+                    const float* outgoing {fadeBlock.getReadPointer(channel)};
+
+                    for (int sampleIndex {0}; sampleIndex < numFadeSamples; sampleIndex++) {
+                        const float progress {startGain + (endGain - startGain) * sampleIndex / numFadeSamples};
+                        output[sampleIndex] = output[sampleIndex] * std::max(0.0f, 2 * progress - 1)
+                                              + outgoing[sampleIndex] * std::max(0.0f, 1 - 2 * progress);
+                    }
+                }
+            } else {
+                for (int channel {0}; channel < buffer.getNumChannels(); channel++) {
+                    buffer.applyGainRamp(channel, 0, numFadeSamples, startGain, endGain);
+                    buffer.addFromWithRamp(channel, 0, fadeBlock.getReadPointer(channel), numFadeSamples, 1 - startGain, 1 - endGain);
+                }
+            }
+
+            _sceneFadeSamplesRemaining -= numFadeSamples;
+            if (_sceneFadeSamplesRemaining == 0) {
+                _sceneFadeCompleter.triggerAsyncUpdate();
+            }
+        }
+    }
+}
+
+std::shared_ptr<juce::AudioPluginInstance> SyndicateAudioProcessor::_configurePlugin(std::shared_ptr<juce::AudioPluginInstance> plugin,
+                                                                                     int chainNumber,
+                                                                                     const HostConfiguration& configuration) {
+    if (_shouldSandboxGuestPlugins && dynamic_cast<SandboxedPluginInstance*>(plugin.get()) == nullptr) {
+        // The selector loads plugins in this process, so replace it with one running in the plugin
+        // host server before it processes any audio
+        juce::String errorMessage;
+        std::unique_ptr<SandboxedPluginInstance> sandboxedPlugin = SandboxedPluginInstance::create(
+            plugin->getPluginDescription(), configuration.sampleRate, configuration.blockSize, errorMessage);
+
+        if (sandboxedPlugin != nullptr) {
+            plugin = std::move(sandboxedPlugin);
+        } else {
+            juce::Logger::writeToLog("SyndicateAudioProcessor::_configurePlugin: Couldn't sandbox plugin, running in process instead");
+        }
+    }
+
+    // If the chain is running in mono try that first, otherwise (or if the plugin doesn't support
+    // it) use the same layout as Syndicate
+    bool isConfigured {false};
+    if (chainNumber < pluginSplitter->getNumChains() && pluginSplitter->getChain(chainNumber)->isMonoLayout()) {
+        isConfigured = pluginConfigurator.configure(plugin, pluginConfigurator.getMonoConfiguration(configuration));
+    }
+
+    if (!isConfigured) {
+        isConfigured = pluginConfigurator.configure(plugin, configuration);
+    }
+
+    if (isConfigured) {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::_configurePlugin: Plugin configured");
+    } else {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::_configurePlugin: Failed to configure plugin");
+        plugin.reset();
+    }
+
+    return plugin;
+}
+
+std::unique_ptr<PluginSplitter> SyndicateAudioProcessor::_createSplitter(SPLIT_TYPE splitType, PluginSplitter* previousSplitter) {
+    const std::function<float(int, MODULATION_TYPE)> getModulationValue {
+        [&](int id, MODULATION_TYPE type) { return getModulationValueForSource(id, type); }
+    };
+
+    switch (splitType) {
+        case SPLIT_TYPE::SERIES:
+            return createSplitter<PluginSplitterSeries>(previousSplitter, getModulationValue);
+        case SPLIT_TYPE::PARALLEL:
+            return createSplitter<PluginSplitterParallel>(previousSplitter, getModulationValue);
+        case SPLIT_TYPE::MULTIBAND:
+            return createSplitter<PluginSplitterMultiband>(previousSplitter, getModulationValue, canDoStereoSplitTypes());
+        case SPLIT_TYPE::LEFTRIGHT:
+            if (canDoStereoSplitTypes()) {
+                return createSplitter<PluginSplitterLeftRight>(previousSplitter, getModulationValue);
+            }
+
+            juce::Logger::writeToLog("SyndicateAudioProcessor::_createSplitter: Attempted to use left/right split while not in 2in2out configuration");
+            assert(false);
+            break;
+        case SPLIT_TYPE::MIDSIDE:
+            if (canDoStereoSplitTypes()) {
+                return createSplitter<PluginSplitterMidSide>(previousSplitter, getModulationValue);
+            }
+
+            juce::Logger::writeToLog("SyndicateAudioProcessor::_createSplitter: Attempted to use mid/side split while not in 2in2out configuration");
+            assert(false);
+            break;
+    }
+
+    return nullptr;
+}
+
+std::unique_ptr<PluginSplitter> SyndicateAudioProcessor::_createSplitterFromXml(juce::XmlElement* element, SPLIT_TYPE splitType) {
+    std::unique_ptr<PluginSplitter> newSplitter = _createSplitter(splitType, nullptr);
+    if (newSplitter == nullptr) {
+        juce::Logger::writeToLog("SyndicateAudioProcessor::_createSplitterFromXml: Failed to create splitter");
+        return nullptr;
+    }
+
+    const HostConfiguration configuration {getBusesLayout(), getSampleRate(), _getSplitterBlockSize()};
+
+    newSplitter->restoreFromXml(
+        element,
+        configuration,
+        pluginConfigurator,
+        [&](juce::String errorText) { restoreErrors.push_back(errorText); });
+    newSplitter->configureChainLayouts(configuration, pluginConfigurator);
+
+    // Restored plugins will already have been prepared when they were configured, and any chains
+    // the split type doesn't use were restored hibernated without loading their plugins
+    newSplitter->prepareToPlayIfNeeded(getSampleRate(), _getSplitterBlockSize());
+
+    newSplitter->addListener(this);
+    newSplitter->setWorkerPool(_workerPool.get());
+
+    return newSplitter;
+}
+
+std::unique_ptr<PluginSplitter> SyndicateAudioProcessor::_copySplitter() {
+    juce::XmlElement element(XML_SPLITTER_STR);
+    SPLIT_TYPE splitType {_splitType};
+
+    {
+        DeferredPluginStates deferredStates;
+
+        {
+            WECore::AudioSpinLock lock(pluginSplitterMutex);
+            pluginSplitter->writeToXml(&element, &deferredStates);
+            splitType = pluginSplitter->getSplitType();
+        }
+
+        deferredStates.write();
+    }
+
+    return _createSplitterFromXml(&element, splitType);
+}
+
+void SyndicateAudioProcessor::_forEachSceneSplitter(std::function<void(PluginSplitter&)> callback) {
+    for (Scene& scene : _scenes) {
+        if (scene.splitter != nullptr) {
+            callback(*scene.splitter);
+        }
+    }
+
+    if (_outgoingSplitter != nullptr) {
+        callback(*_outgoingSplitter);
+    }
+}
+
+void SyndicateAudioProcessor::_completeSceneFade() {
+    _sceneFadeCompleter.cancelPendingUpdate();
+
+    PluginSplitter* fadedSplitter {nullptr};
+
+    {
+        WECore::AudioSpinLock lock(pluginSplitterMutex);
+        if (_outgoingSplitter != nullptr) {
+            fadedSplitter = _outgoingSplitter.get();
+            _scenes[_outgoingScene].splitter = std::move(_outgoingSplitter);
+            _outgoingScene = -1;
+            _sceneFadeSamplesRemaining = 0;
+        }
+    }
+
+    // Clear any tails so the scene starts from silence next time. The audio thread doesn't process
+    // inactive scenes, but this thread is the only one that can make them active again.
+    if (fadedSplitter != nullptr) {
+        fadedSplitter->reset();
+    }
+}
+
+void SyndicateAudioProcessor::_switchToPendingScene() {
+    _sceneSwitcher.cancelPendingUpdate();
+
+    const int index {_pendingScene.exchange(-1)};
+    if (index >= 0) {
+        switchToScene(index);
+    }
+}
+
+void SyndicateAudioProcessor::_clearScenes() {
+    _completeSceneFade();
+
+    std::array<std::shared_ptr<PluginSplitter>, NUM_SCENES> clearedSplitters;
+
+    {
+        WECore::AudioSpinLock lock(pluginSplitterMutex);
+        for (int index {0}; index < _scenes.size(); index++) {
+            clearedSplitters[index] = std::move(_scenes[index].splitter);
+        }
+
+        _currentScene = 0;
+    }
+
+    for (int index {0}; index < _scenes.size(); index++) {
+        _scenes[index].name = getDefaultSceneName(index);
+    }
+
+    // The splitters and their plugins are deleted here, outside the lock
+}
+
+int SyndicateAudioProcessor::_getSplitterBlockSize() const {
+    const int internalBlockSize {_fixedBlockProcessor.getBlockSize()};
+    return internalBlockSize > 0 ? internalBlockSize : getBlockSize();
+}
+
+SyndicateAudioProcessor::SplitterSuspendScope::SplitterSuspendScope(SyndicateAudioProcessor& processor) :
+        _processor(processor),
+        _wasSuspended(processor._isSplitterSuspended.exchange(true)) {
+    // The audio thread checks the flag while it holds the lock, so once the lock has been taken
+    // no block is being processed and no more will be
+    WECore::AudioSpinLock lock(_processor.pluginSplitterMutex);
+}
+
+SyndicateAudioProcessor::SplitterSuspendScope::~SplitterSuspendScope() {
+    _processor._isSplitterSuspended = _wasSuspended;
+}
+
+void SyndicateAudioProcessor::SplitterParameters::restoreFromXml(juce::XmlElement* element) {
+#ifdef DEMO_BUILD
+    juce::Logger::writeToLog("Not restoring state - demo build");
+#else
+    juce::Logger::writeToLog("Restoring plugin state from XML");
+    Tracer::Scope traceScope("restoreState", "state");
+
+    if (_processor != nullptr) {
+        // Older versions don't have scenes, in which case the restored splitter is the only one
+        juce::XmlElement* scenesElement = element->getChildByName(XML_SCENES_STR);
+        _restoreScenesFromXml(scenesElement);
+
+        juce::XmlElement* splitterElement = element->getChildByName(XML_SPLITTER_STR);
+        if (splitterElement != nullptr) {
+            // Restore the splitter first as we need to know how many chains there are
+            _restoreSplitterFromXml(splitterElement);
+
+            // Now make sure the chain parameters are configured
+            _processor->_updateChainParametersFromSplitter();
+        } else {
+            juce::Logger::writeToLog("Missing element " + juce::String(XML_SPLITTER_STR));
+        }
 
         juce::XmlElement* modulationElement = element->getChildByName(XML_MODULATION_SOURCES_STR);
         if (modulationElement != nullptr) {
@@ -838,6 +1983,20 @@ void SyndicateAudioProcessor::SplitterParameters::restoreFromXml(juce::XmlElemen
         } else {
             juce::Logger::writeToLog("Missing element " + juce::String(XML_MACRO_NAMES_STR));
         }
+
+        // Older versions don't have anticipative processing, so it's disabled if missing
+        _processor->setAnticipativeLatency(element->getIntAttribute(XML_ANTICIPATIVE_LATENCY_STR, 0));
+        _processor->setInternalBlockSize(element->getIntAttribute(XML_INTERNAL_BLOCK_SIZE_STR, 0));
+        _processor->setSandboxGuestPlugins(element->getBoolAttribute(XML_SANDBOX_GUEST_PLUGINS_STR, false));
+
+        // Older versions don't have the CPU governor, use the defaults if missing
+        _processor->setCpuBudget(static_cast<float>(element->getDoubleAttribute(XML_CPU_BUDGET_STR, CpuGovernor::DEFAULT_BUDGET)));
+        const int cpuFallbacks {element->getIntAttribute(XML_CPU_FALLBACKS_STR, CpuGovernor::DEFAULT_ENABLED_FALLBACKS)};
+        for (int index {0}; index < CpuGovernor::NUM_FALLBACKS; index++) {
+            _processor->setCpuFallbackEnabled(static_cast<CPU_FALLBACK>(index), (cpuFallbacks & (1 << index)) != 0);
+        }
+
+        _processor->setFlightRecorderThreshold(static_cast<float>(element->getDoubleAttribute(XML_FLIGHT_RECORDER_THRESHOLD_STR, FlightRecorder::DEFAULT_THRESHOLD)));
     } else {
         juce::Logger::writeToLog("Restore failed - no processor");
     }
@@ -849,12 +2008,17 @@ void SyndicateAudioProcessor::SplitterParameters::writeToXml(juce::XmlElement* e
     juce::Logger::writeToLog("Not writing state - demo build");
 #else
     juce::Logger::writeToLog("Writing plugin state to XML");
+    Tracer::Scope traceScope("saveState", "state");
 
     if (_processor != nullptr) {
         // Store the splitter
         juce::XmlElement* splitterElement = element->createNewChildElement(XML_SPLITTER_STR);
         _writeSplitterToXml(splitterElement);
 
+        // Store the other scenes
+        juce::XmlElement* scenesElement = element->createNewChildElement(XML_SCENES_STR);
+        _writeScenesToXml(scenesElement);
+
         // Store the LFOs/envelopes
         juce::XmlElement* modulationElement = element->createNewChildElement(XML_MODULATION_SOURCES_STR);
         _writeModulationSourcesToXml(modulationElement);
@@ -862,14 +2026,21 @@ void SyndicateAudioProcessor::SplitterParameters::writeToXml(juce::XmlElement* e
         // Store the macro names
         juce::XmlElement* macroNamesElement = element->createNewChildElement(XML_MACRO_NAMES_STR);
         _writeMacroNamesToXml(macroNamesElement);
+
+        element->setAttribute(XML_ANTICIPATIVE_LATENCY_STR, _processor->getAnticipativeLatency());
+        element->setAttribute(XML_INTERNAL_BLOCK_SIZE_STR, _processor->getInternalBlockSize());
+        element->setAttribute(XML_SANDBOX_GUEST_PLUGINS_STR, _processor->getSandboxGuestPlugins());
+        element->setAttribute(XML_CPU_BUDGET_STR, _processor->getCpuGovernor().getBudget());
+        element->setAttribute(XML_CPU_FALLBACKS_STR, _processor->getCpuGovernor().getEnabledFallbacks());
+        element->setAttribute(XML_FLIGHT_RECORDER_THRESHOLD_STR, _processor->getFlightRecorder().getThreshold());
     } else {
         juce::Logger::writeToLog("Writing failed - no processor");
     }
 #endif
 }
 
-void SyndicateAudioProcessor::SplitterParameters::_restoreSplitterFromXml(juce::XmlElement* element) {
-    // Restore the split type before doing anything else
+SPLIT_TYPE SyndicateAudioProcessor::SplitterParameters::_restoreSplitTypeFromXml(juce::XmlElement* element) {
+    SPLIT_TYPE splitType {_processor->_splitType};
     if (element->hasAttribute(XML_SPLIT_TYPE_STR)) {
         const juce::String splitTypeString = element->getStringAttribute(XML_SPLIT_TYPE_STR);
         juce::Logger::writeToLog("Restoring split type: " + splitTypeString);
@@ -879,47 +2050,98 @@ void SyndicateAudioProcessor::SplitterParameters::_restoreSplitterFromXml(juce::
         // using a left/right split in a 2in2out configuration but will be restoring into a 1in1out
         // configuration.
         // In that case we move to a parallel split type.
-        const SPLIT_TYPE splitType {stringToSplitType(splitTypeString)};
+        splitType = stringToSplitType(splitTypeString);
         const bool isExpecting2in2out {splitType == SPLIT_TYPE::LEFTRIGHT || splitType == SPLIT_TYPE::MIDSIDE};
 
         if (isExpecting2in2out && !_processor->canDoStereoSplitTypes()) {
             // Migrate to parallel
-            _processor->setSplitType(SPLIT_TYPE::PARALLEL);
-        } else {
-            // Carry on as normal
-            _processor->setSplitType(splitType);
+            splitType = SPLIT_TYPE::PARALLEL;
         }
 
     } else {
         juce::Logger::writeToLog("Missing attribute " + juce::String(XML_SPLIT_TYPE_STR));
     }
 
-    // Now actually restore the splitter
-    WECore::AudioSpinLock lock(_processor->pluginSplitterMutex);
-    _processor->pluginSplitter->restoreFromXml(
-        element,
-        {_processor->getBusesLayout(), _processor->getSampleRate(), _processor->getBlockSize()},
-        _processor->pluginConfigurator,
-        [&](juce::String errorText) { _processor->restoreErrors.push_back(errorText); });
-    _processor->pluginSplitter->prepareToPlay(_processor->getSampleRate(), _processor->getBlockSize());
+    return splitType;
 }
 
-void SyndicateAudioProcessor::SplitterParameters::_restoreChainParameters() {
-    while (_processor->chainParameters.size() > _processor->pluginSplitter->getNumChains()) {
-        // More parameters than chains, delete them
-        _processor->chainParameters.erase(_processor->chainParameters.begin());
+void SyndicateAudioProcessor::SplitterParameters::_restoreSplitterFromXml(juce::XmlElement* element) {
+    // Work out the split type before doing anything else
+    const SPLIT_TYPE splitType {_restoreSplitTypeFromXml(element)};
+
+    // Restore into a new splitter which the audio thread can't see yet, so instantiating and
+    // restoring the plugins doesn't need the lock. The current splitter carries on processing in
+    // the meantime.
+    std::unique_ptr<PluginSplitter> restoredSplitter = _processor->_createSplitterFromXml(element, splitType);
+    if (restoredSplitter == nullptr) {
+        juce::Logger::writeToLog("Failed to create splitter to restore");
+        return;
     }
 
-    for (int chainNumber {0}; chainNumber < _processor->pluginSplitter->getNumChains(); chainNumber++) {
-        // Add parameters if needed
-        if (_processor->chainParameters.size() <= chainNumber) {
-            _processor->chainParameters.emplace_back([&]() { triggerUpdate(); });
+    // Only the swap needs the lock
+    std::shared_ptr<PluginSplitter> previousSplitter;
+    {
+        WECore::AudioSpinLock lock(_processor->pluginSplitterMutex);
+        const juce::ScopedLock pointerLock(_processor->_splitterPointerMutex);
+        previousSplitter = std::move(_processor->pluginSplitter);
+        _processor->pluginSplitter = std::move(restoredSplitter);
+        _processor->_splitType = splitType;
+        _processor->_isSplitterInitialised = true;
+    }
+
+    // The previous splitter and its plugins are deleted here, outside the lock, along with any
+    // slots the history was keeping, unless another thread is still using it
+    previousSplitter.reset();
+    _processor->_graphHistory.clear();
+
+    // The listener was added after the plugins were restored, so the latency needs updating now
+    _processor->_onLatencyChange();
+
+    // The new splitter needs the CPU governor's fallbacks applying
+    _processor->_cpuFallbackApplier.triggerAsyncUpdate();
+
+    _processor->_notifyGraphRebuild();
+}
+
+void SyndicateAudioProcessor::SplitterParameters::_restoreScenesFromXml(juce::XmlElement* element) {
+    // The restored splitter will replace the current scene, any others are replaced by the ones
+    // being restored
+    _processor->_clearScenes();
+
+    if (element == nullptr) {
+        juce::Logger::writeToLog("Missing element " + juce::String(XML_SCENES_STR));
+        return;
+    }
+
+    const int currentScene {element->getIntAttribute(XML_CURRENT_SCENE_STR, 0)};
+    if (currentScene < 0 || currentScene >= NUM_SCENES) {
+        juce::Logger::writeToLog("Invalid current scene " + juce::String(currentScene));
+        return;
+    }
+
+    for (int index {0}; index < NUM_SCENES; index++) {
+        juce::XmlElement* sceneElement = element->getChildByName(getSceneXMLName(index));
+        if (sceneElement == nullptr) {
+            continue;
         }
 
-        _processor->chainParameters[chainNumber].setBypass(_processor->pluginSplitter->getChain(chainNumber)->getChainBypass());
-        _processor->chainParameters[chainNumber].setMute(_processor->pluginSplitter->getChain(chainNumber)->getChainMute());
-        _processor->chainParameters[chainNumber].setSolo(_processor->pluginSplitter->getChainSolo(chainNumber));
+        _processor->_scenes[index].name = sceneElement->getStringAttribute(XML_SCENE_NAME_STR, getDefaultSceneName(index));
+
+        juce::XmlElement* splitterElement = sceneElement->getChildByName(XML_SPLITTER_STR);
+        if (splitterElement != nullptr && index != currentScene) {
+            juce::Logger::writeToLog("Restoring scene " + juce::String(index));
+
+            // Restored without the lock, the audio thread doesn't process other scenes
+            std::unique_ptr<PluginSplitter> sceneSplitter = _processor->_createSplitterFromXml(
+                splitterElement, _restoreSplitTypeFromXml(splitterElement));
+
+            WECore::AudioSpinLock lock(_processor->pluginSplitterMutex);
+            _processor->_scenes[index].splitter = std::move(sceneSplitter);
+        }
     }
+
+    WECore::AudioSpinLock lock(_processor->pluginSplitterMutex);
+    _processor->_currentScene = currentScene;
 }
 
 void SyndicateAudioProcessor::SplitterParameters::_restoreModulationSourcesFromXml(juce::XmlElement* element) {
@@ -956,10 +2178,9 @@ void SyndicateAudioProcessor::SplitterParameters::_restoreModulationSourcesFromX
 
             if (_processor->lfos.size() > index) {
                 // Replace an existing (default) LFO
-                _processor->lfos[index] = newLfo;
-            } else {
-                // Add a new LFO
-                _processor->lfos.push_back(newLfo);
+                _processor->lfos.replace(index, newLfo);
+            } else if (!_processor->lfos.add(newLfo)) {
+                juce::Logger::writeToLog("Too many LFOs, skipping " + lfoElementName);
             }
         }
     } else {
@@ -989,12 +2210,13 @@ void SyndicateAudioProcessor::SplitterParameters::_restoreModulationSourcesFromX
             newEnv->setLowCutHz(thisEnvelopeElement->getDoubleAttribute(XML_ENV_LOW_CUT_STR));
             newEnv->setHighCutHz(thisEnvelopeElement->getDoubleAttribute(XML_ENV_HIGH_CUT_STR));
 
+            const EnvelopeFollowerWrapper newWrapper {newEnv, static_cast<float>(thisEnvelopeElement->getDoubleAttribute(XML_ENV_AMOUNT_STR))};
+
             if (_processor->envelopes.size() > index) {
                 // Replace an existing (default) envelope
-                _processor->envelopes[index] = {newEnv, static_cast<float>(thisEnvelopeElement->getDoubleAttribute(XML_ENV_AMOUNT_STR))};
-            } else {
-                // Add a new envelope
-                _processor->envelopes.push_back({newEnv, static_cast<float>(thisEnvelopeElement->getDoubleAttribute(XML_ENV_AMOUNT_STR))});
+                _processor->envelopes.replace(index, newWrapper);
+            } else if (!_processor->envelopes.add(newWrapper)) {
+                juce::Logger::writeToLog("Too many envelopes, skipping " + envelopeElementName);
             }
         }
     } else {
@@ -1013,22 +2235,68 @@ void SyndicateAudioProcessor::SplitterParameters::_restoreMacroNamesFromXml(juce
 }
 
 void SyndicateAudioProcessor::SplitterParameters::_writeSplitterToXml(juce::XmlElement* element) {
-    WECore::AudioSpinLock lock(_processor->pluginSplitterMutex);
-    _processor->pluginSplitter->writeToXml(element);
+    DeferredPluginStates deferredStates;
+
+    {
+        // Only the structure is written while locked, which is quick
+        WECore::AudioSpinLock lock(_processor->pluginSplitterMutex);
+        if (_processor->pluginSplitter == nullptr) {
+            // Only while the split type is being changed on another thread
+            juce::Logger::writeToLog("Not writing splitter - splitter is being replaced");
+            return;
+        }
+
+        _processor->pluginSplitter->writeToXml(element, &deferredStates);
+
+        // We take responsibility for storing the split type here as when restoring the split type
+        // again later the processor can change the splitter's type but the splitter can't do it
+        // itself
+        element->setAttribute(
+            XML_SPLIT_TYPE_STR, splitTypeToString(_processor->pluginSplitter->getSplitType()));
+    }
+
+    // Collecting the plugins' state can take a while, so it's done without blocking the audio
+    // thread. The plugins are kept alive until it's done even if they're removed in the meantime.
+    deferredStates.write();
+}
+
+void SyndicateAudioProcessor::SplitterParameters::_writeScenesToXml(juce::XmlElement* element) {
+    DeferredPluginStates deferredStates;
+
+    {
+        // The current scene is written as the main splitter, only the other scenes' splitters are
+        // written here
+        WECore::AudioSpinLock lock(_processor->pluginSplitterMutex);
+        element->setAttribute(XML_CURRENT_SCENE_STR, _processor->_currentScene);
+
+        for (int index {0}; index < _processor->_scenes.size(); index++) {
+            juce::XmlElement* sceneElement = element->createNewChildElement(getSceneXMLName(index));
+            sceneElement->setAttribute(XML_SCENE_NAME_STR, _processor->_scenes[index].name);
+
+            // A scene that's being faded out is still stored
+            PluginSplitter* splitter {
+                index == _processor->_outgoingScene ? _processor->_outgoingSplitter.get() : _processor->_scenes[index].splitter.get()
+            };
+
+            if (splitter != nullptr) {
+                juce::XmlElement* splitterElement = sceneElement->createNewChildElement(XML_SPLITTER_STR);
+                splitter->writeToXml(splitterElement, &deferredStates);
+                splitterElement->setAttribute(XML_SPLIT_TYPE_STR, splitTypeToString(splitter->getSplitType()));
+            }
+        }
+    }
 
-    // We take responsibility for storing the split type here as when restoring the split type
-    // again later the processor can change the splitter's type but the splitter can't do it
-    // itself
-    element->setAttribute(
-        XML_SPLIT_TYPE_STR, splitTypeToString(_processor->pluginSplitter->getSplitType()));
+    deferredStates.write();
 }
 
 void SyndicateAudioProcessor::SplitterParameters::_writeModulationSourcesToXml(juce::XmlElement* element) {
     // LFOs
+    // The host may save from any thread, so read the sources in the same way as the audio thread
+    LfoRegistry::ReadScope lfoScope(_processor->lfos);
     juce::XmlElement* lfosElement = element->createNewChildElement(XML_LFOS_STR);
-    for (int index {0}; index < _processor->lfos.size(); index++) {
+    for (int index {0}; index < lfoScope.size(); index++) {
         juce::XmlElement* thisLfoElement = lfosElement->createNewChildElement(getLfoXMLName(index));
-        std::shared_ptr<WECore::Richter::RichterLFO> thisLfo = _processor->lfos[index];
+        std::shared_ptr<WECore::Richter::RichterLFO> thisLfo = lfoScope[index];
 
         thisLfoElement->setAttribute(XML_LFO_BYPASS_STR, thisLfo->getBypassSwitch());
         thisLfoElement->setAttribute(XML_LFO_PHASE_SYNC_STR, thisLfo->getPhaseSyncSwitch());
@@ -1045,10 +2313,11 @@ void SyndicateAudioProcessor::SplitterParameters::_writeModulationSourcesToXml(j
     }
 
     // Envelopes
+    EnvelopeRegistry::ReadScope envelopeScope(_processor->envelopes);
     juce::XmlElement* envelopesElement = element->createNewChildElement(XML_ENVELOPES_STR);
-    for (int index {0}; index < _processor->envelopes.size(); index++) {
+    for (int index {0}; index < envelopeScope.size(); index++) {
         juce::XmlElement* thisEnvelopeElement = envelopesElement->createNewChildElement(getEnvelopeXMLName(index));
-        EnvelopeFollowerWrapper thisEnvelope = _processor->envelopes[index];
+        EnvelopeFollowerWrapper thisEnvelope = envelopeScope[index];
 
         thisEnvelopeElement->setAttribute(XML_ENV_ATTACK_TIME_STR, thisEnvelope.envelope->getAttackTimeMs());
         thisEnvelopeElement->setAttribute(XML_ENV_RELEASE_TIME_STR, thisEnvelope.envelope->getReleaseTimeMs());
@@ -1067,7 +2336,9 @@ void SyndicateAudioProcessor::SplitterParameters::_writeMacroNamesToXml(juce::Xm
 
 void SyndicateAudioProcessor::_onLatencyChange() {
     if (pluginSplitter != nullptr) {
-        setLatencySamples(pluginSplitter->getLatencySamples());
+        setLatencySamples(pluginSplitter->getLatencySamples()
+                          + _anticipativeProcessor.getLatencySamples()
+                          + _fixedBlockProcessor.getLatencySamples());
     }
 }
 
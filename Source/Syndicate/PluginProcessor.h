@@ -22,10 +22,22 @@
 #include "ParameterData.h"
 #include "RichterLFO/RichterLFO.h"
 #include "EnvelopeFollowerWrapper.h"
+#include "ModulationSourceRegistry.h"
 #include "PluginConfigurator.h"
+#include "AnticipativeProcessor.h"
+#include "FixedBlockProcessor.h"
+#include "WorkerPool.h"
+#include "GainPanMeter.h"
+#include "CpuGovernor.h"
+#include "FlightRecorder.h"
+#include "GraphChangeNotifier.h"
+#include "GraphHistory.h"
 
 class SyndicateAudioProcessorEditor;
 
+typedef ModulationSourceRegistry<std::shared_ptr<WECore::Richter::RichterLFO>, MAX_NUM_LFOS> LfoRegistry;
+typedef ModulationSourceRegistry<EnvelopeFollowerWrapper, MAX_NUM_ENVELOPES> EnvelopeRegistry;
+
 //==============================================================================
 /**
 */
@@ -36,14 +48,14 @@ public:
     PluginScanClient pluginScanClient;
     PluginSelectorState pluginSelectorState; // TODO convert this to a custom parameter
     PluginParameterSelectorState pluginParameterSelectorState;
-    std::unique_ptr<PluginSplitter> pluginSplitter;
+    std::shared_ptr<PluginSplitter> pluginSplitter;
     WECore::AudioSpinMutex pluginSplitterMutex;
     std::vector<ChainParameters> chainParameters;
-    std::vector<std::shared_ptr<WECore::Richter::RichterLFO>> lfos;
-    std::vector<EnvelopeFollowerWrapper> envelopes;
+    LfoRegistry lfos;
+    EnvelopeRegistry envelopes;
     PluginConfigurator pluginConfigurator;
     std::array<juce::String, NUM_MACROS> macroNames;
-    std::array<WECore::AREnv::AREnvelopeFollowerSquareLaw, 2> meterEnvelopes;
+    GainPanMeter outputGainPanMeter;
     std::vector<juce::String> restoreErrors; // Populated during restore, displayed and cleared when the UI is opened
 
     //==============================================================================
@@ -87,8 +99,8 @@ public:
     void removeEditor() { _editor = nullptr; }
 
     float getModulationValueForSource(int id, MODULATION_TYPE type);
-    void addLfo();
-    void addEnvelope();
+    bool addLfo();
+    bool addEnvelope();
     void removeModulationSource(ModulationSourceDefinition definition);
 
     void setSplitType(SPLIT_TYPE splitType);
@@ -113,7 +125,137 @@ public:
 
     void insertGainStage(int chainNumber, int pluginNumber);
 
-    void moveSlot(int fromChainNumber, int fromSlotNumber, int toChainNumber, int toSlotNumber);
+    /**
+     * Moves a slot within or between chains. Returns false if either chain or the slot doesn't
+     * exist.
+     */
+    bool moveSlot(int fromChainNumber, int fromSlotNumber, int toChainNumber, int toSlotNumber);
+
+    /**
+     * A batch of edits to the slots in the graph, applied in order by applyGraphTransaction().
+     */
+    class GraphTransaction {
+    public:
+        void insertPlugin(std::shared_ptr<juce::AudioPluginInstance> plugin, int chainNumber, int slotNumber) {
+            _edits.push_back({EDIT_TYPE::INSERT_PLUGIN, std::move(plugin), chainNumber, slotNumber});
+        }
+
+        void replacePlugin(std::shared_ptr<juce::AudioPluginInstance> plugin, int chainNumber, int slotNumber) {
+            _edits.push_back({EDIT_TYPE::REPLACE_PLUGIN, std::move(plugin), chainNumber, slotNumber});
+        }
+
+        void removeSlot(int chainNumber, int slotNumber) {
+            _edits.push_back({EDIT_TYPE::REMOVE_SLOT, nullptr, chainNumber, slotNumber});
+        }
+
+        void insertGainStage(int chainNumber, int slotNumber) {
+            _edits.push_back({EDIT_TYPE::INSERT_GAIN_STAGE, nullptr, chainNumber, slotNumber});
+        }
+
+        bool isEmpty() const { return _edits.empty(); }
+
+    private:
+        friend class SyndicateAudioProcessor;
+
+        enum class EDIT_TYPE {
+            INSERT_PLUGIN,
+            REPLACE_PLUGIN,
+            REMOVE_SLOT,
+            INSERT_GAIN_STAGE
+        };
+
+        struct Edit {
+            EDIT_TYPE type;
+            std::shared_ptr<juce::AudioPluginInstance> plugin;
+            int chainNumber;
+            int slotNumber;
+        };
+
+        std::vector<Edit> _edits;
+    };
+
+    /**
+     * Applies the edits with a single lock of the splitter, latency compensation pass, plan
+     * rebuild, and UI update, rather than one of each per edit. The plugins are sandboxed,
+     * configured for their chain's layout, and prepared before the splitter is locked, and the plan
+     * is rebuilt after it's unlocked. Only chains whose layout has to change are configured again,
+     * with the splitter suspended.
+     *
+     * Returns false if any of the plugins couldn't be configured, the edits for those plugins are
+     * skipped.
+     */
+    bool applyGraphTransaction(GraphTransaction transaction);
+
+    /**
+     * Undoes or redoes the last slot edit (transactions, moves, and nested splitter insertions) by
+     * moving the affected slots back into place, without reloading any plugins. The history is
+     * cleared when the graph is changed in any other way, eg. by changing the split type or
+     * number of chains, or restoring or switching scene.
+     *
+     * Returns false if there was nothing to undo or redo.
+     */
+    bool undoGraphEdit();
+    bool redoGraphEdit();
+
+    // Nested splitters
+    bool insertSplitter(int chainNumber, int slotNumber, SPLIT_TYPE splitType);
+
+    // Anticipative processing
+    void setAnticipativeLatency(int numSamples);
+    int getAnticipativeLatency() const { return _anticipativeProcessor.getRequestedLatencySamples(); }
+
+    // Internal block size
+    void setInternalBlockSize(int numSamples);
+    int getInternalBlockSize() const { return _fixedBlockProcessor.getBlockSize(); }
+
+    // Sandboxing
+    void setSandboxGuestPlugins(bool shouldSandbox);
+    bool getSandboxGuestPlugins() const { return _shouldSandboxGuestPlugins; }
+
+    // Chain freezing
+    void startChainFreeze(int chainNumber);
+    bool completeChainFreeze(int chainNumber);
+    void unfreezeChain(int chainNumber);
+
+    // CPU governor
+    void setCpuBudget(float budget);
+    void setCpuFallbackEnabled(CPU_FALLBACK fallback, bool isEnabled);
+    const CpuGovernor& getCpuGovernor() const { return _cpuGovernor; }
+
+    // Deadline miss reports
+    void setFlightRecorderThreshold(float threshold);
+    const FlightRecorder& getFlightRecorder() const { return _flightRecorder; }
+
+    // Tracing, shared by every instance in the process. startTrace() returns false if the last
+    // trace is still being exported, stopTrace() returns the exported trace file or an invalid file
+    // if it couldn't be written
+    bool startTrace();
+    juce::File stopTrace();
+    bool isTracing() const;
+
+    // Sends changes to the chains, slots, and crossovers to the UI
+    GraphChangeNotifier& getGraphChangeNotifier() { return _graphChangeNotifier; }
+
+    // Scenes are exposed to the host as programs. Each one is a complete graph which is kept
+    // instantiated and prepared while it isn't being used, so switching doesn't need to load
+    // anything.
+    static constexpr int NUM_SCENES {8};
+    static constexpr double SCENE_FADE_SECONDS {0.02};
+
+    /**
+     * Makes the given scene the current one at the start of the next block, crossfading from the
+     * previous scene over SCENE_FADE_SECONDS. If the scenes have different latencies they'd be
+     * misaligned during a crossfade, so the previous scene is faded out before the new one is faded
+     * in over the same time instead. If the scene is empty it's first created as a copy of
+     * the current scene, which needs its plugins instantiating.
+     *
+     * Returns false if the scene couldn't be switched to.
+     */
+    bool switchToScene(int index);
+    int getCurrentScene() const { return _currentScene; }
+
+    juce::String getSceneName(int index) const;
+    void setSceneName(int index, const juce::String& name);
 
     /**
      * Returns true if split types that require a stereo in/out configuration can be used.
@@ -140,32 +282,327 @@ private:
     private:
         SyndicateAudioProcessor* _processor;
 
+        SPLIT_TYPE _restoreSplitTypeFromXml(juce::XmlElement* element);
         void _restoreSplitterFromXml(juce::XmlElement* element);
-        void _restoreChainParameters();
+        void _restoreScenesFromXml(juce::XmlElement* element);
         void _restoreModulationSourcesFromXml(juce::XmlElement* element);
         void _restoreMacroNamesFromXml(juce::XmlElement* element);
 
         void _writeSplitterToXml(juce::XmlElement* element);
+        void _writeScenesToXml(juce::XmlElement* element);
         void _writeModulationSourcesToXml(juce::XmlElement* element);
         void _writeMacroNamesToXml(juce::XmlElement* element);
     };
 
+    /**
+     * Applies the chain parameters to the splitter on the message thread when they're changed from
+     * another thread.
+     */
+    class ChainParametersApplier : public juce::AsyncUpdater {
+    public:
+        explicit ChainParametersApplier(SyndicateAudioProcessor& processor) : _processor(processor) { }
+
+        void handleAsyncUpdate() override { _processor._applyChainParameters(); }
+
+    private:
+        SyndicateAudioProcessor& _processor;
+    };
+
+    /**
+     * Applies the CPU governor's fallbacks on the message thread when it changes level on the audio
+     * thread.
+     */
+    class CpuFallbackApplier : public juce::AsyncUpdater {
+    public:
+        explicit CpuFallbackApplier(SyndicateAudioProcessor& processor) : _processor(processor) { }
+
+        void handleAsyncUpdate() override { _processor._applyCpuFallbacks(); }
+
+    private:
+        SyndicateAudioProcessor& _processor;
+    };
+
+    /**
+     * Wakes the hibernated chains of the splitter one at a time on the message thread, so each
+     * chain passes audio through until its own plugins are ready rather than the whole splitter
+     * waiting for all of them.
+     */
+    class ChainWaker : public juce::AsyncUpdater {
+    public:
+        explicit ChainWaker(SyndicateAudioProcessor& processor) : _processor(processor) { }
+
+        void handleAsyncUpdate() override { _processor._wakeNextHibernatedChain(); }
+
+    private:
+        SyndicateAudioProcessor& _processor;
+    };
+
+    /**
+     * Rebuilds the description of the graph used by deadline miss reports on the message thread
+     * whenever the graph changes, so writing a report never needs to walk the splitter.
+     */
+    class ReportContextUpdater : public juce::AsyncUpdater,
+                                 public GraphChangeNotifier::Listener {
+    public:
+        explicit ReportContextUpdater(SyndicateAudioProcessor& processor) : _processor(processor) { }
+
+        void handleAsyncUpdate() override { _processor._updateReportContext(); }
+
+        void onGraphChanged(const GraphChangeNotifier::Changes& /*changes*/) override { _processor._updateReportContext(); }
+
+    private:
+        SyndicateAudioProcessor& _processor;
+    };
+
+    /**
+     * Returns the previous scene's splitter to its scene on the message thread once the audio
+     * thread has finished crossfading from it.
+     */
+    class SceneFadeCompleter : public juce::AsyncUpdater {
+    public:
+        explicit SceneFadeCompleter(SyndicateAudioProcessor& processor) : _processor(processor) { }
+
+        void handleAsyncUpdate() override { _processor._completeSceneFade(); }
+
+    private:
+        SyndicateAudioProcessor& _processor;
+    };
+
+    /**
+     * Switches to the scene requested by the host on the message thread, as the host may change
+     * program from any thread.
+     */
+    class SceneSwitcher : public juce::AsyncUpdater {
+    public:
+        explicit SceneSwitcher(SyndicateAudioProcessor& processor) : _processor(processor) { }
+
+        void handleAsyncUpdate() override { _processor._switchToPendingScene(); }
+
+    private:
+        SyndicateAudioProcessor& _processor;
+    };
+
+    /**
+     * Stops the audio thread processing the splitters (the audio passes through unprocessed as it
+     * does while they're locked) without holding pluginSplitterMutex, so slow work such as
+     * preparing every plugin can be done on the message thread outside the lock. Waits for any
+     * block already being processed to finish.
+     */
+    class SplitterSuspendScope {
+    public:
+        explicit SplitterSuspendScope(SyndicateAudioProcessor& processor);
+        ~SplitterSuspendScope();
+
+    private:
+        SyndicateAudioProcessor& _processor;
+        bool _wasSuspended;
+    };
+
+    struct Scene {
+        // Nullptr for the current scene (whose splitter is pluginSplitter), the scene being faded
+        // out, and scenes which haven't been created
+        std::shared_ptr<PluginSplitter> splitter;
+        juce::String name;
+    };
+
     MainLogger _logger;
     SyndicateAudioProcessorEditor* _editor;
     SPLIT_TYPE _splitType;
-    double _outputGainLinear;
+    std::atomic<float> _outputGainLinear;
 
     SplitterParameters* _splitterParameters;
 
     bool _isSplitterInitialised;
 
+    // Set by SplitterSuspendScope
+    std::atomic<bool> _isSplitterSuspended;
+
+    // Held along with pluginSplitterMutex whenever pluginSplitter is replaced, so other threads can
+    // take a reference to it without contending with the audio thread
+    juce::CriticalSection _splitterPointerMutex;
+
+    // If true newly selected plugins are run in the plugin host server
+    bool _shouldSandboxGuestPlugins;
+
+    ChainParametersApplier _chainParametersApplier;
+    CpuFallbackApplier _cpuFallbackApplier;
+    ChainWaker _chainWaker;
+    ReportContextUpdater _reportContextUpdater;
+
+    GraphChangeNotifier _graphChangeNotifier;
+
+    // Message thread only
+    GraphHistory _graphHistory;
+
+    // The splitters of the scenes are guarded by pluginSplitterMutex
+    std::array<Scene, NUM_SCENES> _scenes;
+    int _currentScene;
+
+    // The previous scene's splitter while the audio thread crossfades from it, guarded by
+    // pluginSplitterMutex along with the fade position
+    std::shared_ptr<PluginSplitter> _outgoingSplitter;
+    int _outgoingScene;
+    int _sceneFadeLength;
+    int _sceneFadeSamplesRemaining;
+    bool _isSceneFadeThroughSilence;
+
+    // Audio thread only, the block as processed by the outgoing splitter
+    juce::AudioBuffer<float> _sceneFadeBuffer;
+    juce::MidiBuffer _sceneFadeMidi;
+
+    SceneFadeCompleter _sceneFadeCompleter;
+
+    // The scene the host last asked for from setCurrentProgram(), or -1 once it's been switched to
+    std::atomic<int> _pendingScene;
+    SceneSwitcher _sceneSwitcher;
+
+    CpuGovernor _cpuGovernor;
+
+    // Audio thread only, the modulation sources are advanced every _modulationRateDivider samples
+    // starting from _nextModulationSample in the next block
+    int _modulationRateDivider;
+    int _nextModulationSample;
+
+    // The macros, then the LFOs, then the envelopes
+    static constexpr int NUM_MODULATION_VALUES {NUM_MACROS + MAX_NUM_LFOS + MAX_NUM_ENVELOPES};
+
+    // The values of the modulation sources when the block being processed arrived, or nullptr if
+    // it's being processed as it arrives and the sources can be read directly. Only used by the
+    // thread processing the splitter.
+    const std::vector<float>* _blockModulationValues;
+
+    // The governor level the fallbacks were last applied for, only used for logging
+    int _appliedCpuGovernorLevel;
+
+    // The last description of the graph built on the message thread, copied into each deadline
+    // miss report
+    FlightRecorder::ReportContext _graphReportContext;
+    juce::CriticalSection _reportContextMutex;
+
+    // Records the stages of recent blocks and writes a report when one misses its deadline
+    FlightRecorder _flightRecorder;
+
+    // Used to process independent chains concurrently, shared with every other instance in the
+    // process
+    std::shared_ptr<WorkerPool> _workerPool;
+
+    FixedBlockProcessor _fixedBlockProcessor;
+
+    // Declared last so its worker thread is stopped before anything it processes is deleted
+    AnticipativeProcessor _anticipativeProcessor;
+
     std::vector<juce::String> _provideParamNamesForMigration() override;
     void _migrateParamValues(std::vector<float>& paramValues) override;
 
     void _onParameterUpdate() override;
 
+    void _applyChainParameters();
+
+    /**
+     * Applies the parameters of a single chain to the splitter, waking the chain first if it's
+     * being unmuted while hibernated. Message thread only. Returns true if anything changed.
+     */
+    bool _applyChainParameters(size_t chainIndex);
+
+    void _onChainParametersUpdate(const ChainParameters& params);
+
+    bool _applyGraphHistory(bool isUndo);
+
+    /**
+     * Sets the chain parameters to match the chains of the current splitter.
+     */
+    void _updateChainParametersFromSplitter();
+
     void _resetModulationSources();
 
+    /**
+     * Stores the current value of every modulation source, called on the audio thread when a
+     * block is queued to be processed ahead of time.
+     */
+    void _saveModulationValues(std::vector<float>& values);
+
+    /**
+     * Wakes any hibernated chains the splitter's split type processes, except muted chains the CPU
+     * governor has unloaded. Unmuted chains would pass audio through unprocessed while hibernated,
+     * so this is done before a splitter is made visible to the audio thread.
+     */
+    void _wakeHibernatedChains(PluginSplitter& splitter);
+
+    /**
+     * Wakes the first hibernated chain the current splitter processes, and triggers _chainWaker
+     * again if there are more.
+     */
+    void _wakeNextHibernatedChain();
+
+    /**
+     * Replaces the description of the graph used by deadline miss reports. Must be called on the
+     * message thread.
+     */
+    void _updateReportContext();
+
+    /**
+     * Tells the editor and the deadline miss reports that the structure of the graph has changed.
+     */
+    void _notifyGraphRebuild();
+
+    /**
+     * Returns a reference to the current splitter which stays valid if it's replaced meanwhile.
+     * Doesn't lock pluginSplitterMutex.
+     */
+    std::shared_ptr<PluginSplitter> _getSplitter();
+
+    void _applyCpuFallbacks();
+
+    void _processSplitter(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, juce::AudioPlayHead* playHead);
+
+    /**
+     * Sandboxes the plugin if needed and configures it for the given chain. Returns the plugin to
+     * insert (which may be a sandboxed replacement), or nullptr if it couldn't be configured.
+     */
+    std::shared_ptr<juce::AudioPluginInstance> _configurePlugin(std::shared_ptr<juce::AudioPluginInstance> plugin,
+                                                                int chainNumber,
+                                                                const HostConfiguration& configuration);
+
+    /**
+     * Returns the size of the blocks the splitter is processed in, which is either the internal
+     * block size or the host's block size.
+     */
+    int _getSplitterBlockSize() const;
+
+    /**
+     * Creates a splitter of the given type which takes over the chains of the previous splitter,
+     * or has the default chains if previousSplitter is nullptr. Returns nullptr if the split type
+     * can't be used with the current layout.
+     */
+    std::unique_ptr<PluginSplitter> _createSplitter(SPLIT_TYPE splitType, PluginSplitter* previousSplitter);
+
+    /**
+     * Creates a splitter of the given type from XML written by PluginSplitter::writeToXml(), with
+     * its plugins restored, configured and prepared. Nothing else can see the splitter yet so this
+     * doesn't need the lock. Returns nullptr if the splitter couldn't be created.
+     */
+    std::unique_ptr<PluginSplitter> _createSplitterFromXml(juce::XmlElement* element, SPLIT_TYPE splitType);
+
+    /**
+     * Creates a copy of the current splitter, including the state of its plugins.
+     */
+    std::unique_ptr<PluginSplitter> _copySplitter();
+
+    /**
+     * Calls the function with the splitter of every scene other than the current one, including
+     * one that's being faded out. Must be called with pluginSplitterMutex locked.
+     */
+    void _forEachSceneSplitter(std::function<void(PluginSplitter&)> callback);
+
+    void _completeSceneFade();
+
+    void _switchToPendingScene();
+
+    /**
+     * Deletes every scene other than the current one, which becomes the first scene.
+     */
+    void _clearScenes();
+
     void _onLatencyChange() override;
 
     //==============================================================================
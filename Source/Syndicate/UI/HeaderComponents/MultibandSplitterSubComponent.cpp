@@ -64,3 +64,12 @@ void MultibandSplitterSubComponent::buttonClicked(juce::Button* buttonThatWasCli
 void MultibandSplitterSubComponent::onParameterUpdate() {
     crossoverComponent->onParameterUpdate();
 }
+
+void MultibandSplitterSubComponent::onChainParametersUpdate(int /*chainNumber*/) {
+    // The band buttons are drawn as part of the crossover
+    crossoverComponent->onParameterUpdate();
+}
+
+void MultibandSplitterSubComponent::onCrossoverUpdate() {
+    crossoverComponent->onParameterUpdate();
+}
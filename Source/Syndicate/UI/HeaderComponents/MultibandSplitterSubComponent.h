@@ -11,6 +11,8 @@ public:
     ~MultibandSplitterSubComponent() override;
 
     void onParameterUpdate() override;
+    void onChainParametersUpdate(int chainNumber) override;
+    void onCrossoverUpdate() override;
 
     void resized() override;
     void buttonClicked(juce::Button* buttonThatWasClicked) override;
@@ -67,6 +67,13 @@ void ParallelSplitterSubComponent::onParameterUpdate() {
     }
 }
 
+void ParallelSplitterSubComponent::onChainParametersUpdate(int chainNumber) {
+    // The header is only rebuilt on the message thread, so it doesn't need locking here
+    if (chainNumber >= 0 && chainNumber < _chainButtons.size()) {
+        _chainButtons[chainNumber]->onParameterUpdate();
+    }
+}
+
 void ParallelSplitterSubComponent::_rebuildHeader() {
     // Set up the scrollable view
     const size_t numChains {_processor.pluginSplitter->getNumChains()};
@@ -14,6 +14,7 @@ public:
     ~ParallelSplitterSubComponent() override;
 
     void onParameterUpdate() override;
+    void onChainParametersUpdate(int chainNumber) override;
 
     void resized() override;
     void buttonClicked(juce::Button* buttonThatWasClicked) override;
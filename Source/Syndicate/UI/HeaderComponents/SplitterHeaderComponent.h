@@ -8,4 +8,15 @@ public:
     SplitterHeaderComponent() = default;
 
     virtual void onParameterUpdate() = 0;
+
+    /**
+     * Called when the bypass, mute, or solo of a single chain has changed. Headers with many chains
+     * can override this to refresh only that chain.
+     */
+    virtual void onChainParametersUpdate(int chainNumber) { onParameterUpdate(); }
+
+    /**
+     * Called when a crossover has moved.
+     */
+    virtual void onCrossoverUpdate() { }
 };
@@ -86,13 +86,15 @@ void ModulationBar::resized() {
 
 void ModulationBar::buttonClicked(juce::Button* buttonThatWasClicked) {
     if (buttonThatWasClicked == _addLfoButton.get()) {
-        _processor.addLfo();
-        _resetButtons();
-        _selectModulationSource(_lfoButtons[_lfoButtons.size() - 1].get());
+        if (_processor.addLfo()) {
+            _resetButtons();
+            _selectModulationSource(_lfoButtons[_lfoButtons.size() - 1].get());
+        }
     } else if (buttonThatWasClicked == _addEnvelopeButton.get()) {
-        _processor.addEnvelope();
-        _resetButtons();
-        _selectModulationSource(_envelopeButtons[_envelopeButtons.size() - 1].get());
+        if (_processor.addEnvelope()) {
+            _resetButtons();
+            _selectModulationSource(_envelopeButtons[_envelopeButtons.size() - 1].get());
+        }
     }
 }
 
@@ -3,10 +3,33 @@
 #include "OutputComponent.h"
 
 OutputMeter::OutputMeter(const SyndicateAudioProcessor& processor) :
-            _processor(processor) {
+            _processor(processor), _cpuGovernorLevel(0) {
     setFramesPerSecond(20);
 }
 
+void OutputMeter::update() {
+    // List the fallbacks in the tooltip when the level changes
+    const CpuGovernor& governor = _processor.getCpuGovernor();
+    const int level {governor.getLevel()};
+
+    if (level != _cpuGovernorLevel) {
+        _cpuGovernorLevel = level;
+
+        juce::String tooltip("Output level");
+        if (level > 0) {
+            tooltip += " - reduced quality to save CPU:";
+            for (int index {0}; index < CpuGovernor::NUM_FALLBACKS; index++) {
+                const CPU_FALLBACK fallback {static_cast<CPU_FALLBACK>(index)};
+                if (governor.isFallbackActive(fallback)) {
+                    tooltip += " " + CpuGovernor::fallbackToString(fallback) + ".";
+                }
+            }
+        }
+
+        setTooltip(tooltip);
+    }
+}
+
 void OutputMeter::paint(juce::Graphics& g) {
     g.fillAll(UIUtils::backgroundColour);
 
@@ -29,7 +52,7 @@ void OutputMeter::paint(juce::Graphics& g) {
 
 
     for (int channel {0}; channel < numChannels; channel++) {
-        const float gaindB = WECore::CoreMath::linearTodB(_processor.meterEnvelopes[channel].getLastOutput());
+        const float gaindB = WECore::CoreMath::linearTodB(_processor.outputGainPanMeter.getOutputAmplitude(channel));
         const int meterHeight = dBToHeight(gaindB);
 
         availableArea.removeFromLeft(MARGIN);
@@ -49,6 +72,13 @@ void OutputMeter::paint(juce::Graphics& g) {
             g.fillRect(meterArea);
         }
     }
+
+    // Show that quality has been reduced, details are in the tooltip
+    if (_cpuGovernorLevel > 0) {
+        g.setColour(UIUtils::neutralHighlightColour);
+        g.setFont(juce::Font(12.0f, juce::Font::bold));
+        g.drawText("CPU " + juce::String(_cpuGovernorLevel), getLocalBounds().removeFromTop(16), juce::Justification::centred);
+    }
 }
 
 OutputComponent::OutputComponent(SyndicateAudioProcessor& processor) : _processor(processor) {
@@ -6,7 +6,8 @@
 #include "UIUtils.h"
 
 /**
- * Displays the output amplitude of this gain stage.
+ * Displays the output amplitude of this gain stage, and whether the CPU governor has reduced
+ * quality.
  */
 class OutputMeter : public juce::AnimatedAppComponent,
                     public juce::SettableTooltipClient {
@@ -14,14 +15,13 @@ public:
     OutputMeter(const SyndicateAudioProcessor& processor);
     ~OutputMeter() = default;
 
-    void update() override {
-        // Do nothing
-    }
+    void update() override;
 
     void paint(juce::Graphics& g) override;
 
 private:
     const SyndicateAudioProcessor& _processor;
+    int _cpuGovernorLevel;
 };
 
 class OutputComponent : public juce::Component, public juce::Slider::Listener {
@@ -25,6 +25,7 @@
 #include "ParallelSplitterSubComponent.h"
 #include "ParameterData.h"
 #include "SeriesSplitterSubComponent.h"
+#include "Tracer.h"
 //[/Headers]
 
 #include "PluginEditor.h"
@@ -97,6 +98,7 @@ SyndicateAudioProcessorEditor::SyndicateAudioProcessorEditor (SyndicateAudioProc
 
     //[Constructor] You can add your own custom stuff here..
     _processor.setEditor(this);
+    _processor.getGraphChangeNotifier().addListener(this);
 
     _setSliderRanges();
 
@@ -110,6 +112,9 @@ SyndicateAudioProcessorEditor::SyndicateAudioProcessorEditor (SyndicateAudioProc
 
     _displayErrorsIfNeeded();
 
+    // For the undo/redo shortcuts
+    setWantsKeyboardFocus(true);
+
     //[/Constructor]
 }
 
@@ -117,6 +122,7 @@ SyndicateAudioProcessorEditor::~SyndicateAudioProcessorEditor()
 {
     //[Destructor_pre]. You can add your own custom destruction code here..
     _processor.setEditor(nullptr);
+    _processor.getGraphChangeNotifier().removeListener(this);
     _tooltipLabelUpdater.stop();
     //[/Destructor_pre]
 
@@ -161,11 +167,49 @@ void SyndicateAudioProcessorEditor::resized()
 
 //[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
 void SyndicateAudioProcessorEditor::needsGraphRebuild() {
+    Tracer::Scope traceScope("rebuildGraphView", "ui");
+
     splitterButtonsBar->onParameterUpdate();
     _updateSplitterHeader();
     graphView->onParameterUpdate();
 }
 
+void SyndicateAudioProcessorEditor::onGraphChanged(const GraphChangeNotifier::Changes& changes) {
+    if (changes.contains(GRAPH_CHANGE::CROSSOVER)) {
+        splitterHeader->onCrossoverUpdate();
+    }
+
+    for (int chainNumber : changes.getTargets(GRAPH_CHANGE::CHAIN_FLAGS)) {
+        splitterHeader->onChainParametersUpdate(chainNumber);
+    }
+
+    // Only the chains with changed slots need rebuilding
+    std::set<int> chainsToRebuild = changes.getTargets(GRAPH_CHANGE::SLOT);
+    const std::set<int>& modulationChains = changes.getTargets(GRAPH_CHANGE::MODULATION_ROUTING);
+    chainsToRebuild.insert(modulationChains.begin(), modulationChains.end());
+
+    if (!chainsToRebuild.empty()) {
+        graphView->onChainsUpdate(chainsToRebuild);
+    }
+}
+
+bool SyndicateAudioProcessorEditor::keyPressed(const juce::KeyPress& key) {
+    const juce::ModifierKeys redoModifiers {juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier};
+
+    // If there's nothing to undo or redo the key is left for the host
+    if (key == juce::KeyPress('z', juce::ModifierKeys::commandModifier, 0)) {
+        return _processor.undoGraphEdit();
+    } else if (key == juce::KeyPress('z', redoModifiers, 0) ||
+               key == juce::KeyPress('y', juce::ModifierKeys::commandModifier, 0)) {
+        return _processor.redoGraphEdit();
+    } else if (key == juce::KeyPress('t', redoModifiers, 0)) {
+        _toggleTrace();
+        return true;
+    }
+
+    return false;
+}
+
 void SyndicateAudioProcessorEditor::_enableDoubleClickToDefault() {
     // TODO
 }
@@ -240,6 +284,33 @@ void SyndicateAudioProcessorEditor::_displayErrorsIfNeeded() {
     }
 }
 
+void SyndicateAudioProcessorEditor::_toggleTrace() {
+    juce::String title;
+    juce::String bodyText;
+
+    if (_processor.isTracing()) {
+        const juce::File traceFile {_processor.stopTrace()};
+
+        if (traceFile != juce::File()) {
+            title = "Trace saved, open it at ui.perfetto.dev:";
+            bodyText = traceFile.getFullPathName();
+        } else {
+            title = "Failed to save the trace";
+            bodyText = "See the log for details";
+        }
+    } else if (_processor.startTrace()) {
+        title = "Tracing started";
+        bodyText = "Press the same keys again to stop tracing and save the trace";
+    } else {
+        title = "Failed to start tracing";
+        bodyText = "The last trace is still being saved, try again in a moment";
+    }
+
+    _tracePopover.reset(new UIUtils::PopoverComponent(title, bodyText, [&]() {_tracePopover.reset(); }));
+    addAndMakeVisible(_tracePopover.get());
+    _tracePopover->setBounds(getLocalBounds());
+}
+
 //[/MiscUserCode]
 
 
@@ -253,7 +324,7 @@ void SyndicateAudioProcessorEditor::_displayErrorsIfNeeded() {
 BEGIN_JUCER_METADATA
 
 <JUCER_COMPONENT documentType="Component" className="SyndicateAudioProcessorEditor"
-                 componentName="" parentClasses="public WECore::JUCEPlugin::CoreProcessorEditor, public juce::DragAndDropContainer"
+                 componentName="" parentClasses="public WECore::JUCEPlugin::CoreProcessorEditor, public juce::DragAndDropContainer, public GraphChangeNotifier::Listener"
                  constructorParams="SyndicateAudioProcessor&amp; ownerProcessor"
                  variableInitialisers="CoreProcessorEditor(ownerProcessor), _processor(ownerProcessor), _isHeaderInitialised(false)"
                  snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330"
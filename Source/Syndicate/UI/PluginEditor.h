@@ -44,7 +44,8 @@
                                                                     //[/Comments]
 */
 class SyndicateAudioProcessorEditor  : public WECore::JUCEPlugin::CoreProcessorEditor,
-                                       public juce::DragAndDropContainer
+                                       public juce::DragAndDropContainer,
+                                       public GraphChangeNotifier::Listener
 {
 public:
     //==============================================================================
@@ -54,6 +55,8 @@ public:
     //==============================================================================
     //[UserMethods]     -- You can add your own custom methods in this section.
     void needsGraphRebuild();
+    void onGraphChanged(const GraphChangeNotifier::Changes& changes) override;
+    bool keyPressed(const juce::KeyPress& key) override;
     //[/UserMethods]
 
     void paint (juce::Graphics& g) override;
@@ -68,6 +71,7 @@ private:
     std::unique_ptr<SplitterHeaderComponent> splitterHeader;
     bool _isHeaderInitialised;
     std::unique_ptr<UIUtils::PopoverComponent> _errorPopover;
+    std::unique_ptr<UIUtils::PopoverComponent> _tracePopover;
 
     void _enableDoubleClickToDefault();
     void _startSliderReadouts();
@@ -76,6 +80,11 @@ private:
     void _onParameterUpdate() override;
     void _updateSplitterHeader();
     void _displayErrorsIfNeeded();
+
+    /**
+     * Starts tracing, or stops it and shows where the trace was saved.
+     */
+    void _toggleTrace();
     //[/UserVariables]
 
     //==============================================================================
@@ -27,7 +27,10 @@ ChainViewComponent::ChainViewComponent(int chainNumber,
         _pluginSelectionInterface(pluginSelectionInterface),
         _pluginModulationInterface(pluginModulationInterface),
         _shouldDrawDragHint(false),
-        _dragHintSlotNumber(0) {
+        _dragHintSlotNumber(0),
+        _isHibernatedWhileMuted(false),
+        _isFreezing(false),
+        _isFrozen(false) {
 
     _viewPort.reset(new juce::Viewport());
     _viewPort->setViewedComponent(new juce::Component());
@@ -37,6 +40,9 @@ ChainViewComponent::ChainViewComponent(int chainNumber,
     _viewPort->getVerticalScrollBar().setColour(juce::ScrollBar::ColourIds::trackColourId, juce::Colour(0x00000000));
     addAndMakeVisible(_viewPort.get());
     _viewPort->setBounds(getLocalBounds());
+
+    // Clicks anywhere in the chain can open its menu
+    _viewPort->addMouseListener(this, true);
 }
 
 ChainViewComponent::~ChainViewComponent() {
@@ -47,6 +53,18 @@ void ChainViewComponent::setPlugins(PluginChain* newChain) {
     // Clear all slots and rebuild the chain
     _pluginSlots.clear();
 
+    _isFreezing = newChain->isFreezing();
+    _isFrozen = newChain->isFrozen();
+
+    // The plugins don't exist at the moment, so there's nothing to show or insert into until the
+    // chain is woken or unfrozen
+    _isHibernatedWhileMuted = newChain->isHibernated() && newChain->getChainMute() && !_isFrozen;
+    if (_isHibernatedWhileMuted || _isFrozen) {
+        resized();
+        repaint();
+        return;
+    }
+
     for (size_t index {0}; index < newChain->getNumSlots(); index++) {
         // Add the slot
         std::unique_ptr<BaseSlotComponent> newSlot;
@@ -78,6 +96,10 @@ void ChainViewComponent::resized() {
 
     _viewPort->setBounds(availableArea);
 
+    if (_pluginSlots.empty()) {
+        return;
+    }
+
     // First pass to calculate the scrollable height
     // We need to do this since we don't know if the modulation tray will be open or not
     // There's always an empty slot so start with that
@@ -113,6 +135,14 @@ void ChainViewComponent::resized() {
 }
 
 void ChainViewComponent::paint(juce::Graphics& g) {
+    if (_isHibernatedWhileMuted) {
+        g.setColour(UIUtils::neutralHighlightColour);
+        g.drawFittedText("Muted chain unloaded to save CPU", getLocalBounds().reduced(4), juce::Justification::centred, 3);
+    } else if (_isFrozen) {
+        g.setColour(UIUtils::neutralHighlightColour);
+        g.drawFittedText("Frozen chain\nRight click to unfreeze", getLocalBounds().reduced(4), juce::Justification::centred, 3);
+    }
+
     if (_shouldDrawDragHint) {
         g.setColour(UIUtils::neutralHighlightColour);
         const int hintYPos {_dragHintSlotNumber < _pluginSlots.size() ?
@@ -127,7 +157,7 @@ bool ChainViewComponent::isInterestedInDragSource(const SourceDetails& dragSourc
 
     // TODO check if the slot has actually moved
 
-    return isValid;
+    return isValid && !_isHibernatedWhileMuted && !_isFrozen;
 }
 
 void ChainViewComponent::itemDragEnter(const SourceDetails& dragSourceDetails) {
@@ -174,6 +204,12 @@ void ChainViewComponent::itemDropped(const SourceDetails& dragSourceDetails) {
     }
 }
 
+void ChainViewComponent::mouseDown(const juce::MouseEvent& event) {
+    if (event.mods.isPopupMenu()) {
+        _showChainMenu();
+    }
+}
+
 int ChainViewComponent::_dragCursorPositionToSlotNumber(juce::Point<int> cursorPosition) {
     int retVal {static_cast<int>(_pluginSlots.size() - 1)};
 
@@ -189,3 +225,41 @@ int ChainViewComponent::_dragCursorPositionToSlotNumber(juce::Point<int> cursorP
 
     return retVal;
 }
+
+void ChainViewComponent::_showChainMenu() {
+    enum MENU_ITEM {
+        START_FREEZE = 1,
+        COMPLETE_FREEZE,
+        UNFREEZE
+    };
+
+    juce::PopupMenu menu;
+
+    if (_isFrozen) {
+        menu.addItem(UNFREEZE, "Unfreeze chain");
+    } else if (_isFreezing) {
+        menu.addItem(COMPLETE_FREEZE, "Finish freezing chain");
+    } else {
+        // The chain is captured the next time the host plays through the section to be frozen
+        menu.addItem(START_FREEZE, "Freeze chain (then play the section to freeze)", !_isHibernatedWhileMuted);
+    }
+
+    juce::Component::SafePointer<ChainViewComponent> safeThis(this);
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(this), [safeThis](int result) {
+        if (safeThis == nullptr) {
+            return;
+        }
+
+        PluginSelectionInterface& pluginSelectionInterface = safeThis->_pluginSelectionInterface;
+        const int chainNumber {safeThis->_chainNumber};
+
+        // The processor rebuilds the graph, which may delete this component
+        if (result == START_FREEZE) {
+            pluginSelectionInterface.startChainFreeze(chainNumber);
+        } else if (result == COMPLETE_FREEZE) {
+            pluginSelectionInterface.completeChainFreeze(chainNumber);
+        } else if (result == UNFREEZE) {
+            pluginSelectionInterface.unfreezeChain(chainNumber);
+        }
+    });
+}
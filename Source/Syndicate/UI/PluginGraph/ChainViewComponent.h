@@ -22,6 +22,8 @@ public:
 
     void paint(juce::Graphics& g) override;
 
+    void mouseDown(const juce::MouseEvent& event) override;
+
     bool isInterestedInDragSource(const SourceDetails& dragSourceDetails) override;
     void itemDragEnter(const SourceDetails& dragSourceDetails) override;
     void itemDragMove(const SourceDetails& dragSourceDetails) override;
@@ -37,6 +39,19 @@ private:
     bool _shouldDrawDragHint;
     int _dragHintSlotNumber;
 
+    // Set while the chain's plugins have been unloaded to save CPU (see CpuGovernor)
+    bool _isHibernatedWhileMuted;
+
+    // Set while the chain's output is being captured or played back in place of its plugins (see
+    // ChainFreezer)
+    bool _isFreezing;
+    bool _isFrozen;
+
     int _dragCursorPositionToSlotNumber(juce::Point<int> cursorPosition);
 
+    /**
+     * Shows the options for freezing or unfreezing the chain.
+     */
+    void _showChainMenu();
+
 };
@@ -4,7 +4,7 @@
 GraphViewComponent::GraphViewComponent(SyndicateAudioProcessor& processor)
         : _processor(processor),
           _pluginSelectionInterface(processor),
-          _pluginModulationInterface(processor, this) {
+          _pluginModulationInterface(processor) {
     setSize (572, 276);
 
     _viewPort.reset(new UIUtils::LinkedScrollView());
@@ -86,3 +86,24 @@ void GraphViewComponent::onParameterUpdate() {
     // Maintain the previous scroll position
     _viewPort->setViewPosition(scrollPosition, 0);
 }
+
+void GraphViewComponent::onChainsUpdate(const std::set<int>& chainNumbers) {
+    WECore::AudioSpinLock lock(_processor.pluginSplitterMutex);
+
+    if (_processor.pluginSplitter == nullptr) {
+        return;
+    }
+
+    if (_chainViews.size() != _processor.pluginSplitter->getNumActiveChains()) {
+        // Chains have been added or removed since the last rebuild
+        lock.unlock();
+        onParameterUpdate();
+        return;
+    }
+
+    for (int chainNumber : chainNumbers) {
+        if (chainNumber >= 0 && chainNumber < _chainViews.size()) {
+            _chainViews[chainNumber]->setPlugins(_processor.pluginSplitter->getChain(chainNumber).get());
+        }
+    }
+}
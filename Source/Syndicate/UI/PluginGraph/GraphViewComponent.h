@@ -13,6 +13,11 @@ public:
 
     void onParameterUpdate();
 
+    /**
+     * Rebuilds only the given chains, or everything if the number of chains has changed.
+     */
+    void onChainsUpdate(const std::set<int>& chainNumbers);
+
     UIUtils::LinkedScrollView* getViewport() { return _viewPort.get(); }
 
 private:
@@ -1,23 +1,26 @@
 #include "PluginModulationInterface.h"
-#include "GraphViewComponent.h"
 
 namespace {
-    juce::Array<juce::AudioProcessorParameter*> getParamsExcludingSelected(
-            const juce::Array<juce::AudioProcessorParameter*>& pluginParameters,
+    juce::Array<CachedParameterInfo> getParamsExcludingSelected(
+            const std::vector<CachedParameterInfo>& pluginParameters,
             PluginModulationConfig config) {
         // Get the list of all parameters, and create a subset that includes only ones that haven't
         // been selected yet
         // TODO this might break if the plugin changes its list of parameters after this list has
         // been created
-        juce::Array<juce::AudioProcessorParameter*> availableParameters;
+        juce::Array<CachedParameterInfo> availableParameters;
 
-        for (juce::AudioProcessorParameter* thisParam : pluginParameters) {
+        for (const CachedParameterInfo& thisParam : pluginParameters) {
             bool shouldCopy {true};
 
-            // If this parameter name is already in the config, don't add it to the list
+            // If this parameter is already in the config, don't add it to the list (compare IDs as
+            // names aren't always unique, or indexes if the plugin doesn't provide IDs)
             for (const PluginParameterModulationConfig& paramConfig : config.parameterConfigs) {
-                const juce::String thisParamName = thisParam->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT);
-                if (thisParamName == paramConfig.targetParameterName) {
+                const bool isSameParameter {thisParam.id.isNotEmpty() ?
+                    thisParam.id == paramConfig.targetParameterID :
+                    thisParam.index == paramConfig.targetParameterIndex};
+
+                if (isSameParameter) {
                     shouldCopy = false;
                     break;
                 }
@@ -32,9 +35,8 @@ namespace {
     }
 }
 
-PluginModulationInterface::PluginModulationInterface(SyndicateAudioProcessor& processor, GraphViewComponent* graphView)
-    : _processor(processor),
-      _graphView(graphView) {
+PluginModulationInterface::PluginModulationInterface(SyndicateAudioProcessor& processor)
+    : _processor(processor) {
 }
 
 PluginModulationConfig PluginModulationInterface::getPluginModulationConfig(int chainNumber, int pluginNumber) {
@@ -65,11 +67,9 @@ bool PluginModulationInterface::togglePluginModulationActive(int chainNumber, in
         config.isActive = !config.isActive;
         _processor.pluginSplitter->setPluginModulationConfig(config, chainNumber, pluginNumber);
 
-        // We need the graph to redraw so that it puts all the plugins at the right height after
+        // We need the chain to redraw so that it puts all the plugins at the right height after
         // the modulation tray is expanded/collapsed
-        if (_graphView != nullptr) {
-            _graphView->onParameterUpdate();
-        }
+        _processor.getGraphChangeNotifier().notify(GRAPH_CHANGE::MODULATION_ROUTING, chainNumber);
     }
 
     return retVal;
@@ -80,11 +80,17 @@ void PluginModulationInterface::selectModulationTarget(int chainNumber, int plug
         // Collect the parameter list for this plugin
         std::shared_ptr<juce::AudioPluginInstance> plugin =
             _processor.pluginSplitter->getPlugin(chainNumber, pluginNumber);
+        PluginParameterCache* parameterCache =
+            _processor.pluginSplitter->getPluginParameterCache(chainNumber, pluginNumber);
+
+        if (plugin == nullptr || parameterCache == nullptr) {
+            return;
+        }
 
         // Create the selector
         PluginParameterSelectorListParameters parameters {
             _processor.pluginParameterSelectorState,
-            getParamsExcludingSelected(plugin->getParameters(), _processor.pluginSplitter->getPluginModulationConfig(chainNumber, pluginNumber)),
+            getParamsExcludingSelected(parameterCache->getParameters(), _processor.pluginSplitter->getPluginModulationConfig(chainNumber, pluginNumber)),
             [&, chainNumber, pluginNumber, targetNumber](juce::AudioProcessorParameter* parameter) { _onPluginParameterSelected(parameter, chainNumber, pluginNumber, targetNumber); }
         };
 
@@ -102,12 +108,7 @@ void PluginModulationInterface::removeModulationTarget(int chainNumber, int plug
         if (config.parameterConfigs.size() > targetNumber) {
             config.parameterConfigs.erase(config.parameterConfigs.begin() + targetNumber);
             _processor.pluginSplitter->setPluginModulationConfig(config, chainNumber, pluginNumber);
-
-            // TODO maybe find a more efficient way to refresh this part of the display than redrawing
-            // the whole graph?
-            if (_graphView != nullptr) {
-                _graphView->onParameterUpdate();
-            }
+            _processor.getGraphChangeNotifier().notify(GRAPH_CHANGE::MODULATION_ROUTING, chainNumber);
         }
     }
 }
@@ -120,17 +121,15 @@ juce::AudioProcessorParameter* PluginModulationInterface::getPluginParameterForT
 
         if (config.parameterConfigs.size() > targetNumber) {
 
-            std::shared_ptr<juce::AudioPluginInstance> plugin = _processor.pluginSplitter->getPlugin(chainNumber, pluginNumber);
+            PluginParameterCache* parameterCache = _processor.pluginSplitter->getPluginParameterCache(chainNumber, pluginNumber);
 
-            if (plugin != nullptr) {
-                const juce::String paramName(config.parameterConfigs[targetNumber].targetParameterName);
+            if (parameterCache != nullptr) {
+                const PluginParameterModulationConfig& parameterConfig = config.parameterConfigs[targetNumber];
+                const CachedParameterInfo* info {parameterCache->findTarget(
+                    parameterConfig.targetParameterID, parameterConfig.targetParameterIndex, parameterConfig.targetParameterName)};
 
-                const juce::Array<juce::AudioProcessorParameter*>& parameters = plugin->getParameters();
-                for (juce::AudioProcessorParameter* thisParam : parameters) {
-                    if (thisParam->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT) == paramName) {
-                        retVal = thisParam;
-                        break;
-                    }
+                if (info != nullptr) {
+                    retVal = info->parameter;
                 }
             }
         }
@@ -148,15 +147,16 @@ void PluginModulationInterface::_onPluginParameterSelected(juce::AudioProcessorP
             config.parameterConfigs.emplace_back();
         }
 
-        config.parameterConfigs[targetNumber].targetParameterName = parameter->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT);
+        PluginParameterModulationConfig& parameterConfig = config.parameterConfigs[targetNumber];
+        parameterConfig.targetParameterName = parameter->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT);
+        parameterConfig.targetParameterIndex = parameter->getParameterIndex();
 
-        _processor.pluginSplitter->setPluginModulationConfig(config, chainNumber, pluginNumber);
+        PluginParameterCache* parameterCache = _processor.pluginSplitter->getPluginParameterCache(chainNumber, pluginNumber);
+        const CachedParameterInfo* info {parameterCache != nullptr ? parameterCache->findByParameter(parameter) : nullptr};
+        parameterConfig.targetParameterID = info != nullptr ? info->id : juce::String();
 
-        // TODO maybe find a more efficient way to refresh this part of the display than redrawing
-        // the whole graph?
-        if (_graphView != nullptr) {
-            _graphView->onParameterUpdate();
-        }
+        _processor.pluginSplitter->setPluginModulationConfig(config, chainNumber, pluginNumber);
+        _processor.getGraphChangeNotifier().notify(GRAPH_CHANGE::MODULATION_ROUTING, chainNumber);
     }
 
     _parameterSelectorWindow.reset();
@@ -4,14 +4,12 @@
 #include "PluginProcessor.h"
 #include "PluginParameterSelectorWindow.h"
 
-class GraphViewComponent;
-
 /**
  * The interface between the processor and parts of the UI that control modulation.
  */
 class PluginModulationInterface {
 public:
-    PluginModulationInterface(SyndicateAudioProcessor& processor, GraphViewComponent* graphView);
+    explicit PluginModulationInterface(SyndicateAudioProcessor& processor);
     ~PluginModulationInterface() = default;
 
     PluginModulationConfig getPluginModulationConfig(int chainNumber, int pluginNumber);
@@ -23,7 +21,6 @@ public:
 
 private:
     SyndicateAudioProcessor& _processor;
-    GraphViewComponent* _graphView;
     std::unique_ptr<PluginParameterSelectorWindow> _parameterSelectorWindow;
 
     void _onPluginParameterSelected(juce::AudioProcessorParameter* parameter, int chainNumber, int pluginNumber, int targetNumber);
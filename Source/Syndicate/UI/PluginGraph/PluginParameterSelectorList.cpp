@@ -5,18 +5,18 @@
 
 PluginParameterListSorter::PluginParameterListSorter(
         PluginParameterSelectorState& newState,
-        const juce::Array<juce::AudioProcessorParameter*>& fullParameterList)
+        const juce::Array<CachedParameterInfo>& fullParameterList)
             : state(newState),
               _fullParameterList(fullParameterList) {
 }
 
 
-juce::Array<juce::AudioProcessorParameter*> PluginParameterListSorter::getFilteredParameterList() const {
-    juce::Array<juce::AudioProcessorParameter*> filteredParameterList;
+juce::Array<CachedParameterInfo> PluginParameterListSorter::getFilteredParameterList() const {
+    juce::Array<CachedParameterInfo> filteredParameterList;
 
     // Do filtering first if needed
     if (_isFilterNeeded()) {
-        for (juce::AudioProcessorParameter* thisParameter : _fullParameterList) {
+        for (const CachedParameterInfo& thisParameter : _fullParameterList) {
             if (_passesFilter(thisParameter)) {
                 filteredParameterList.add(thisParameter);
             }
@@ -31,17 +31,17 @@ juce::Array<juce::AudioProcessorParameter*> PluginParameterListSorter::getFilter
     return filteredParameterList;
 }
 
-int PluginParameterListSorter::compareElements(juce::AudioProcessorParameter* first, juce::AudioProcessorParameter* second) const {
-    return first->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT).compare(
-           second->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT));
+int PluginParameterListSorter::compareElements(const CachedParameterInfo& first, const CachedParameterInfo& second) const {
+    // Use the cached names, asking the plugin for them on every comparison is slow
+    return first.name.compare(second.name);
 }
 
 bool PluginParameterListSorter::_isFilterNeeded() const {
     return state.filterString.isNotEmpty();
 }
 
-bool PluginParameterListSorter::_passesFilter(const juce::AudioProcessorParameter* parameter) const {
-    return parameter->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT).containsIgnoreCase(state.filterString) || state.filterString.isEmpty();
+bool PluginParameterListSorter::_passesFilter(const CachedParameterInfo& parameter) const {
+    return parameter.name.containsIgnoreCase(state.filterString) || state.filterString.isEmpty();
 }
 
 
@@ -76,7 +76,7 @@ void PluginParameterSelectorTableListBoxModel::paintCell(juce::Graphics& g,
                                                          int height,
                                                          bool /*rowIsSelected*/) {
     if (rowNumber < _parameterList.size()) {
-        const juce::String text = _parameterList[rowNumber]->getName(PluginParameterModulationConfig::PLUGIN_PARAMETER_NAME_LENGTH_LIMIT);
+        const juce::String text = _parameterList[rowNumber].name;
 
         g.setColour(UIUtils::neutralHighlightColour);
         g.drawText(text, 2, 0, width - 4, height, juce::Justification::centredLeft, true);
@@ -86,7 +86,7 @@ void PluginParameterSelectorTableListBoxModel::paintCell(juce::Graphics& g,
 void PluginParameterSelectorTableListBoxModel::cellDoubleClicked(int rowNumber,
                                                                  int /*columnId*/,
                                                                  const juce::MouseEvent& /*event*/) {
-    _parameterSelectedCallback(_parameterList[rowNumber]);
+    _parameterSelectedCallback(_parameterList[rowNumber].parameter);
 }
 
 PluginParameterSelectorTableListBox::PluginParameterSelectorTableListBox(
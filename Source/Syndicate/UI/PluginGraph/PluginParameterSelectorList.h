@@ -10,19 +10,19 @@ public:
     PluginParameterSelectorState& state;
 
     PluginParameterListSorter(PluginParameterSelectorState& newState,
-                              const juce::Array<juce::AudioProcessorParameter*>& fullParameterList);
+                              const juce::Array<CachedParameterInfo>& fullParameterList);
     ~PluginParameterListSorter() = default;
 
-    juce::Array<juce::AudioProcessorParameter*> getFilteredParameterList() const;
+    juce::Array<CachedParameterInfo> getFilteredParameterList() const;
 
-    int compareElements(juce::AudioProcessorParameter* first, juce::AudioProcessorParameter* second) const;
+    int compareElements(const CachedParameterInfo& first, const CachedParameterInfo& second) const;
 
 private:
     // We need to take ownership of this array here
-    const juce::Array<juce::AudioProcessorParameter*> _fullParameterList;
+    const juce::Array<CachedParameterInfo> _fullParameterList;
 
     bool _isFilterNeeded() const;
-    bool _passesFilter(const juce::AudioProcessorParameter* parameter) const;
+    bool _passesFilter(const CachedParameterInfo& parameter) const;
 };
 
 class PluginParameterSelectorTableListBoxModel : public juce::TableListBoxModel {
@@ -42,7 +42,7 @@ public:
 
 private:
     PluginParameterListSorter _parameterListSorter;
-    juce::Array<juce::AudioProcessorParameter*> _parameterList;
+    juce::Array<CachedParameterInfo> _parameterList;
     std::function<void(juce::AudioProcessorParameter*)> _parameterSelectedCallback;
 };
 
@@ -3,9 +3,10 @@
 #include <JuceHeader.h>
 
 #include "PluginParameterSelectorState.h"
+#include "PluginParameterCache.h"
 
 struct PluginParameterSelectorListParameters {
     PluginParameterSelectorState& state;
-    const juce::Array<juce::AudioProcessorParameter*> fullParameterList;
+    const juce::Array<CachedParameterInfo> fullParameterList;
     std::function<void(juce::AudioProcessorParameter*)> parameterSelectedCallback;
 };
@@ -107,6 +107,18 @@ void PluginSelectionInterface::moveSlot(int fromChainNumber, int fromSlotNumber,
     _processor.moveSlot(fromChainNumber, fromSlotNumber, toChainNumber, toSlotNumber);
 }
 
+void PluginSelectionInterface::startChainFreeze(int chainNumber) {
+    _processor.startChainFreeze(chainNumber);
+}
+
+void PluginSelectionInterface::completeChainFreeze(int chainNumber) {
+    _processor.completeChainFreeze(chainNumber);
+}
+
+void PluginSelectionInterface::unfreezeChain(int chainNumber) {
+    _processor.unfreezeChain(chainNumber);
+}
+
 void PluginSelectionInterface::_onPluginSelected(std::unique_ptr<juce::AudioPluginInstance> plugin, const juce::String& error) {
     auto createErrorPopover = [&](juce::String errorText) {
         if (_pluginSelectorWindow != nullptr) {
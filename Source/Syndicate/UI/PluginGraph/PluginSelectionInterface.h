@@ -22,6 +22,10 @@ public:
     void insertGainStage(int chainNumber, int pluginNumber);
     void moveSlot(int fromChainNumber, int fromSlotNumber, int toChainNumber, int toSlotNumber);
 
+    void startChainFreeze(int chainNumber);
+    void completeChainFreeze(int chainNumber);
+    void unfreezeChain(int chainNumber);
+
     /**
      * Returns true if it's a plugin in this slot, otherwise false.
      */